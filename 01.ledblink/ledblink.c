@@ -44,6 +44,15 @@
 *********************************************************/
 #define uint32_t        unsigned int
 
+#include "profile.h"
+
+// Profile regions (make profile)
+#define PROF_BSRR       0
+#define PROF_ODR_XOR    1
+
+// Host simulator (07.simulator) provides its own register definitions
+#ifndef STM32F1REG_H
+
 /********************************
 * Base addresses for peripherals
 ********************************/
@@ -55,11 +64,14 @@
 /**************************
 * Stack Initiallization : 
 * Two ways of doing stack intializtion
-*   1)  Defining STACKINIT in C File (used in this example)
-*   2)  Defining STACKINIT in linker Script File
+*   1)  Defining STACKINIT in C File
+*   2)  Defining STACKINIT in linker Script File (used in this example : _estack)
+*
+* Reset_Handler (startup.s) copies .data, zeroes .bss and calls main
 ***************************/
 
-#define STACKINIT       (0x20002000)
+extern uint32_t _estack;
+#define STACKINIT       (&_estack)
 
 /***********************
 * Peripheral Structure 
@@ -98,7 +110,10 @@ typedef struct
 #define GPIOC   ((GPIO_type *)  GPIOC_BASE)
 #define RCC     ((RCC_type *)     RCC_BASE)
 
+#endif /* STM32F1REG_H */
+
 int main(void);
+void Reset_Handler(void);
 
 /*************************************************
 * ISR Vector Table
@@ -106,7 +121,7 @@ int main(void);
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vectors"))) = {
 	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
-	(uint32_t *) main,              /* 0x04 Reset         */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
 };
 
 
@@ -159,6 +174,11 @@ int main(void)
     //  Res    USERT  Res  SP1  TIM1  ADC2  ADC1  Res  Res  IOPE  IOPD  IOPC IOPB  IOPA  Res  AFIO
     //         1EN    -    EN   EN    EN    EN              EN    EN    EN   EN    EN         EN
 
+	// Cycle counter and region names, empty without -DPROFILE
+	PROFILE_INIT();
+	PROFILE_NAME(PROF_BSRR, "ledblink_bsrr");
+	PROFILE_NAME(PROF_ODR_XOR, "ledblink_odr_xor");
+
 	// Enabling Clock for GPIOC
 	RCC->APB2ENR |= (1 << 4);
 	
@@ -182,7 +202,16 @@ int main(void)
 	while(1) {
     //    ledblink_odr_xor();
     //    ledblink_bsrr();
+          PROFILE_BEGIN(PROF_ODR_XOR);
           ledblink_odr_xor();
+          PROFILE_END(PROF_ODR_XOR);
+
+#ifdef PROFILE
+          // NOP loop delays of ledblink_bsrr measured in cycles
+          PROFILE_BEGIN(PROF_BSRR);
+          ledblink_bsrr();
+          PROFILE_END(PROF_BSRR);
+#endif
 	}
 
 	return 0;
@@ -0,0 +1,219 @@
+/*
+ * File Name  : ledblink_cycles.c Ver 1.0
+ *
+ *
+ * Description:
+ *              Cycle count comparison of the PC13 set/clear methods
+ *              (ODR OR/AND, BSRR/BRR, ODR XOR, bit-band alias) and of a
+ *              boolean flag in RAM (OR/AND against SRAM bit-band alias)
+ *
+ *              Each method is timed with DWT->CYCCNT (enabled by startup.s),
+ *              minimum of MEASURE_RUNS runs minus the empty measurement.
+ *              Results are left in cycleResult, read them with gdb :
+ *                  make cycles      (st-util must be running)
+ *              Numbers depend on CFLAGS (-O0 in makefile), compare methods
+ *              with each other only. LED blinks (XOR) when measurement is done.
+ *
+ * Author: 
+ *              ICEEL.NET (iceelinstitute@gmail.com)
+ * 
+ * Date  : 27 March 2020
+ * 
+ * License : GNU General Public License v3.0
+ *
+ * 
+ * Hardware : 
+ *      STM32F103C8T6 Blue Pill Board 
+ 
+ *      Processor Detail    :
+ *          Chip                :   STM32F103C8T6    
+ *          Processor Type      :   ARM ® 32-bit Cortex ® -M3 CPU Core 
+ *          Device Type         :   F1 Medium-density device
+ *          Floating Point Unit :   Not Present
+  *          Flash memory       :   64K Bytes (65536 Bytes)
+ *                                  (st-info --flash : 0x10000) (pagesize: 1024)
+ *                                  Location  :: 0x800 0000
+ *          SRAM                :   20 Kbytes (65536 Bytes)
+ *                                  (st-info --sram : 0x5000 ) 
+ *                                  Location  :: 0x20000000   
+ *          Chip ID             :   0x0410    
+ *
+ *      Ext. Clock Freq     :   8 MHz   
+ *
+ * Led Connection Details : PC13
+ *
+ * Compile          :
+ * Link and Locate  :         
+ * Flash Command    :
+ *              
+ */
+
+/*********************************************************
+* Type Defination for variables Type for easy readibility
+*********************************************************/
+#define uint32_t        unsigned int
+
+#include "bitband.h"
+
+/********************************
+* Base addresses for peripherals
+********************************/
+
+#define PERIPH_BASE     ((uint32_t) 0x40000000)
+#define GPIOC_BASE      (PERIPH_BASE + 0x11000) // GPIOC base address is 0x40011000
+#define RCC_BASE        (PERIPH_BASE + 0x21000) // RCC base address is 0x40021000
+#define DWT_BASE        ((uint32_t) 0xE0001000) // Data watchpoint and trace unit
+
+/**************************
+* Stack Initiallization : 
+* Two ways of doing stack intializtion
+*   1)  Defining STACKINIT in C File
+*   2)  Defining STACKINIT in linker Script File (used in this example : _estack)
+*
+* Reset_Handler (startup.s) copies .data, zeroes .bss and calls main
+***************************/
+
+extern uint32_t _estack;
+#define STACKINIT       (&_estack)
+
+/***********************
+* Peripheral Structure 
+************************/
+typedef struct
+{
+	uint32_t CRL;      /* GPIO port configuration register low,      Address offset: 0x00 */
+	uint32_t CRH;      /* GPIO port configuration register high,     Address offset: 0x04 */
+	uint32_t IDR;      /* GPIO port input data register,             Address offset: 0x08 */
+	uint32_t ODR;      /* GPIO port output data register,            Address offset: 0x0C */
+	uint32_t BSRR;     /* GPIO port bit set/reset register,          Address offset: 0x10 */
+	uint32_t BRR;      /* GPIO port bit reset register,              Address offset: 0x14 */
+	uint32_t LCKR;     /* GPIO port configuration lock register,     Address offset: 0x18 */
+} GPIO_type;
+
+typedef struct
+{
+	uint32_t CR;       /* RCC clock control register,                Address offset: 0x00 */
+	uint32_t CFGR;     /* RCC clock configuration register,          Address offset: 0x04 */
+	uint32_t CIR;      /* RCC clock interrupt register,              Address offset: 0x08 */
+	uint32_t APB2RSTR; /* RCC APB2 peripheral reset register,        Address offset: 0x0C */
+	uint32_t APB1RSTR; /* RCC APB1 peripheral reset register,        Address offset: 0x10 */
+	uint32_t AHBENR;   /* RCC AHB peripheral clock enable register,  Address offset: 0x14 */
+	uint32_t APB2ENR;  /* RCC APB2 peripheral clock enable register, Address offset: 0x18 */
+	uint32_t APB1ENR;  /* RCC APB1 peripheral clock enable register, Address offset: 0x1C */
+	uint32_t BDCR;     /* RCC backup domain control register,        Address offset: 0x20 */
+	uint32_t CSR;      /* RCC control/status register,               Address offset: 0x24 */
+	uint32_t AHBRSTR;  /* RCC AHB peripheral clock reset register,   Address offset: 0x28 */
+	uint32_t CFGR2;    /* RCC clock configuration register2,         Address offset: 0x2C */
+} RCC_type;
+
+typedef struct
+{
+	uint32_t CTRL;     /* DWT control register,                      Address offset: 0x00 */
+	uint32_t CYCCNT;   /* DWT cycle count register,                  Address offset: 0x04 */
+} DWT_type;
+
+typedef struct
+{
+	uint32_t empty;        /* Measurement overhead (subtracted from all others) */
+	uint32_t odrOrAnd;     /* GPIOC->ODR |= bit;  GPIOC->ODR &= ~bit;           */
+	uint32_t bsrrBrr;      /* GPIOC->BSRR = bit;  GPIOC->BRR = bit;             */
+	uint32_t odrXor;       /* GPIOC->ODR ^= bit;  GPIOC->ODR ^= bit;            */
+	uint32_t bitband;      /* alias = 1;  alias = 0;                            */
+	uint32_t bitbandXor;   /* alias ^= 1;  alias ^= 1;                          */
+	uint32_t sramOrAnd;    /* ledFlags |= bit;  ledFlags &= ~bit;               */
+	uint32_t sramBitband;  /* flag alias = 1;  flag alias = 0;                  */
+} CYCLES_type;
+
+
+/****************************************
+* Peripheral Structure Definatio
+*****************************************/
+#define GPIOC   ((GPIO_type *)  GPIOC_BASE)
+#define RCC     ((RCC_type *)     RCC_BASE)
+#define DWT     ((DWT_type *)     DWT_BASE)
+
+int main(void);
+void Reset_Handler(void);
+void cyclesDone(void);
+
+/*************************************************
+* ISR Vector Table
+*************************************************/
+uint32_t (* const vector_table[])
+__attribute__ ((section(".isr_vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
+};
+
+#define MEASURE_RUNS    100
+#define LED_BIT         (1 << 13)
+#define LED_PC13        BITBAND_PERIPH(&GPIOC->ODR, 13)
+#define LED_FLAG        BITBAND_SRAM(&ledFlags, 3)
+
+// Boolean flags in RAM, bit 3 is used for the SRAM bit-band measurement
+volatile uint32_t ledFlags;
+
+// Minimum cycles of each method, read with gdb (make cycles)
+CYCLES_type cycleResult;
+
+/*
+ * Keep the smallest CYCCNT difference of 'code' in 'result'
+ */
+#define MEASURE(result, code) \
+	do { \
+		uint32_t start, cycles; \
+		start = DWT->CYCCNT; \
+		code; \
+		cycles = DWT->CYCCNT - start; \
+		if (cycles < (result)) (result) = cycles; \
+	} while (0)
+
+/*
+ * Funtion Name		: cyclesDone
+ * Description 		: Called after all measurements, gdb breakpoint for make cycles
+ * Input			: None
+ * Return Value		: None
+*/
+void cyclesDone(void)
+{
+}
+
+int main(void)
+{
+    int i, run;
+    uint32_t *result;
+
+	// Enabling Clock for GPIOC
+	RCC->APB2ENR |= (1 << 4);
+	
+	// Make GPIOC Pin13 output (PC13)
+	GPIOC->CRH |= 0x00200000;
+
+	// Start every result with the largest value, MEASURE keeps the minimum
+	for (result = &cycleResult.empty; result <= &cycleResult.sramBitband; ++result)
+		*result = 0xFFFFFFFF;
+
+	for (run = 0; run < MEASURE_RUNS; ++run) {
+		MEASURE(cycleResult.empty,       );
+		MEASURE(cycleResult.odrOrAnd,    GPIOC->ODR |= LED_BIT; GPIOC->ODR &= ~LED_BIT);
+		MEASURE(cycleResult.bsrrBrr,     GPIOC->BSRR = LED_BIT; GPIOC->BRR = LED_BIT);
+		MEASURE(cycleResult.odrXor,      GPIOC->ODR ^= LED_BIT; GPIOC->ODR ^= LED_BIT);
+		MEASURE(cycleResult.bitband,     LED_PC13 = 1; LED_PC13 = 0);
+		MEASURE(cycleResult.bitbandXor,  LED_PC13 ^= 1; LED_PC13 ^= 1);
+		MEASURE(cycleResult.sramOrAnd,   ledFlags |= (1 << 3); ledFlags &= ~(1 << 3));
+		MEASURE(cycleResult.sramBitband, LED_FLAG = 1; LED_FLAG = 0);
+	}
+
+	// Remove cost of reading CYCCNT twice
+	for (result = &cycleResult.odrOrAnd; result <= &cycleResult.sramBitband; ++result)
+		*result -= cycleResult.empty;
+
+	cyclesDone();
+
+	while(1) {
+        LED_PC13 ^= 1;
+    	for (i = 0; i < 100000; ++i) __asm__("nop");
+	}
+
+	return 0;
+}
@@ -55,11 +55,14 @@
 /**************************
 * Stack Initiallization : 
 * Two ways of doing stack intializtion
-*   1)  Defining STACKINIT in C File (used in this example)
-*   2)  Defining STACKINIT in linker Script File
+*   1)  Defining STACKINIT in C File
+*   2)  Defining STACKINIT in linker Script File (used in this example : _estack)
+*
+* Reset_Handler (startup.s) copies .data, zeroes .bss and calls main
 ***************************/
 
-#define STACKINIT       (0x20002000)
+extern uint32_t _estack;
+#define STACKINIT       (&_estack)
 
 /***********************
 * Peripheral Structure 
@@ -101,6 +104,7 @@ typedef struct
 #define GPIO_PIN   (5)   //PA5
 
 int main(void);
+void Reset_Handler(void);
 
 /*************************************************
 * ISR Vector Table
@@ -108,7 +112,7 @@ int main(void);
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vectors"))) = {
 	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
-	(uint32_t *) main,              /* 0x04 Reset         */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
 };
 
 
@@ -0,0 +1,120 @@
+/*
+ * File Name  : startup.s Ver 1.0
+ *
+ * Description:
+ *   Reset handler for STM32F103 (Cortex-M3)
+ *      1. Start DWT cycle counter (CYCCNT) for boot time measurement
+ *      2. Copy .data initial values from flash (_sidata) to RAM (_sdata - _edata)
+ *      3. Zero .bss (_sbss - _ebss)
+ *      4. Store cycles spent from reset handler entry to main in bootCycles
+ *      5. Call main
+ *
+ *   .data copy and .bss zeroing use LDM/STM bursts of 8 words (32 bytes),
+ *   remaining words are moved one at a time. Linker script keeps all
+ *   section boundaries word aligned.
+ *
+ *   Boot time : read bootCycles with gdb (make bootcycles) after main is reached.
+ *               Each 32 byte burst costs about 20 cycles (LDM 9 + STM 9 + loop),
+ *               so watch bootCycles as .data/.bss grow (see make size).
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+	.syntax unified
+	.cpu cortex-m3
+	.thumb
+
+	.global Reset_Handler
+	.global bootCycles
+
+/* Cycles from Reset_Handler entry to main (DWT->CYCCNT) */
+	.section .bss.bootCycles, "aw", %nobits
+	.align 2
+	.type bootCycles, %object
+bootCycles:
+	.space 4
+	.size bootCycles, 4
+
+	.section .text.Reset_Handler, "ax", %progbits
+	.align 1
+	.type Reset_Handler, %function
+	.thumb_func
+Reset_Handler:
+	/* CoreDebug->DEMCR  TRCENA (bit 24) : enable DWT block */
+	ldr   r0, =0xE000EDFC
+	ldr   r1, [r0]
+	orr   r1, r1, #(1 << 24)
+	str   r1, [r0]
+
+	/* DWT->CYCCNT = 0, DWT->CTRL CYCCNTENA (bit 0) */
+	ldr   r0, =0xE0001000
+	movs  r1, #0
+	str   r1, [r0, #4]
+	ldr   r1, [r0]
+	orr   r1, r1, #1
+	str   r1, [r0]
+
+	/* Copy .data : r0 = flash source, r1 = RAM destination, r2 = byte count */
+	ldr   r0, =_sidata
+	ldr   r1, =_sdata
+	ldr   r2, =_edata
+	subs  r2, r2, r1
+data_burst:
+	subs  r2, r2, #32
+	blo   data_tail
+	ldmia r0!, {r4-r11}
+	stmia r1!, {r4-r11}
+	b     data_burst
+data_tail:
+	adds  r2, r2, #32
+data_word:
+	subs  r2, r2, #4
+	blo   bss_init
+	ldr   r3, [r0], #4
+	str   r3, [r1], #4
+	b     data_word
+
+	/* Zero .bss : r1 = RAM destination, r2 = byte count */
+bss_init:
+	ldr   r1, =_sbss
+	ldr   r2, =_ebss
+	subs  r2, r2, r1
+	movs  r4, #0
+	movs  r5, #0
+	movs  r6, #0
+	movs  r7, #0
+	mov   r8, r4
+	mov   r9, r4
+	mov   r10, r4
+	mov   r11, r4
+bss_burst:
+	subs  r2, r2, #32
+	blo   bss_tail
+	stmia r1!, {r4-r11}
+	b     bss_burst
+bss_tail:
+	adds  r2, r2, #32
+bss_word:
+	subs  r2, r2, #4
+	blo   boot_done
+	str   r4, [r1], #4
+	b     bss_word
+
+	/* bootCycles = DWT->CYCCNT */
+boot_done:
+	ldr   r0, =0xE0001004
+	ldr   r1, [r0]
+	ldr   r0, =bootCycles
+	str   r1, [r0]
+
+	bl    main
+
+	/* main should never return */
+hang:
+	b     hang
+
+	.pool
+	.size Reset_Handler, . - Reset_Handler
@@ -0,0 +1,375 @@
+/*
+ * File Name  : kernel.c Ver 1.0
+ *
+ * Description:
+ *   Preemptive fixed priority scheduler (see kernel.h)
+ *
+ *   Ready threads of one priority are kept in a ring, kernelReadyTail
+ *   points to its last thread, tail->next is the first one (the one that
+ *   runs). Bit n of kernelReadyMask is set while ring n is not empty, the
+ *   highest priority ready thread is found with one count trailing zeros
+ *   (RBIT + CLZ), independent of the number of threads.
+ *
+ *   Lists are changed by threads with interrupts disabled and by the
+ *   SysTick handler, which has the same priority as PendSV : a switch
+ *   never runs in the middle of a list change.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "kernel.h"
+
+// Initial stack frame : r4-r11 (pendSVHandler) then r0-r3, r12, lr, pc, xPSR (exception return)
+#define KERNEL_FRAME_WORDS			(16)
+#define KERNEL_FRAME_R0				(8)
+#define KERNEL_FRAME_LR				(13)
+#define KERNEL_FRAME_PC				(14)
+#define KERNEL_FRAME_XPSR			(15)
+#define KERNEL_XPSR_THUMB			(1 << 24)
+
+// SysTick control and status register (CSR) bits
+#define SYSTICK_CSR_ENABLE			(1 << 0)
+#define SYSTICK_CSR_TICKINT			(1 << 1)
+#define SYSTICK_CSR_CLKSOURCE		(1 << 2)  // Processor clock
+
+KERNEL_SWITCH_type kernelSwitch;
+KERNEL_CYCLES_type kernelSwitchCycles;
+volatile uint32_t kernelTicks;
+
+static KERNEL_THREAD_type *kernelReadyTail[KERNEL_PRIORITIES];
+static uint32_t kernelReadyMask;
+static KERNEL_THREAD_type *kernelThreads[KERNEL_MAX_THREADS];
+static uint32_t kernelThreadCount;
+static uint32_t kernelSlice;				// Ticks of the running time slice
+static volatile uint32_t kernelStamp;		// CYCCNT at the last switch request of a thread, 0 : none
+
+static KERNEL_THREAD_type kernelIdle;
+static uint32_t kernelIdleStack[KERNEL_IDLE_STACK] __attribute__ ((aligned (8)));
+
+// pendsv.s : starts the first thread
+void kernelLaunch(uint32_t *sp);
+
+/*
+ * Funtion Name		: kernelReadyAdd
+ * Description 		: Puts a thread at the end of the ready ring of its priority
+ * Input			: thread
+ * Return Value		: None
+*/
+static void kernelReadyAdd(KERNEL_THREAD_type *thread)
+{
+	uint32_t priority = thread->priority;
+	KERNEL_THREAD_type *tail = kernelReadyTail[priority];
+
+	if (tail) {
+		thread->next = tail->next;
+		tail->next = thread;
+	} else {
+		thread->next = thread;
+		kernelReadyMask |= (1 << priority);
+	}
+	kernelReadyTail[priority] = thread;
+}
+
+/*
+ * Funtion Name		: kernelReadyRemove
+ * Description 		: Takes a thread out of the ready ring of its priority
+ * Input			: thread
+ * Return Value		: None
+*/
+static void kernelReadyRemove(KERNEL_THREAD_type *thread)
+{
+	uint32_t priority = thread->priority;
+	KERNEL_THREAD_type *prev = kernelReadyTail[priority];
+
+	while (prev->next != thread)
+		prev = prev->next;
+
+	if (prev == thread) {
+		// Last thread of this priority
+		kernelReadyTail[priority] = 0;
+		kernelReadyMask &= ~(1 << priority);
+	} else {
+		prev->next = thread->next;
+		if (kernelReadyTail[priority] == thread)
+			kernelReadyTail[priority] = prev;
+	}
+	thread->next = 0;
+}
+
+/*
+ * Funtion Name		: kernelSchedule
+ * Description 		: Sets kernelSwitch.next to the first thread of the
+ *					  highest priority ring. The idle thread is always ready.
+ *					  Called with interrupts disabled or from SysTick.
+ * Input			: None
+ * Return Value		: 1 a switch is needed, 0 the running thread stays
+*/
+static uint32_t kernelSchedule(void)
+{
+	KERNEL_THREAD_type *next;
+
+	next = kernelReadyTail[__builtin_ctz(kernelReadyMask)]->next;
+	kernelSwitch.next = next;
+	if (next == kernelSwitch.current)
+		return 0;
+
+	// New thread starts with a full time slice
+	kernelSlice = 0;
+	return 1;
+}
+
+/*
+ * Funtion Name		: kernelRequestSwitch
+ * Description 		: Pends PendSV and enables interrupts, the switch runs
+ *					  at cpsie. Returns when this thread is switched in
+ *					  again and records the latency of that switch if it was
+ *					  requested by a thread (kernelStamp).
+ *					  Called by threads with interrupts disabled.
+ * Input			: None
+ * Return Value		: None
+*/
+static void kernelRequestSwitch(void)
+{
+	uint32_t end, cycles;
+	KERNEL_CYCLES_type *c = &kernelSwitchCycles;
+
+	SCB->ICSR = ICSR_PENDSVSET;
+	kernelStamp = PROFILE_DWT->CYCCNT;
+	__asm__("cpsie i");
+
+	// Switched in again here, kernelStamp is from the thread that ran before
+	end = PROFILE_DWT->CYCCNT;
+
+	__asm__("cpsid i");
+	if (kernelStamp != 0) {
+		cycles = end - kernelStamp;
+		kernelStamp = 0;
+		c->count++;
+		c->total += cycles;
+		if (cycles < c->min)
+			c->min = cycles;
+		if (cycles > c->max)
+			c->max = cycles;
+	}
+	__asm__("cpsie i");
+}
+
+/*
+ * Funtion Name		: kernelIdleThread
+ * Description 		: Lowest priority thread, sleeps until the next interrupt
+ * Input			: arg (not used)
+ * Return Value		: None
+*/
+static void kernelIdleThread(void *arg)
+{
+	while (1)
+		__asm__("wfi");
+}
+
+/*
+ * Funtion Name		: kernelInit
+ * Description 		: Empties the ready rings and creates the idle thread.
+ *					  Call before kernelCreate.
+ * Input			: None
+ * Return Value		: None
+*/
+void kernelInit(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < KERNEL_PRIORITIES; ++i)
+		kernelReadyTail[i] = 0;
+	kernelReadyMask = 0;
+	kernelThreadCount = 0;
+	kernelSlice = 0;
+	kernelStamp = 0;
+	kernelTicks = 0;
+	kernelSwitch.current = 0;
+	kernelSwitch.next = 0;
+
+	kernelSwitchCycles.count = 0;
+	kernelSwitchCycles.min = 0xFFFFFFFF;
+	kernelSwitchCycles.max = 0;
+	kernelSwitchCycles.total = 0;
+
+	kernelCreate(&kernelIdle, "idle", kernelIdleThread, 0, kernelIdleStack, KERNEL_IDLE_STACK,
+				 KERNEL_PRIORITIES - 1);
+}
+
+/*
+ * Funtion Name		: kernelCreate
+ * Description 		: Prepares the stack of a thread as if it had been
+ *					  switched out by pendSVHandler and makes it ready.
+ *					  The entry function gets 'arg' in r0, returning from
+ *					  it calls kernelExit. Call before kernelStart.
+ * Input			: thread, name, entry, arg,
+ *					  stack, words (stack size), priority
+ * Return Value		: None
+*/
+void kernelCreate(KERNEL_THREAD_type *thread, const char *name, void (*entry)(void *arg), void *arg,
+				  uint32_t *stack, uint32_t words, uint32_t priority)
+{
+	uint32_t *sp;
+	uint32_t i;
+
+	if (kernelThreadCount >= KERNEL_MAX_THREADS || priority >= KERNEL_PRIORITIES)
+		return;
+
+	// Stack pointer 8 byte aligned at exception entry (AAPCS)
+	sp = (uint32_t *) ((uint32_t) (stack + words) & ~7);
+	sp -= KERNEL_FRAME_WORDS;
+	for (i = 0; i < KERNEL_FRAME_WORDS; ++i)
+		sp[i] = 0;
+	sp[KERNEL_FRAME_R0] = (uint32_t) arg;
+	sp[KERNEL_FRAME_LR] = (uint32_t) kernelExit;
+	sp[KERNEL_FRAME_PC] = (uint32_t) entry & ~1;	// Return address without the Thumb bit
+	sp[KERNEL_FRAME_XPSR] = KERNEL_XPSR_THUMB;
+
+	thread->sp = sp;
+	thread->priority = priority;
+	thread->state = KERNEL_READY;
+	thread->delay = 0;
+	thread->stack = stack;
+	thread->name = name;
+
+	kernelThreads[kernelThreadCount++] = thread;
+	kernelReadyAdd(thread);
+}
+
+/*
+ * Funtion Name		: kernelStart
+ * Description 		: Sets PendSV and SysTick to the lowest priority, starts
+ *					  SysTick at KERNEL_TICK_HZ on the processor clock and
+ *					  runs the highest priority thread on PSP. main's stack
+ *					  (MSP) is used by the interrupt handlers from here on.
+ *					  Does not return.
+ * Input			: None
+ * Return Value		: None
+*/
+void kernelStart(void)
+{
+	SCB->SHPR3 = (SCB->SHPR3 & 0x0000FFFF) | SHPR3_PENDSV_LOWEST | SHPR3_SYSTICK_LOWEST;
+
+	__asm__("cpsid i");
+	kernelSchedule();
+	kernelSwitch.current = kernelSwitch.next;
+
+	// SysTick on the processor clock, first reload at the next tick
+	SYSTICK->CSR = SYSTICK_CSR_CLKSOURCE | SYSTICK_CSR_TICKINT;
+	SYSTICK->RVR = SYSTICK_RELOAD(1, KERNEL_TICK_HZ);
+	SYSTICK->CVR = 0;
+	SYSTICK->CSR |= SYSTICK_CSR_ENABLE;
+
+	// Enables interrupts, the first SysTick comes one tick later
+	kernelLaunch(kernelSwitch.current->sp);
+}
+
+/*
+ * Funtion Name		: kernelDelay
+ * Description 		: Running thread waits for 'ticks' SysTick interrupts,
+ *					  the first one ends the running tick. 0 is kernelYield.
+ * Input			: ticks
+ * Return Value		: None
+*/
+void kernelDelay(uint32_t ticks)
+{
+	KERNEL_THREAD_type *thread = kernelSwitch.current;
+
+	if (ticks == 0) {
+		kernelYield();
+		return;
+	}
+
+	__asm__("cpsid i");
+	kernelReadyRemove(thread);
+	thread->state = KERNEL_DELAYED;
+	thread->delay = ticks;
+	kernelSchedule();
+	kernelRequestSwitch();
+}
+
+/*
+ * Funtion Name		: kernelYield
+ * Description 		: Running thread goes to the end of its ready ring, the
+ *					  next thread of the same priority runs. Returns at once
+ *					  if there is none.
+ * Input			: None
+ * Return Value		: None
+*/
+void kernelYield(void)
+{
+	KERNEL_THREAD_type *thread = kernelSwitch.current;
+
+	__asm__("cpsid i");
+	// Running thread is the first of its ring, as the tail the ring turns by one
+	kernelReadyTail[thread->priority] = thread;
+	if (kernelSchedule())
+		kernelRequestSwitch();
+	else
+		__asm__("cpsie i");
+}
+
+/*
+ * Funtion Name		: kernelExit
+ * Description 		: Ends the running thread, also called when its entry
+ *					  function returns. Its stack is not used any more.
+ * Input			: None
+ * Return Value		: None
+*/
+void kernelExit(void)
+{
+	KERNEL_THREAD_type *thread = kernelSwitch.current;
+
+	__asm__("cpsid i");
+	kernelReadyRemove(thread);
+	thread->state = KERNEL_EXITED;
+	kernelSchedule();
+	kernelRequestSwitch();
+
+	// Not switched in again
+	while (1);
+}
+
+/*
+ * Funtion Name		: kernelTickHandler
+ * Description 		: SysTick interrupt handler. Counts the delays down,
+ *					  turns the ring of the running thread when its time
+ *					  slice is over and pends PendSV if another thread has
+ *					  to run.
+ * Input			: None
+ * Return Value		: None
+*/
+void kernelTickHandler(void)
+{
+	KERNEL_THREAD_type *current = kernelSwitch.current;
+	KERNEL_THREAD_type *thread;
+	uint32_t i;
+
+	kernelTicks++;
+
+	for (i = 0; i < kernelThreadCount; ++i) {
+		thread = kernelThreads[i];
+		if (thread->state == KERNEL_DELAYED && --thread->delay == 0) {
+			thread->state = KERNEL_READY;
+			kernelReadyAdd(thread);
+		}
+	}
+
+	if (++kernelSlice >= KERNEL_SLICE_TICKS) {
+		kernelSlice = 0;
+		if (current->state == KERNEL_READY)
+			kernelReadyTail[current->priority] = current;
+	}
+
+	if (kernelSchedule()) {
+		// Preempted thread is not in kernelRequestSwitch : nothing to measure
+		kernelStamp = 0;
+		SCB->ICSR = ICSR_PENDSVSET;
+	}
+}
@@ -0,0 +1,121 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+/*
+ * File Name  : kernel.h Ver 1.0
+ *
+ * Description:
+ *   Preemptive fixed priority scheduler, PendSV context switch
+ *
+ *   Threads run in Thread mode on their own stack (PSP), interrupt handlers
+ *   and the kernel run on the main stack (MSP, _estack). Priority 0 is the
+ *   highest, KERNEL_PRIORITIES - 1 is the idle thread. The highest priority
+ *   ready thread runs; threads with the same priority share the CPU in
+ *   time slices of KERNEL_SLICE_TICKS SysTick ticks, or give it to the
+ *   next one earlier with kernelYield.
+ *
+ *   A switch is only requested (SCB->ICSR PENDSVSET), the switch itself is
+ *   done in pendSVHandler (pendsv.s) : r4-r11 of the running thread are
+ *   pushed on its stack, the stack pointer is stored in its thread
+ *   structure and the same is done backwards for the next thread. r0-r3,
+ *   r12, lr, pc and xPSR are stacked by the exception entry/return.
+ *   PendSV and SysTick have the lowest priority, a switch never delays
+ *   a device interrupt and runs after all pending interrupts are done.
+ *
+ *   Threads are KERNEL_THREAD_type variables with a stack array of the
+ *   application (static or global), there is no heap.
+ *
+ *      static KERNEL_THREAD_type blink;
+ *      static uint32_t blinkStack[128] __attribute__ ((aligned (8)));
+ *
+ *      void blinkThread(void *arg)
+ *      {
+ *          while (1) {
+ *              GPIOC->ODR ^= (1 << 13);
+ *              kernelDelay(500);            // 500 ticks, other threads run
+ *          }
+ *      }
+ *
+ *      clockInit72MHz();
+ *      kernelInit();
+ *      kernelCreate(&blink, "blink", blinkThread, 0, blinkStack, 128, 1);
+ *      kernelStart();                      // does not return
+ *
+ *   Vector table : 0x38 pendSVHandler, 0x3C kernelTickHandler.
+ *
+ *   kernelDelay, kernelYield and kernelExit are called from threads only.
+ *   Other interrupt handlers do not call the kernel.
+ *
+ *   Context switch latency (kernelSwitchCycles) : DWT->CYCCNT from the
+ *   switch request of one thread (PENDSVSET, taken at the following cpsie)
+ *   to the first instruction of the thread that is switched in : cpsie,
+ *   exception entry, pendSVHandler, exception return. Only switches from
+ *   kernelYield/kernelDelay to a thread that also left in one of them are
+ *   counted, switches requested by the SysTick handler are not.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define KERNEL_PRIORITIES			(8)		// 0 highest .. 7 idle
+#define KERNEL_MAX_THREADS			(8)		// Idle thread included
+#define KERNEL_TICK_HZ				(1000)	// SysTick rate
+#define KERNEL_SLICE_TICKS			(10)	// Time slice between equal priorities
+#define KERNEL_IDLE_STACK			(64)	// Words
+
+// SCB->ICSR : PendSV exception pending set
+#define ICSR_PENDSVSET				(1 << 28)
+
+// SCB->SHPR3 : PendSV (bits 23-16) and SysTick (bits 31-24) priority, lowest
+#define SHPR3_PENDSV_LOWEST			(0xF0 << 16)
+#define SHPR3_SYSTICK_LOWEST		(0xF0 << 24)
+
+#define KERNEL_READY				(0)
+#define KERNEL_DELAYED				(1)
+#define KERNEL_EXITED				(2)
+
+typedef struct KERNEL_THREAD
+{
+	uint32_t *sp;                   /* Saved PSP, r4-r11 on top (pendsv.s : offset 0) */
+	struct KERNEL_THREAD *next;     /* Ready ring of the same priority                */
+	uint32_t priority;
+	uint32_t state;                 /* KERNEL_READY, KERNEL_DELAYED, KERNEL_EXITED    */
+	uint32_t delay;                 /* Ticks left in kernelDelay                      */
+	uint32_t *stack;                /* Lowest address of the stack                    */
+	const char *name;
+} KERNEL_THREAD_type;
+
+// Running thread and thread to switch to, used by pendsv.s (current at offset 0)
+typedef struct
+{
+	KERNEL_THREAD_type *current;
+	KERNEL_THREAD_type *next;
+} KERNEL_SWITCH_type;
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t min;                   /* Cycles, PENDSVSET store to next thread */
+	uint32_t max;
+	unsigned long long total;
+} KERNEL_CYCLES_type;
+
+extern KERNEL_SWITCH_type kernelSwitch;
+extern KERNEL_CYCLES_type kernelSwitchCycles;
+extern volatile uint32_t kernelTicks;
+
+void kernelInit(void);
+void kernelCreate(KERNEL_THREAD_type *thread, const char *name, void (*entry)(void *arg), void *arg,
+				  uint32_t *stack, uint32_t words, uint32_t priority);
+void kernelStart(void);
+void kernelDelay(uint32_t ticks);
+void kernelYield(void);
+void kernelExit(void);
+void kernelTickHandler(void);
+void pendSVHandler(void);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * File Name  : pendsv.s Ver 1.0
+ *
+ * Description:
+ *   Context switch of kernel.c (Cortex-M3)
+ *
+ *   pendSVHandler : PendSV exception, lowest priority. The exception entry
+ *   has pushed r0-r3, r12, lr, pc and xPSR on the PSP of the running
+ *   thread; r4-r11 are pushed here, the new PSP is stored in
+ *   kernelSwitch.current->sp and the next thread is restored the same way.
+ *   EXC_RETURN in lr (0xFFFFFFFD : Thread mode, PSP) is not changed, the
+ *   exception return unstacks the rest of the next thread.
+ *
+ *   10 instructions, no branches and no interrupt lock : kernelSwitch is
+ *   only changed by threads with interrupts disabled and by the SysTick
+ *   handler, which has the same priority and cannot preempt PendSV.
+ *   About 35 cycles plus 12 for exception entry and 12 for the return
+ *   (Cortex-M3 TRM, zero wait state memory); kernelSwitchCycles has the
+ *   figure measured on the board.
+ *
+ *   kernelLaunch : first thread, called by kernelStart with interrupts
+ *   disabled. Takes r0, lr and pc from the frame made by kernelCreate,
+ *   sets PSP to the empty stack, selects PSP for Thread mode (CONTROL
+ *   SPSEL) and jumps to the entry function with interrupts enabled.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+	.syntax unified
+	.cpu cortex-m3
+	.thumb
+
+	.global pendSVHandler
+	.global kernelLaunch
+
+	.section .text.pendSVHandler, "ax", %progbits
+	.align 1
+	.type pendSVHandler, %function
+	.thumb_func
+pendSVHandler:
+	ldr   r3, =kernelSwitch
+	mrs   r0, psp
+	ldmia r3, {r1, r2}          /* r1 = current, r2 = next */
+	stmdb r0!, {r4-r11}
+	str   r0, [r1]              /* current->sp */
+	str   r2, [r3]              /* current = next */
+	ldr   r0, [r2]              /* next->sp */
+	ldmia r0!, {r4-r11}
+	msr   psp, r0
+	bx    lr
+
+	.pool
+	.size pendSVHandler, . - pendSVHandler
+
+	.section .text.kernelLaunch, "ax", %progbits
+	.align 1
+	.type kernelLaunch, %function
+	.thumb_func
+kernelLaunch:
+	/* r0 = thread->sp : r4-r11 (8 words) then r0 r1 r2 r3 r12 lr pc xPSR */
+	ldr   r1, [r0, #32]         /* argument        */
+	ldr   lr, [r0, #52]         /* kernelExit      */
+	ldr   r2, [r0, #56]         /* entry function  */
+	orr   r2, r2, #1            /* Thumb bit for bx */
+	adds  r0, r0, #64           /* empty stack     */
+	msr   psp, r0
+	movs  r0, #2                /* CONTROL SPSEL : Thread mode uses PSP */
+	msr   control, r0
+	isb
+	mov   r0, r1
+	cpsie i
+	bx    r2
+
+	.size kernelLaunch, . - kernelLaunch
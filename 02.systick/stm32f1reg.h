@@ -10,24 +10,39 @@
 #define uint32_t        unsigned int
 #define uint16_t        unsigned short
 #define uint8_t         unsigned char
+#define uint64_t        unsigned long long
+
+#define HSE_Value       ((uint32_t)  8000000) /* Value of the External oscillator in Hz (Blue Pill crystal) */
+#define HSI_Value       ((uint32_t)  8000000) /* Value of the Internal oscillator in Hz*/
 
 // Define the base addresses for peripherals
 #define PERIPH_BASE     ((uint32_t) 0x40000000)
 #define SYSTICK_BASE    ((uint32_t) 0xE000E010)
+#define SCB_BASE        ((uint32_t) 0xE000ED00)
+#define NVIC_BASE       ((uint32_t) 0xE000E100)
 
+#define TIM2_BASE       (PERIPH_BASE + 0x00000) //  TIM2 base address is 0x40000000
 #define GPIOC_BASE      (PERIPH_BASE + 0x11000) // GPIOC base address is 0x40011000
 #define GPIOD_BASE      (PERIPH_BASE + 0x11400) // GPIOD base address is 0x40011400
 #define GPIOE_BASE      (PERIPH_BASE + 0x11800) // GPIOE base address is 0x40011800
 #define RCC_BASE        (PERIPH_BASE + 0x21000) //   RCC base address is 0x40021000
+#define FLASH_BASE      (PERIPH_BASE + 0x22000) // FLASH base address is 0x40022000
 
-#define STACKINIT       0x20002000
+// Stack top (_estack) is defined in the linker script, Reset_Handler in startup.s
+extern uint32_t _estack;
+void Reset_Handler(void);
+#define STACKINIT       (&_estack)
 #define DELAY           70000
 
 #define GPIOC   ((GPIO_type *)  GPIOC_BASE)
 #define GPIOD   ((GPIO_type *)  GPIOD_BASE)
 #define GPIOE   ((GPIO_type *)  GPIOE_BASE)
 #define RCC     ((RCC_type *)     RCC_BASE)
+#define FLASH   ((FLASH_type *) FLASH_BASE)
 #define SYSTICK ((STK_type *) SYSTICK_BASE)
+#define SCB     ((SCB_type *)     SCB_BASE)
+#define NVIC    ((NVIC_type *)   NVIC_BASE)
+#define TIM2    ((TIM_type *)    TIM2_BASE)
 
 /*
  * Register Addresses
@@ -59,6 +74,43 @@ typedef struct
 	uint32_t CFGR2;    /* RCC clock configuration register2,         Address offset: 0x2C */
 } RCC_type;
 
+typedef struct
+{
+	uint32_t ACR;      /* FLASH access control register,             Address offset: 0x00 */
+	uint32_t KEYR;     /* FLASH key register,                        Address offset: 0x04 */
+	uint32_t OPTKEYR;  /* FLASH option key register,                 Address offset: 0x08 */
+	uint32_t SR;       /* FLASH status register,                     Address offset: 0x0C */
+	uint32_t CR;       /* FLASH control register,                    Address offset: 0x10 */
+	uint32_t AR;       /* FLASH address register,                    Address offset: 0x14 */
+	uint32_t RESERVED; /* Reserved,                                  Address offset: 0x18 */
+	uint32_t OBR;      /* FLASH option byte register,                Address offset: 0x1C */
+	uint32_t WRPR;     /* FLASH write protection register,           Address offset: 0x20 */
+} FLASH_type;
+
+typedef struct
+{
+	uint32_t CR1;      /* TIM control register 1,                    Address offset: 0x00 */
+	uint32_t CR2;      /* TIM control register 2,                    Address offset: 0x04 */
+	uint32_t SMCR;     /* TIM slave mode control register,           Address offset: 0x08 */
+	uint32_t DIER;     /* TIM DMA/interrupt enable register,         Address offset: 0x0C */
+	uint32_t SR;       /* TIM status register,                       Address offset: 0x10 */
+	uint32_t EGR;      /* TIM event generation register,             Address offset: 0x14 */
+	uint32_t CCMR1;    /* TIM capture/compare mode register 1,       Address offset: 0x18 */
+	uint32_t CCMR2;    /* TIM capture/compare mode register 2,       Address offset: 0x1C */
+	uint32_t CCER;     /* TIM capture/compare enable register,       Address offset: 0x20 */
+	uint32_t CNT;      /* TIM counter,                               Address offset: 0x24 */
+	uint32_t PSC;      /* TIM prescaler,                             Address offset: 0x28 */
+	uint32_t ARR;      /* TIM auto-reload register,                  Address offset: 0x2C */
+	uint32_t RES1;     /* Reserved,                                  Address offset: 0x30 */
+	uint32_t CCR1;     /* TIM capture/compare register 1,            Address offset: 0x34 */
+	uint32_t CCR2;     /* TIM capture/compare register 2,            Address offset: 0x38 */
+	uint32_t CCR3;     /* TIM capture/compare register 3,            Address offset: 0x3C */
+	uint32_t CCR4;     /* TIM capture/compare register 4,            Address offset: 0x40 */
+	uint32_t BDTR;     /* Reserved on TIM2 - TIM4,                   Address offset: 0x44 */
+	uint32_t DCR;      /* TIM DMA control register,                  Address offset: 0x48 */
+	uint32_t DMAR;     /* TIM DMA address for full transfer,         Address offset: 0x4C */
+} TIM_type;
+
 typedef struct
 {
 	uint32_t CSR;      /* SYSTICK control and status register,       Address offset: 0x00 */
@@ -67,5 +119,36 @@ typedef struct
 	uint32_t CALIB;    /* SYSTICK calibration value register,        Address offset: 0x0C */
 } STK_type;
 
+typedef struct
+{
+	uint32_t CPUID;    /* SCB CPUID base register,                   Address offset: 0x00 */
+	uint32_t ICSR;     /* SCB interrupt control and state register,  Address offset: 0x04 */
+	uint32_t VTOR;     /* SCB vector table offset register,          Address offset: 0x08 */
+	uint32_t AIRCR;    /* SCB application interrupt/reset control,   Address offset: 0x0C */
+	uint32_t SCR;      /* SCB system control register,               Address offset: 0x10 */
+	uint32_t CCR;      /* SCB configuration and control register,    Address offset: 0x14 */
+	uint32_t SHPR1;    /* SCB system handler priority 4-7,           Address offset: 0x18 */
+	uint32_t SHPR2;    /* SCB system handler priority 8-11 (SVCall), Address offset: 0x1C */
+	uint32_t SHPR3;    /* SCB system handler priority 12-15,         Address offset: 0x20 */
+	uint32_t SHCSR;    /* SCB system handler control and state,      Address offset: 0x24 */
+} SCB_type;
+
+typedef struct
+{
+	uint32_t   ISER[8];     /* Address offset: 0x000 - 0x01C */
+	uint32_t  RES0[24];     /* Address offset: 0x020 - 0x07C */
+	uint32_t   ICER[8];     /* Address offset: 0x080 - 0x09C */
+	uint32_t  RES1[24];     /* Address offset: 0x0A0 - 0x0FC */
+	uint32_t   ISPR[8];     /* Address offset: 0x100 - 0x11C */
+	uint32_t  RES2[24];     /* Address offset: 0x120 - 0x17C */
+	uint32_t   ICPR[8];     /* Address offset: 0x180 - 0x19C */
+	uint32_t  RES3[24];     /* Address offset: 0x1A0 - 0x1FC */
+	uint32_t   IABR[8];     /* Address offset: 0x200 - 0x21C */
+	uint32_t  RES4[56];     /* Address offset: 0x220 - 0x2FC */
+	uint8_t   IPR[240];     /* Address offset: 0x300 - 0x3EC */
+	uint32_t RES5[644];     /* Address offset: 0x3F0 - 0xEFC */
+	uint32_t       STIR;    /* Address offset:         0xF00 */
+} NVIC_type;
+
 #endif
 
@@ -20,11 +20,12 @@
  * 		    Processor Detail    :
  *
  *      Ext. Clock Freq     :   8 MHz   
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
  *
  * Led Connection Details : PC13 
  *
- * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c systick.c
- * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld systick.o -o systick.elf 
+ * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c systick.c clock.c
+ * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld systick.o clock.o -o systick.elf 
  * ELF to Hex       : arm-none-eabi-objcopy -O ihex systick.elf 
  * ELF to Bin       : arm-none-eabi-objcopy -O binary systick.elf
  * Clean            : rm systick.elf systick.hex systick.bin
@@ -36,12 +37,13 @@
 
 /*************STEPS for SYSTICK **********************
 
+0.	Switch system clock to 72 MHz (clockInit72MHz)
 1.	Enable Clock for GPIOC Port
 2.	Configure PC13 pin as Output Push Pull
 
 3.	Select Clock Source for Systick
 4.	Configure Interrupt Enable or Disable
-5.  Set Systick Reload Value
+5.  Set Systick Reload Value (derived from clockFreq.hclk)
 5.  Set Systick Current Value
 6   Enable Systick
 
@@ -51,9 +53,13 @@
 
 /********** stm32f1 Register Address and Structures  ***************/
 #include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
 
 #define GPIO_PIN					(13)  // LED connected on PC13
 
+#define PROF_DELAY_MS				(0)   // Profile region (make profile)
+
 
 /*********** Function declarations ****************/
 void systickHandler(void);
@@ -66,7 +72,7 @@ int32_t main(void);
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vector"))) = {
 	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
-	(uint32_t *) main,              /* 0x04 Reset         */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
 	0,                              /* 0x08 NMI           */
 	0,                              /* 0x0C HardFaullt    */
 	0,                              /* 0x10 MemManage     */
@@ -120,13 +126,13 @@ void delayMilliSec(volatile uint32_t mSec)
 Function : Main
 
 Here Four Option
-APH Clock APH/8 = 1Mz
-Processor Clock = 8Mz
+APH Clock APH/8 = 9Mz
+Processor Clock = 72Mz
 
 1. 	APH CLOCK with Interrupt Disable (Polling Delay) : 2 Sec
-				SYSTICK->CSR = (0 << 2);// 0x00004; // AHB/8 1 Mhz
+				SYSTICK->CSR = (0 << 2);// 0x00004; // AHB/8 9 Mhz
 				SYSTICK->CSR &= 0xFFFFFFFD; //~(1 << 1); // Disable Interrupt
-				SYSTICK->RVR = 1000; 		// 1 ms for without interrupt AHB
+				SYSTICK->RVR = SYSTICK_RELOAD(0, 1000); 	// 1 ms for without interrupt AHB
 				while(1){
 					delayMilliSec(2000);  // 2 second
 					GPIOC->ODR ^= (1 << GPIO_PIN);
@@ -135,16 +141,16 @@ Processor Clock = 8Mz
 
 
 2. 	APH CLOCK with Interrupt Enable  : 1 Sec
-				SYSTICK->CSR = (0 << 2);// 0x00004; // AHB/8 1 Mhz
+				SYSTICK->CSR = (0 << 2);// 0x00004; // AHB/8 9 Mhz
 				SYSTICK->CSR |= (1 << 1);	// Enable Interrupt
-				SYSTICK->RVR = 1000000; 		// 1 sec for without interrupt AHB
+				SYSTICK->RVR = SYSTICK_RELOAD(0, 1); 		// 1 sec for without interrupt AHB
 				while(1);				
 
 
 3. 	Processor CLOCK with Interrupt Disable (Polling Delay) : 500ms
-				SYSTICK->CSR = (1 << 2);// 0x00004; // AHB/8 1 Mhz
+				SYSTICK->CSR = (1 << 2);// 0x00004; // Processor 72 Mhz
 				SYSTICK->CSR &= 0xFFFFFFFD; //~(1 << 1); // Disable Interrupt
-				SYSTICK->RVR = 8*1000; 		// 1 ms for without interrupt AHB
+				SYSTICK->RVR = SYSTICK_RELOAD(1, 1000); 	// 1 ms for without interrupt AHB
 				while(1){
 					delayMilliSec(500);  // 500 mSecond
 					GPIOC->ODR ^= (1 << GPIO_PIN);
@@ -153,21 +159,28 @@ Processor Clock = 8Mz
 
 
 4. 	Processor CLOCK with Interrupt Enable  : 
-				SYSTICK->CSR = (1 << 2);// 0x00004; // AHB/8 1 Mhz
+				SYSTICK->CSR = (1 << 2);// 0x00004; // Processor 72 Mhz
 				SYSTICK->CSR |= (1 << 1);	// Enable Interrupt
-				SYSTICK->RVR = 8*100000; 		// 100 ms for without interrupt AHB
+				SYSTICK->RVR = SYSTICK_RELOAD(1, 10); 		// 100 ms for without interrupt AHB
 				while(1);				
 
 */
 
 int32_t main(void)
 {
+	// SYSCLK 72 MHz, HCLK 72 MHz -> SysTick 72 MHz (Processor) or 9 MHz (AHB/8)
+	clockInit72MHz();
+
 	 //  Register RCC->APB2ENR
 	// Enabling Clock for GPIOC RCC Register
     //  15     14     13   12   11    10    09    08   07   06    05    04    03   02    01   00
     //  Res    USERT  Res  SP1  TIM1  ADC2  ADC1  Res  Res  IOPE  IOPD  IOPC IOPB  IOPA  Res  AFIO
     //         1EN    -    EN   EN    EN    EN              EN    EN    EN   EN    EN         EN
 
+	// Cycle counter and region names, empty without -DPROFILE
+	PROFILE_INIT();
+	PROFILE_NAME(PROF_DELAY_MS, "delayMilliSec(2000)");
+
 	RCC->APB2ENR |= (1 << 4); // Enable GPIOC
 
 
@@ -198,8 +211,8 @@ int32_t main(void)
 	//  ENABLE    1 -> Counter Enabled  0 -> Disabled
   
 	// Setting Clock Source
-	SYSTICK->CSR = (0 << 2);// 0x00004; // CLK : AHB/8 1 Mhz
-//	SYSTICK->CSR = (1 << 2);// 0x00004; // CLK : Processor 8 Mhz
+	SYSTICK->CSR = (0 << 2);// 0x00004; // CLK : AHB/8 9 Mhz
+//	SYSTICK->CSR = (1 << 2);// 0x00004; // CLK : Processor 72 Mhz
 
 
 	// Configure Interrupt  Interrupt 
@@ -207,10 +220,10 @@ int32_t main(void)
 //	SYSTICK->CSR |= (1 << 1);				 // Interrupt	: Enable
 	
 	// Load the reload value (4 Values for 4 Modes to get differnt timing)
-	SYSTICK->RVR = 1000; 		// 1 ms   	CLK : APH        Interrupt : Disable 	delayMilliSec(2000);
-//	SYSTICK->RVR = 1000000; 	// 1 Second CLK : APH        Interrupt : Enable		
-//	SYSTICK->RVR = 8*1000; 	 	// 1 ms 	CLK : Processor  Interrupt : Disable	delayMilliSec(500);
-//	SYSTICK->RVR = 8*100000; 	// 100 ms 	CLK : Processor  Interrupt : Enable
+	SYSTICK->RVR = SYSTICK_RELOAD(0, 1000); 	// 1 ms   	CLK : APH        Interrupt : Disable 	delayMilliSec(2000);
+//	SYSTICK->RVR = SYSTICK_RELOAD(0, 1); 		// 1 Second CLK : APH        Interrupt : Enable		
+//	SYSTICK->RVR = SYSTICK_RELOAD(1, 1000); 	// 1 ms 	CLK : Processor  Interrupt : Disable	delayMilliSec(500);
+//	SYSTICK->RVR = SYSTICK_RELOAD(1, 10); 		// 100 ms 	CLK : Processor  Interrupt : Enable
 	
 	// Set the current value to 0
 
@@ -225,7 +238,9 @@ int32_t main(void)
 	
 //  With Interrupt Diable (Polling Mode) While loop with delay
 	while(1){
+		PROFILE_BEGIN(PROF_DELAY_MS);
 		delayMilliSec(2000);  // 2 second
+		PROFILE_END(PROF_DELAY_MS);
 		GPIOC->ODR ^= (1 << GPIO_PIN);
 	}
 
@@ -35,6 +35,7 @@
 
 /********** stm32f1 Register Address and Structures  ***************/
 #include "stm32f1reg.h"
+#include "clock.h"
 
 #define SYSTICK_PROCESSOR_CLOCK		(1)
 #define SYSTICK_AHB_CLOCK			(0)
@@ -64,7 +65,7 @@ int32_t main(void);
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vector"))) = {
 	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
-	(uint32_t *) main,              /* 0x04 Reset         */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
 	0,                              /* 0x08 NMI           */
 	0,                              /* 0x0C HardFaullt    */
 	0,                              /* 0x10 MemManage     */
@@ -185,6 +186,9 @@ void delayMilliSec(volatile uint32_t mSec)
 
 int32_t main(void)
 {
+	// SYSCLK 72 MHz, HCLK 72 MHz -> SysTick 72 MHz (Processor) or 9 MHz (AHB/8)
+	clockInit72MHz();
+
 	 //  Register RCC->APB2ENR
 	// Enabling Clock for GPIOC RCC Register
     //  15     14     13   12   11    10    09    08   07   06    05    04    03   02    01   00
@@ -213,7 +217,7 @@ int32_t main(void)
 
 
 	// SYSTICK_AHB_CLOCK 		0
-	initSysTickWithInterrupt(200000,SYSTICK_AHB_CLOCK); //
+	initSysTickWithInterrupt(SYSTICK_RELOAD(SYSTICK_AHB_CLOCK, 5),SYSTICK_AHB_CLOCK); // 200 ms time
 
 	while(1);
 
@@ -226,14 +230,14 @@ int32_t main(void)
 
 #ifdef SYSTICK_AHB_CLK_WITHOUT_INTERRUPT 
 
-	/* Clock Source : AHB/ -> 1MHz
-				Timer Value = 1000 1ms (1000)
+	/* Clock Source : AHB/8 -> 9MHz
+				Timer Value = 9000 1ms
        Interrupt	: Disbale  
 	   Delay Method : delayMilliSec (1ms because of 1ms timer)
 				
 	*/
 
-	initSysTickWithoutInterrupt(1000,SYSTICK_AHB_CLOCK);
+	initSysTickWithoutInterrupt(SYSTICK_RELOAD(SYSTICK_AHB_CLOCK, 1000),SYSTICK_AHB_CLOCK);
 
 	while(1){
 		delayMilliSec(1000);  // 01 second
@@ -245,11 +249,11 @@ int32_t main(void)
 
 #ifdef SYSTICK_AHB_CLK_WITH_INTERRUPT 
 	// SYSTICK_AHB_CLOCK 		0
-	/* Clock Source : AHB/ -> 1MHz
-				Timer Value = 200000  -> 200ms 
+	/* Clock Source : AHB/8 -> 9MHz
+				Timer Value = 1800000  -> 200ms 
 	*/
 	
-	initSysTickWithInterrupt(200000,SYSTICK_AHB_CLOCK); //200 ms time
+	initSysTickWithInterrupt(SYSTICK_RELOAD(SYSTICK_AHB_CLOCK, 5),SYSTICK_AHB_CLOCK); //200 ms time
 
 	while(1);
 
@@ -258,14 +262,14 @@ int32_t main(void)
 
 #ifdef SYSTICK_PROCESSOR_CLK_WITHOUT_INTERRUPT 
 
-	/* Clock Source : Processor  -> 8MHz
-				Timer Value = 8000 1ms 
+	/* Clock Source : Processor  -> 72MHz
+				Timer Value = 72000 1ms 
        Interrupt	: Disbale  
 	   Delay Method : delayMilliSec (1ms because of 1ms timer)
 				
 	*/
 
-	initSysTickWithoutInterrupt(1000,SYSTICK_AHB_CLOCK);
+	initSysTickWithoutInterrupt(SYSTICK_RELOAD(SYSTICK_PROCESSOR_CLOCK, 1000),SYSTICK_PROCESSOR_CLOCK);
 
 	while(1){
 		delayMilliSec(2000);  // 02 second
@@ -277,11 +281,12 @@ int32_t main(void)
 
 #ifdef SYSTICK_PROCESSOR_CLK_WITH_INTERRUPT 
 	// SYSTICK_AHB_CLOCK 		0
-	/* Clock Source : Processor -> 8MHz
-				Timer Value = 8*200000  -> 200ms 
+	/* Clock Source : Processor -> 72MHz
+				Timer Value = 72*200000  -> 200ms 
+				(24 bit RVR : maximum 233 ms at 72 MHz)
 	*/
 	
-	initSysTickWithInterrupt(8*500000,SYSTICK_AHB_CLOCK); //500 ms time5
+	initSysTickWithInterrupt(SYSTICK_RELOAD(SYSTICK_PROCESSOR_CLOCK, 5),SYSTICK_PROCESSOR_CLOCK); //200 ms time
 	while(1);
 
 
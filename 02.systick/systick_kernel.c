@@ -0,0 +1,177 @@
+/*
+ * File Name  : systick_kernel.c Ver 1.0
+ *
+ * Description:
+ *   Preemptive scheduler example (kernel.c, pendsv.s), SysTick at 1 kHz
+ *
+ *      blink        priority 1 : toggles PC13 every 500 ms (kernelDelay)
+ *      ping, pong   priority 2 : PINGPONG_ROUNDS kernelYield calls each,
+ *                                then a PINGPONG_PAUSE ms pause. Every
+ *                                yield is a context switch between them.
+ *      spin0, spin1 priority 3 : busy loops, share the CPU in 10 ms time
+ *                                slices while ping and pong pause,
+ *                                spinCount[] shows both make progress.
+ *
+ *   Context switch latency of the yields is collected in
+ *   kernelSwitchCycles (DWT->CYCCNT, enabled by startup.s).
+ *
+ *   make kernel (st-util must be running) stops in kernelBenchDone after
+ *   SWITCH_BENCH_COUNT switches and prints kernelSwitchCycles
+ *   (count, min, max, total cycles; mean = total / count, 72 cycles = 1 us)
+ *   and spinCount.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * Led Connection Details : PC13
+ *
+ * Build            : make kernel
+ * Flash Command    : st-flash write systick_kernel.bin 0x8000000
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "kernel.h"
+
+#define GPIO_PIN					(13)      // LED connected on PC13
+#define STACK_WORDS					(128)
+
+#define PINGPONG_ROUNDS				(1000)    // Yields per burst
+#define PINGPONG_PAUSE				(100)     // Ticks (ms) between bursts
+#define SWITCH_BENCH_COUNT			(10000)   // Switches measured for make kernel
+
+static KERNEL_THREAD_type blinkThread, pingThread, pongThread, spinThread[2];
+static uint32_t blinkStack[STACK_WORDS] __attribute__ ((aligned (8)));
+static uint32_t pingStack[STACK_WORDS] __attribute__ ((aligned (8)));
+static uint32_t pongStack[STACK_WORDS] __attribute__ ((aligned (8)));
+static uint32_t spinStack[2][STACK_WORDS] __attribute__ ((aligned (8)));
+
+volatile uint32_t pingPongCount[2];           // Yields of ping and pong
+volatile uint32_t spinCount[2];               // Loops of spin0 and spin1
+
+/*********** Function declarations ****************/
+void kernelBenchDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".isr_vector"))) = {
+	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
+	0,                              /* 0x08 NMI           */
+	0,                              /* 0x0C HardFaullt    */
+	0,                              /* 0x10 MemManage     */
+	0,                              /* 0x14 BusFault      */
+	0,                              /* 0x18 UsageFault    */
+	0,                              /* 0x1C Reserved      */
+	0,                              /* 0x20 Reserved      */
+	0,                              /* 0x24 Reserved      */
+	0,                              /* 0x28 Reserved      */
+	0,                              /* 0x2C SVCall        */
+	0,                              /* 0x30 Debug Monitor */
+	0,                              /* 0x34 Reserved      */
+	(uint32_t *) pendSVHandler,     /* 0x38 PendSV        */
+	(uint32_t *) kernelTickHandler, /* 0x3C SysTick       */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: kernelBenchDone
+ * Description 		: SWITCH_BENCH_COUNT switches measured, gdb breakpoint
+ *					  for make kernel
+ * Input			: None
+ * Return Value		: None
+*/
+void kernelBenchDone(void)
+{
+}
+
+/*
+ * Funtion Name		: blink
+ * Description 		: Toggles PC13 every 500 ms
+ * Input			: arg (not used)
+ * Return Value		: None
+*/
+static void blink(void *arg)
+{
+	while (1) {
+		GPIOC->ODR ^= (1 << GPIO_PIN);
+		kernelDelay(500);
+	}
+}
+
+/*
+ * Funtion Name		: pingPong
+ * Description 		: Bursts of kernelYield calls, ping (arg 0) and pong
+ *					  (arg 1) switch to each other at every call
+ * Input			: arg : 0 ping, 1 pong
+ * Return Value		: None
+*/
+static void pingPong(void *arg)
+{
+	uint32_t id = (uint32_t) arg;
+	uint32_t i, reported = 0;
+
+	while (1) {
+		for (i = 0; i < PINGPONG_ROUNDS; ++i) {
+			pingPongCount[id]++;
+			kernelYield();
+		}
+
+		if (id == 0 && !reported && kernelSwitchCycles.count >= SWITCH_BENCH_COUNT) {
+			reported = 1;
+			kernelBenchDone();
+		}
+		kernelDelay(PINGPONG_PAUSE);
+	}
+}
+
+/*
+ * Funtion Name		: spin
+ * Description 		: Busy loop, preempted by the higher priorities and
+ *					  time sliced with the other spin thread
+ * Input			: arg : 0 spin0, 1 spin1
+ * Return Value		: None
+*/
+static void spin(void *arg)
+{
+	uint32_t id = (uint32_t) arg;
+
+	while (1)
+		spinCount[id]++;
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	// SYSCLK 72 MHz, HCLK 72 MHz -> SysTick 72 MHz (Processor clock)
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC
+	GPIOC->CRH |= 0x00200000; // PC13 General Purpose Push Pull Output 2 Mhz
+
+	kernelInit();
+	kernelCreate(&blinkThread, "blink", blink, 0, blinkStack, STACK_WORDS, 1);
+	kernelCreate(&pingThread, "ping", pingPong, (void *) 0, pingStack, STACK_WORDS, 2);
+	kernelCreate(&pongThread, "pong", pingPong, (void *) 1, pongStack, STACK_WORDS, 2);
+	kernelCreate(&spinThread[0], "spin0", spin, (void *) 0, spinStack[0], STACK_WORDS, 3);
+	kernelCreate(&spinThread[1], "spin1", spin, (void *) 1, spinStack[1], STACK_WORDS, 3);
+
+	// Runs the threads, main does not continue
+	kernelStart();
+
+	while(1);
+}
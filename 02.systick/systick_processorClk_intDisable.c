@@ -66,7 +66,7 @@ int32_t main(void);
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vector"))) = {
 	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
-	(uint32_t *) main,              /* 0x04 Reset         */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
 	0,                              /* 0x08 NMI           */
 	0,                              /* 0x0C HardFaullt    */
 	0,                              /* 0x10 MemManage     */
@@ -0,0 +1,202 @@
+/*
+ * File Name  : systick_tickless.c Ver 1.0
+ *
+ * Description:
+ *   Tickless SysTick example : Blink LED at 500 ms intervals (PC13)
+ *   The core sleeps in WFI between the deadlines instead of polling
+ *   COUNTFLAG (delayMilliSec in systick.c keeps the CPU 100 % busy).
+ *
+ *   SysTick interrupts : one every 233 ms (longest period) and one at
+ *   each deadline. Wake-up delay after the deadline (ticks, 1/72 us)
+ *   is kept in ticklessLateMax, read it with gdb.
+ *
+ *   Before blinking, the clock is read from a higher priority interrupt
+ *   than SysTick : TIM2 update every READER_TICKS while main sleeps to
+ *   READER_DEADLINES deadlines READER_US apart. 72000 = 89 * 809 - 1, so
+ *   the TIM2 interrupt comes one tick earlier at each SysTick wrap and
+ *   falls on every point of the SysTick handler, also between its entry
+ *   and its first instruction. ticklessReads counts the reads,
+ *   ticklessPreempts those that interrupted the SysTick handler and
+ *   ticklessBackwards those smaller than the read before (must be 0).
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * Led Connection Details : PC13
+ *
+ * Build            : make tickless
+ * Flash Command    : st-flash write systick_tickless.bin 0x8000000
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "timebase.h"
+
+#define GPIO_PIN					(13)      // LED connected on PC13
+#define BLINK_US					(500000)  // Toggle every 500 ms
+
+#define READER_DEADLINES			(1000)
+#define READER_US					(1000)    // 72000 ticks
+#define READER_TICKS				(809)     // TIM2 clock 72 MHz = HCLK
+
+// SCB->SHPR3 : SysTick (bits 31-24) priority, lowest
+#define SHPR3_SYSTICK_LOWEST		(0xF0 << 24)
+
+volatile uint32_t ticklessLateMax;            // Ticks between deadline and wake-up
+volatile uint32_t ticklessWakeups;
+
+volatile uint32_t ticklessReads;              // Clock reads in the TIM2 interrupt
+volatile uint32_t ticklessPreempts;           // ... of them in the SysTick handler
+volatile uint32_t ticklessBackwards;          // ... of them before the read before
+static uint64_t ticklessLast;
+
+/*********** Function declarations ****************/
+void ticklessReaderHandler(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".isr_vector"))) = {
+	(uint32_t *) STACKINIT,         /* 0x00 Stack Pointer */
+	(uint32_t *) Reset_Handler,     /* 0x04 Reset         */
+	0,                              /* 0x08 NMI           */
+	0,                              /* 0x0C HardFaullt    */
+	0,                              /* 0x10 MemManage     */
+	0,                              /* 0x14 BusFault      */
+	0,                              /* 0x18 UsageFault    */
+	0,                              /* 0x1C Reserved      */
+	0,                              /* 0x20 Reserved      */
+	0,                              /* 0x24 Reserved      */
+	0,                              /* 0x28 Reserved      */
+	0,                              /* 0x2C SVCall        */
+	0,                              /* 0x30 Debug Monitor */
+	0,                              /* 0x34 Reserved      */
+	0,                              /* 0x38 PendSV        */
+	(uint32_t *) timebaseHandler,   /* 0x3C SysTick       */
+	0,                              /* 0x40 Window watchdog */
+	0,                              /* 0x44 PVD           */
+	0,                              /* 0x48 Tamper        */
+	0,                              /* 0x4C RTC           */
+	0,                              /* 0x50 FLASH         */
+	0,                              /* 0x54 RCC           */
+	0,                              /* 0x58 EXTI Line0    */
+	0,                              /* 0x5C EXTI Line1    */
+	0,                              /* 0x60 EXTI Line2    */
+	0,                              /* 0x64 EXTI Line3    */
+	0,                              /* 0x68 EXTI Line4    */
+	0,                              /* 0x6C DMA1_Ch1      */
+	0,                              /* 0x70 DMA1_Ch2      */
+	0,                              /* 0x74 DMA1_Ch3      */
+	0,                              /* 0x78 DMA1_Ch4      */
+	0,                              /* 0x7C DMA1_Ch5      */
+	0,                              /* 0x80 DMA1_Ch6      */
+	0,                              /* 0x84 DMA1_Ch7      */
+	0,                              /* 0x88 ADC1 and ADC2 */
+	0,                              /* 0x8C CAN1_TX       */
+	0,                              /* 0x90 CAN1_RX0      */
+	0,                              /* 0x94 CAN1_RX1      */
+	0,                              /* 0x98 CAN1_SCE      */
+	0,                              /* 0x9C EXTI Line9..5 */
+	0,                              /* 0xA0 TIM1_BRK      */
+	0,                              /* 0xA4 TIM1_UP       */
+	0,                              /* 0xA8 TIM1_TRG_COM  */
+	0,                              /* 0xAC TIM1_CC       */
+	(uint32_t *) ticklessReaderHandler, /* 0xB0 TIM2      */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: ticklessReaderHandler
+ * Description 		: TIM2 update interrupt, above SysTick priority.
+ *					  Reads the clock and checks it did not go back.
+ * Input			: None
+ * Return Value		: None
+*/
+
+void ticklessReaderHandler(void)
+{
+	uint64_t now;
+
+	TIM2->SR = 0;
+	if (SCB->SHCSR & SHCSR_SYSTICKACT)
+		ticklessPreempts++;
+	now = timebaseNow();
+	if (now < ticklessLast)
+		ticklessBackwards++;
+	ticklessLast = now;
+	ticklessReads++;
+}
+
+/*
+ * Funtion Name		: ticklessReaderCheck
+ * Description 		: Sleeps to READER_DEADLINES deadlines with the TIM2
+ *					  reader running, SysTick at the lowest priority
+ * Input			: None
+ * Return Value		: None
+*/
+
+static void ticklessReaderCheck(void)
+{
+	uint64_t next;
+	uint32_t n;
+
+	SCB->SHPR3 = (SCB->SHPR3 & 0x00FFFFFF) | SHPR3_SYSTICK_LOWEST;
+
+	RCC->APB1ENR |= (1 << 0);       // Enable TIM2
+	TIM2->PSC = 0;
+	TIM2->ARR = READER_TICKS - 1;
+	TIM2->EGR = 1;                  // UG : load PSC
+	TIM2->SR = 0;
+	TIM2->DIER = 1;                 // UIE
+	NVIC->ISER[0] = (1 << 28);      // TIM2_IRQn, priority 0
+	TIM2->CR1 = 1;                  // CEN
+
+	next = timebaseNow();
+	for (n = 0; n < READER_DEADLINES; n++) {
+		next += timebaseUsToTicks(READER_US);
+		timebaseSleepUntil(next);
+	}
+
+	TIM2->CR1 = 0;
+	TIM2->DIER = 0;
+	NVIC->ICER[0] = (1 << 28);
+}
+
+int32_t main(void)
+{
+	uint64_t next;
+	uint64_t late;
+
+	// SYSCLK 72 MHz, HCLK 72 MHz -> SysTick 72 MHz (Processor clock)
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC
+	GPIOC->CRH |= 0x00200000; // PC13 General Purpose Push Pull Output 2 Mhz
+
+	timebaseInit();
+	ticklessReaderCheck();
+
+	next = timebaseNow();
+	while(1){
+		next += timebaseUsToTicks(BLINK_US);
+		timebaseSleepUntil(next);
+		late = timebaseElapsed(next);
+
+		GPIOC->ODR ^= (1 << GPIO_PIN);
+
+		if (late > ticklessLateMax)
+			ticklessLateMax = (uint32_t) late;
+		ticklessWakeups++;
+	}
+}
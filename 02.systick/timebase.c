@@ -0,0 +1,338 @@
+/*
+ * File Name  : timebase.c Ver 1.0
+ *
+ * Description:
+ *   Tickless SysTick time base with a 64 bit monotonic clock (see timebase.h)
+ *
+ *   timebaseHandler must be the SysTick entry (0x3C) of the vector table.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "timebase.h"
+
+// Counter must be at least this far from 0 to change RVR/CVR without racing the wrap
+#define TIMEBASE_GUARD_TICKS		(TIMEBASE_MIN_TICKS / 2)
+
+static volatile uint64_t timebaseBase;			// Ticks at the start of the running period
+static volatile uint32_t timebaseLoad;			// RVR of the running period
+static volatile uint32_t timebaseNextLoad;		// RVR register, loaded at the next wrap
+static volatile uint64_t timebaseDeadline;
+static volatile uint32_t timebaseSeq;			// Counts updates of the above
+
+volatile uint32_t timebaseTicksPerUs;			// HCLK in MHz
+volatile uint32_t timebaseRearms;				// Periods cut short for an earlier deadline
+
+/*
+ * Funtion Name		: 	initSysTickWithInterrupt
+ * Description 		: 	Initialize SysTick Timer with interrupt
+ * Input			: 	uiReloadValue
+						uiClockSource
+ * Return Value		:	None
+*/
+
+void initSysTickWithInterrupt(uint32_t uiReloadValue, uint8_t uiClockSource)
+{
+	// Control and Status Register
+	//  31-17      16       15-3      2        1       0
+	//  RES      CNTFLAG    RES     CLKSRC   TICKINT  ENABLE
+
+	// Setting Clock Source
+	SYSTICK->CSR = (uiClockSource << 2);
+	// Setting Interrupt
+	SYSTICK->CSR |= (1 << 1);
+
+	// Load the reload value
+	SYSTICK->RVR = uiReloadValue;
+	// Set the current value to 0 (reloads on the next tick)
+	SYSTICK->CVR = 0;
+
+	// Enable SysTick
+	SYSTICK->CSR |= (1 << 0);
+}
+
+/*
+ * Funtion Name		: timebasePeriod
+ * Description 		: Length of the next SysTick period for 'ticks' ticks
+ *					  to go. A deadline further than TIMEBASE_MAX_TICKS is
+ *					  split so the last period is not shorter than
+ *					  TIMEBASE_MIN_TICKS.
+ * Input			: ticks
+ * Return Value		: period in ticks (RVR + 1)
+*/
+
+static uint32_t timebasePeriod(uint64_t ticks)
+{
+	if (ticks > TIMEBASE_MAX_TICKS) {
+		if (ticks - TIMEBASE_MAX_TICKS < TIMEBASE_MIN_TICKS)
+			return (uint32_t) (ticks / 2);
+		return TIMEBASE_MAX_TICKS;
+	}
+	if (ticks < TIMEBASE_MIN_TICKS)
+		return TIMEBASE_MIN_TICKS;
+	return (uint32_t) ticks;
+}
+
+/*
+ * Funtion Name		: timebaseCount
+ * Description 		: Adds the finished period if the counter wrapped since
+ *					  the last count (COUNTFLAG, cleared by the read).
+ *					  Called with interrupts disabled from the SysTick
+ *					  handler or from a handler that interrupted it.
+ * Input			: None
+ * Return Value		: None
+*/
+
+static void timebaseCount(void)
+{
+	if (SYSTICK->CSR & SYSTICK_CSR_COUNTFLAG) {
+		timebaseBase += timebaseLoad + 1;
+		timebaseLoad = timebaseNextLoad;
+		timebaseSeq++;
+	}
+}
+
+/*
+ * Funtion Name		: timebaseProgram
+ * Description 		: Sets RVR for the deadline. If the deadline is after
+ *					  the running period, RVR is the length of the next
+ *					  period. If it is inside the running period, the
+ *					  counter is restarted with CVR = 0.
+ *					  Called with interrupts disabled.
+ * Input			: None
+ * Return Value		: None
+*/
+
+static void timebaseProgram(void)
+{
+	uint64_t now, end, deadline, remaining;
+	uint32_t cvr, first, period, cycles, after, reload;
+
+	cvr = SYSTICK->CVR;
+	// Period ends now or a wrap is not counted yet : the SysTick handler programs RVR
+	if ((SCB->ICSR & ICSR_PENDSTSET) || cvr < TIMEBASE_GUARD_TICKS)
+		return;
+
+	now = timebaseBase + timebaseLoad - cvr;
+	end = timebaseBase + timebaseLoad + 1;
+	deadline = timebaseDeadline;
+
+	// Deadline reached : the sleeper sees it in timebaseNow()
+	if (deadline <= now)
+		deadline = timebaseDeadline = TIMEBASE_NEVER;
+
+	// Next period can end at the deadline : only RVR changes
+	if (deadline == end || (deadline > end && deadline - end >= TIMEBASE_MIN_TICKS)) {
+		// Deadline at the end of the running period : nothing after it yet
+		if (deadline == TIMEBASE_NEVER || deadline == end)
+			period = TIMEBASE_MAX_TICKS;
+		else
+			period = timebasePeriod(deadline - end);
+		timebaseNextLoad = period - 1;
+		SYSTICK->RVR = period - 1;
+		return;
+	}
+
+	// Deadline inside the running period or too close after its end :
+	// restart the counter with CVR = 0. CYCCNT counts the same HCLK cycles,
+	// CYCCNT + CVR is constant within a period : read both the same way
+	// before and after the restart, the change is the time it took.
+	remaining = deadline - now;
+	period = timebasePeriod(remaining);
+	first = cvr;
+	cycles = PROFILE_DWT->CYCCNT;
+	cvr = SYSTICK->CVR;
+	period -= first - cvr;					// Ticks spent since the first CVR read
+	SYSTICK->RVR = period - 1;
+	SYSTICK->CVR = 0;
+	after = PROFILE_DWT->CYCCNT;
+	reload = SYSTICK->CVR;
+	// Old period up to the CVR read, cycles between the reads, less the
+	// ticks of the new period up to the second CVR read
+	timebaseBase = timebaseBase + timebaseLoad - cvr + (after - cycles) - (period - 1 - reload);
+	timebaseLoad = period - 1;
+	timebaseNextLoad = period - 1;
+	timebaseRearms++;
+}
+
+/*
+ * Funtion Name		: timebaseInit
+ * Description 		: Starts SysTick on the processor clock with the longest
+ *					  period and no deadline. Call after clockInit72MHz().
+ * Input			: None
+ * Return Value		: None
+*/
+
+void timebaseInit(void)
+{
+	timebaseTicksPerUs = clockFreq.hclk / 1000000;
+	timebaseBase = 0;
+	timebaseLoad = TIMEBASE_MAX_TICKS - 1;
+	timebaseNextLoad = TIMEBASE_MAX_TICKS - 1;
+	timebaseDeadline = TIMEBASE_NEVER;
+	timebaseSeq = 0;
+	timebaseRearms = 0;
+
+	// CoreDebug->DEMCR TRCENA : enable DWT block, then start CYCCNT (re-arm)
+	COREDEBUG_DEMCR |= DEMCR_TRCENA;
+	PROFILE_DWT->CTRL |= DWT_CTRL_CYCCNTENA;
+
+	initSysTickWithInterrupt(TIMEBASE_MAX_TICKS - 1, SYSTICK_PROCESSOR_CLOCK);
+}
+
+/*
+ * Funtion Name		: timebaseHandler
+ * Description 		: SysTick interrupt handler. Counter wrapped : adds the
+ *					  finished period and sets RVR for the deadline.
+ * Input			: None
+ * Return Value		: None
+*/
+
+void timebaseHandler(void)
+{
+	__asm__("cpsid i");
+	// Not counted yet if no handler that interrupted this one read the clock
+	timebaseCount();
+	timebaseProgram();
+	timebaseSeq++;
+	__asm__("cpsie i");
+}
+
+/*
+ * Funtion Name		: timebaseNow
+ * Description 		: Ticks (HCLK cycles) since timebaseInit.
+ *					  Usable from main and from interrupt handlers.
+ *					  Enables interrupts when it interrupted the SysTick
+ *					  handler.
+ * Input			: None
+ * Return Value		: ticks
+*/
+
+uint64_t timebaseNow(void)
+{
+	uint64_t base;
+	uint32_t load, cvr, seq;
+
+	// Interrupted the SysTick handler, maybe before it counted the wrap :
+	// PENDSTSET is clear already, count it here (COUNTFLAG)
+	if ((SCB->SHCSR & SHCSR_SYSTICKACT) && !(SCB->ICSR & ICSR_PENDSTSET)) {
+		__asm__("cpsid i");
+		timebaseCount();
+		__asm__("cpsie i");
+	}
+
+	do {
+		seq = timebaseSeq;
+		base = timebaseBase;
+		load = timebaseLoad;
+		cvr = SYSTICK->CVR;
+		// Wrapped, handler not run yet (called with SysTick masked) : next period
+		if (SCB->ICSR & ICSR_PENDSTSET) {
+			cvr = SYSTICK->CVR;
+			if (cvr != 0) {
+				base += load + 1;
+				load = timebaseNextLoad;
+			}
+		}
+	} while (seq != timebaseSeq);	// SysTick handler ran in between
+
+	return base + load - cvr;
+}
+
+/*
+ * Funtion Name		: timebaseMicros
+ * Description 		: Microseconds since timebaseInit
+ * Input			: None
+ * Return Value		: microseconds
+*/
+
+uint64_t timebaseMicros(void)
+{
+	return timebaseNow() / timebaseTicksPerUs;
+}
+
+/*
+ * Funtion Name		: timebaseElapsed
+ * Description 		: Ticks since a timestamp of timebaseNow()
+ * Input			: since
+ * Return Value		: ticks
+*/
+
+uint64_t timebaseElapsed(uint64_t since)
+{
+	return timebaseNow() - since;
+}
+
+/*
+ * Funtion Name		: timebaseElapsedUs
+ * Description 		: Microseconds since a timestamp of timebaseNow()
+ * Input			: since
+ * Return Value		: microseconds
+*/
+
+uint64_t timebaseElapsedUs(uint64_t since)
+{
+	return timebaseElapsed(since) / timebaseTicksPerUs;
+}
+
+/*
+ * Funtion Name		: timebaseUsToTicks
+ * Description 		: Converts microseconds to ticks
+ * Input			: us
+ * Return Value		: ticks
+*/
+
+uint64_t timebaseUsToTicks(uint64_t us)
+{
+	return us * timebaseTicksPerUs;
+}
+
+/*
+ * Funtion Name		: timebaseSetDeadline
+ * Description 		: Next SysTick interrupt at 'deadline' (ticks of
+ *					  timebaseNow), TIMEBASE_NEVER for none. There is one
+ *					  deadline, a new one replaces the old one.
+ *					  Interrupts are enabled on return.
+ * Input			: deadline
+ * Return Value		: None
+*/
+
+void timebaseSetDeadline(uint64_t deadline)
+{
+	__asm__("cpsid i");
+	if (SCB->SHCSR & SHCSR_SYSTICKACT)
+		timebaseCount();
+	timebaseDeadline = deadline;
+	timebaseProgram();
+	timebaseSeq++;
+	__asm__("cpsie i");
+}
+
+/*
+ * Funtion Name		: timebaseSleepUntil
+ * Description 		: Sleeps in WFI until 'deadline'. Other interrupts are
+ *					  handled while sleeping. Call from main only.
+ * Input			: deadline
+ * Return Value		: None
+*/
+
+void timebaseSleepUntil(uint64_t deadline)
+{
+	timebaseSetDeadline(deadline);
+
+	// WFI with interrupts disabled : an interrupt between the check and WFI
+	// still wakes the core, its handler runs at cpsie
+	__asm__("cpsid i");
+	while (timebaseNow() < deadline) {
+		__asm__("wfi");
+		__asm__("cpsie i");
+		__asm__("cpsid i");
+	}
+	__asm__("cpsie i");
+}
@@ -0,0 +1,103 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+/*
+ * File Name  : timebase.h Ver 1.0
+ *
+ * Description:
+ *   Tickless SysTick time base with a 64 bit monotonic clock
+ *
+ *   SysTick runs on the processor clock (HCLK), one tick = one HCLK cycle.
+ *   Instead of a fixed 1 ms interrupt the reload value (RVR) is set to the
+ *   next deadline, so the core can sleep in WFI until something is due.
+ *
+ *      timebaseBase    ticks at the start of the running SysTick period
+ *      timebaseLoad    RVR of the running period (period = RVR + 1 ticks)
+ *
+ *      now = timebaseBase + timebaseLoad - SYSTICK->CVR
+ *
+ *   Counter wrap (SysTick exception) adds the finished period to timebaseBase.
+ *   Periods are between TIMEBASE_MIN_TICKS and TIMEBASE_MAX_TICKS long,
+ *   a deadline further away is reached in several periods.
+ *
+ *   A wrap sets COUNTFLAG, the first code to read it with interrupts
+ *   disabled counts the period : the SysTick handler, or a reader in a
+ *   higher priority handler that interrupted the SysTick handler before it
+ *   got there (SCB->SHCSR SYSTICKACT, PENDSTSET is already clear then).
+ *
+ *   Reading the clock (timebaseNow, timebaseMicros, timebaseElapsed) is
+ *   safe from main and from any interrupt handler :
+ *      - the state is changed with interrupts disabled and counts
+ *        timebaseSeq, a reader that was interrupted retries
+ *      - a wrap whose handler has not started yet (reader in a higher
+ *        priority handler or with interrupts disabled) is seen in
+ *        SCB->ICSR PENDSTSET
+ *      - a wrap whose handler started but was interrupted is counted by
+ *        the reader. It disables interrupts for that and enables them on
+ *        return : in a handler that can interrupt SysTick, do not read
+ *        the clock with interrupts disabled.
+ *
+ *   A deadline inside the running period restarts the counter (CVR = 0).
+ *   The ticks lost by the restart are measured with DWT->CYCCNT, which
+ *   counts the same HCLK cycles : CYCCNT + CVR is constant within a period,
+ *   its change over the restart is the time lost, so no tick is lost or
+ *   added at a re-arm (timebaseRearms). timebaseInit starts CYCCNT, do not
+ *   stop it.
+ *
+ *   Interrupts must not be blocked longer than one period (at least
+ *   TIMEBASE_MIN_TICKS), otherwise a counter wrap is lost.
+ *
+ *      clockInit72MHz();
+ *      timebaseInit();
+ *      next = timebaseNow();
+ *      while (1) {
+ *          next += timebaseUsToTicks(500000);
+ *          timebaseSleepUntil(next);        // WFI until 500 ms are over
+ *          GPIOC->ODR ^= (1 << 13);
+ *      }
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define SYSTICK_PROCESSOR_CLOCK		(1)
+#define SYSTICK_AHB_CLOCK			(0)
+
+// SysTick CSR : counter reached 0 since the last read
+#define SYSTICK_CSR_COUNTFLAG		(1 << 16)
+
+// SCB->ICSR : SysTick exception pending set / clear
+#define ICSR_PENDSTSET				(1 << 26)
+#define ICSR_PENDSTCLR				(1 << 25)
+
+// SCB->SHCSR : SysTick exception active
+#define SHCSR_SYSTICKACT			(1 << 11)
+
+#define TIMEBASE_NEVER				(~(uint64_t) 0)		// No deadline
+
+// Longest period : 24 bit counter, 2^24 ticks = 233 ms at 72 MHz
+#define TIMEBASE_MAX_TICKS			(0x01000000)
+
+// Shortest period : longer than SysTick handler (-O0) plus interrupt latency
+#define TIMEBASE_MIN_TICKS			(2000)
+
+extern volatile uint32_t timebaseTicksPerUs;
+extern volatile uint32_t timebaseRearms;
+
+void initSysTickWithInterrupt(uint32_t uiReloadValue, uint8_t uiClockSource);
+
+void timebaseInit(void);
+void timebaseHandler(void);
+uint64_t timebaseNow(void);
+uint64_t timebaseMicros(void);
+uint64_t timebaseElapsed(uint64_t since);
+uint64_t timebaseElapsedUs(uint64_t since);
+uint64_t timebaseUsToTicks(uint64_t us);
+void timebaseSetDeadline(uint64_t deadline);
+void timebaseSleepUntil(uint64_t deadline);
+
+#endif
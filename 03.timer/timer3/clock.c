@@ -0,0 +1,144 @@
+/*
+ * File Name  : clock.c Ver 1.0
+ *
+ * Description:
+ *   Clock tree bring-up : HSE 8 MHz -> PLL x9 -> SYSCLK 72 MHz
+ *                         AHB /1 (72 MHz), APB1 /2 (36 MHz), APB2 /1 (72 MHz)
+ *                         ADC /6 (12 MHz), USB /1.5 (48 MHz)
+ *                         FLASH 2 wait states with prefetch buffer
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      Int. Default Freq   :   8 MHz
+ */
+
+
+/*************STEPS for 72 MHz Clock **********************
+
+1.	Switch on HSE (RCC->CR HSEON) and wait for HSERDY
+	(If HSE does not start, stay on HSI 8 MHz)
+2.	Program FLASH->ACR : 2 wait states (48 < SYSCLK <= 72 MHz)
+	and enable prefetch buffer
+3.	Set AHB /1, APB1 /2, APB2 /1, ADC /6 prescalers in RCC->CFGR
+4.	Select HSE as PLL source and PLL multiplication x9 in RCC->CFGR
+5.	Switch on PLL (RCC->CR PLLON) and wait for PLLRDY
+6.	Select PLL as system clock (RCC->CFGR SW) and wait until SWS shows PLL
+7.	Compute bus frequencies from RCC->CFGR into clockFreq
+
+*****************************************************/
+
+#include "clock.h"
+
+CLOCKFREQ_type clockFreq;
+
+/*
+ * Funtion Name		: clockInit72MHz
+ * Description 		: Start HSE, lock the PLL to 72 MHz and switch SYSCLK to PLL
+ * Input			: None
+ * Return Value		: 0 on success, -1 if HSE failed to start (SYSCLK stays HSI 8 MHz)
+*/
+int32_t clockInit72MHz(void)
+{
+	uint32_t timeout;
+
+	// RCC Clock Control Register
+	//  31-26   25      24      23-20   19      18      17      16      15-8     7-3      2   1       0
+	//  Res     PLLRDY  PLLON   Res     CSSON   HSEBYP  HSERDY  HSEON   HSICAL   HSITRIM  Res HSIRDY  HSION
+
+	// Switch on HSE and wait for HSE ready
+	RCC->CR |= (1 << 16);
+	for(timeout = 0; !(RCC->CR & (1 << 17)); timeout++){
+		if(timeout == HSE_STARTUP_TIMEOUT){
+			RCC->CR &= ~(1 << 16);
+			clockUpdateFreq();
+			return -1;
+		}
+	}
+
+	// Flash Access Control Register
+	//  31-6    5       4       3       2-0
+	//  Res     PRFTBS  PRFTBE  HLFCYA  LATENCY[2:0]
+	//  LATENCY 000 -> 0 < SYSCLK <= 24 MHz   001 -> 24 < SYSCLK <= 48 MHz   010 -> 48 < SYSCLK <= 72 MHz
+	FLASH->ACR = (FLASH->ACR & ~0x7) | (1 << 4) | (2 << 0);
+
+	// RCC Clock Configuration Register
+	//  31-27  26-24    23   22      21-18        17         16      15-14    13-11   10-8    7-4    3-2   1-0
+	//  Res    MCO      Res  USBPRE  PLLMUL[3:0]  PLLXTPRE   PLLSRC  ADCPRE   PPRE2   PPRE1   HPRE   SWS   SW
+	//
+	//  HPRE    0xxx -> /1        PPRE1/2  0xx -> /1   100 -> /2
+	//  ADCPRE  00   -> /2   01 -> /4   10 -> /6   11 -> /8
+	//  PLLMUL  0111 -> x9        PLLSRC   1   -> HSE  PLLXTPRE 0 -> HSE not divided
+	//  USBPRE  0    -> /1.5
+	RCC->CFGR &= ~((1 << 22) | (0xF << 18) | (1 << 17) | (1 << 16) |
+	               (0x3 << 14) | (0x7 << 11) | (0x7 << 8) | (0xF << 4));
+	RCC->CFGR |= (7 << 18)  // PLL x9
+	          |  (1 << 16)  // PLL source HSE
+	          |  (2 << 14)  // ADC  /6
+	          |  (0 << 11)  // APB2 /1
+	          |  (4 << 8)   // APB1 /2
+	          |  (0 << 4);  // AHB  /1
+
+	// Switch on PLL and wait for PLL lock
+	RCC->CR |= (1 << 24);
+	while(!(RCC->CR & (1 << 25)));
+
+	// Select PLL as system clock and wait until switch is done (SWS = 10)
+	RCC->CFGR = (RCC->CFGR & ~0x3) | (2 << 0);
+	while((RCC->CFGR & (0x3 << 2)) != (2 << 2));
+
+	clockUpdateFreq();
+
+	return 0;
+}
+
+/*
+ * Funtion Name		: clockUpdateFreq
+ * Description 		: Compute SYSCLK and bus frequencies from current RCC->CFGR
+ *					  and store them in clockFreq
+ * Input			: None
+ * Return Value		: None
+*/
+void clockUpdateFreq(void)
+{
+	static const uint8_t ahbShift[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9};
+	static const uint8_t apbShift[8]  = {0, 0, 0, 0, 1, 2, 3, 4};
+	uint32_t cfgr = RCC->CFGR;
+	uint32_t pllInput;
+	uint32_t pllMul;
+
+	switch((cfgr >> 2) & 0x3){
+	case 1:                                 // HSE
+		clockFreq.sysclk = HSE_Value;
+		break;
+	case 2:                                 // PLL
+		if(cfgr & (1 << 16))
+			pllInput = (cfgr & (1 << 17)) ? (HSE_Value / 2) : HSE_Value;
+		else
+			pllInput = HSI_Value / 2;
+		pllMul = ((cfgr >> 18) & 0xF) + 2;
+		if(pllMul > 16)
+			pllMul = 16;
+		clockFreq.sysclk = pllInput * pllMul;
+		break;
+	default:                                // HSI
+		clockFreq.sysclk = HSI_Value;
+		break;
+	}
+
+	clockFreq.hclk  = clockFreq.sysclk >> ahbShift[(cfgr >> 4) & 0xF];
+	clockFreq.pclk1 = clockFreq.hclk >> apbShift[(cfgr >> 8) & 0x7];
+	clockFreq.pclk2 = clockFreq.hclk >> apbShift[(cfgr >> 11) & 0x7];
+
+	// Timer clock is doubled when the APB prescaler is not 1
+	clockFreq.timApb1clk = (clockFreq.pclk1 == clockFreq.hclk) ? clockFreq.pclk1 : (clockFreq.pclk1 * 2);
+	clockFreq.timApb2clk = (clockFreq.pclk2 == clockFreq.hclk) ? clockFreq.pclk2 : (clockFreq.pclk2 * 2);
+
+	clockFreq.adcclk = clockFreq.pclk2 / ((((cfgr >> 14) & 0x3) + 1) * 2);
+}
@@ -0,0 +1,142 @@
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+/*
+ * File Name  : ringbuf.h Ver 1.0
+ *
+ * Description:
+ *   Lock-free single producer / single consumer ring buffer, header only
+ *
+ *   RINGBUF_DEFINE works like a template : it makes a ring buffer type for
+ *   one element type and capacity, with its functions (static inline).
+ *
+ *      RINGBUF_DEFINE(SAMPLE_RING_type, sampleRing, uint16_t, 64)
+ *
+ *      SAMPLE_RING_type samples;
+ *
+ *      sampleRingInit(&samples);
+ *      sampleRingPush(&samples, value);              // interrupt handler
+ *      while (sampleRingPop(&samples, &value))       // main loop
+ *          ...
+ *
+ *   makes SAMPLE_RING_type and
+ *
+ *      sampleRingInit(ring)
+ *      sampleRingCount(ring)                   elements in the ring
+ *      sampleRingFree(ring)                    free places
+ *      sampleRingPush(ring, value)             1 pushed, 0 full (value dropped)
+ *      sampleRingPop(ring, &value)             1 popped, 0 empty
+ *      sampleRingPushBatch(ring, values, n)    pushes up to n, returns number pushed
+ *      sampleRingPopBatch(ring, values, n)     pops up to n, returns number popped
+ *
+ *   Capacity must be a power of two (2, 4, 8 ...), checked at compile time.
+ *   head and tail are free running counters : the slot is counter & (size - 1),
+ *   head - tail is the number of elements also after the counters wrap, and
+ *   all 'size' places are used.
+ *
+ *   No critical sections : only the producer writes head, only the consumer
+ *   writes tail. Each side stores its index after it is done with the data
+ *   (RINGBUF_BARRIER between), so the other side never sees an index ahead
+ *   of the data. One side may be an interrupt handler, the other main (or a
+ *   lower priority handler); there must be only one producer and one consumer.
+ *   A batch copies all elements and then moves the index once.
+ *
+ *   RINGBUF_BARRIER : DMB, a compiler memory barrier as well. Cortex-M3 does
+ *   its own loads and stores in program order, DMB keeps the order also for
+ *   other bus masters (DMA) reading the ring and costs about one cycle.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#ifndef RINGBUF_BARRIER
+#define RINGBUF_BARRIER()		__asm__ volatile ("dmb" : : : "memory")
+#endif
+
+#define RINGBUF_DEFINE(TYPE, prefix, elem, size)											\
+																							\
+typedef struct																				\
+{																							\
+	volatile uint32_t head;     /* Push counter, written by the producer only */			\
+	volatile uint32_t tail;     /* Pop counter, written by the consumer only  */			\
+	elem data[size];																		\
+} TYPE;																						\
+																							\
+/* Compile error here : size is not a power of two */										\
+typedef char prefix##SizeCheck[(((size) & ((size) - 1)) == 0 && (size) >= 2) ? 1 : -1];	\
+																							\
+static inline void prefix##Init(TYPE *ring)												\
+{																							\
+	ring->head = 0;																			\
+	ring->tail = 0;																			\
+}																							\
+																							\
+static inline uint32_t prefix##Count(TYPE *ring)											\
+{																							\
+	return ring->head - ring->tail;															\
+}																							\
+																							\
+static inline uint32_t prefix##Free(TYPE *ring)											\
+{																							\
+	return (size) - (ring->head - ring->tail);												\
+}																							\
+																							\
+static inline uint32_t prefix##Push(TYPE *ring, elem value)								\
+{																							\
+	uint32_t head = ring->head;																\
+																							\
+	if (head - ring->tail == (size))														\
+		return 0;																			\
+	ring->data[head & ((size) - 1)] = value;												\
+	RINGBUF_BARRIER();          /* Element written before it is published */				\
+	ring->head = head + 1;																	\
+	return 1;																				\
+}																							\
+																							\
+static inline uint32_t prefix##Pop(TYPE *ring, elem *value)								\
+{																							\
+	uint32_t tail = ring->tail;																\
+																							\
+	if (ring->head == tail)																	\
+		return 0;																			\
+	RINGBUF_BARRIER();          /* head read before the element */							\
+	*value = ring->data[tail & ((size) - 1)];												\
+	RINGBUF_BARRIER();          /* Element read before its place is given back */			\
+	ring->tail = tail + 1;																	\
+	return 1;																				\
+}																							\
+																							\
+static inline uint32_t prefix##PushBatch(TYPE *ring, const elem *values, uint32_t count)	\
+{																							\
+	uint32_t head = ring->head;																\
+	uint32_t space = (size) - (head - ring->tail);											\
+	uint32_t i;																				\
+																							\
+	if (count > space)																		\
+		count = space;																		\
+	for (i = 0; i < count; ++i)																\
+		ring->data[(head + i) & ((size) - 1)] = values[i];									\
+	RINGBUF_BARRIER();																		\
+	ring->head = head + count;																\
+	return count;																			\
+}																							\
+																							\
+static inline uint32_t prefix##PopBatch(TYPE *ring, elem *values, uint32_t count)			\
+{																							\
+	uint32_t tail = ring->tail;																\
+	uint32_t used = ring->head - tail;														\
+	uint32_t i;																				\
+																							\
+	if (count > used)																		\
+		count = used;																		\
+	RINGBUF_BARRIER();																		\
+	for (i = 0; i < count; ++i)																\
+		values[i] = ring->data[(tail + i) & ((size) - 1)];									\
+	RINGBUF_BARRIER();																		\
+	ring->tail = tail + count;																\
+	return count;																			\
+}
+
+#endif
@@ -13,7 +13,7 @@
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vector"))) = {
 	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
-	(uint32_t *) main,              /* 0x004 Reset                           */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
 	0,                              /* 0x008 Non maskable interrupt          */
 	0,                              /* 0x00C HardFault                       */
 	0,                              /* 0x010 Memory Management               */
@@ -21,13 +21,14 @@
  *
  *      Ext. Clock Freq     :   8 MHz   
  *      Int. Default Freq   :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
  *
  * Led Connection Details : PC13 
  *
  * Step for generating bin : make
  *  
- * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c timer.c
- * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld timer.o -o timer.elf 
+ * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c timer.c clock.c
+ * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld timer.o clock.o -o timer.elf 
  * ELF to Hex       : arm-none-eabi-objcopy -O ihex timer.elf 
  * ELF to Bin       : arm-none-eabi-objcopy -O binary timer.elf
  * Clean            : rm timer.elf timer.hex timer.bin
@@ -39,12 +40,13 @@
 
 /*************STEPS for Timer 3 **********************
 
+0.	Switch system clock to 72 MHz (clockInit72MHz)
 1.	Enable Clock for GPIOC Port
 2.	Configure PC13 pin as Output Push Pull
 
 3.  Reset Control Register 1
-4.  Setting PSC to 7999 (dividing 8000 to generate 1Mhz Clock)
-5.  Load Automatic Reload Register (APR) to 1000 for 1 Second
+4.  Setting PSC from timer clock to generate 10 KHz timer tick
+5.  Load Automatic Reload Register (APR) to 10000 ticks for 1 Second
 6.  Enable Update Interrupt (DIER) Register
 7.  Set Priority level for timer3 Inteerupt
 8.  Enable Timer 3 from NVIC register
@@ -58,9 +60,14 @@
 
 /********** stm32f1 Register Address and Structures  ***************/
 #include "stm32f1reg.h"
+#include "bitband.h"
+#include "clock.h"
+#include "profile.h"
 
 #define GPIO_PIN					(13)  // LED connected on PC13
 
+#define PROF_TIMER3_HANDLER			(0)   // Profile region (make profile)
+
 /*********** Function declarations ****************/
 // Function declarations. Add your functions here
 void enableInterrupt(IRQn_type IRQn);
@@ -104,24 +111,32 @@ void disableInterrupt(IRQn_type IRQn)
  *					  Initialized in Interrupt Vector Table
  *                    Toggles output at PC13
  *                    clear pending Bit in Status Regiser
+ *                    Both are done without read-modify-write of the full register
  * Input			: None
  * Return Value		: None
 */
 void timer3Handler(void)
 {
-	GPIOC->ODR ^= (1 << 13);
+	// Handler body only, interrupt entry/exit (12 cycles each) not included
+	PROFILE_BEGIN(PROF_TIMER3_HANDLER);
+
+	// PC13 bit-band alias : only ODR bit 13 is written back
+	BITBAND_PERIPH(&GPIOC->ODR, 13) ^= 1;
 
 	// Timer 3 Status Regiser
 	//	15-13	12		11		10		09		08 -07		06		05		04		03		02		01		00
 	//  Res		CC4OF 	CC3OF 	CC2OF 	CC1OF	Res			TIF 	Res		CC4IF 	CC3IF 	CC2IF 	CC1IF 	UIF 
-	// Clear pending bit
-	TIM3->SR &= ~(1 << 0);
+	// Clear pending bit : rc_w0, writing 1 to other flags has no effect
+	// Single store, a flag set during the handler is not lost (SR &= ~x could lose it)
+	TIM3->SR = ~(1 << 0);
+
+	PROFILE_END(PROF_TIMER3_HANDLER);
 }
 /*
  * Funtion Name		: delayMS
  * Description 		: millisecond delay using polling  without interrupt
-                        Check if the 1 MHz timer reached to 1000.
-                        1000 will generate 1 milli-second
+                        Check if the 10 KHz timer reached to 10.
+                        10 will generate 1 milli-second
 
  * Input			: mSec
  * Return Value		: None
@@ -132,7 +147,7 @@ void delayMS(volatile uint32_t uiTime)
 
 		TIM3->EGR |= 0x0001;        // Reset the timer
  	
-    	while(TIM3->CNT < 1000);    // Wait until timer reaches to 1000
+    	while(TIM3->CNT < 10);      // Wait until timer reaches to 10
 	}
 }
 
@@ -141,12 +156,19 @@ void delayMS(volatile uint32_t uiTime)
 *************************************************/
 int32_t main(void)
 {
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
    	//  Register RCC->APB2ENR
 	// Enabling Clock for GPIOC RCC Register
     //  15     14     13   12   11    10    09    08   07   06    05    04    03   02    01   00
     //  Res    USERT  Res  SP1  TIM1  ADC2  ADC1  Res  Res  IOPE  IOPD  IOPC IOPB  IOPA  Res  AFIO
     //         1EN    -    EN   EN    EN    EN              EN    EN    EN   EN    EN         EN
 
+	// Cycle counter and region names, empty without -DPROFILE
+	PROFILE_INIT();
+	PROFILE_NAME(PROF_TIMER3_HANDLER, "timer3Handler");
+
     RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK
 	RCC->APB1ENR |= (1 << 1); // Enable Timer 3 CLK
 
@@ -168,12 +190,12 @@ int32_t main(void)
     // 16 Bit PSC Register 
 	//Setting PSC
 	// fCK_PSC / (PSC[15:0] + 1)
-	// 8 Mhz / 7 + 1 = 1 Mhz timer clock speed
-	TIM3->PSC = 7999;
+	// 72 Mhz / 7199 + 1 = 10 KHz timer clock speed
+	TIM3->PSC = TIMER_PSC(clockFreq.timApb1clk, 10000);
 
 	// Timer 3 Auto Reload Register (APR) 16 Bit
-    //TIM3->ARR = 300; //Setting 300 for .3 Second   	
-    TIM3->ARR = 1000; //Setting 1000 for  1 Second
+    //TIM3->ARR = 3000 - 1; //Setting 3000 for .3 Second   	
+    TIM3->ARR = 10000 - 1; //Setting 10000 for  1 Second
 
     // Enable Update Interrupt (DIER)
 //	15	14	13	12		11		10		09		08	07	06	05	04		03		02		01		00
@@ -0,0 +1,210 @@
+/*
+ * File Name  : timer_ring.c Ver 1.0
+ *
+ * Description:
+ *   Ring buffer example : TIM3 update interrupt (producer) hands data to
+ *   main (consumer) through the lock-free ring of ringbuf.h
+ *
+ *      - TIM3 interrupts at TICK_HZ, each one pushes RING_BURST sequence
+ *        numbers. main pops them and checks that none is lost or
+ *        repeated (errors).
+ *      - step 0 : one element per sampleRingPush / sampleRingPop call
+ *        step 1 : sampleRingPushBatch / sampleRingPopBatch, RING_BURST per call
+ *      - Each step runs BENCH_IRQS interrupts (1 s) and records in ringBench :
+ *        pushed, dropped (ring full), popped, errors, push cycles in the
+ *        interrupt and pop cycles in main (DWT->CYCCNT, enabled by
+ *        startup.s). Pops interrupted by TIM3 are not counted in popCycles.
+ *
+ *   make ring (st-util must be running) stops in ringBenchDone and prints
+ *   ringBench. Cycles per element : pushCycles / pushed and
+ *   popCycles / popMeasured. Elements per second the ring can move :
+ *   72000000 / (push + pop cycles per element).
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * Led Connection Details : PC13
+ *
+ * Build            : make ring
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "ringbuf.h"
+
+#define GPIO_PIN					(13)     // LED connected on PC13
+#define TICK_HZ						(10000)  // TIM3 update rate, producer
+
+#define RING_SIZE					(256)    // Elements, power of two
+#define RING_BURST					(16)     // Elements pushed per interrupt
+
+#define BENCH_STEPS					(2)
+#define BENCH_IRQS					(10000)  // Interrupts per step
+
+RINGBUF_DEFINE(SAMPLE_RING_type, sampleRing, uint32_t, RING_SIZE)
+
+typedef struct
+{
+	uint32_t batch;             /* 0 : single element calls, 1 : batch calls  */
+	uint32_t irqs;              /* TIM3 interrupts of the step                */
+	uint32_t pushed;
+	uint32_t dropped;           /* Ring full                                  */
+	uint32_t popped;
+	uint32_t errors;            /* Sequence numbers lost or repeated          */
+	unsigned long long pushCycles;
+	unsigned long long popCycles;
+	uint32_t popMeasured;       /* Elements in popCycles                      */
+} RINGBENCH_type;
+
+RINGBENCH_type ringBench[BENCH_STEPS];
+
+static SAMPLE_RING_type samples;
+static volatile uint32_t benchStep = BENCH_STEPS;     // Step measured, BENCH_STEPS : none
+static volatile uint32_t ringIrqs;                    // All TIM3 interrupts
+static uint32_t ringSeq;                              // Next sequence number pushed
+
+/*********** Function declarations ****************/
+void enableInterrupt(IRQn_type IRQn);
+void timer3Handler(void);
+void ringBenchDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/*
+ * Funtion Name		: enableInterrupt
+ * Description 		: Enable Interrupt for IRQn
+ * Input			: IRQn
+ * Return Value		: None
+*/
+void enableInterrupt(IRQn_type IRQn)
+{
+	NVIC->ISER[((uint32_t)(IRQn) >> 5)] = (1 << ((uint32_t)(IRQn) & 0x1F));
+}
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: TIM3 update interrupt, producer. Pushes RING_BURST
+ *					  sequence numbers during a benchmark step.
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	uint32_t burst[RING_BURST];
+	uint32_t start, n;
+	RINGBENCH_type *b;
+
+	// Clear UIF only (rc_w0)
+	TIM3->SR = ~(1 << 0);
+	ringIrqs++;
+
+	if (benchStep >= BENCH_STEPS)
+		return;
+	b = &ringBench[benchStep];
+	if (b->irqs >= BENCH_IRQS)
+		return;
+	b->irqs++;
+
+	for (n = 0; n < RING_BURST; ++n)
+		burst[n] = ringSeq + n;
+
+	start = PROFILE_DWT->CYCCNT;
+	if (b->batch) {
+		n = sampleRingPushBatch(&samples, burst, RING_BURST);
+	} else {
+		for (n = 0; n < RING_BURST; ++n)
+			if (!sampleRingPush(&samples, burst[n]))
+				break;
+	}
+	b->pushCycles += PROFILE_DWT->CYCCNT - start;
+
+	b->pushed += n;
+	b->dropped += RING_BURST - n;
+	ringSeq += n;
+}
+
+/*
+ * Funtion Name		: ringBenchDone
+ * Description 		: All steps measured, gdb breakpoint for make ring
+ * Input			: None
+ * Return Value		: None
+*/
+void ringBenchDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	uint32_t values[RING_BURST];
+	uint32_t step, i, n, irqs, start, cycles;
+	uint32_t expect = 0;
+	RINGBENCH_type *b;
+
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK
+	RCC->APB1ENR |= (1 << 1); // Enable Timer 3 CLK
+	GPIOC->CRH |= 0x00200000; // PC13 General Purpose Push Pull Output 2 Mhz
+
+	sampleRingInit(&samples);
+
+	// TIM3 : 1 MHz counter clock, update every 100 counts -> 10 kHz
+	TIM3->CR1 = 0x0000;
+	TIM3->PSC = TIMER_PSC(clockFreq.timApb1clk, 1000000);
+	TIM3->ARR = (1000000 / TICK_HZ) - 1;
+	TIM3->DIER |= (1 << 0);
+	NVIC->IPR[TIM3_IRQn] = 0x10;
+	enableInterrupt(TIM3_IRQn);
+	TIM3->CR1 |= (1 << 0);
+
+	for (step = 0; step < BENCH_STEPS; ++step) {
+		b = &ringBench[step];
+		b->batch = step;
+		benchStep = step;
+
+		// Until the producer is done and the ring is empty
+		while (b->irqs < BENCH_IRQS || sampleRingCount(&samples)) {
+			irqs = ringIrqs;
+			start = PROFILE_DWT->CYCCNT;
+			if (b->batch)
+				n = sampleRingPopBatch(&samples, values, RING_BURST);
+			else
+				n = sampleRingPop(&samples, &values[0]);
+			cycles = PROFILE_DWT->CYCCNT - start;
+
+			if (n && irqs == ringIrqs) {
+				b->popCycles += cycles;
+				b->popMeasured += n;
+			}
+			for (i = 0; i < n; ++i) {
+				if (values[i] != expect)
+					b->errors++;
+				expect = values[i] + 1;
+			}
+			b->popped += n;
+		}
+		benchStep = BENCH_STEPS;
+
+		GPIOC->ODR ^= (1 << GPIO_PIN);
+	}
+
+	ringBenchDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,216 @@
+/*
+ * File Name  : timer_wheel.c Ver 1.0
+ *
+ * Description:
+ *   Timer wheel example : TIM3 update interrupt at 1 kHz drives the
+ *   software timers of twheel.c
+ *
+ *      - blinkTimer toggles PC13 every 500 ms (periodic timer)
+ *      - benchmark : 0, 16, 64 and 256 further timers are armed with
+ *        random timeouts of 1 .. BENCH_MAX_TIMEOUT ms, each callback
+ *        restarts its timer, so the number of armed timers stays the same.
+ *        Cycles of timer3Handler (DWT->CYCCNT, enabled by startup.s) are
+ *        recorded for BENCH_TICKS ticks per step in wheelBench.
+ *
+ *   make wheel (st-util must be running) stops in wheelBenchDone and
+ *   prints wheelBench : armed timers, ticks, callbacks, min/max/total
+ *   cycles. Mean cycles per tick = total / ticks. The blink timer is
+ *   armed in every step (armed + 1 timers).
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * Led Connection Details : PC13
+ *
+ * Build            : make wheel
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "twheel.h"
+
+#define GPIO_PIN					(13)    // LED connected on PC13
+#define TICK_HZ						(1000)  // Wheel tick, TIM3 update rate
+
+#define BENCH_STEPS					(4)
+#define BENCH_TIMERS				(256)   // Largest step
+#define BENCH_TICKS					(2000)  // Ticks measured per step
+#define BENCH_MAX_TIMEOUT			(1000)  // Ticks
+
+typedef struct
+{
+	uint32_t armed;             /* Benchmark timers armed                     */
+	uint32_t ticks;             /* Ticks measured                             */
+	uint32_t callbacks;         /* Timers expired during the step             */
+	uint32_t min;               /* timer3Handler cycles                       */
+	uint32_t max;
+	unsigned long long total;
+} WHEELBENCH_type;
+
+WHEELBENCH_type wheelBench[BENCH_STEPS];
+
+static const uint32_t benchArmed[BENCH_STEPS] = {0, 16, 64, BENCH_TIMERS};
+static volatile uint32_t benchStep = BENCH_STEPS;     // Step measured, BENCH_STEPS : none
+static uint32_t benchSeed = 1;
+
+static TWHEEL_TIMER_type blinkTimer;
+static TWHEEL_TIMER_type benchTimer[BENCH_TIMERS];
+
+/*********** Function declarations ****************/
+void enableInterrupt(IRQn_type IRQn);
+void timer3Handler(void);
+void wheelBenchDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/*
+ * Funtion Name		: enableInterrupt
+ * Description 		: Enable Interrupt for IRQn
+ * Input			: IRQn
+ * Return Value		: None
+*/
+void enableInterrupt(IRQn_type IRQn)
+{
+	NVIC->ISER[((uint32_t)(IRQn) >> 5)] = (1 << ((uint32_t)(IRQn) & 0x1F));
+}
+
+/*
+ * Funtion Name		: benchRandom
+ * Description 		: Pseudo random timeout 1 .. BENCH_MAX_TIMEOUT (LCG)
+ * Input			: None
+ * Return Value		: ticks
+*/
+static uint32_t benchRandom(void)
+{
+	benchSeed = benchSeed * 1664525 + 1013904223;
+	return 1 + (benchSeed >> 8) % BENCH_MAX_TIMEOUT;
+}
+
+/*
+ * Funtion Name		: blinkCallback
+ * Description 		: Toggles PC13 (periodic timer, 500 ms)
+ * Input			: timer
+ * Return Value		: None
+*/
+static void blinkCallback(TWHEEL_TIMER_type *timer)
+{
+	GPIOC->ODR ^= (1 << GPIO_PIN);
+}
+
+/*
+ * Funtion Name		: benchCallback
+ * Description 		: Benchmark timer expired, restarted with a new timeout
+ * Input			: timer
+ * Return Value		: None
+*/
+static void benchCallback(TWHEEL_TIMER_type *timer)
+{
+	if (benchStep < BENCH_STEPS)
+		wheelBench[benchStep].callbacks++;
+	twheelStart(timer, benchRandom(), 0);
+}
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: TIM3 update interrupt, one wheel tick.
+ *					  Records the handler cycles during a benchmark step.
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	uint32_t start = PROFILE_DWT->CYCCNT;
+	uint32_t cycles;
+	WHEELBENCH_type *b;
+
+	// Clear UIF only (rc_w0)
+	TIM3->SR = ~(1 << 0);
+	twheelTick();
+
+	cycles = PROFILE_DWT->CYCCNT - start;
+	if (benchStep < BENCH_STEPS) {
+		b = &wheelBench[benchStep];
+		if (b->ticks < BENCH_TICKS) {
+			b->ticks++;
+			b->total += cycles;
+			if (cycles < b->min)
+				b->min = cycles;
+			if (cycles > b->max)
+				b->max = cycles;
+		}
+	}
+}
+
+/*
+ * Funtion Name		: wheelBenchDone
+ * Description 		: All steps measured, gdb breakpoint for make wheel
+ * Input			: None
+ * Return Value		: None
+*/
+void wheelBenchDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	uint32_t step, i;
+
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK
+	RCC->APB1ENR |= (1 << 1); // Enable Timer 3 CLK
+	GPIOC->CRH |= 0x00200000; // PC13 General Purpose Push Pull Output 2 Mhz
+
+	twheelInit();
+	twheelTimerInit(&blinkTimer, blinkCallback, 0);
+	twheelStart(&blinkTimer, 500, 500);
+	for (i = 0; i < BENCH_TIMERS; ++i)
+		twheelTimerInit(&benchTimer[i], benchCallback, 0);
+
+	// TIM3 : 1 MHz counter clock, update every 1000 counts -> 1 kHz wheel tick
+	TIM3->CR1 = 0x0000;
+	TIM3->PSC = TIMER_PSC(clockFreq.timApb1clk, 1000000);
+	TIM3->ARR = (1000000 / TICK_HZ) - 1;
+	TIM3->DIER |= (1 << 0);
+	NVIC->IPR[TIM3_IRQn] = 0x10;
+	enableInterrupt(TIM3_IRQn);
+	TIM3->CR1 |= (1 << 0);
+
+	for (step = 0; step < BENCH_STEPS; ++step) {
+		wheelBench[step].armed = benchArmed[step];
+		wheelBench[step].min = 0xFFFFFFFF;
+
+		for (i = 0; i < benchArmed[step]; ++i)
+			twheelStart(&benchTimer[i], benchRandom(), 0);
+
+		// Measure from the next tick on
+		benchStep = step;
+		while (wheelBench[step].ticks < BENCH_TICKS)
+			__asm__("wfi");
+		benchStep = BENCH_STEPS;
+
+		for (i = 0; i < benchArmed[step]; ++i)
+			twheelStop(&benchTimer[i]);
+	}
+
+	wheelBenchDone();
+
+	// Only the blink timer is left
+	while(1)
+		__asm__("wfi");
+}
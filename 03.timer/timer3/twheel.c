@@ -0,0 +1,220 @@
+/*
+ * File Name  : twheel.c Ver 1.0
+ *
+ * Description:
+ *   Hierarchical timer wheel, see twheel.h
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+#include "twheel.h"
+
+// Slot of a level for tick number 'ticks'
+#define TWHEEL_INDEX(ticks, level)	(((ticks) >> ((level) * TWHEEL_SLOT_BITS)) & TWHEEL_SLOT_MASK)
+
+static TWHEEL_TIMER_type *twheelSlot[TWHEEL_LEVELS][TWHEEL_SLOTS];
+static volatile uint32_t twheelNext;		// Tick number of the next twheelTick()
+
+/*
+ * Funtion Name		: twheelLink
+ * Description 		: Puts a timer in the slot for its expiry tick,
+ *					  the level is chosen by the ticks left
+ * Input			: timer
+ * Return Value		: None
+*/
+static void twheelLink(TWHEEL_TIMER_type *timer)
+{
+	uint32_t expires = timer->expires;
+	uint32_t left = expires - twheelNext;
+	TWHEEL_TIMER_type **head;
+
+	if ((int32_t) left < 0) {
+		// Expiry tick already passed : runs at the next tick
+		head = &twheelSlot[0][TWHEEL_INDEX(twheelNext, 0)];
+	} else if (left < (1 << TWHEEL_SLOT_BITS)) {
+		head = &twheelSlot[0][TWHEEL_INDEX(expires, 0)];
+	} else if (left < (1 << (2 * TWHEEL_SLOT_BITS))) {
+		head = &twheelSlot[1][TWHEEL_INDEX(expires, 1)];
+	} else if (left < (1 << (3 * TWHEEL_SLOT_BITS))) {
+		head = &twheelSlot[2][TWHEEL_INDEX(expires, 2)];
+	} else {
+		// Further than the wheel : parked in the last slot it reaches, moved down again later
+		if (left > TWHEEL_MAX_TICKS)
+			expires = twheelNext + TWHEEL_MAX_TICKS;
+		head = &twheelSlot[3][TWHEEL_INDEX(expires, 3)];
+	}
+
+	// Insert at the head of the slot list
+	timer->next = *head;
+	if (timer->next)
+		timer->next->pprev = &timer->next;
+	timer->pprev = head;
+	*head = timer;
+}
+
+/*
+ * Funtion Name		: twheelUnlink
+ * Description 		: Removes a timer from its slot list
+ * Input			: timer
+ * Return Value		: None
+*/
+static void twheelUnlink(TWHEEL_TIMER_type *timer)
+{
+	*timer->pprev = timer->next;
+	if (timer->next)
+		timer->next->pprev = timer->pprev;
+	timer->next = 0;
+	timer->pprev = 0;
+}
+
+/*
+ * Funtion Name		: twheelCascade
+ * Description 		: Moves the timers of one slot of 'level' down to
+ *					  the lower levels
+ * Input			: level, slot index
+ * Return Value		: slot index (0 : the next level has to be moved too)
+*/
+static uint32_t twheelCascade(uint32_t level, uint32_t index)
+{
+	TWHEEL_TIMER_type *list = twheelSlot[level][index];
+	TWHEEL_TIMER_type *timer;
+
+	twheelSlot[level][index] = 0;
+	while (list) {
+		timer = list;
+		list = list->next;
+		twheelLink(timer);
+	}
+	return index;
+}
+
+/*
+ * Funtion Name		: twheelInit
+ * Description 		: Empties the wheel, tick number 0
+ * Input			: None
+ * Return Value		: None
+*/
+void twheelInit(void)
+{
+	uint32_t level, slot;
+
+	for (level = 0; level < TWHEEL_LEVELS; ++level)
+		for (slot = 0; slot < TWHEEL_SLOTS; ++slot)
+			twheelSlot[level][slot] = 0;
+	twheelNext = 0;
+}
+
+/*
+ * Funtion Name		: twheelTimerInit
+ * Description 		: Sets callback and argument of a stopped timer
+ * Input			: timer, callback, arg
+ * Return Value		: None
+*/
+void twheelTimerInit(TWHEEL_TIMER_type *timer, void (*callback)(TWHEEL_TIMER_type *timer), void *arg)
+{
+	timer->next = 0;
+	timer->pprev = 0;
+	timer->expires = 0;
+	timer->period = 0;
+	timer->callback = callback;
+	timer->arg = arg;
+}
+
+/*
+ * Funtion Name		: twheelStart
+ * Description 		: (Re)starts a timer. The callback runs at the
+ *					  'ticks'-th twheelTick() from now, then every 'period'
+ *					  ticks if period is not 0. ticks 0 is taken as 1.
+ * Input			: timer, ticks, period
+ * Return Value		: None
+*/
+void twheelStart(TWHEEL_TIMER_type *timer, uint32_t ticks, uint32_t period)
+{
+	__asm__("cpsid i");
+	if (timer->pprev)
+		twheelUnlink(timer);
+	timer->expires = twheelNext + (ticks ? ticks - 1 : 0);
+	timer->period = period;
+	twheelLink(timer);
+	__asm__("cpsie i");
+}
+
+/*
+ * Funtion Name		: twheelStop
+ * Description 		: Stops a timer, nothing happens if it is not running
+ * Input			: timer
+ * Return Value		: None
+*/
+void twheelStop(TWHEEL_TIMER_type *timer)
+{
+	__asm__("cpsid i");
+	if (timer->pprev)
+		twheelUnlink(timer);
+	__asm__("cpsie i");
+}
+
+/*
+ * Funtion Name		: twheelActive
+ * Description 		: Timer is running
+ * Input			: timer
+ * Return Value		: 1 running, 0 stopped
+*/
+uint32_t twheelActive(TWHEEL_TIMER_type *timer)
+{
+	return timer->pprev != 0;
+}
+
+/*
+ * Funtion Name		: twheelTicks
+ * Description 		: Number of twheelTick() calls since twheelInit
+ * Input			: None
+ * Return Value		: ticks
+*/
+uint32_t twheelTicks(void)
+{
+	return twheelNext;
+}
+
+/*
+ * Funtion Name		: twheelTick
+ * Description 		: Advances the wheel by one tick and runs the callbacks
+ *					  of the timers that expire. Call from the periodic
+ *					  interrupt (TIM3 update, SysTick).
+ * Input			: None
+ * Return Value		: None
+*/
+void twheelTick(void)
+{
+	uint32_t now = twheelNext;
+	uint32_t index = TWHEEL_INDEX(now, 0);
+	uint32_t level;
+	TWHEEL_TIMER_type *expired;
+	TWHEEL_TIMER_type *timer;
+
+	// Level 0 went round : move the next slot of level 1 down, and so on
+	if (index == 0)
+		for (level = 1; level < TWHEEL_LEVELS; ++level)
+			if (twheelCascade(level, TWHEEL_INDEX(now, level)) != 0)
+				break;
+
+	// Take the whole slot, a callback may stop other timers of it
+	expired = twheelSlot[0][index];
+	twheelSlot[0][index] = 0;
+	if (expired)
+		expired->pprev = &expired;
+	twheelNext = now + 1;
+
+	while (expired) {
+		timer = expired;
+		twheelUnlink(timer);
+		if (timer->period) {
+			timer->expires += timer->period;
+			twheelLink(timer);
+		}
+		timer->callback(timer);
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef TWHEEL_H
+#define TWHEEL_H
+
+/*
+ * File Name  : twheel.h Ver 1.0
+ *
+ * Description:
+ *   Hierarchical timer wheel : many software timers on one periodic
+ *   interrupt (TIM3 update or SysTick), callbacks run from that interrupt
+ *
+ *   4 levels of 64 slots. A timer is kept in the level that matches the
+ *   ticks left until it expires :
+ *
+ *      level 0 :          0 ..         63 ticks, one slot per tick
+ *      level 1 :         64 ..      4 095 ticks, one slot per      64 ticks
+ *      level 2 :      4 096 ..    262 143 ticks, one slot per   4 096 ticks
+ *      level 3 :    262 144 .. 16 777 215 ticks, one slot per 262 144 ticks
+ *
+ *   Every tick runs the timers of one level 0 slot. Every 64 ticks the
+ *   next slot of level 1 is moved down to level 0 (and so on up the levels),
+ *   so a timer is moved at most 3 times. Slots are lists without sorting :
+ *   twheelStart and twheelStop are O(1), a tick costs the timers it runs
+ *   plus the timers moved down, not the number of armed timers.
+ *
+ *   Timers are TWHEEL_TIMER_type variables of the application (static or
+ *   global), there is no heap. At 1 kHz the longest timeout is 4.6 hours,
+ *   longer timeouts are moved down again until they are reached.
+ *
+ *      static TWHEEL_TIMER_type blink;
+ *
+ *      twheelInit();
+ *      twheelTimerInit(&blink, blinkCallback, 0);
+ *      twheelStart(&blink, 500, 500);      // after 500 ticks, then every 500
+ *
+ *      void timer3Handler(void)            // 1 kHz update interrupt
+ *      {
+ *          TIM3->SR = ~(1 << 0);
+ *          twheelTick();
+ *      }
+ *
+ *   Callbacks run in the tick interrupt and may start or stop any timer,
+ *   also their own. twheelStart/twheelStop are called from main or from
+ *   callbacks, not from interrupts with a higher priority than the tick.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#define TWHEEL_LEVELS			4
+#define TWHEEL_SLOT_BITS		6
+#define TWHEEL_SLOTS			(1 << TWHEEL_SLOT_BITS)
+#define TWHEEL_SLOT_MASK		(TWHEEL_SLOTS - 1)
+#define TWHEEL_MAX_TICKS		((1 << (TWHEEL_LEVELS * TWHEEL_SLOT_BITS)) - 1)
+
+typedef struct TWHEEL_TIMER
+{
+	struct TWHEEL_TIMER *next;      /* Next timer in the slot                          */
+	struct TWHEEL_TIMER **pprev;    /* Pointer that points to this timer, 0 : stopped  */
+	uint32_t expires;               /* Tick number the callback runs at                */
+	uint32_t period;                /* Restart after this many ticks, 0 : one shot     */
+	void (*callback)(struct TWHEEL_TIMER *timer);
+	void *arg;                      /* For the callback                                */
+} TWHEEL_TIMER_type;
+
+void twheelInit(void);
+void twheelTimerInit(TWHEEL_TIMER_type *timer, void (*callback)(TWHEEL_TIMER_type *timer), void *arg);
+void twheelStart(TWHEEL_TIMER_type *timer, uint32_t ticks, uint32_t period);
+void twheelStop(TWHEEL_TIMER_type *timer);
+uint32_t twheelActive(TWHEEL_TIMER_type *timer);
+uint32_t twheelTicks(void);
+void twheelTick(void);
+
+#endif
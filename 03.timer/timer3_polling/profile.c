@@ -0,0 +1,123 @@
+/*
+ * File Name  : profile.c Ver 1.0
+ *
+ * Description:
+ *   DWT->CYCCNT region profiling, see profile.h
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#ifndef uint32_t
+#define uint32_t        unsigned int
+#endif
+
+#include "profile.h"
+
+PROFILE_type profileTable[PROFILE_MAX_REGIONS];
+uint32_t profileOverhead;
+
+/*
+ * Funtion Name		: profileInit
+ * Description 		: Enables DWT cycle counter and measures cost of an
+ *					  empty BEGIN/END pair (removed from every measurement)
+ *					  Clears all regions.
+ * Input			: None
+ * Return Value		: None
+*/
+void profileInit(void)
+{
+	uint32_t i;
+
+	// CoreDebug->DEMCR TRCENA : enable DWT block, then start CYCCNT
+	COREDEBUG_DEMCR |= DEMCR_TRCENA;
+	PROFILE_DWT->CTRL |= DWT_CTRL_CYCCNTENA;
+
+	profileOverhead = 0;
+	for (i = 0; i < PROFILE_MAX_REGIONS; ++i) {
+		profileTable[i].name = 0;
+		profileTable[i].count = 0;
+		profileTable[i].min = 0xFFFFFFFF;
+		profileTable[i].max = 0;
+		profileTable[i].total = 0;
+	}
+
+	// Region 0 is used for the calibration, smallest of 8 empty pairs
+	for (i = 0; i < 8; ++i) {
+		profileBegin(0);
+		profileEnd(0);
+	}
+	profileOverhead = profileTable[0].min;
+
+	profileTable[0].count = 0;
+	profileTable[0].min = 0xFFFFFFFF;
+	profileTable[0].max = 0;
+	profileTable[0].total = 0;
+}
+
+/*
+ * Funtion Name		: profileName
+ * Description 		: Name of a region, printed by profile.gdb
+ * Input			: region number, name (string constant)
+ * Return Value		: None
+*/
+void profileName(uint32_t region, const char *name)
+{
+	if (region < PROFILE_MAX_REGIONS)
+		profileTable[region].name = name;
+}
+
+/*
+ * Funtion Name		: profileBegin
+ * Description 		: Start of region, CYCCNT is read as the last instruction
+ * Input			: region number
+ * Return Value		: None
+*/
+void profileBegin(uint32_t region)
+{
+	if (region < PROFILE_MAX_REGIONS)
+		profileTable[region].start = PROFILE_DWT->CYCCNT;
+}
+
+/*
+ * Funtion Name		: profileEnd
+ * Description 		: End of region, CYCCNT is read first and statistics
+ *					  are updated. Calls profileReport when the region
+ *					  reaches PROFILE_REPORT_COUNT measurements.
+ * Input			: region number
+ * Return Value		: None
+*/
+void profileEnd(uint32_t region)
+{
+	uint32_t cycles = PROFILE_DWT->CYCCNT;
+	PROFILE_type *p;
+
+	if (region >= PROFILE_MAX_REGIONS)
+		return;
+
+	p = &profileTable[region];
+	cycles -= p->start;	// Unsigned difference, correct across one CYCCNT wrap
+	cycles = (cycles > profileOverhead) ? (cycles - profileOverhead) : 0;
+
+	p->count++;
+	p->total += cycles;
+	if (cycles < p->min)
+		p->min = cycles;
+	if (cycles > p->max)
+		p->max = cycles;
+
+	if (p->count == PROFILE_REPORT_COUNT)
+		profileReport();
+}
+
+/*
+ * Funtion Name		: profileReport
+ * Description 		: Breakpoint for profile.gdb (make profile), does nothing
+ * Input			: None
+ * Return Value		: None
+*/
+void profileReport(void)
+{
+}
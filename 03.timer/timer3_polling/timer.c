@@ -21,13 +21,14 @@
  *
  *      Ext. Clock Freq     :   8 MHz   
  *      Int. Default Freq   :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
  *
  * Led Connection Details : PC13 
  *
  * Step for generating bin : make
  *  
- * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c timer.c
- * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld timer.o -o timer.elf 
+ * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c timer.c clock.c
+ * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld timer.o clock.o -o timer.elf 
  * ELF to Hex       : arm-none-eabi-objcopy -O ihex timer.elf 
  * ELF to Bin       : arm-none-eabi-objcopy -O binary timer.elf
  * Clean            : rm timer.elf timer.hex timer.bin
@@ -39,12 +40,13 @@
 
 /*************STEPS for Timer 3 **********************
 
+0.	Switch system clock to 72 MHz (clockInit72MHz)
 1.	Enable Clock for GPIOC Port
 2.	Configure PC13 pin as Output Push Pull
 
 3.  Reset Control Register 1
-4.  Setting PSC to 7999 (dividing 8000 to generate 1Mhz Clock)
-5.  Load Automatic Reload Register (APR) to 1000 for 1 Second
+4.  Setting PSC from timer clock to generate 1Mhz timer tick
+5.  Load Automatic Reload Register (APR) to maximum value
 9.	Finally enable TIM3 module
 
 10. Set timer 3 handler in IVT if interrupt is enabled.
@@ -55,9 +57,13 @@
 
 /********** stm32f1 Register Address and Structures  ***************/
 #include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
 
 #define GPIO_PIN					(13)  // LED connected on PC13
 
+#define PROF_DELAY_MS				(0)   // Profile region (make profile)
+
 /*********** Function declarations ****************/
 int32_t main(void);
 void delayMS(volatile uint32_t s);
@@ -68,7 +74,7 @@ void delayMS(volatile uint32_t s);
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vector"))) = {
 	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
-	(uint32_t *) main,              /* 0x004 Reset                           */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
 	0,                              /* 0x008 Non maskable interrupt          */
 };
 
@@ -97,12 +103,19 @@ void delayMS(volatile uint32_t uiTime)
 *************************************************/
 int32_t main(void)
 {
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
    	//  Register RCC->APB2ENR
 	// Enabling Clock for GPIOC RCC Register
     //  15     14     13   12   11    10    09    08   07   06    05    04    03   02    01   00
     //  Res    USERT  Res  SP1  TIM1  ADC2  ADC1  Res  Res  IOPE  IOPD  IOPC IOPB  IOPA  Res  AFIO
     //         1EN    -    EN   EN    EN    EN              EN    EN    EN   EN    EN         EN
 
+	// Cycle counter and region names, empty without -DPROFILE
+	PROFILE_INIT();
+	PROFILE_NAME(PROF_DELAY_MS, "delayMS(100)");
+
     RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK
 	RCC->APB1ENR |= (1 << 1); // Enable Timer 3 CLK
 
@@ -124,8 +137,8 @@ int32_t main(void)
     // 16 Bit PSC Register 
 	//Setting PSC
 	// fCK_PSC / (PSC[15:0] + 1)
-	// 8 Mhz / 7 + 1 = 1 Mhz timer clock speed
-	TIM3->PSC = 7;
+	// 72 Mhz / 71 + 1 = 1 Mhz timer clock speed
+	TIM3->PSC = TIMER_PSC(clockFreq.timApb1clk, 1000000);
 
 	// Timer 3 Auto Reload Register (APR) 16 Bit
     TIM3->ARR = 0xFFFF; //Setting APR to maximum value. Time will be controlleed in delayMS function
@@ -134,7 +147,9 @@ int32_t main(void)
 	TIM3->CR1 |= (1 << 0); //Enable CEN Bit
 
 	while(1){
+		PROFILE_BEGIN(PROF_DELAY_MS);
 		delayMS(100);
+		PROFILE_END(PROF_DELAY_MS);
 		GPIOC->ODR ^= (1 << 13);
 	}
 	
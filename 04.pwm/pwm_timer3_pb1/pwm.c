@@ -18,6 +18,7 @@
  *
  *      Ext. Clock Freq     :   8 MHz   
  *      Int. Default Freq   :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
  *
  * Led Connection Details : PC13 
  *							Connect External LED +v Terminal -> 3.3 V
@@ -25,8 +26,8 @@
  *
  * Step for generating bin : make
  *  
- * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c pwm.c
- * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld pwm.o -o pwm.elf 
+ * Compile          : arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -O0 -Wall -c pwm.c clock.c
+ * Link and Locate  : arm-none-eabi-gcc  -march=armv7-m -nostartfiles --specs=nosys.specs -T stm32f103.ld pwm.o clock.o -o pwm.elf 
  * ELF to Hex       : arm-none-eabi-objcopy -O ihex pwm.elf 
  * ELF to Bin       : arm-none-eabi-objcopy -O binary pwm.elf
  * Clean            : rm pwm.elf pwm.hex pwm.bin
@@ -38,13 +39,14 @@
 
 /*************STEPS for Timer 3  and PWM **********************
 
+0.	Switch system clock to 72 MHz (clockInit72MHz)
 1.	Enable Clock for GPIOC Port,GPIO B, Alternate Function  and Timer 3 Block
 2.	Configure PC13 pin as Output Push Pull
 
 3.  Configure AFIO REMAP Register (Write 00 as no remapping required for pb1)
 4.  Reset Control Register 1
-5.  Setting PSC to 7999 (dividing 8000 to generate 1Mhz Clock)
-6.  Load Automatic Reload Register (APR) to 1000 (PWM Period)
+5.  Setting PSC from timer clock to generate 10 KHz timer tick
+6.  Load Automatic Reload Register (APR) to 10000 ticks (PWM Period)
 7.  Write CCR4 with duty cycle of PWM
 8.  Enable Update Interrupt (DIER) Register
 9.  Set Preload Enable and PWM Mode in CCMR2
@@ -59,9 +61,14 @@
 
 /********** stm32f1 Register Address and Structures  ***************/
 #include "stm32f1reg.h"
+#include "bitband.h"
+#include "clock.h"
+#include "profile.h"
 
 #define GPIO_PIN					(13)  // LED connected on PC13
 
+#define PROF_TIMER3_HANDLER			(0)   // Profile region (make profile)
+
 /*********** Function declarations ****************/
 // Function declarations. Add your functions here
 void enableInterrupt(IRQn_type IRQn);
@@ -105,19 +112,27 @@ void disableInterrupt(IRQn_type IRQn)
  *					  Initialized in Interrupt Vector Table
  *                    Toggles output at PC13
  *                    clear pending Bit in Status Regiser
+ *                    Both are done without read-modify-write of the full register
  * Input			: None
  * Return Value		: None
 */
 void timer3Handler(void)
 {
-    TIM3->CCR4 = 100;
-    GPIOC->ODR ^= (1 << 13);    
+	// Handler body only, interrupt entry/exit (12 cycles each) not included
+	PROFILE_BEGIN(PROF_TIMER3_HANDLER);
+
+    // CCR4 is preloaded (OC4PE) and keeps its value : no rewrite here
+    // PC13 bit-band alias : only ODR bit 13 is written back
+    BITBAND_PERIPH(&GPIOC->ODR, 13) ^= 1;
 
 	// Timer 3 Status Regiser
 	//	15-13	12		11		10		09		08 -07		06		05		04		03		02		01		00
 	//  Res		CC4OF 	CC3OF 	CC2OF 	CC1OF	Res			TIF 	Res		CC4IF 	CC3IF 	CC2IF 	CC1IF 	UIF 
-	// Clear pending bit
-	TIM3->SR &= ~(1 << 4);
+	// Clear pending bit : rc_w0, writing 1 to other flags has no effect
+	// Single store, a flag set during the handler is not lost (SR &= ~x could lose it)
+	TIM3->SR = ~(1 << 4);
+
+	PROFILE_END(PROF_TIMER3_HANDLER);
 }
 
 /*************************************************
@@ -125,6 +140,13 @@ void timer3Handler(void)
 *************************************************/
 int32_t main(void)
 {
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	// Cycle counter and region names, empty without -DPROFILE
+	PROFILE_INIT();
+	PROFILE_NAME(PROF_TIMER3_HANDLER, "timer3Handler");
+
    	//  Register RCC->APB2ENR
 	// Enabling Clock for GPIOC RCC Register
     //  15     14     13   12   11    10    09    08   07   06    05    04    03   02    01   00
@@ -160,13 +182,13 @@ int32_t main(void)
     // 16 Bit PSC Register 
 	//Setting PSC
 	// fCK_PSC / (PSC[15:0] + 1)
-	// 8 Mhz / 7999 + 1 = 8000 -> 1 KHz timer clock speed
-	TIM3->PSC = 7999; // 1KHz
+	// 72 Mhz / 7199 + 1 = 7200 -> 10 KHz timer clock speed
+	TIM3->PSC = TIMER_PSC(clockFreq.timApb1clk, 10000); // 10KHz
 
 	// Timer 3 Auto Reload Register (APR) 16 Bit
-    TIM3->ARR = 1000; // 1 Second PWM Period
+    TIM3->ARR = 10000 - 1; // 1 Second PWM Period
 
-    TIM3->CCR4 = 100; // 100 ms PWM Duty Cycle
+    TIM3->CCR4 = 1000; // 100 ms PWM Duty Cycle
         
     // Enable Update Interrupt (DIER)
 //	15	14	13	12		11		10		09		08	07	06	05	04		03		02		01		00
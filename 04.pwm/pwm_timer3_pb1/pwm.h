@@ -15,7 +15,7 @@
 #define uint16_t        unsigned short
 #define uint8_t         unsigned char
 
-#define HSE_Value       ((uint32_t) 25000000) /* Value of the External oscillator in Hz */
+#define HSE_Value       ((uint32_t)  8000000) /* Value of the External oscillator in Hz (Blue Pill crystal) */
 #define HSI_Value       ((uint32_t)  8000000) /* Value of the Internal oscillator in Hz*/
 
 // Define the base addresses for peripherals
@@ -46,7 +46,10 @@
 #define NVIC_BASE       ((uint32_t) 0xE000E100)
 
 
-#define STACKINIT       0x20002000
+// Stack top (_estack) is defined in the linker script, Reset_Handler in startup.s
+extern uint32_t _estack;
+void Reset_Handler(void);
+#define STACKINIT       (&_estack)
 #define DELAY           7200000
 
 
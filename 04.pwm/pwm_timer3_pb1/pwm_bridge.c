@@ -0,0 +1,177 @@
+/*
+ * File Name  : pwm_bridge.c Ver 1.0
+ *
+ * Description:
+ *   Three phase bridge PWM on TIM1 : complementary outputs, dead-time,
+ *   center-aligned, software and hardware break (tim1bridge.c)
+ *
+ *   The three legs run at 20 kHz center-aligned with 500 ns dead-time
+ *   and 25 / 50 / 75 % duty. Every run of BRIDGE_RUN_PERIODS periods
+ *   polls the six outputs and counts the samples where the high and low
+ *   side of a leg are on together (overlaps, must stay 0). Then :
+ *
+ *      - bridgeBreak : all outputs low at once, bridgeResume restarts them
+ *      - fault : BKIN (PB12, active low) pulled low by switching its pull
+ *        resistor to pull-down, as the fault output of a gate driver
+ *        would. The outputs are low right after the write, bridgeResume
+ *        fails while BKIN is low and works once it is released.
+ *
+ *   bridgeResult holds the timing obtained, the output pins after each
+ *   break (bits 0-2 PA8-PA10, bits 3-5 PB13-PB15, 0 : all off), the
+ *   results of bridgeResume and the overlaps.
+ *
+ *   make bridge (st-util must be running) stops in pwmBridgeDone and
+ *   prints bridgeResult.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * High side gates        : PA8, PA9, PA10 (TIM1 CH1-CH3)
+ * Low side gates         : PB13, PB14, PB15 (TIM1 CH1N-CH3N)
+ * Fault input            : PB12 (TIM1 BKIN, active low, internal pull-up)
+ *
+ * Build            : make bridge
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "tim3pwm.h"
+#include "tim1bridge.h"
+
+#define BRIDGE_HZ				(20000)
+#define BRIDGE_DEAD_NS			(500)
+#define BRIDGE_RUN_PERIODS		(200)     // 10 ms
+#define BRIDGE_OFF_PERIODS		(20)      // 1 ms
+
+typedef struct
+{
+	uint32_t hz;                /* PWM frequency obtained                     */
+	uint32_t steps;             /* Duty steps (ARR)                           */
+	uint32_t deadNs;            /* Dead-time obtained                         */
+	uint32_t dtg;               /* BDTR DTG                                   */
+	uint32_t breakPins;         /* Outputs after bridgeBreak                  */
+	uint32_t breakResume;       /* bridgeResume after it, 1 expected          */
+	uint32_t faultPins;         /* Outputs after BKIN went low                */
+	uint32_t faultResume;       /* bridgeResume while BKIN is low, 0 expected */
+	uint32_t faultRestart;      /* bridgeResume after BKIN high, 1 expected   */
+	uint32_t samples;           /* Output samples taken while running         */
+	uint32_t overlaps;          /* High and low side of a leg on together     */
+} BRIDGERESULT_type;
+
+BRIDGERESULT_type bridgeResult;
+
+static const uint16_t legDuty[BRIDGE_CHANNELS] = {2500, 5000, 7500};
+
+/*********** Function declarations ****************/
+void timer3Handler(void);
+void pwmBridgeDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: Not used, the TIM3 interrupt stays off
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	TIM3->SR = 0;
+}
+
+/*
+ * Funtion Name		: bridgePins
+ * Description 		: Levels of the six outputs
+ * Input			: None
+ * Return Value		: bits 0-2 PA8-PA10 (high side), 3-5 PB13-PB15 (low side)
+*/
+static uint32_t bridgePins(void)
+{
+	return ((GPIOA->IDR >> 8) & 0x7) | (((GPIOB->IDR >> 13) & 0x7) << 3);
+}
+
+/*
+ * Funtion Name		: bridgeRun
+ * Description 		: Waits 'periods' update events (one per period), the
+ *					  outputs sampled meanwhile
+ * Input			: periods
+ * Return Value		: None
+*/
+static void bridgeRun(uint32_t periods)
+{
+	uint32_t pins;
+
+	TIM1->SR = ~1u;
+	while (periods) {
+		if (TIM1->SR & 1) {
+			TIM1->SR = ~1u;                     // UIF only, BIF kept
+			periods--;
+		}
+		pins = bridgePins();
+		bridgeResult.samples++;
+		if (pins & (pins >> 3) & 0x7)
+			bridgeResult.overlaps++;
+	}
+}
+
+/*
+ * Funtion Name		: pwmBridgeDone
+ * Description 		: Result filled, gdb breakpoint for make bridge
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmBridgeDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	BRIDGERESULT_type *r = &bridgeResult;
+
+	// SYSCLK 72 MHz, APB2 72 MHz -> TIM1 clock 72 MHz
+	clockInit72MHz();
+
+	r->hz = bridgeStart(BRIDGE_HZ, BRIDGE_DEAD_NS, BRIDGE_CH1 | BRIDGE_CH2 | BRIDGE_CH3,
+						BRIDGE_CENTER | BRIDGE_BREAK_LOW);
+	r->steps = bridgeTiming.pwm.steps;
+	r->deadNs = bridgeTiming.deadNs;
+	r->dtg = bridgeTiming.dtg;
+	bridgeSetDuties(legDuty);
+	bridgeRun(BRIDGE_RUN_PERIODS);
+
+	// Software break
+	bridgeBreak();
+	r->breakPins = bridgePins();
+	bridgeRun(BRIDGE_OFF_PERIODS);
+	r->breakResume = bridgeResume();
+	bridgeRun(BRIDGE_RUN_PERIODS);
+
+	// Fault : BKIN low through the pull-down
+	GPIOB->ODR &= ~(1 << 12);
+	r->faultPins = bridgePins();
+	r->faultResume = bridgeResume();
+	bridgeRun(BRIDGE_OFF_PERIODS);
+	GPIOB->ODR |= (1 << 12);
+	r->faultRestart = bridgeResume();
+	bridgeRun(BRIDGE_RUN_PERIODS);
+
+	pwmBridgeDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,189 @@
+/*
+ * File Name  : pwm_burst.c Ver 1.0
+ *
+ * Description:
+ *   TIM3 DMA burst : precomputed tables of ARR and CCR1-CCR4 streamed into
+ *   the timer on every update event, no interrupt
+ *
+ *      - step 0 : frequency sweep, SWEEP_ROWS rows of ARR + CCR1-4 from
+ *                 1 kHz to 2 kHz at 50 %, sent once. burstSweep holds the
+ *                 DWT cycles from the first to the last row and the cycles
+ *                 the table predicts : a row takes effect one period after
+ *                 it is sent, the first period is the one before the table
+ *      - step 1 : 20 kHz, a table of STREAM_ROWS rows of CCR1-4 repeated
+ *                 (circular DMA), each channel a triangle of +-5 % around
+ *                 20 / 40 / 60 / 80 %. burstStream holds the rows per
+ *                 second and the CPU cycles of pwmBurstStart, the only
+ *                 CPU time of the stream
+ *
+ *   Written by an update interrupt (pwm_multi.c step 0) step 1 would take
+ *   20000 interrupts per second; with the burst the CPU only sleeps.
+ *
+ *   make burst (st-util must be running) stops in pwmBurstDone and prints
+ *   burstSweep and burstStream, the stream keeps running.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * PWM outputs            : PA6, PA7, PB0, PB1 (TIM3 CH1-CH4)
+ *
+ * Build            : make burst
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "tim3pwm.h"
+#include "tim3burst.h"
+
+#define SWEEP_HZ_START			(1000)
+#define SWEEP_HZ_END			(2000)
+#define SWEEP_ROWS				(32)
+#define STREAM_HZ				(20000)
+#define STREAM_ROWS				(64)      // 312.5 Hz triangle at 20 kHz
+
+typedef struct
+{
+	uint32_t rows;              /* Rows sent                                  */
+	uint32_t cycles;            /* First to last row, DWT                     */
+	uint32_t expected;          /* From the table                             */
+} BURSTSWEEP_type;
+
+typedef struct
+{
+	uint32_t hz;                /* Rows per second                            */
+	uint32_t rows;              /* Rows of the table                          */
+	uint32_t setupCycles;       /* pwmBurstStart                              */
+} BURSTSTREAM_type;
+
+BURSTSWEEP_type burstSweep;
+BURSTSTREAM_type burstStream;
+
+static const uint16_t streamCenter[PWM_CHANNELS] = {2000, 4000, 6000, 8000};
+
+static PWM_BURST_ARR_ROW_type sweepTable[SWEEP_ROWS];
+static PWM_BURST_ROW_type streamTable[STREAM_ROWS];
+
+/*********** Function declarations ****************/
+void timer3Handler(void);
+void pwmBurstDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: Not used, the TIM3 interrupt stays off
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	TIM3->SR = 0;
+}
+
+/*
+ * Funtion Name		: sweepPrepare
+ * Description 		: Rows of the sweep : ARR of SWEEP_HZ_START .. SWEEP_HZ_END
+ *					  at the running prescaler, CCRx half the period
+ * Input			: None
+ * Return Value		: cycles the table takes, first period included
+*/
+static uint32_t sweepPrepare(void)
+{
+	uint32_t tick = clockFreq.timApb1clk / (pwmTiming.psc + 1);
+	uint32_t row, ch, hz, steps;
+	uint32_t ticks = pwmTiming.steps;      // Period before the table
+
+	for (row = 0; row < SWEEP_ROWS; row++) {
+		hz = SWEEP_HZ_START + row * (SWEEP_HZ_END - SWEEP_HZ_START) / (SWEEP_ROWS - 1);
+		steps = tick / hz;
+		sweepTable[row].arr = steps - 1;
+		sweepTable[row].rcr = 0;
+		for (ch = 0; ch < PWM_CHANNELS; ch++)
+			sweepTable[row].ccr[ch] = steps / 2;
+		// Row n sent at update event n + 1 sets the period after event n + 2
+		if (row + 2 < SWEEP_ROWS)
+			ticks += steps;
+	}
+
+	return (unsigned long long) ticks * (pwmTiming.psc + 1) * clockFreq.sysclk / clockFreq.timApb1clk;
+}
+
+/*
+ * Funtion Name		: streamPrepare
+ * Description 		: Rows of the stream : per channel a triangle of +-5 %
+ *					  around its center duty, in ticks of the running period
+ * Input			: None
+ * Return Value		: None
+*/
+static void streamPrepare(void)
+{
+	uint32_t row, ch, phase, duty;
+
+	for (row = 0; row < STREAM_ROWS; row++) {
+		// 0 .. STREAM_ROWS / 2 .. 0
+		phase = (row < STREAM_ROWS / 2) ? row : STREAM_ROWS - row;
+		for (ch = 0; ch < PWM_CHANNELS; ch++) {
+			duty = streamCenter[ch] - 500 + phase * 1000 / (STREAM_ROWS / 2);
+			streamTable[row].ccr[ch] = duty * pwmTiming.steps / PWM_DUTY_FULL;
+		}
+	}
+}
+
+/*
+ * Funtion Name		: pwmBurstDone
+ * Description 		: Results filled, gdb breakpoint for make burst
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmBurstDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	uint32_t start;
+
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	// Step 0 : frequency sweep sent once
+	pwmStart(SWEEP_HZ_START, PWM_CH1 | PWM_CH2 | PWM_CH3 | PWM_CH4, 0);
+	burstSweep.expected = sweepPrepare();
+	pwmBurstStart(sweepTable, SWEEP_ROWS, PWM_BURST_ARR);
+	while (pwmBurstRows() == 0);
+	start = PROFILE_DWT->CYCCNT;
+	while (pwmBurstBusy());
+	burstSweep.cycles = PROFILE_DWT->CYCCNT - start;
+	burstSweep.rows = pwmBurstRows();
+	pwmBurstStop();
+
+	// Step 1 : repeated table at 20 kHz
+	pwmSetFrequency(STREAM_HZ);
+	streamPrepare();
+	start = PROFILE_DWT->CYCCNT;
+	pwmBurstStart(streamTable, STREAM_ROWS, PWM_BURST_LOOP);
+	burstStream.setupCycles = PROFILE_DWT->CYCCNT - start;
+	burstStream.hz = pwmTiming.hz;
+	burstStream.rows = STREAM_ROWS;
+
+	pwmBurstDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,178 @@
+/*
+ * File Name  : pwm_capture.c Ver 1.0
+ *
+ * Description:
+ *   Frequency and duty of a signal by TIM2 input capture and DMA
+ *   (tim2capture.c), the signal made by TIM3 CH1 PWM (tim3pwm.c)
+ *
+ *   PA6 (TIM3 CH1) is wired to PA0 (TIM2 CH1). Each step starts the PWM
+ *   at a frequency and duty, starts the measurement for a range around
+ *   it, waits for the first measurement (CAP_WINDOW + 1 rising edges
+ *   captured) and CAPTURE_UPDATES results more, and reads the newest
+ *   one. The last step holds PA6 low (duty 0) : it must read 0 Hz.
+ *
+ *   captureResult holds per step the frequency and duty set, the
+ *   frequency (Hz and 0.001 Hz), duty (0.01 %) and high time measured,
+ *   the periods averaged and the input prescaler; captureStats the
+ *   interrupt counts of the last step. The CPU sleeps while measuring,
+ *   it wakes for the TIM2 update interrupt only.
+ *
+ *   make capture (st-util must be running) stops in pwmCaptureDone and
+ *   prints captureResult.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * Signal output          : PA6 (TIM3 CH1)
+ * Measured input         : PA0 (TIM2 CH1), jumper PA6 - PA0
+ *
+ * Build            : make capture
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "tim3pwm.h"
+#include "tim2capture.h"
+
+#define CAPTURE_STEPS			(5)
+#define CAPTURE_UPDATES			(4)       // Results waited after the first measurement
+#define CAPTURE_TIMEOUT			(16)      // Results waited for the first measurement
+
+typedef struct
+{
+	uint32_t setHz;             /* PWM frequency obtained                     */
+	uint32_t setDuty;           /* PWM duty in 0.01 %                         */
+	uint32_t edges;             /* Edges per capture (input prescaler)        */
+	uint32_t hz;                /* Measured                                   */
+	uint32_t millihertz;
+	uint32_t duty;
+	uint32_t highNs;
+	uint32_t periods;           /* Signal periods averaged                    */
+} CAPTURESTEP_type;
+
+typedef struct
+{
+	uint32_t hz;                /* Signal                                     */
+	uint32_t duty;
+	uint32_t minHz;             /* Range given to capStart                    */
+	uint32_t maxHz;
+} CAPTURESETUP_type;
+
+CAPTURESTEP_type captureResult[CAPTURE_STEPS];
+CAP_STATS_type captureStats;
+
+static const CAPTURESETUP_type captureSetup[CAPTURE_STEPS] = {
+	{   1000, 2500,    500,    2000},
+	{ 100000, 7500,  50000,  200000},
+	{1000000, 2000, 500000, 2000000},
+	{6000000, 5000, 3000000, 8000000},
+	{   1000,    0,    500,    2000},   // PA6 held low : no signal
+};
+
+/*********** Function declarations ****************/
+void timer3Handler(void);
+void pwmCaptureDone(void);
+int32_t main(void);
+
+#define IVT_TIM2					capTimerHandler
+#include "stm32f1ivt.h"
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: Not used, the TIM3 interrupt stays off
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	TIM3->SR = 0;
+}
+
+/*
+ * Funtion Name		: captureWait
+ * Description 		: Sleeps until 'updates' more results are published;
+ *					  interrupts masked around the test so the update
+ *					  interrupt cannot fall between test and WFI
+ * Input			: updates
+ * Return Value		: None
+*/
+static void captureWait(uint32_t updates)
+{
+	updates += capStats.updates;
+	__asm__("cpsid i");
+	while (capStats.updates < updates) {
+		__asm__("wfi");
+		__asm__("cpsie i");
+		__asm__("cpsid i");
+	}
+	__asm__("cpsie i");
+}
+
+/*
+ * Funtion Name		: pwmCaptureDone
+ * Description 		: Result filled, gdb breakpoint for make capture
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmCaptureDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	const CAPTURESETUP_type *s;
+	CAPTURESTEP_type *r;
+	CAP_RESULT_type m;
+	uint32_t step, n;
+
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM2, TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	for (step = 0; step < CAPTURE_STEPS; step++) {
+		s = &captureSetup[step];
+		r = &captureResult[step];
+
+		r->setHz = pwmStart(s->hz, PWM_CH1, 0);
+		pwmSetDuty(1, s->duty);
+		r->setDuty = s->duty;
+		r->edges = capStart(s->minHz, s->maxHz);
+		for (n = 0; n < CAPTURE_TIMEOUT; n++) {
+			captureWait(1);
+			if (capRead(&m) && m.hz != 0)
+				break;
+		}
+		captureWait(CAPTURE_UPDATES);
+
+		if (capRead(&m)) {
+			r->hz = m.hz;
+			r->millihertz = m.millihertz;
+			r->duty = m.duty;
+			r->highNs = m.highNs;
+			r->periods = m.periods;
+		}
+	}
+	capStop();
+	captureStats.updates = capStats.updates;
+	captureStats.skipped = capStats.skipped;
+	captureStats.lost = capStats.lost;
+	captureStats.overcaptures = capStats.overcaptures;
+
+	pwmCaptureDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,185 @@
+/*
+ * File Name  : pwm_multi.c Ver 1.0
+ *
+ * Description:
+ *   Four channel PWM on TIM3 : duty updates with and without interrupt
+ *
+ *   TIM3 runs a 1 kHz PWM on CH1-CH4 (PA6, PA7, PB0, PB1, tim3pwm.c). The
+ *   duties are changed over PWM_PERIODS periods in two ways :
+ *
+ *      - step 0 : as pwm.c, the update interrupt (timer3Handler) writes
+ *                 CCR1-4 in every period
+ *      - step 1 : preloaded CCRx, main calls pwmSetDuties whenever it has
+ *                 new duties (here about every 0.25 ms, not in step with
+ *                 the period); the timer takes them at the next update
+ *                 event, TIM3 interrupt off
+ *
+ *   pwmLoad holds per step the interrupts taken, the duty updates, the
+ *   CPU cycles spent on them (DWT; handler body + 24 cycles of interrupt
+ *   entry and exit) and that load in 0.01 % of the step time. Step 1
+ *   takes no interrupt : its cost is only the register writes of each
+ *   update, and an update the application does not make costs nothing.
+ *
+ *   Afterwards the outputs stay at 10 / 25 / 50 / 75 % on CH1-CH4.
+ *
+ *   make multi (st-util must be running) stops in pwmMultiDone and prints
+ *   pwmLoad and pwmTiming.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * PWM outputs            : PA6, PA7, PB0, PB1 (TIM3 CH1-CH4)
+ *
+ * Build            : make multi
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "tim3pwm.h"
+
+#define PWM_HZ					(1000)
+#define PWM_PERIODS				(200)     // Periods per step
+#define UPDATE_CYCLES			(18000)   // Step 1 : new duties every 0.25 ms
+#define IRQ_ENTRY_EXIT			(24)      // Cortex-M3 exception entry + return
+#define LOAD_STEPS				(2)
+
+typedef struct
+{
+	uint32_t interrupts;        /* TIM3 interrupts taken                      */
+	uint32_t updates;           /* Duty updates written                       */
+	uint32_t cycles;            /* CPU cycles for the updates                 */
+	uint32_t stepCycles;        /* Length of the step                         */
+	uint32_t load;              /* cycles / stepCycles in 0.01 %              */
+} PWMLOAD_type;
+
+PWMLOAD_type pwmLoad[LOAD_STEPS];
+
+static const uint16_t finalDuty[PWM_CHANNELS] = {1000, 2500, 5000, 7500};
+
+static volatile uint32_t periods;
+static PWMLOAD_type *loadStep;
+
+/*********** Function declarations ****************/
+void timer3Handler(void);
+void pwmMultiDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: rampDuties
+ * Description 		: Duties of CH1-CH4 for an update : a ramp per channel,
+ *					  a quarter of the range apart
+ * Input			: n update number, duty[4] (result)
+ * Return Value		: None
+*/
+static void rampDuties(uint32_t n, uint16_t *duty)
+{
+	uint32_t ch;
+
+	for (ch = 0; ch < PWM_CHANNELS; ch++)
+		duty[ch] = (n * 50 + ch * (PWM_DUTY_FULL / 4)) % PWM_DUTY_FULL;
+}
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: Step 0 : update interrupt, new CCR1-4 every period
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	uint32_t start = PROFILE_DWT->CYCCNT;
+	uint16_t duty[PWM_CHANNELS];
+	uint32_t ch;
+
+	TIM3->SR = ~(1 << 0);       // rc_w0 : clear UIF only
+
+	rampDuties(periods, duty);
+	for (ch = 0; ch < PWM_CHANNELS; ch++)
+		(&TIM3->CCR1)[ch] = duty[ch] * pwmTiming.steps / PWM_DUTY_FULL;
+	periods++;
+
+	loadStep->interrupts++;
+	loadStep->updates++;
+	loadStep->cycles += PROFILE_DWT->CYCCNT - start + IRQ_ENTRY_EXIT;
+}
+
+/*
+ * Funtion Name		: pwmMultiDone
+ * Description 		: pwmLoad is filled, gdb breakpoint for make multi
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmMultiDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	PWMLOAD_type *l;
+	uint16_t duty[PWM_CHANNELS];
+	uint32_t stepStart, stepLength, last, start, n;
+
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	pwmStart(PWM_HZ, PWM_CH1 | PWM_CH2 | PWM_CH3 | PWM_CH4, 0);
+	stepLength = PWM_PERIODS * (clockFreq.sysclk / pwmTiming.hz);
+
+	// Step 0 : update interrupt writes the duties
+	loadStep = l = &pwmLoad[0];
+	periods = 0;
+	TIM3->SR = 0;
+	TIM3->DIER |= (1 << 0);                         // UIE
+	NVIC->IPR[TIM3_IRQn] = 0x10;
+	NVIC->ISER[TIM3_IRQn >> 5] = (1 << (TIM3_IRQn & 0x1F));
+	stepStart = PROFILE_DWT->CYCCNT;
+	while (periods < PWM_PERIODS)
+		__asm__("wfi");
+	l->stepCycles = PROFILE_DWT->CYCCNT - stepStart;
+	NVIC->ICER[TIM3_IRQn >> 5] = (1 << (TIM3_IRQn & 0x1F));
+	TIM3->DIER &= ~(1 << 0);
+
+	// Step 1 : preloaded registers written from main, no interrupt
+	loadStep = l = &pwmLoad[1];
+	stepStart = last = PROFILE_DWT->CYCCNT;
+	n = 0;
+	while (PROFILE_DWT->CYCCNT - stepStart < stepLength) {
+		if (PROFILE_DWT->CYCCNT - last < UPDATE_CYCLES)
+			continue;
+		last = PROFILE_DWT->CYCCNT;
+
+		rampDuties(n++, duty);
+		start = PROFILE_DWT->CYCCNT;
+		pwmSetDuties(duty);
+		l->cycles += PROFILE_DWT->CYCCNT - start;
+		l->updates++;
+	}
+	l->stepCycles = PROFILE_DWT->CYCCNT - stepStart;
+
+	for (n = 0; n < LOAD_STEPS; n++)
+		pwmLoad[n].load = (unsigned long long) pwmLoad[n].cycles * 10000 / pwmLoad[n].stepCycles;
+
+	pwmSetDuties(finalDuty);
+
+	pwmMultiDone();
+
+	while(1)
+		__asm__("wfi");
+}
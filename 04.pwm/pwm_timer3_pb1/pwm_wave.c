@@ -0,0 +1,120 @@
+/*
+ * File Name  : pwm_wave.c Ver 1.0
+ *
+ * Description:
+ *   Sine and triangle on PB1 (TIM3 CH4) from a table played by DMA into
+ *   CCR4, no interrupt per sample
+ *
+ *   wavPlans holds the plans of the examples in tim3wave.h (1 kHz 8 bit,
+ *   440 Hz 10 bit, 50 Hz 12 bit). Then PB1 outputs :
+ *
+ *      - step 0 : 440 Hz triangle, 10 bit, for WAVE_STEP_MS
+ *      - step 1 : 1 kHz sine, 8 bit, 281 kHz carrier, keeps running
+ *
+ *   wavSetupCycles holds the CPU cycles of wavTable and wavStart of step
+ *   1; after them the output costs no CPU, the DMA moves 281000 samples
+ *   per second (one bus transfer each). An RC low pass on PB1 (e.g. 1 k
+ *   and 100 nF, corner 1.6 kHz) shows the sine on a scope.
+ *
+ *   make wave (st-util must be running) stops in pwmWaveDone and prints
+ *   wavPlans and wavSetupCycles.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * PWM output             : PB1 (TIM3 CH4), RC low pass for the waveform
+ *
+ * Build            : make wave
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "tim3pwm.h"
+#include "tim3wave.h"
+
+#define WAVE_CHANNEL			(4)       // PB1
+#define WAVE_STEP_MS			(50)
+#define WAVE_PLANS				(3)
+
+static const uint32_t planHz[WAVE_PLANS] = {1000, 440, 50};
+static const uint32_t planBits[WAVE_PLANS] = {8, 10, 12};
+
+WAV_PLAN_type wavPlans[WAVE_PLANS];
+uint32_t wavSetupCycles;
+
+static uint16_t waveTable[WAV_SAMPLES_MAX];
+
+/*********** Function declarations ****************/
+void timer3Handler(void);
+void pwmWaveDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: Not used, the TIM3 interrupt stays off
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	TIM3->SR = 0;
+}
+
+/*
+ * Funtion Name		: pwmWaveDone
+ * Description 		: Plans filled, gdb breakpoint for make wave
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmWaveDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	WAV_PLAN_type *p;
+	uint32_t n, start;
+
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	for (n = 0; n < WAVE_PLANS; n++)
+		wavPlan(clockFreq.timApb1clk, planHz[n], planBits[n], WAV_SAMPLES_MAX, &wavPlans[n]);
+
+	// Step 0 : 440 Hz triangle
+	p = &wavPlans[1];
+	wavTable(WAV_TRIANGLE, waveTable, p->samples, p->pwm.steps, PWM_DUTY_FULL);
+	wavStart(waveTable, p, WAVE_CHANNEL);
+	start = PROFILE_DWT->CYCCNT;
+	while (PROFILE_DWT->CYCCNT - start < WAVE_STEP_MS * (clockFreq.sysclk / 1000));
+
+	// Step 1 : 1 kHz sine
+	p = &wavPlans[0];
+	wavStop();                  // The DMA reads the table
+	start = PROFILE_DWT->CYCCNT;
+	wavTable(WAV_SINE, waveTable, p->samples, p->pwm.steps, PWM_DUTY_FULL);
+	wavStart(waveTable, p, WAVE_CHANNEL);
+	wavSetupCycles = PROFILE_DWT->CYCCNT - start;
+
+	pwmWaveDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,147 @@
+/*
+ * File Name  : pwm_ws2812.c Ver 1.0
+ *
+ * Description:
+ *   300 LED WS2812 strip on PB1, TIM3 CH4 PWM + DMA (ws2812.c)
+ *
+ *   WS2812_FRAMES frames of a color ramp moving one LED per frame are
+ *   sent back to back. ws2812Result holds the DWT cycles of one frame
+ *   (ws2812Show until ws2812Busy is 0, the reset time included), the
+ *   frame rate that gives in 0.01 frames per second, the chunk
+ *   interrupts per frame, the chunks encoded late and the size of the
+ *   duty buffer. The CPU is free while a frame is sent except for the
+ *   chunk interrupts.
+ *
+ *   make ws2812 (st-util must be running) stops in pwmWs2812Done and
+ *   prints ws2812Result.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * WS2812 strip           : DIN -> PB1 (5 V strips : through a 74HCT125 or
+ *                          with the first LED at 3.7 V), GND common
+ *
+ * Build            : make ws2812
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "tim3pwm.h"
+#include "ws2812.h"
+
+#define WS2812_LEDS				(300)
+#define WS2812_FRAMES			(20)
+
+typedef struct
+{
+	uint32_t frameCycles;       /* Last frame, reset time included            */
+	uint32_t fps;               /* Frames per second in 0.01                  */
+	uint32_t chunksPerFrame;    /* DMA interrupts                             */
+	uint32_t late;              /* Chunks encoded late                        */
+	uint32_t bufferBytes;       /* Duty buffer                                */
+} WS2812RESULT_type;
+
+WS2812RESULT_type ws2812Result;
+
+static uint8_t strip[WS2812_LEDS * 3];
+
+/*********** Function declarations ****************/
+void timer3Handler(void);
+void pwmWs2812Done(void);
+int32_t main(void);
+
+#define IVT_DMA1_CH3				ws2812DmaHandler
+#include "stm32f1ivt.h"
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: Not used, the TIM3 interrupt stays off
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	TIM3->SR = 0;
+}
+
+/*
+ * Funtion Name		: stripPattern
+ * Description 		: Color ramp along the strip, moved by one LED per frame
+ * Input			: frame number
+ * Return Value		: None
+*/
+static void stripPattern(uint32_t frame)
+{
+	uint32_t i, n;
+
+	for (i = 0; i < WS2812_LEDS; i++) {
+		n = i + frame;
+		strip[i * 3 + 0] = n & 0xFF;                // R
+		strip[i * 3 + 1] = (n * 3) & 0xFF;          // G
+		strip[i * 3 + 2] = 0xFF - (n & 0xFF);       // B
+	}
+}
+
+/*
+ * Funtion Name		: pwmWs2812Done
+ * Description 		: Result filled, gdb breakpoint for make ws2812
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmWs2812Done(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	WS2812RESULT_type *r = &ws2812Result;
+	uint32_t frame, start, chunks;
+
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	ws2812Init();
+
+	for (frame = 0; frame < WS2812_FRAMES; frame++) {
+		stripPattern(frame);
+		chunks = ws2812Stats.chunks;
+		start = PROFILE_DWT->CYCCNT;
+		ws2812Show(strip, WS2812_LEDS);
+
+		// Sleep until the frame ends; interrupts masked around the test so
+		// the last chunk interrupt cannot fall between test and WFI
+		__asm__("cpsid i");
+		while (ws2812Busy()) {
+			__asm__("wfi");
+			__asm__("cpsie i");
+			__asm__("cpsid i");
+		}
+		__asm__("cpsie i");
+		r->frameCycles = PROFILE_DWT->CYCCNT - start;
+		r->chunksPerFrame = ws2812Stats.chunks - chunks;
+	}
+
+	r->fps = (unsigned long long) clockFreq.sysclk * 100 / r->frameCycles;
+	r->late = ws2812Stats.late;
+	r->bufferBytes = 2 * WS2812_CHUNK_PIXELS * 24;
+
+	pwmWs2812Done();
+
+	while(1)
+		__asm__("wfi");
+}
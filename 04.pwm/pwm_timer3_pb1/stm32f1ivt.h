@@ -1,6 +1,15 @@
 #ifndef IVT_H
 #define IVT_H
 
+// DMA1 channel 3 handler of a program (#define before the include), none by default
+#ifndef IVT_DMA1_CH3
+#define IVT_DMA1_CH3                0
+#endif
+
+// TIM2 handler of a program, none by default
+#ifndef IVT_TIM2
+#define IVT_TIM2                    0
+#endif
 
 
 /*************************************************
@@ -13,7 +22,7 @@
 uint32_t (* const vector_table[])
 __attribute__ ((section(".isr_vector"))) = {
 	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
-	(uint32_t *) main,              /* 0x004 Reset                           */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
 	0,                              /* 0x008 Non maskable interrupt          */
 	0,                              /* 0x00C HardFault                       */
 	0,                              /* 0x010 Memory Management               */
@@ -41,7 +50,7 @@ __attribute__ ((section(".isr_vector"))) = {
 	0,                              /* 0x068 EXTI Line4                      */
 	0,                              /* 0x06C DMA1_Ch1                        */
 	0,                              /* 0x070 DMA1_Ch2                        */
-	0,                              /* 0x074 DMA1_Ch3                        */
+	(uint32_t *) IVT_DMA1_CH3,      /* 0x074 DMA1_Ch3                        */
 	0,                              /* 0x078 DMA1_Ch4                        */
 	0,                              /* 0x07C DMA1_Ch5                        */
 	0,                              /* 0x080 DMA1_Ch6                        */
@@ -56,7 +65,7 @@ __attribute__ ((section(".isr_vector"))) = {
 	0,                              /* 0x0A4 TIM1 Update                     */
 	0,                              /* 0x0A8 TIM1 Trigger and Communication  */
 	0,                              /* 0x0AC TIM1 Capture Compare            */
-	0,                              /* 0x0B0 TIM2                            */
+	(uint32_t *) IVT_TIM2,          /* 0x0B0 TIM2                            */
 	(uint32_t *) timer3Handler, 	/* 0x0B4 TIM3                            */
 	0,                              /* 0x0B8 TIM4                            */
 	0,                              /* 0x0BC I2C1 event                      */
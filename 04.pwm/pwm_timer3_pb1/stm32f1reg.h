@@ -13,7 +13,7 @@
 #define uint16_t        unsigned short
 #define uint8_t         unsigned char
 
-#define HSE_Value       ((uint32_t) 25000000) /* Value of the External oscillator in Hz */
+#define HSE_Value       ((uint32_t)  8000000) /* Value of the External oscillator in Hz (Blue Pill crystal) */
 #define HSI_Value       ((uint32_t)  8000000) /* Value of the Internal oscillator in Hz*/
 
 // Define the base addresses for peripherals
@@ -27,7 +27,9 @@
 #define AFIO_BASE       (APB2PERIPH_BASE + 0x0000) //  AFIO base address is 0x40010000
 
 
+#define TIM2_BASE       (APB1PERIPH_BASE + 0x0000) //  TIM2 base address is 0x40000000
 #define TIM3_BASE       (APB1PERIPH_BASE + 0x0400) //  TIM3 base address is 0x40000400
+#define TIM1_BASE       (APB2PERIPH_BASE + 0x2C00) //  TIM1 base address is 0x40012C00
 
 
 #define GPIOA_BASE      (PERIPH_BASE + 0x10800) // GPIOC base address is 0x40011000
@@ -38,18 +40,26 @@
 
 #define GPIOE_BASE      (APB2PERIPH_BASE + 0x1800) // GPIOE base address is 0x40011800
 
+#define DMA1_BASE       ( AHBPERIPH_BASE + 0x0000) //  DMA1 base address is 0x40020000
+#define DMA1_Channel3_BASE (DMA1_BASE + 0x0030)    //  Channel n at 0x40020008 + 20 * (n - 1)
+#define DMA1_Channel5_BASE (DMA1_BASE + 0x0058)
+#define DMA1_Channel7_BASE (DMA1_BASE + 0x0080)
 #define RCC_BASE        ( AHBPERIPH_BASE + 0x1000) //   RCC base address is 0x40021000
 #define FLASH_BASE      ( AHBPERIPH_BASE + 0x2000) // FLASH base address is 0x40022000
 
 #define NVIC_BASE       ((uint32_t) 0xE000E100)
 
 
-#define STACKINIT       0x20002000
+// Stack top (_estack) is defined in the linker script, Reset_Handler in startup.s
+extern uint32_t _estack;
+void Reset_Handler(void);
+#define STACKINIT       (&_estack)
 #define DELAY           7200000
 
 
 #define AFIO            ((AFIO_type  *)  AFIO_BASE)
 
+#define GPIOA   ((GPIO_type *)  GPIOA_BASE)
 #define GPIOB   ((GPIO_type *)  GPIOB_BASE)
 
 #define GPIOC   ((GPIO_type *)  GPIOC_BASE)
@@ -57,8 +67,17 @@
 
 #define RCC             ((RCC_type   *)   RCC_BASE)
 #define FLASH           ((FLASH_type *) FLASH_BASE)
+#define TIM2            ((TIM_type  *)   TIM2_BASE)
 #define TIM3            ((TIM_type  *)   TIM3_BASE)
+#define TIM1            ((TIM_type  *)   TIM1_BASE)
 #define NVIC            ((NVIC_type  *)  NVIC_BASE)
+#define DMA1            ((DMA_type   *)  DMA1_BASE)
+#define DMA1_Channel3   ((DMA_Channel_type *) DMA1_Channel3_BASE)
+#define DMA1_Channel5   ((DMA_Channel_type *) DMA1_Channel5_BASE)
+#define DMA1_Channel7   ((DMA_Channel_type *) DMA1_Channel7_BASE)
+
+// Address of a register or buffer for DMA CPAR/CMAR (the host simulator maps it to its own)
+#define DMA_ADDRESS(p)  ((uint32_t) (p))
 
 /*
  * Macros
@@ -95,16 +114,31 @@ typedef struct
 	uint32_t CNT;       /* Address offset: 0x24 */
 	uint32_t PSC;       /* Address offset: 0x28 */
 	uint32_t ARR;       /* Address offset: 0x2C */
-	uint32_t RES1;      /* Address offset: 0x30 */
+	uint32_t RCR;       /* Address offset: 0x30, TIM1 only */
 	uint32_t CCR1;      /* Address offset: 0x34 */
 	uint32_t CCR2;      /* Address offset: 0x38 */
 	uint32_t CCR3;      /* Address offset: 0x3C */
 	uint32_t CCR4;      /* Address offset: 0x40 */
-	uint32_t BDTR;      /* Address offset: 0x44 */
+	uint32_t BDTR;      /* Address offset: 0x44, TIM1 only */
 	uint32_t DCR;       /* Address offset: 0x48 */
 	uint32_t DMAR;      /* Address offset: 0x4C */
 } TIM_type;
 
+typedef struct
+{
+	uint32_t ISR;       /* DMA interrupt status register,             Address offset: 0x00 */
+	uint32_t IFCR;      /* DMA interrupt flag clear register,         Address offset: 0x04 */
+} DMA_type;
+
+typedef struct
+{
+	uint32_t CCR;       /* DMA channel configuration register,        Address offset: 0x00 */
+	uint32_t CNDTR;     /* DMA channel number of data register,       Address offset: 0x04 */
+	uint32_t CPAR;      /* DMA channel peripheral address register,   Address offset: 0x08 */
+	uint32_t CMAR;      /* DMA channel memory address register,       Address offset: 0x0C */
+	uint32_t RESERVED;  /* Reserved,                                  Address offset: 0x10 */
+} DMA_Channel_type;
+
 typedef struct
 {
 	uint32_t CR;       /* RCC clock control register,                Address offset: 0x00 */
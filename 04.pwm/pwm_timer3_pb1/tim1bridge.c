@@ -0,0 +1,304 @@
+/*
+ * File Name  : tim1bridge.c Ver 1.0
+ *
+ * Description:
+ *   Half-bridge / three phase drive on TIM1 : complementary outputs,
+ *   dead-time, break input, center-aligned PWM (see tim1bridge.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for TIM1 complementary PWM **********************
+
+1.	Enable clocks : TIM1, GPIOA, GPIOB, AFIO (RCC->APB2ENR)
+2.	PSC/ARR from pwmPlan at the APB2 timer clock (clockFreq.timApb2clk), at
+	half of it for center-aligned (ARR = steps, 2 * ARR clocks per period)
+3.	Dead-time in ns -> timer clocks (rounded up) -> BDTR DTG
+4.	CCMR1/CCMR2 : OCxM 110 (PWM mode 1) and OCxPE (CCRx preload)
+5.	CCER : CCxE and CCxNE of each leg, CR2 OISx / OISxN 0 : idle low
+6.	BDTR : DTG, OSSR/OSSI (outputs driven at their inactive / idle level
+	when off), BKE/BKP for the break input, AOE, MOE still 0
+7.	RCR 1 for center-aligned : one update event per period (valley)
+8.	EGR UG, CR1 : CMS 01, ARPE, CEN
+9.	Pins : BKIN input with pull-up/down, then the outputs as alternate
+	function push-pull; the timer drives them low (idle) already
+10.	BDTR MOE : outputs on
+11.	Break (BKIN or EGR BG) : the hardware clears MOE, outputs idle, BIF.
+	Resume : clear BIF, set MOE (ignored while BKIN is active)
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "tim3pwm.h"
+#include "tim1bridge.h"
+
+#define TIM_CR1_CEN					(1 << 0)
+#define TIM_CR1_UDIS				(1 << 1)
+#define TIM_CR1_CMS_CENTER1			(1 << 5)  // Center-aligned, CCxIF while counting down
+#define TIM_CR1_ARPE				(1 << 7)
+#define TIM_EGR_UG					(1 << 0)
+#define TIM_EGR_BG					(1 << 7)
+#define TIM_SR_BIF					(1 << 7)
+#define TIM_OCM_PWM1				(6)
+#define TIM_CCMR_OCPE				(1 << 3)
+
+#define TIM_BDTR_OSSI				(1 << 10)
+#define TIM_BDTR_OSSR				(1 << 11)
+#define TIM_BDTR_BKE				(1 << 12)
+#define TIM_BDTR_BKP				(1 << 13)
+#define TIM_BDTR_AOE				(1 << 14)
+#define TIM_BDTR_MOE				(1 << 15)
+
+#define BKIN_PIN					(12)      // PB12
+
+BRIDGE_TIMING_type bridgeTiming;
+
+static uint16_t bridgeDuty[BRIDGE_CHANNELS];
+
+/*
+ * Funtion Name		: bridgeDeadTime
+ * Description 		: DTG of a dead-time, rounded up to the next step
+ *					  (CKD 0 : tDTS is one timer clock)
+ *					    DTG 0xxxxxxx :       DTG[6:0]  clocks (0 .. 127)
+ *					    DTG 10xxxxxx : (64 + DTG[5:0]) * 2   (128 .. 254)
+ *					    DTG 110xxxxx : (32 + DTG[4:0]) * 8   (256 .. 504)
+ *					    DTG 111xxxxx : (32 + DTG[4:0]) * 16  (512 .. 1008)
+ * Input			: timclk timer clock, ns dead-time, t (dtg, deadClocks,
+ *					  deadNs set)
+ * Return Value		: Dead-time obtained in ns, 0 : above 1008 clocks or
+ *					  ns 0
+*/
+uint32_t bridgeDeadTime(uint32_t timclk, uint32_t ns, BRIDGE_TIMING_type *t)
+{
+	uint32_t clocks;
+
+	clocks = ((unsigned long long) ns * timclk + 999999999) / 1000000000;
+	if (clocks <= 127) {
+		t->dtg = clocks;
+		t->deadClocks = clocks;
+	} else if (clocks <= 254) {
+		t->dtg = 0x80 | ((clocks + 1) / 2 - 64);
+		t->deadClocks = (64 + (t->dtg & 0x3F)) * 2;
+	} else if (clocks <= 504) {
+		t->dtg = 0xC0 | ((clocks + 7) / 8 - 32);
+		t->deadClocks = (32 + (t->dtg & 0x1F)) * 8;
+	} else if (clocks <= 1008) {
+		t->dtg = 0xE0 | ((clocks + 15) / 16 - 32);
+		t->deadClocks = (32 + (t->dtg & 0x1F)) * 16;
+	} else {
+		t->dtg = 0;
+		t->deadClocks = 0;
+	}
+	t->deadNs = (unsigned long long) t->deadClocks * 1000000000 / timclk;
+	return t->deadNs;
+}
+
+/*
+ * Funtion Name		: bridgeCompare
+ * Description 		: CCRx of a duty (of OCxREF, before the dead-time)
+ * Input			: duty 0 .. PWM_DUTY_FULL
+ * Return Value		: compare value, 0 .. steps
+*/
+static uint32_t bridgeCompare(uint32_t duty)
+{
+	if (duty > PWM_DUTY_FULL)
+		duty = PWM_DUTY_FULL;
+	return duty * bridgeTiming.pwm.steps / PWM_DUTY_FULL;
+}
+
+/*
+ * Funtion Name		: bridgeSetPins
+ * Description 		: BKIN input with pull-up (break low) or pull-down
+ *					  (break high), outputs of the legs alternate function
+ *					  push-pull 50 MHz : CHx PA8-PA10, CHxN PB13-PB15
+ * Input			: channels (BRIDGE_CHx mask), flags
+ * Return Value		: None
+*/
+static void bridgeSetPins(uint32_t channels, uint32_t flags)
+{
+	uint32_t ch;
+
+	if (flags & (BRIDGE_BREAK_LOW | BRIDGE_BREAK_HIGH)) {
+		if (flags & BRIDGE_BREAK_LOW)
+			GPIOB->ODR |= (1 << BKIN_PIN);              // Pull-up
+		else
+			GPIOB->ODR &= ~(1 << BKIN_PIN);             // Pull-down
+		GPIOB->CRH = (GPIOB->CRH & ~(0xF << ((BKIN_PIN - 8) * 4))) | (0x8 << ((BKIN_PIN - 8) * 4));
+	}
+
+	for (ch = 0; ch < BRIDGE_CHANNELS; ch++) {
+		if (!(channels & (1 << ch)))
+			continue;
+		GPIOA->CRH = (GPIOA->CRH & ~(0xF << (ch * 4))) | (0xB << (ch * 4));              // PA8 + ch
+		GPIOB->CRH = (GPIOB->CRH & ~(0xF << ((ch + 5) * 4))) | (0xB << ((ch + 5) * 4));  // PB13 + ch
+	}
+}
+
+/*
+ * Funtion Name		: bridgeStart
+ * Description 		: TIM1 complementary PWM at 'hz' on the legs of the
+ *					  mask, duty 0 (high side off, low side on)
+ * Input			: hz, deadNs dead-time, channels (BRIDGE_CHx mask),
+ *					  flags BRIDGE_CENTER, BRIDGE_BREAK_LOW / _HIGH,
+ *					  BRIDGE_AUTO_RESTART
+ * Return Value		: Frequency obtained, 0 : not possible
+*/
+uint32_t bridgeStart(uint32_t hz, uint32_t deadNs, uint32_t channels, uint32_t flags)
+{
+	BRIDGE_TIMING_type t;
+	PWM_TIMING_type *p = &t.pwm;
+	uint32_t timclk = clockFreq.timApb2clk;
+	uint32_t ch, ccmr1 = 0, ccmr2 = 0, ccer = 0, bdtr, period;
+
+	if (flags & BRIDGE_CENTER) {
+		pwmPlan(timclk / 2, hz, p);
+		if (p->steps > 0xFFFF)
+			p->steps = 0xFFFF;
+		p->arr = p->steps;                          // 0 .. ARR .. 0
+		period = (p->psc + 1) * 2 * p->steps;
+	} else {
+		pwmPlan(timclk, hz, p);
+		period = (p->psc + 1) * p->steps;
+	}
+	if (p->hz == 0)
+		return 0;
+	p->hz = timclk / period;
+
+	// The dead-time counts timer clocks, not prescaled ones
+	if (bridgeDeadTime(timclk, deadNs, &t) == 0 && deadNs != 0)
+		return 0;
+	if (t.deadClocks >= period)
+		return 0;
+	bridgeTiming = t;
+
+	RCC->APB2ENR |= (1 << 11) | (1 << 3) | (1 << 2) | (1 << 0);  // TIM1, GPIOB, GPIOA, AFIO
+
+	channels &= (1 << BRIDGE_CHANNELS) - 1;
+	for (ch = 0; ch < BRIDGE_CHANNELS; ch++) {
+		bridgeDuty[ch] = 0;
+		if (!(channels & (1 << ch)))
+			continue;
+		if (ch < 2)
+			ccmr1 |= ((TIM_OCM_PWM1 << 4) | TIM_CCMR_OCPE) << (ch * 8);
+		else
+			ccmr2 |= ((TIM_OCM_PWM1 << 4) | TIM_CCMR_OCPE) << ((ch - 2) * 8);
+		ccer |= 0x5 << (ch * 4);                    // CCxE, CCxNE
+	}
+
+	bdtr = t.dtg | TIM_BDTR_OSSR | TIM_BDTR_OSSI;
+	if (flags & (BRIDGE_BREAK_LOW | BRIDGE_BREAK_HIGH))
+		bdtr |= TIM_BDTR_BKE;
+	if (flags & BRIDGE_BREAK_HIGH)
+		bdtr |= TIM_BDTR_BKP;
+	if (flags & BRIDGE_AUTO_RESTART)
+		bdtr |= TIM_BDTR_AOE;
+
+	TIM1->CR1 = 0;
+	TIM1->BDTR = 0;                                 // MOE 0 : outputs idle
+	TIM1->CR2 = 0;                                  // OISx, OISxN 0 : idle low
+	TIM1->PSC = p->psc;
+	TIM1->ARR = p->arr;
+	TIM1->RCR = (flags & BRIDGE_CENTER) ? 1 : 0;    // One update per period
+	TIM1->CCR1 = 0;
+	TIM1->CCR2 = 0;
+	TIM1->CCR3 = 0;
+	TIM1->CCMR1 = ccmr1;
+	TIM1->CCMR2 = ccmr2;
+	TIM1->CCER = ccer;
+	TIM1->BDTR = bdtr;
+	TIM1->EGR = TIM_EGR_UG;     // Preload registers into the shadow registers
+	TIM1->SR = 0;
+	TIM1->CR1 = ((flags & BRIDGE_CENTER) ? TIM_CR1_CMS_CENTER1 : 0) | TIM_CR1_ARPE | TIM_CR1_CEN;
+
+	bridgeSetPins(channels, flags);
+	TIM1->SR = 0;               // BIF of a BKIN level seen while the pin was set up
+	TIM1->BDTR = bdtr | TIM_BDTR_MOE;
+
+	return p->hz;
+}
+
+/*
+ * Funtion Name		: bridgeStop
+ * Description 		: Outputs idle (low), counter off
+ * Input			: None
+ * Return Value		: None
+*/
+void bridgeStop(void)
+{
+	TIM1->BDTR &= ~(TIM_BDTR_MOE | TIM_BDTR_AOE);
+	TIM1->CR1 &= ~TIM_CR1_CEN;
+}
+
+/*
+ * Funtion Name		: bridgeSetDuty
+ * Description 		: Duty of one leg from the next period on
+ * Input			: channel 1 .. 3, duty 0 .. PWM_DUTY_FULL (0.01 %)
+ * Return Value		: None
+*/
+void bridgeSetDuty(uint32_t channel, uint32_t duty)
+{
+	if (channel < 1 || channel > BRIDGE_CHANNELS)
+		return;
+
+	bridgeDuty[channel - 1] = duty;
+	(&TIM1->CCR1)[channel - 1] = bridgeCompare(duty);
+}
+
+/*
+ * Funtion Name		: bridgeSetDuties
+ * Description 		: Duty of the three legs, taken at the same update
+ *					  event (UDIS while writing)
+ * Input			: duty[3] 0 .. PWM_DUTY_FULL (0.01 %)
+ * Return Value		: None
+*/
+void bridgeSetDuties(const uint16_t *duty)
+{
+	uint32_t ch;
+
+	TIM1->CR1 |= TIM_CR1_UDIS;
+	for (ch = 0; ch < BRIDGE_CHANNELS; ch++) {
+		bridgeDuty[ch] = duty[ch];
+		(&TIM1->CCR1)[ch] = bridgeCompare(duty[ch]);
+	}
+	TIM1->CR1 &= ~TIM_CR1_UDIS;
+}
+
+/*
+ * Funtion Name		: bridgeBreak
+ * Description 		: Software break (EGR BG) : as the break input, outputs
+ *					  idle at once
+ * Input			: None
+ * Return Value		: None
+*/
+void bridgeBreak(void)
+{
+	TIM1->EGR = TIM_EGR_BG;
+}
+
+/*
+ * Funtion Name		: bridgeResume
+ * Description 		: Outputs on again after a break
+ * Input			: None
+ * Return Value		: 1 running, 0 : BKIN still active, outputs stay off
+*/
+uint32_t bridgeResume(void)
+{
+	TIM1->SR = ~TIM_SR_BIF;
+	TIM1->BDTR |= TIM_BDTR_MOE;
+	return bridgeRunning();
+}
+
+/*
+ * Funtion Name		: bridgeRunning
+ * Description 		: Outputs on (MOE), 0 after a break
+ * Input			: None
+ * Return Value		: 1 running, 0 : off
+*/
+uint32_t bridgeRunning(void)
+{
+	return (TIM1->BDTR & TIM_BDTR_MOE) ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#ifndef TIM1BRIDGE_H
+#define TIM1BRIDGE_H
+
+/*
+ * File Name  : tim1bridge.h Ver 1.0
+ *
+ * Description:
+ *   Half-bridge / three phase drive on the advanced timer TIM1 :
+ *   complementary outputs with dead-time, break input, center-aligned PWM
+ *
+ *      CH1  PA8     CH2  PA9     CH3  PA10    high side gates
+ *      CH1N PB13    CH2N PB14    CH3N PB15    low side gates
+ *      BKIN PB12                              fault input (no remap)
+ *
+ *   Each channel drives one half-bridge : OCx is OCxREF (PWM mode 1),
+ *   OCxN its complement. The dead-time generator delays the rising edge
+ *   of both, so the two switches of a leg are never on together :
+ *
+ *      OCxREF  ____|==========|________
+ *      OCx     ______|========|________    high : duty - dead-time
+ *      OCxN    ====|____________|======    high : 1 - duty - dead-time
+ *                  DT         DT
+ *
+ *   The dead-time is given in ns and rounded up to the DTG steps of BDTR
+ *   (timer clock 72 MHz, 13.9 ns per clock) : 0 .. 1.76 us in 1 clock
+ *   steps, up to 3.53 us in 2, 7.0 us in 8 and 14.0 us in 16 clocks.
+ *
+ *   Center-aligned : the counter runs 0 .. ARR .. 0, the pulses of all
+ *   legs are centered in the period (less current ripple, and the peak
+ *   and valley are fixed points to sample phase currents). The period is 2 * ARR clocks, half the
+ *   duty steps of an edge aligned PWM of the same frequency
+ *   (20 kHz : 1800 steps instead of 3600). The repetition counter (RCR 1)
+ *   keeps one update event per period at the valley of the counter, so
+ *   the preloaded CCRx of all legs change at the same point, with the
+ *   outputs of every leg symmetric about the peak.
+ *
+ *   Break : BKIN (BRIDGE_BREAK_LOW / _HIGH, e.g. the open drain fault
+ *   output of a gate driver, with the internal pull-up or pull-down) or
+ *   bridgeBreak clears MOE in hardware, with no CPU in the path : all
+ *   outputs go to their idle level (low, both switches off) at once.
+ *   They stay off until bridgeResume, which fails while BKIN is still
+ *   active; BRIDGE_AUTO_RESTART sets MOE again at the next update event
+ *   once BKIN is released.
+ *
+ *      bridgeStart(20000, 500, BRIDGE_CH1 | BRIDGE_CH2 | BRIDGE_CH3,
+ *                  BRIDGE_CENTER | BRIDGE_BREAK_LOW);
+ *      bridgeSetDuty(1, 2500);                         // Leg 1 25 %
+ *
+ *   The outputs are active high on both sides; a gate driver with
+ *   inverted low side input needs CCxNP set in TIM1->CCER.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+#include "tim3pwm.h"
+
+#define BRIDGE_CH1					(1 << 0)  // PA8  / PB13
+#define BRIDGE_CH2					(1 << 1)  // PA9  / PB14
+#define BRIDGE_CH3					(1 << 2)  // PA10 / PB15
+#define BRIDGE_CHANNELS				(3)
+
+#define BRIDGE_CENTER				(1 << 0)  // Center-aligned, else edge aligned
+#define BRIDGE_BREAK_LOW			(1 << 1)  // BKIN (PB12) low turns the outputs off, pull-up
+#define BRIDGE_BREAK_HIGH			(1 << 2)  // BKIN high turns the outputs off, pull-down
+#define BRIDGE_AUTO_RESTART			(1 << 3)  // Outputs on again once BKIN is released (AOE)
+
+// Timer setup of a bridge : PWM period and dead-time
+typedef struct
+{
+	PWM_TIMING_type pwm;            /* PSC, ARR, duty steps, frequency obtained     */
+	uint32_t dtg;                   /* BDTR DTG                                     */
+	uint32_t deadClocks;            /* Dead-time in timer clocks                    */
+	uint32_t deadNs;                /* Dead-time obtained in ns                     */
+} BRIDGE_TIMING_type;
+
+extern BRIDGE_TIMING_type bridgeTiming;   // Running setup
+
+uint32_t bridgeDeadTime(uint32_t timclk, uint32_t ns, BRIDGE_TIMING_type *t);
+uint32_t bridgeStart(uint32_t hz, uint32_t deadNs, uint32_t channels, uint32_t flags);
+void bridgeStop(void);
+void bridgeSetDuty(uint32_t channel, uint32_t duty);
+void bridgeSetDuties(const uint16_t *duty);
+void bridgeBreak(void);
+uint32_t bridgeResume(void);
+uint32_t bridgeRunning(void);
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ * File Name  : tim2capture.c Ver 1.0
+ *
+ * Description:
+ *   Frequency and duty measurement on PA0 by TIM2 input capture and DMA
+ *   (see tim2capture.h)
+ *
+ *   capTimerHandler must be the TIM2 entry (0x0B0) of the vector table.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for input capture by DMA **********************
+
+1.	Input prescaler 2^n : smallest n with maxHz / 2^n <= CAP_RATE_MAX
+2.	Timer prescaler : 2^n periods of minHz in 32768 ticks at most
+3.	Enable GPIOA, AFIO, TIM2 (RCC->APB1ENR) and DMA1 clocks, PA0 input
+	floating
+4.	DMA1 channel 5 (TIM2_CH1) : CPAR = &TIM2->CCR1, CMAR = capRise,
+	channel 7 (TIM2_CH2) : CPAR = &TIM2->CCR2, CMAR = capFall, both
+	peripheral to memory, 16 bit, memory increment, circular, no interrupt
+5.	TIM2 : PSC, ARR 0xFFFF, CCMR1 CC1S 01 (TI1) and CC2S 10 (TI1 too),
+	IC1PSC = IC2PSC = n, DIER CC1DE, CC2DE and UIE
+6.	CCER CC1E, CC2E, CC2P (falling), then CEN
+7.	Update interrupt : newest CAP_WINDOW + 1 timestamps of both buffers
+	from the CNDTR of the channels, frequency from the rising edges, high
+	time from falling - rising, published with the sequence count
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "tim2capture.h"
+
+// DMA channel configuration register (CCR) bits
+#define DMA_CCR_EN					(1 << 0)
+#define DMA_CCR_CIRC				(1 << 5)
+#define DMA_CCR_MINC				(1 << 7)
+#define DMA_CCR_PSIZE_16			(1 << 8)
+#define DMA_CCR_MSIZE_16			(1 << 10)
+#define DMA_CCR_PL_HIGH				(2 << 12)
+
+// DMA flags of channel 5 (ISR / IFCR)
+#define DMA_ISR_TCIF5				(1 << 17)
+#define DMA_ISR_HTIF5				(1 << 18)
+
+#define TIM_CR1_CEN					(1 << 0)
+#define TIM_SR_UIF					(1 << 0)
+#define TIM_SR_CC1OF				(1 << 9)
+#define TIM_SR_CC2OF				(1 << 10)
+#define TIM_DIER_UIE				(1 << 0)
+#define TIM_DIER_CC1DE				(1 << 9)
+#define TIM_DIER_CC2DE				(1 << 10)
+#define TIM_EGR_UG					(1 << 0)
+#define TIM_CCMR1_CC1S_TI1			(1 << 0)
+#define TIM_CCMR1_CC2S_TI1			(2 << 8)
+#define TIM_CCER_CC1E				(1 << 0)
+#define TIM_CCER_CC2E				(1 << 4)
+#define TIM_CCER_CC2P				(1 << 5)
+
+#define CAP_HALF_TICKS				(32768)   // Longest capture interval
+
+volatile CAP_STATS_type capStats;
+
+static volatile uint16_t capRise[CAP_SAMPLES];  // CCR1 : rising edges
+static volatile uint16_t capFall[CAP_SAMPLES];  // CCR2 : falling edges
+
+// Published result, fields written by the update interrupt only
+static volatile uint32_t capSequence;           // Odd while the fields change
+static volatile CAP_RESULT_type capResult;
+
+static uint32_t capPsc;                         // Input prescaler 2^capPsc
+static uint32_t capTicks;                       // TIM2 PSC + 1
+static uint32_t lastPos;                        // Rising edge buffer position at the last update
+static uint32_t primed;                         // CAP_WINDOW + 1 timestamps written
+
+/*
+ * Funtion Name		: capPublish
+ * Description 		: New result for capRead : sequence count odd, fields,
+ *					  sequence count even
+ * Input			: hz, millihertz, duty, highNs, periods
+ * Return Value		: None
+*/
+static void capPublish(uint32_t hz, uint32_t millihertz, uint32_t duty, uint32_t highNs, uint32_t periods)
+{
+	capSequence++;
+	capResult.hz = hz;
+	capResult.millihertz = millihertz;
+	capResult.duty = duty;
+	capResult.highNs = highNs;
+	capResult.periods = periods;
+	capResult.updates++;
+	capSequence++;
+}
+
+/*
+ * Funtion Name		: capStart
+ * Description 		: Starts measuring the signal on PA0
+ * Input			: minHz, maxHz range of the signal
+ * Return Value		: 2^n edges per capture, 0 : range not possible
+*/
+uint32_t capStart(uint32_t minHz, uint32_t maxHz)
+{
+	uint32_t timclk = clockFreq.timApb1clk;
+	uint32_t n = 0, ticks;
+
+	if (minHz == 0 || minHz > maxHz)
+		return 0;
+	while ((maxHz >> n) > CAP_RATE_MAX && n < CAP_PSC_MAX)
+		n++;
+	if ((maxHz >> n) > CAP_RATE_MAX)
+		return 0;
+	ticks = (((unsigned long long) timclk << n) + (unsigned long long) minHz * CAP_HALF_TICKS - 1) /
+			((unsigned long long) minHz * CAP_HALF_TICKS);
+	if (ticks == 0)
+		ticks = 1;
+	if (ticks > 0x10000)
+		return 0;
+
+	capStop();
+	capPsc = n;
+	capTicks = ticks;
+	lastPos = 0;
+	primed = 0;
+	capStats.updates = 0;
+	capStats.skipped = 0;
+	capStats.lost = 0;
+	capStats.overcaptures = 0;
+	capSequence = 0;
+	capResult.updates = 0;
+	capPublish(0, 0, 0, 0, 0);
+
+	RCC->APB2ENR |= (1 << 2) | (1 << 0);   // GPIOA, AFIO clocks, no remap of TIM2
+	RCC->APB1ENR |= (1 << 0);   // TIM2 clock
+	RCC->AHBENR |= (1 << 0);    // DMA1 clock
+	GPIOA->CRL = (GPIOA->CRL & ~0xF) | 0x4;     // PA0 input floating
+
+	// DMA1 channels 5 and 7 : CCR1 / CCR2 -> timestamp buffers, circular
+	DMA1->IFCR = (0xF << 16) | (0xF << 24);
+	DMA1_Channel5->CPAR = DMA_ADDRESS(&TIM2->CCR1);
+	DMA1_Channel5->CMAR = DMA_ADDRESS(capRise);
+	DMA1_Channel5->CNDTR = CAP_SAMPLES;
+	DMA1_Channel5->CCR = DMA_CCR_PL_HIGH | DMA_CCR_MSIZE_16 | DMA_CCR_PSIZE_16 | DMA_CCR_MINC | DMA_CCR_CIRC;
+	DMA1_Channel7->CPAR = DMA_ADDRESS(&TIM2->CCR2);
+	DMA1_Channel7->CMAR = DMA_ADDRESS(capFall);
+	DMA1_Channel7->CNDTR = CAP_SAMPLES;
+	DMA1_Channel7->CCR = DMA_CCR_PL_HIGH | DMA_CCR_MSIZE_16 | DMA_CCR_PSIZE_16 | DMA_CCR_MINC | DMA_CCR_CIRC;
+	DMA1_Channel5->CCR |= DMA_CCR_EN;
+	DMA1_Channel7->CCR |= DMA_CCR_EN;
+
+	// Both channels on TI1, free running counter
+	TIM2->PSC = ticks - 1;
+	TIM2->ARR = 0xFFFF;
+	TIM2->CCMR1 = TIM_CCMR1_CC1S_TI1 | (n << 2) | TIM_CCMR1_CC2S_TI1 | (n << 10);
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->SR = 0;
+	TIM2->DIER = TIM_DIER_CC1DE | TIM_DIER_CC2DE | TIM_DIER_UIE;
+	TIM2->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC2P;
+
+	NVIC->IPR[TIM2_IRQn] = 0x10;
+	NVIC->ISER[TIM2_IRQn >> 5] = (1 << (TIM2_IRQn & 0x1F));
+	TIM2->CR1 = TIM_CR1_CEN;
+
+	return 1 << n;
+}
+
+/*
+ * Funtion Name		: capStop
+ * Description 		: Stops TIM2 and both DMA channels, the last result stays
+ * Input			: None
+ * Return Value		: None
+*/
+void capStop(void)
+{
+	RCC->APB1ENR |= (1 << 0);   // TIM2 clock
+	RCC->AHBENR |= (1 << 0);    // DMA1 clock
+	NVIC->ICER[TIM2_IRQn >> 5] = (1 << (TIM2_IRQn & 0x1F));
+	TIM2->CR1 = 0;
+	TIM2->DIER = 0;
+	TIM2->CCER = 0;
+	DMA1_Channel5->CCR = 0;
+	DMA1_Channel7->CCR = 0;
+}
+
+/*
+ * Funtion Name		: capUpdate
+ * Description 		: Result from the newest timestamps of both buffers
+ * Input			: None
+ * Return Value		: None
+*/
+static void capUpdate(void)
+{
+	uint32_t risePos, fallPos, last, moved, i, k;
+	uint32_t span, periods, period256, high256, isr;
+	int32_t high;
+	unsigned long long mhz;
+
+	isr = DMA1->ISR & (DMA_ISR_TCIF5 | DMA_ISR_HTIF5);
+	DMA1->IFCR = isr;
+
+	risePos = (CAP_SAMPLES - DMA1_Channel5->CNDTR) % CAP_SAMPLES;
+	fallPos = (CAP_SAMPLES - DMA1_Channel7->CNDTR) % CAP_SAMPLES;
+	if (risePos == lastPos && isr == 0) {
+		// No capture since the last update
+		capStats.lost++;
+		capPublish(0, 0, 0, 0, 0);
+		return;
+	}
+	lastPos = risePos;
+	if (risePos > CAP_WINDOW || isr != 0)
+		primed = 1;
+	if (!primed)
+		return;
+
+	// Newest index both channels wrote : one of them may be an edge ahead
+	last = (((risePos - fallPos) % CAP_SAMPLES) == 1) ? fallPos : risePos;
+	last = (last + CAP_SAMPLES - 1) % CAP_SAMPLES;
+
+	span = 0;
+	high = 0;
+	for (i = 0; i < CAP_WINDOW; i++) {
+		k = (last + CAP_SAMPLES - i) % CAP_SAMPLES;
+		span += (uint16_t) (capRise[k] - capRise[(k + CAP_SAMPLES - 1) % CAP_SAMPLES]);
+		high += (int16_t) (capFall[k] - capRise[k]);
+	}
+
+	// The DMA must not have reached the window while it was read
+	moved = (CAP_SAMPLES - DMA1_Channel5->CNDTR - risePos) % CAP_SAMPLES;
+	if (moved >= CAP_SAMPLES - CAP_WINDOW - 1) {
+		capStats.skipped++;
+		return;
+	}
+	if (span == 0)
+		return;
+
+	// Period and high time in 1/256 timer ticks, high modulo the period
+	periods = CAP_WINDOW << capPsc;
+	period256 = (span << 8) / periods;
+	high = (high * 256) / CAP_WINDOW;
+	high %= (int32_t) period256;
+	if (high < 0)
+		high += period256;
+	high256 = high;
+
+	mhz = ((unsigned long long) clockFreq.timApb1clk * periods * 1000 + (unsigned long long) span * capTicks / 2) /
+		  ((unsigned long long) span * capTicks);
+	capPublish((mhz + 500) / 1000, (mhz > 0xFFFFFFFFull) ? 0 : mhz,
+			   (unsigned long long) high256 * 10000 / period256,
+			   ((unsigned long long) high256 * capTicks * 1000000 / (clockFreq.timApb1clk / 1000) + 128) >> 8,
+			   periods);
+}
+
+/*
+ * Funtion Name		: capTimerHandler
+ * Description 		: TIM2 update interrupt : publishes a new result
+ * Input			: None
+ * Return Value		: None
+*/
+void capTimerHandler(void)
+{
+	uint32_t sr = TIM2->SR;
+
+	TIM2->SR = ~(sr & (TIM_SR_UIF | TIM_SR_CC1OF | TIM_SR_CC2OF));
+	if (sr & (TIM_SR_CC1OF | TIM_SR_CC2OF))
+		capStats.overcaptures++;
+	if (!(sr & TIM_SR_UIF))
+		return;
+	capStats.updates++;
+	capUpdate();
+}
+
+/*
+ * Funtion Name		: capRead
+ * Description 		: Copy of the newest result, never waits for the
+ *					  interrupt : retried while it was being published
+ * Input			: r result
+ * Return Value		: 1 copied, 0 : published meanwhile CAP_READ_TRIES times
+*/
+uint32_t capRead(CAP_RESULT_type *r)
+{
+	uint32_t tries, sequence;
+
+	for (tries = 0; tries < CAP_READ_TRIES; tries++) {
+		sequence = capSequence;
+		if (sequence & 1)
+			continue;
+		r->hz = capResult.hz;
+		r->millihertz = capResult.millihertz;
+		r->duty = capResult.duty;
+		r->highNs = capResult.highNs;
+		r->periods = capResult.periods;
+		r->updates = capResult.updates;
+		if (capSequence == sequence)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,91 @@
+#ifndef TIM2CAPTURE_H
+#define TIM2CAPTURE_H
+
+/*
+ * File Name  : tim2capture.h Ver 1.0
+ *
+ * Description:
+ *   Frequency and duty of an external signal on PA0 (TIM2 CH1) by input
+ *   capture and DMA, no interrupt per edge
+ *
+ *      TI1 PA0 --+-- IC1 (CC1S 01, rising)  -> CCR1 -> DMA1 ch5 -> capRise[]
+ *                +-- IC2 (CC2S 10, falling) -> CCR2 -> DMA1 ch7 -> capFall[]
+ *
+ *   Both channels capture the one pin, as in the PWM input mode of the
+ *   reference manual, but the counter runs free (ARR 0xFFFF, no slave
+ *   reset) : the captures are timestamps, and the DMA writes them into
+ *   two circular buffers of CAP_SAMPLES entries with no CPU in the path.
+ *   The input prescaler (ICxPSC) captures every 1, 2, 4 or 8 edges, so a
+ *   signal of several MHz gives at most CAP_RATE_MAX captures per second
+ *   and channel.
+ *
+ *   The TIM2 update interrupt (counter overflow, 1.1 kHz at most) takes
+ *   the newest CAP_WINDOW + 1 timestamps of both buffers :
+ *
+ *      period = (rise[last] - rise[last - CAP_WINDOW]) / (CAP_WINDOW << psc)
+ *      high   = average of (fall[i] - rise[i]) modulo period
+ *
+ *   The frequency is the average over CAP_WINDOW << psc periods : one
+ *   timer tick (13.9 ns at 72 MHz) is divided by up to 256 periods, a
+ *   6 MHz signal (12 ticks per period) reads within 0.03 %.
+ *
+ *   The timer prescaler is taken from the lowest frequency : 2^psc
+ *   periods of minHz must fit in half the 16 bit counter, so every
+ *   difference of two timestamps is exact. With no capture between two
+ *   updates the signal is lost and the result reads 0 Hz.
+ *
+ *   The result is published through a sequence count (seqlock) : the
+ *   interrupt makes it odd, writes the fields and makes it even again,
+ *   capRead copies the fields and retries when the count was odd or
+ *   changed meanwhile. Neither side waits for or masks the other.
+ *
+ *      capStart(500, 2000);                    // 1 kHz signal
+ *      ...
+ *      CAP_RESULT_type r;
+ *      if (capRead(&r) && r.hz != 0)
+ *          ... r.hz, r.duty ...
+ *
+ *   capTimerHandler must be the TIM2 entry (0x0B0) of the vector table
+ *   (IVT_TIM2, stm32f1ivt.h). TIM2, DMA1 channels 5 and 7 are used.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define CAP_SAMPLES					(128)     // Timestamps per DMA buffer
+#define CAP_WINDOW					(32)      // Capture intervals averaged
+#define CAP_RATE_MAX				(1000000) // Captures per second and channel
+#define CAP_PSC_MAX					(3)       // Input prescaler : every 8 edges
+#define CAP_READ_TRIES				(4)
+
+// Published measurement
+typedef struct
+{
+	uint32_t hz;                    /* Frequency, 0 : no signal                     */
+	uint32_t millihertz;            /* Frequency in 0.001 Hz, 0 above 4.29 MHz      */
+	uint32_t duty;                  /* High time in 0.01 %                          */
+	uint32_t highNs;                /* High time in ns                              */
+	uint32_t periods;               /* Signal periods averaged                      */
+	uint32_t updates;               /* Results published since capStart             */
+} CAP_RESULT_type;
+
+typedef struct
+{
+	uint32_t updates;               /* Update interrupts                            */
+	uint32_t skipped;               /* Window overwritten by the DMA while read     */
+	uint32_t lost;                  /* Updates with no capture (no signal)          */
+	uint32_t overcaptures;          /* Capture not read by the DMA in time          */
+} CAP_STATS_type;
+
+extern volatile CAP_STATS_type capStats;
+
+uint32_t capStart(uint32_t minHz, uint32_t maxHz);
+void capStop(void);
+uint32_t capRead(CAP_RESULT_type *r);
+void capTimerHandler(void);
+
+#endif
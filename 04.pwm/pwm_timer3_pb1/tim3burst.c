@@ -0,0 +1,129 @@
+/*
+ * File Name  : tim3burst.c Ver 1.0
+ *
+ * Description:
+ *   TIM3 DMA burst of CCR1-CCR4 (and ARR) rows on every update event
+ *   (see tim3burst.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for TIM3 DMA burst **********************
+
+1.	TIM3 running as PWM (pwmStart), CCRx and ARR preloaded
+2.	Enable DMA1 clock (RCC->AHBENR)
+3.	TIM3->DCR : DBA first register of the row, DBL registers - 1
+4.	DMA1 channel 3 (TIM3_UP) : CPAR = &TIM3->DMAR, CMAR = table,
+	CNDTR = rows * registers, memory to peripheral, 16 bit to 16 bit,
+	memory increment, circular for a repeated table
+5.	Enable the channel, then TIM3->DIER UDE : from the next update event
+	on each event moves one row
+6.	Stop : UDE off first, then the channel
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "tim3burst.h"
+
+// DMA channel configuration register (CCR) bits
+#define DMA_CCR_EN					(1 << 0)
+#define DMA_CCR_DIR					(1 << 4)  // Memory to peripheral
+#define DMA_CCR_CIRC				(1 << 5)
+#define DMA_CCR_MINC				(1 << 7)
+#define DMA_CCR_PSIZE_16			(1 << 8)
+#define DMA_CCR_MSIZE_16			(1 << 10)
+#define DMA_CCR_PL_HIGH				(2 << 12)
+
+// DMA interrupt flags of channel 3 (ISR / IFCR)
+#define DMA_ISR_GIF3				(1 << 8)
+#define DMA_ISR_TCIF3				(1 << 9)
+#define DMA_ISR_HTIF3				(1 << 10)
+#define DMA_ISR_TEIF3				(1 << 11)
+
+#define TIM_DIER_UDE				(1 << 8)
+
+#define TIM_DBA_ARR					(0x2C / 4)
+#define TIM_DBA_CCR1				(0x34 / 4)
+
+static uint32_t burstWords;             // Halfwords per row
+static uint32_t burstLength;            // Halfwords of the table
+
+/*
+ * Funtion Name		: pwmBurstStart
+ * Description 		: Streams a table of rows into TIM3, one row per update
+ *					  event. TIM3 must run (pwmStart).
+ * Input			: table (RAM, rows of PWM_BURST_ROW_type or with
+ *					  PWM_BURST_ARR of PWM_BURST_ARR_ROW_type), rows,
+ *					  flags PWM_BURST_ARR / PWM_BURST_LOOP
+ * Return Value		: 1 started, 0 : no rows or table above 65535 halfwords
+*/
+uint32_t pwmBurstStart(const void *table, uint32_t rows, uint32_t flags)
+{
+	uint32_t ccr, words;
+
+	words = (flags & PWM_BURST_ARR) ? sizeof(PWM_BURST_ARR_ROW_type) / 2 : sizeof(PWM_BURST_ROW_type) / 2;
+	if (rows == 0 || rows > 0xFFFF / words)
+		return 0;
+
+	RCC->AHBENR |= (1 << 0);    // DMA1 clock
+	pwmBurstStop();
+
+	// DBL[12:8] transfers - 1, DBA[4:0] first register
+	TIM3->DCR = ((words - 1) << 8) | ((flags & PWM_BURST_ARR) ? TIM_DBA_ARR : TIM_DBA_CCR1);
+
+	// DMA1 channel 3 : table -> TIM3->DMAR, 16 bit
+	ccr = DMA_CCR_PL_HIGH | DMA_CCR_MSIZE_16 | DMA_CCR_PSIZE_16 | DMA_CCR_MINC | DMA_CCR_DIR;
+	if (flags & PWM_BURST_LOOP)
+		ccr |= DMA_CCR_CIRC;
+	burstWords = words;
+	burstLength = rows * words;
+	DMA1->IFCR = DMA_ISR_GIF3 | DMA_ISR_TCIF3 | DMA_ISR_HTIF3 | DMA_ISR_TEIF3;
+	DMA1_Channel3->CPAR = DMA_ADDRESS(&TIM3->DMAR);
+	DMA1_Channel3->CMAR = DMA_ADDRESS(table);
+	DMA1_Channel3->CNDTR = burstLength;
+	DMA1_Channel3->CCR = ccr;
+	DMA1_Channel3->CCR = ccr | DMA_CCR_EN;
+
+	TIM3->DIER |= TIM_DIER_UDE;
+
+	return 1;
+}
+
+/*
+ * Funtion Name		: pwmBurstStop
+ * Description 		: No more rows, the registers keep the last row
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmBurstStop(void)
+{
+	TIM3->DIER &= ~TIM_DIER_UDE;
+	DMA1_Channel3->CCR &= ~DMA_CCR_EN;
+}
+
+/*
+ * Funtion Name		: pwmBurstRows
+ * Description 		: Rows sent, in a repeated table the row position
+ * Input			: None
+ * Return Value		: rows
+*/
+uint32_t pwmBurstRows(void)
+{
+	if (burstWords == 0)
+		return 0;
+	return (burstLength - DMA1_Channel3->CNDTR) / burstWords;
+}
+
+/*
+ * Funtion Name		: pwmBurstBusy
+ * Description 		: Rows left to send (a repeated table never ends)
+ * Input			: None
+ * Return Value		: 1 busy, 0 : table sent or stopped
+*/
+uint32_t pwmBurstBusy(void)
+{
+	return (DMA1_Channel3->CCR & DMA_CCR_EN) && DMA1_Channel3->CNDTR != 0;
+}
@@ -0,0 +1,66 @@
+#ifndef TIM3BURST_H
+#define TIM3BURST_H
+
+/*
+ * File Name  : tim3burst.h Ver 1.0
+ *
+ * Description:
+ *   TIM3 DMA burst : a table of CCR1-CCR4 (and ARR) rows in RAM written to
+ *   the timer on every update event by DMA1 channel 3, no CPU
+ *
+ *   DCR sets a block of timer registers, DBA the first (in words from
+ *   CR1) and DBL the count - 1. With UDE set every update event requests
+ *   DMA, and each DMA access to DMAR goes to the next register of the
+ *   block : one request moves a whole row. The table is a run of rows
+ *   as the registers lie in the timer :
+ *
+ *      CCR1-CCR4       : DBA 13 (0x34), DBL 3, PWM_BURST_ROW_type
+ *      ARR, RCR, CCRx  : DBA 11 (0x2C), DBL 5, PWM_BURST_ARR_ROW_type
+ *                        (RCR at 0x30 only exists on TIM1/TIM8, the
+ *                        word is sent and ignored)
+ *
+ *   The rows hold timer ticks (compare values), not 0.01 % : they are
+ *   computed for the running pwmTiming. ARR and CCRx are preloaded
+ *   (tim3pwm.c), the shadow registers are loaded at the update event
+ *   before the DMA writes the row, so the row sent at update event n is
+ *   the period after update event n + 1 : output follows the table one
+ *   period late and no pulse is cut.
+ *
+ *      pwmStart(20000, PWM_CH1 | PWM_CH2 | PWM_CH3 | PWM_CH4, 0);
+ *      pwmBurstStart(table, 64, PWM_BURST_LOOP);       // 64 rows, repeated
+ *
+ *   While a burst runs pwmSetDuty/pwmSetDuties/pwmSetFrequency are
+ *   overwritten by the next row. DMA1 channel 3 is also the TIM3 CH4
+ *   request, CC4DE must stay off.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define PWM_BURST_ARR				(1 << 0)  // Rows start with ARR (frequency per row)
+#define PWM_BURST_LOOP				(1 << 1)  // Table repeated (circular DMA)
+
+// Row of CCR1-CCR4
+typedef struct
+{
+	uint16_t ccr[4];
+} PWM_BURST_ROW_type;
+
+// Row of ARR and CCR1-CCR4
+typedef struct
+{
+	uint16_t arr;
+	uint16_t rcr;                   /* Not on TIM3, ignored                         */
+	uint16_t ccr[4];
+} PWM_BURST_ARR_ROW_type;
+
+uint32_t pwmBurstStart(const void *table, uint32_t rows, uint32_t flags);
+void pwmBurstStop(void);
+uint32_t pwmBurstRows(void);
+uint32_t pwmBurstBusy(void);
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * File Name  : tim3pwm.c Ver 1.0
+ *
+ * Description:
+ *   TIM3 PWM on all four compare channels with preloaded registers
+ *   (see tim3pwm.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for TIM3 four channel PWM **********************
+
+1.	Enable clocks : TIM3 (RCC->APB1ENR), GPIOA, GPIOB, AFIO (RCC->APB2ENR)
+2.	Pins of the channels : alternate function push-pull, 50 MHz
+3.	Reset CR1, PSC and ARR from pwmPlan, CCRx from the duty
+4.	CCMR1/CCMR2 : OCxM 110 (PWM mode 1) and OCxPE (CCRx preload)
+5.	CCER : CCxE output enable, CCxP for active low outputs
+6.	EGR UG : PSC, ARR and CCRx into the shadow registers before the start
+7.	CR1 : ARPE (ARR preload) and CEN
+8.	Changes : CCRx / ARR / PSC written any time, taken at the next update
+	event. Several registers : UDIS set while writing them
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "tim3pwm.h"
+
+#define TIM_CR1_CEN					(1 << 0)
+#define TIM_CR1_UDIS				(1 << 1)
+#define TIM_CR1_ARPE				(1 << 7)
+#define TIM_EGR_UG					(1 << 0)
+#define TIM_OCM_PWM1				(6)
+#define TIM_CCMR_OCPE				(1 << 3)
+
+PWM_TIMING_type pwmTiming;
+
+static uint32_t pwmChannels;
+static uint16_t pwmDuty[PWM_CHANNELS];
+
+/*
+ * Funtion Name		: pwmPlan
+ * Description 		: PSC/ARR of a PWM frequency. The smallest prescaler that
+ *					  fits ARR in 16 bits, so the period has the most steps.
+ * Input			: timclk timer clock, hz frequency, t (result)
+ * Return Value		: None, t->hz is 0 if hz is 0 or above timclk / 2
+*/
+void pwmPlan(uint32_t timclk, uint32_t hz, PWM_TIMING_type *t)
+{
+	uint32_t ticks, steps;
+
+	t->hz = 0;
+	if (hz == 0 || hz > timclk / 2)
+		return;
+
+	ticks = timclk / hz;                        // Timer clocks per period
+	t->psc = (ticks - 1) / 65536;
+	steps = (timclk / (t->psc + 1) + hz / 2) / hz;
+	if (steps > 65536)
+		steps = 65536;
+
+	t->arr = steps - 1;
+	t->steps = steps;
+	t->hz = timclk / ((t->psc + 1) * steps);
+	for (t->bits = 0; (2u << t->bits) <= steps; t->bits++);
+}
+
+/*
+ * Funtion Name		: pwmCompare
+ * Description 		: CCRx of a duty at the running period
+ * Input			: duty 0 .. PWM_DUTY_FULL
+ * Return Value		: compare value, 0 .. ARR + 1
+*/
+static uint32_t pwmCompare(uint32_t duty)
+{
+	if (duty > PWM_DUTY_FULL)
+		duty = PWM_DUTY_FULL;
+	return duty * pwmTiming.steps / PWM_DUTY_FULL;
+}
+
+/*
+ * Funtion Name		: pwmSetPin
+ * Description 		: Alternate function push-pull 50 MHz for the pin of a
+ *					  channel (PA6, PA7, PB0, PB1)
+ * Input			: channel 1 .. 4
+ * Return Value		: None
+*/
+static void pwmSetPin(uint32_t channel)
+{
+	if (channel <= 2) {
+		RCC->APB2ENR |= (1 << 2);                   // GPIOA clock
+		GPIOA->CRL = (GPIOA->CRL & ~(0xF << ((channel + 5) * 4))) | (0xB << ((channel + 5) * 4));
+	} else {
+		RCC->APB2ENR |= (1 << 3);                   // GPIOB clock
+		GPIOB->CRL = (GPIOB->CRL & ~(0xF << ((channel - 3) * 4))) | (0xB << ((channel - 3) * 4));
+	}
+}
+
+/*
+ * Funtion Name		: pwmStart
+ * Description 		: TIM3 PWM at 'hz' on the channels of the mask, duty 0
+ * Input			: hz, channels (PWM_CHx mask), activeLow (PWM_CHx mask,
+ *					  output low while active, e.g. LED to 3.3 V)
+ * Return Value		: Frequency obtained, 0 : not possible
+*/
+uint32_t pwmStart(uint32_t hz, uint32_t channels, uint32_t activeLow)
+{
+	PWM_TIMING_type t;
+
+	pwmPlan(clockFreq.timApb1clk, hz, &t);
+	return pwmStartTiming(&t, channels, activeLow);
+}
+
+/*
+ * Funtion Name		: pwmStartTiming
+ * Description 		: As pwmStart with PSC/ARR given, e.g. from a planner
+ *					  with other goals than pwmPlan (tim3wave.c)
+ * Input			: t (psc, arr, steps and hz set), channels, activeLow
+ * Return Value		: Frequency, 0 : not possible (t->hz 0)
+*/
+uint32_t pwmStartTiming(const PWM_TIMING_type *t, uint32_t channels, uint32_t activeLow)
+{
+	uint32_t ch, ccmr1 = 0, ccmr2 = 0, ccer = 0;
+
+	if (t->hz == 0)
+		return 0;
+	pwmTiming = *t;
+
+	RCC->APB1ENR |= (1 << 1);   // TIM3 clock
+	RCC->APB2ENR |= (1 << 0);   // AFIO clock, no remap of TIM3
+
+	pwmChannels = channels & 0xF;
+	for (ch = 1; ch <= PWM_CHANNELS; ch++) {
+		pwmDuty[ch - 1] = 0;
+		if (!(pwmChannels & (1 << (ch - 1))))
+			continue;
+
+		pwmSetPin(ch);
+		if (ch <= 2)
+			ccmr1 |= ((TIM_OCM_PWM1 << 4) | TIM_CCMR_OCPE) << ((ch - 1) * 8);
+		else
+			ccmr2 |= ((TIM_OCM_PWM1 << 4) | TIM_CCMR_OCPE) << ((ch - 3) * 8);
+		ccer |= 1 << ((ch - 1) * 4);                // CCxE
+		if (activeLow & (1 << (ch - 1)))
+			ccer |= 2 << ((ch - 1) * 4);            // CCxP
+	}
+
+	TIM3->CR1 = 0;
+	TIM3->PSC = pwmTiming.psc;
+	TIM3->ARR = pwmTiming.arr;
+	TIM3->CCR1 = 0;
+	TIM3->CCR2 = 0;
+	TIM3->CCR3 = 0;
+	TIM3->CCR4 = 0;
+	TIM3->CCMR1 = ccmr1;
+	TIM3->CCMR2 = ccmr2;
+	TIM3->CCER = ccer;
+	TIM3->EGR = TIM_EGR_UG;     // Preload registers into the shadow registers
+	TIM3->SR = 0;
+	TIM3->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+
+	return pwmTiming.hz;
+}
+
+/*
+ * Funtion Name		: pwmStop
+ * Description 		: Counter and outputs off
+ * Input			: None
+ * Return Value		: None
+*/
+void pwmStop(void)
+{
+	TIM3->CR1 &= ~TIM_CR1_CEN;
+	TIM3->CCER = 0;
+}
+
+/*
+ * Funtion Name		: pwmSetDuty
+ * Description 		: Duty of one channel from the next period on
+ * Input			: channel 1 .. 4, duty 0 .. PWM_DUTY_FULL (0.01 %)
+ * Return Value		: None
+*/
+void pwmSetDuty(uint32_t channel, uint32_t duty)
+{
+	if (channel < 1 || channel > PWM_CHANNELS)
+		return;
+
+	pwmDuty[channel - 1] = duty;
+	(&TIM3->CCR1)[channel - 1] = pwmCompare(duty);
+}
+
+/*
+ * Funtion Name		: pwmSetDuties
+ * Description 		: Duty of all four channels, taken at the same update
+ *					  event (UDIS while writing)
+ * Input			: duty[4] 0 .. PWM_DUTY_FULL (0.01 %)
+ * Return Value		: None
+*/
+void pwmSetDuties(const uint16_t *duty)
+{
+	uint32_t ch;
+
+	TIM3->CR1 |= TIM_CR1_UDIS;
+	for (ch = 0; ch < PWM_CHANNELS; ch++) {
+		pwmDuty[ch] = duty[ch];
+		(&TIM3->CCR1)[ch] = pwmCompare(duty[ch]);
+	}
+	TIM3->CR1 &= ~TIM_CR1_UDIS;
+}
+
+/*
+ * Funtion Name		: pwmSetFrequency
+ * Description 		: New PSC/ARR from the next period on, CCRx rescaled to
+ *					  keep the duty of each channel
+ * Input			: hz
+ * Return Value		: Frequency obtained, 0 : not possible (unchanged)
+*/
+uint32_t pwmSetFrequency(uint32_t hz)
+{
+	PWM_TIMING_type t;
+	uint32_t ch;
+
+	pwmPlan(clockFreq.timApb1clk, hz, &t);
+	if (t.hz == 0)
+		return 0;
+
+	TIM3->CR1 |= TIM_CR1_UDIS;
+	pwmTiming = t;
+	TIM3->PSC = t.psc;
+	TIM3->ARR = t.arr;
+	for (ch = 0; ch < PWM_CHANNELS; ch++)
+		(&TIM3->CCR1)[ch] = pwmCompare(pwmDuty[ch]);
+	TIM3->CR1 &= ~TIM_CR1_UDIS;
+
+	return t.hz;
+}
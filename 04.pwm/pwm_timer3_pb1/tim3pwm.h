@@ -0,0 +1,74 @@
+#ifndef TIM3PWM_H
+#define TIM3PWM_H
+
+/*
+ * File Name  : tim3pwm.h Ver 1.0
+ *
+ * Description:
+ *   TIM3 PWM on all four compare channels with preloaded registers
+ *
+ *      CH1 PA6    CH2 PA7    CH3 PB0    CH4 PB1     (no remap)
+ *
+ *   Edge aligned PWM mode 1, counting up : the output is active while
+ *   CNT < CCRx, period = ARR + 1 ticks of timclk / (PSC + 1).
+ *
+ *   ARR (ARPE) and CCR1-4 (OCxPE) are preloaded : a write goes to the
+ *   preload register and is copied to the shadow register the compare
+ *   uses at the next update event (counter overflow). A duty or frequency
+ *   change written anywhere in the period therefore starts with the next
+ *   full period, there is no short or missing pulse, and no interrupt is
+ *   needed to time the write. pwmSetDuties and pwmSetFrequency write
+ *   several registers with UDIS set, so the update event cannot fall
+ *   between two of the writes and all of them change at the same period.
+ *
+ *   Frequency and resolution come from the timer clock (clockFreq.timApb1clk,
+ *   72 MHz) : pwmPlan takes the smallest prescaler that fits ARR in 16
+ *   bits, so the period has the most timer ticks (duty steps) possible :
+ *
+ *      1 kHz   : PSC 1, 36000 steps (15 bits)
+ *      20 kHz  : PSC 0,  3600 steps (11 bits)
+ *      800 kHz : PSC 0,    90 steps ( 6 bits)
+ *
+ *   Duty is given in 0.01 % (0 .. PWM_DUTY_FULL) and kept, a new frequency
+ *   keeps the duty of each channel.
+ *
+ *      pwmStart(1000, PWM_CH1 | PWM_CH4, PWM_CH4);     // 1 kHz, CH4 active low
+ *      pwmSetDuty(1, 2500);                            // CH1 25 %
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define PWM_CH1						(1 << 0)  // PA6
+#define PWM_CH2						(1 << 1)  // PA7
+#define PWM_CH3						(1 << 2)  // PB0
+#define PWM_CH4						(1 << 3)  // PB1
+#define PWM_CHANNELS				(4)
+
+#define PWM_DUTY_FULL				(10000)   // 100.00 %
+
+// PSC/ARR of a PWM frequency : hz = timclk / ((PSC + 1) * (ARR + 1))
+typedef struct
+{
+	uint32_t psc;
+	uint32_t arr;
+	uint32_t hz;                    /* Frequency obtained, 0 : not possible         */
+	uint32_t steps;                 /* Duty steps per period, ARR + 1               */
+	uint32_t bits;                  /* Resolution, whole bits of steps              */
+} PWM_TIMING_type;
+
+extern PWM_TIMING_type pwmTiming;   // Running frequency
+
+void pwmPlan(uint32_t timclk, uint32_t hz, PWM_TIMING_type *t);
+uint32_t pwmStart(uint32_t hz, uint32_t channels, uint32_t activeLow);
+uint32_t pwmStartTiming(const PWM_TIMING_type *t, uint32_t channels, uint32_t activeLow);
+void pwmStop(void);
+void pwmSetDuty(uint32_t channel, uint32_t duty);
+void pwmSetDuties(const uint16_t *duty);
+uint32_t pwmSetFrequency(uint32_t hz);
+
+#endif
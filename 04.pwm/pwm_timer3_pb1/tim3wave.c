@@ -0,0 +1,222 @@
+/*
+ * File Name  : tim3wave.c Ver 1.0
+ *
+ * Description:
+ *   Waveform synthesis on a TIM3 PWM channel, DMA into CCRx on every
+ *   update event (see tim3wave.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for TIM3 waveform synthesis **********************
+
+1.	wavPlan : timer clocks per output period = timclk / hz, samples =
+	those clocks / 2^bits (at most maxSamples), steps = clocks / samples
+	rounded, PSC if steps does not fit 16 bits
+2.	wavTable : one compare value per sample, 0 .. steps
+3.	TIM3 PWM on the channel with the planned PSC/ARR (pwmStartTiming),
+	CCRx preloaded
+4.	Enable DMA1 clock (RCC->AHBENR)
+5.	DMA1 channel 3 (TIM3_UP) : CPAR = &TIM3->CCRx, CMAR = table,
+	CNDTR = samples, memory to peripheral, 16 bit to 16 bit, memory
+	increment, circular
+6.	Enable the channel, then TIM3->DIER UDE : one sample per update event
+	from then on, the table repeats without CPU
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "tim3pwm.h"
+#include "tim3wave.h"
+
+// DMA channel configuration register (CCR) bits
+#define DMA_CCR_EN					(1 << 0)
+#define DMA_CCR_DIR					(1 << 4)  // Memory to peripheral
+#define DMA_CCR_CIRC				(1 << 5)
+#define DMA_CCR_MINC				(1 << 7)
+#define DMA_CCR_PSIZE_16			(1 << 8)
+#define DMA_CCR_MSIZE_16			(1 << 10)
+#define DMA_CCR_PL_HIGH				(2 << 12)
+
+// DMA interrupt flags of channel 3 (ISR / IFCR)
+#define DMA_ISR_GIF3				(1 << 8)
+#define DMA_ISR_TCIF3				(1 << 9)
+#define DMA_ISR_HTIF3				(1 << 10)
+#define DMA_ISR_TEIF3				(1 << 11)
+
+#define TIM_DIER_UDE				(1 << 8)
+
+// sin(0 .. 90 degrees) in Q15, 64 intervals
+static const int16_t wavQuarterSine[65] = {
+	    0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+	 6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+	12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+	18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+	23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+	27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+	30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+	32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+	32767,
+};
+
+/*
+ * Funtion Name		: wavPlan
+ * Description 		: Carrier and table length of an output frequency at a
+ *					  resolution : the most samples with 2^bits steps each
+ * Input			: timclk timer clock, hz output frequency, bits of
+ *					  amplitude (1 .. 16), maxSamples table size, p (result)
+ * Return Value		: None, p->millihertz is 0 if not possible (fewer
+ *					  than WAV_SAMPLES_MIN samples at that resolution)
+*/
+void wavPlan(uint32_t timclk, uint32_t hz, uint32_t bits, uint32_t maxSamples, WAV_PLAN_type *p)
+{
+	PWM_TIMING_type *t = &p->pwm;
+	uint32_t clocks, samples, ticks;
+
+	p->millihertz = 0;
+	t->hz = 0;
+	if (hz == 0 || bits < 1 || bits > 16)
+		return;
+
+	clocks = (timclk + hz / 2) / hz;            // Timer clocks per output period
+	samples = clocks >> bits;
+	if (samples > maxSamples)
+		samples = maxSamples;
+	if (samples < WAV_SAMPLES_MIN)
+		return;
+
+	ticks = (clocks + samples / 2) / samples;   // Timer clocks per sample
+	t->psc = (ticks - 1) / 65536;
+	t->steps = (ticks + (t->psc + 1) / 2) / (t->psc + 1);
+	if (t->steps > 65536)
+		t->steps = 65536;
+	t->arr = t->steps - 1;
+	t->hz = timclk / ((t->psc + 1) * t->steps);
+	for (t->bits = 0; (2u << t->bits) <= t->steps; t->bits++);
+
+	p->samples = samples;
+	p->millihertz = (unsigned long long) timclk * 1000 / ((unsigned long long) (t->psc + 1) * t->steps * samples);
+}
+
+/*
+ * Funtion Name		: wavShape
+ * Description 		: One point of a waveform
+ * Input			: shape WAV_SINE .. WAV_SQUARE, phase 0 .. 0xFFFF (one period)
+ * Return Value		: -32767 .. 32767
+*/
+static int32_t wavShape(uint32_t shape, uint32_t phase)
+{
+	uint32_t q, idx, frac;
+	int32_t s;
+
+	switch (shape) {
+	case WAV_TRIANGLE:
+		if (phase < 0x8000)
+			s = (int32_t) (phase * 2) - 32767;
+		else
+			s = 32767 - (int32_t) ((phase - 0x8000) * 2);
+		break;
+	case WAV_SAWTOOTH:
+		s = (int32_t) phase - 32767;
+		break;
+	case WAV_SQUARE:
+		s = (phase < 0x8000) ? 32767 : -32767;
+		break;
+	default:
+		// Quarter wave table, mirrored : rising 0-90, falling 90-180, negative 180-360
+		q = phase & 0x3FFF;
+		if (phase & 0x4000)
+			q = 0x4000 - q;
+		idx = q >> 8;
+		frac = q & 0xFF;
+		s = wavQuarterSine[idx];
+		if (frac)
+			s += ((wavQuarterSine[idx + 1] - s) * (int32_t) frac) >> 8;
+		if (phase & 0x8000)
+			s = -s;
+		break;
+	}
+	if (s > 32767)
+		s = 32767;
+	return s;
+}
+
+/*
+ * Funtion Name		: wavTable
+ * Description 		: Compare values of one period of a waveform around
+ *					  half of the steps
+ * Input			: shape WAV_SINE .. WAV_SQUARE, table (samples entries),
+ *					  samples, steps (ARR + 1), amplitude peak to peak in
+ *					  0.01 % of the steps (PWM_DUTY_FULL : 0 .. steps)
+ * Return Value		: None
+*/
+void wavTable(uint32_t shape, uint16_t *table, uint32_t samples, uint32_t steps, uint32_t amplitude)
+{
+	int32_t half, v;
+	uint32_t i;
+
+	if (amplitude > PWM_DUTY_FULL)
+		amplitude = PWM_DUTY_FULL;
+	half = steps * amplitude / PWM_DUTY_FULL / 2;
+
+	for (i = 0; i < samples; i++) {
+		v = (int32_t) (steps / 2) + wavShape(shape, (i << 16) / samples) * half / 32767;
+		if (v < 0)
+			v = 0;
+		if (v > (int32_t) steps)
+			v = steps;
+		table[i] = v;
+	}
+}
+
+/*
+ * Funtion Name		: wavStart
+ * Description 		: TIM3 PWM on one channel at the planned carrier, the
+ *					  table played into its CCRx by DMA, repeated
+ * Input			: table (p->samples compare values, RAM or flash),
+ *					  p plan of wavPlan, channel 1 .. 4
+ * Return Value		: Output frequency in 0.001 Hz, 0 : not started
+*/
+uint32_t wavStart(const uint16_t *table, const WAV_PLAN_type *p, uint32_t channel)
+{
+	uint32_t ccr;
+
+	if (p->millihertz == 0 || channel < 1 || channel > PWM_CHANNELS)
+		return 0;
+
+	RCC->AHBENR |= (1 << 0);    // DMA1 clock
+	RCC->APB1ENR |= (1 << 1);   // TIM3 clock, for UDE off before the restart
+	wavStop();
+	if (pwmStartTiming(&p->pwm, 1 << (channel - 1), 0) == 0)
+		return 0;
+
+	// DMA1 channel 3 : table -> TIM3->CCRx, 16 bit, circular
+	ccr = DMA_CCR_PL_HIGH | DMA_CCR_MSIZE_16 | DMA_CCR_PSIZE_16 | DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_DIR;
+	DMA1->IFCR = DMA_ISR_GIF3 | DMA_ISR_TCIF3 | DMA_ISR_HTIF3 | DMA_ISR_TEIF3;
+	DMA1_Channel3->CPAR = DMA_ADDRESS(&(&TIM3->CCR1)[channel - 1]);
+	DMA1_Channel3->CMAR = DMA_ADDRESS(table);
+	DMA1_Channel3->CNDTR = p->samples;
+	DMA1_Channel3->CCR = ccr;
+	DMA1_Channel3->CCR = ccr | DMA_CCR_EN;
+
+	TIM3->DIER |= TIM_DIER_UDE;
+
+	return p->millihertz;
+}
+
+/*
+ * Funtion Name		: wavStop
+ * Description 		: DMA and PWM off
+ * Input			: None
+ * Return Value		: None
+*/
+void wavStop(void)
+{
+	TIM3->DIER &= ~TIM_DIER_UDE;
+	DMA1_Channel3->CCR &= ~DMA_CCR_EN;
+	pwmStop();
+}
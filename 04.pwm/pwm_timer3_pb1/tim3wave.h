@@ -0,0 +1,77 @@
+#ifndef TIM3WAVE_H
+#define TIM3WAVE_H
+
+/*
+ * File Name  : tim3wave.h Ver 1.0
+ *
+ * Description:
+ *   Waveform synthesis on a TIM3 PWM channel : a table of compare values
+ *   played into CCRx by DMA1 channel 3 on every update event, circular,
+ *   no interrupt per sample
+ *
+ *   Each PWM period outputs one sample as its duty; an RC low pass (or
+ *   the speaker, the LED) behind the pin keeps the waveform and removes
+ *   the carrier. With 'samples' entries in the table :
+ *
+ *      carrier = timclk / ((PSC + 1) * steps)      steps = ARR + 1
+ *      output  = carrier / samples
+ *
+ *   so steps * samples is fixed by the output frequency : more samples
+ *   per period move the carrier away from the signal (easier filter),
+ *   more steps give more amplitude resolution. wavPlan takes the
+ *   resolution in bits and fits the most samples to it (up to
+ *   maxSamples), then rounds steps to the output frequency. At 72 MHz :
+ *
+ *      output   bits    samples    steps     carrier      output obtained
+ *      1 kHz     8       281        256      281 kHz      1000.89 Hz
+ *      440 Hz   10       159       1029       70 kHz       440.07 Hz
+ *      50 Hz    12       351       4103     17.5 kHz        49.99 Hz
+ *
+ *   wavTable fills a RAM table with a sine, triangle, sawtooth or square
+ *   (integer only, quarter wave sine table with interpolation). Any other
+ *   table of compare values 0 .. steps works the same, also a const one
+ *   in flash made for the planned steps.
+ *
+ *      static uint16_t table[WAV_SAMPLES_MAX];
+ *      WAV_PLAN_type plan;
+ *
+ *      wavPlan(clockFreq.timApb1clk, 1000, 8, WAV_SAMPLES_MAX, &plan);
+ *      wavTable(WAV_SINE, table, plan.samples, plan.pwm.steps, PWM_DUTY_FULL);
+ *      wavStart(table, &plan, 4);                      // CH4 (PB1)
+ *
+ *   CCRx is preloaded, a sample is written at one update event and is the
+ *   duty of the period after the next one. DMA1 channel 3 (TIM3_UP) is
+ *   shared with the DMA burst (tim3burst.c), only one of them runs.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+#include "tim3pwm.h"
+
+#define WAV_SINE					(0)
+#define WAV_TRIANGLE				(1)
+#define WAV_SAWTOOTH				(2)
+#define WAV_SQUARE					(3)
+
+#define WAV_SAMPLES_MIN				(4)
+#define WAV_SAMPLES_MAX				(1024)    // Table size of the examples
+
+// Timer and table of an output frequency
+typedef struct
+{
+	PWM_TIMING_type pwm;            /* Carrier : PSC, ARR, steps, bits, hz          */
+	uint32_t samples;               /* Table entries per output period              */
+	uint32_t millihertz;            /* Output frequency obtained in 0.001 Hz, 0 :   */
+	                                /* not possible                                 */
+} WAV_PLAN_type;
+
+void wavPlan(uint32_t timclk, uint32_t hz, uint32_t bits, uint32_t maxSamples, WAV_PLAN_type *p);
+void wavTable(uint32_t shape, uint16_t *table, uint32_t samples, uint32_t steps, uint32_t amplitude);
+uint32_t wavStart(const uint16_t *table, const WAV_PLAN_type *p, uint32_t channel);
+void wavStop(void);
+
+#endif
@@ -0,0 +1,243 @@
+/*
+ * File Name  : ws2812.c Ver 1.0
+ *
+ * Description:
+ *   WS2812 LED strip on PB1 by TIM3 CH4 PWM and DMA (see ws2812.h)
+ *
+ *   ws2812DmaHandler must be the DMA1 channel 3 entry (0x074) of the
+ *   vector table.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for WS2812 by PWM + DMA **********************
+
+1.	TIM3 CH4 PWM at 800 kHz (pwmStart), CCR4 0 : line low
+2.	Compare values of a 0 and a 1 bit from the timer ticks, table of the
+	four compare bytes of every nibble
+3.	Enable DMA1 clock (RCC->AHBENR), DMA1_Channel3 interrupt in the NVIC
+4.	Frame : encode the first two chunks of LEDs into both halves of the
+	duty buffer (G R B, MSB first, one byte per bit)
+5.	DMA1 channel 3 (TIM3_UP) : CPAR = &TIM3->CCR4, CMAR = duty buffer,
+	memory to peripheral, 8 bit to 16 bit, memory increment, circular,
+	half transfer and transfer complete interrupts
+6.	Enable the channel, then TIM3->DIER UDE : one bit per PWM period
+7.	Half sent (HT / TC) : encode the next chunk into it, zeros (line low)
+	after the last LED
+8.	Zero chunks for WS2812_RESET_US sent : UDE off, channel off, the
+	line stays low (CCR4 0)
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "tim3pwm.h"
+#include "ws2812.h"
+
+// DMA channel configuration register (CCR) bits
+#define DMA_CCR_EN					(1 << 0)
+#define DMA_CCR_TCIE				(1 << 1)
+#define DMA_CCR_HTIE				(1 << 2)
+#define DMA_CCR_DIR					(1 << 4)  // Memory to peripheral
+#define DMA_CCR_CIRC				(1 << 5)
+#define DMA_CCR_MINC				(1 << 7)
+#define DMA_CCR_PSIZE_16			(1 << 8)
+#define DMA_CCR_MSIZE_8				(0 << 10)
+#define DMA_CCR_PL_HIGH				(2 << 12)
+
+// DMA interrupt flags of channel 3 (ISR / IFCR)
+#define DMA_ISR_GIF3				(1 << 8)
+#define DMA_ISR_TCIF3				(1 << 9)
+#define DMA_ISR_HTIF3				(1 << 10)
+#define DMA_ISR_TEIF3				(1 << 11)
+
+#define TIM_DIER_UDE				(1 << 8)
+
+#define WS2812_BITS					(24)
+#define CHUNK_BYTES					(WS2812_CHUNK_PIXELS * WS2812_BITS)
+#define CHUNK_WORDS					(CHUNK_BYTES / 4)
+#define CHUNK_NS					(CHUNK_BYTES * (1000000000 / WS2812_HZ))
+#define RESET_CHUNKS				((WS2812_RESET_US * 1000 + CHUNK_NS - 1) / CHUNK_NS)
+
+volatile WS2812_STATS_type ws2812Stats;
+
+static uint32_t dutyBuffer[2 * CHUNK_WORDS];    // Two chunks, one byte per bit
+static uint32_t nibbleDuty[16];                 // Compare bytes of 4 bits, MSB first
+
+static const uint8_t *frame;
+static uint32_t frameLength;
+static uint32_t nextPixel;
+static uint32_t zeroChunks;                     // Chunks of zeros after the last LED
+static volatile uint32_t busy;
+
+/*
+ * Funtion Name		: encodeChunk
+ * Description 		: Duty bytes of the next WS2812_CHUNK_PIXELS LEDs, zeros
+ *					  once all LEDs are encoded
+ * Input			: dst half of the duty buffer
+ * Return Value		: None
+*/
+static void encodeChunk(uint32_t *dst)
+{
+	const uint8_t *rgb;
+	uint32_t n;
+
+	if (nextPixel >= frameLength) {
+		for (n = 0; n < CHUNK_WORDS; n++)
+			dst[n] = 0;
+		zeroChunks++;
+		return;
+	}
+
+	for (n = 0; n < WS2812_CHUNK_PIXELS; n++, dst += 6) {
+		if (nextPixel >= frameLength) {
+			dst[0] = dst[1] = dst[2] = dst[3] = dst[4] = dst[5] = 0;
+			continue;
+		}
+		rgb = &frame[nextPixel++ * 3];
+		dst[0] = nibbleDuty[rgb[1] >> 4];           // G
+		dst[1] = nibbleDuty[rgb[1] & 0xF];
+		dst[2] = nibbleDuty[rgb[0] >> 4];           // R
+		dst[3] = nibbleDuty[rgb[0] & 0xF];
+		dst[4] = nibbleDuty[rgb[2] >> 4];           // B
+		dst[5] = nibbleDuty[rgb[2] & 0xF];
+	}
+}
+
+/*
+ * Funtion Name		: ws2812Stop
+ * Description 		: End of a frame, the line stays low
+ * Input			: None
+ * Return Value		: None
+*/
+static void ws2812Stop(void)
+{
+	TIM3->DIER &= ~TIM_DIER_UDE;
+	DMA1_Channel3->CCR &= ~DMA_CCR_EN;
+	busy = 0;
+}
+
+/*
+ * Funtion Name		: ws2812Init
+ * Description 		: TIM3 CH4 (PB1) at 800 kHz, line low, duty of a 0 and
+ *					  a 1 bit, DMA1 channel 3 interrupt
+ * Input			: None
+ * Return Value		: Bit rate obtained, 0 : not possible at this clock
+*/
+uint32_t ws2812Init(void)
+{
+	uint32_t tickKhz, duty0, duty1, n, bit;
+
+	if (pwmStart(WS2812_HZ, PWM_CH4, 0) == 0)
+		return 0;
+
+	// Compare values rounded to the timer tick
+	tickKhz = clockFreq.timApb1clk / (pwmTiming.psc + 1) / 1000;
+	duty0 = (WS2812_T0H_NS * tickKhz + 500000) / 1000000;
+	duty1 = (WS2812_T1H_NS * tickKhz + 500000) / 1000000;
+	if (duty1 > 0xFF || duty1 >= pwmTiming.steps)
+		return 0;
+
+	// Byte 0 (sent first) is the MSB of the nibble
+	for (n = 0; n < 16; n++) {
+		nibbleDuty[n] = 0;
+		for (bit = 0; bit < 4; bit++)
+			nibbleDuty[n] |= ((n & (8 >> bit)) ? duty1 : duty0) << (bit * 8);
+	}
+
+	RCC->AHBENR |= (1 << 0);    // DMA1 clock
+	ws2812Stop();
+	NVIC->IPR[DMA1_Channel3_IRQn] = 0x10;
+	NVIC->ISER[DMA1_Channel3_IRQn >> 5] = (1 << (DMA1_Channel3_IRQn & 0x1F));
+
+	return pwmTiming.hz;
+}
+
+/*
+ * Funtion Name		: ws2812Show
+ * Description 		: Starts sending a frame, returns at once. The pixels
+ *					  are read while the frame is sent.
+ * Input			: rgb (R, G, B bytes per LED), count LEDs
+ * Return Value		: 1 started, 0 : busy or no LED
+*/
+uint32_t ws2812Show(const uint8_t *rgb, uint32_t count)
+{
+	if (busy || count == 0)
+		return 0;
+
+	frame = rgb;
+	frameLength = count;
+	nextPixel = 0;
+	zeroChunks = 0;
+	encodeChunk(&dutyBuffer[0]);
+	encodeChunk(&dutyBuffer[CHUNK_WORDS]);
+
+	// DMA1 channel 3 : duty bytes -> TIM3->CCR4, circular over both halves
+	DMA1->IFCR = DMA_ISR_GIF3 | DMA_ISR_TCIF3 | DMA_ISR_HTIF3 | DMA_ISR_TEIF3;
+	DMA1_Channel3->CPAR = DMA_ADDRESS(&TIM3->CCR4);
+	DMA1_Channel3->CMAR = DMA_ADDRESS(dutyBuffer);
+	DMA1_Channel3->CNDTR = 2 * CHUNK_BYTES;
+	DMA1_Channel3->CCR = DMA_CCR_PL_HIGH | DMA_CCR_MSIZE_8 | DMA_CCR_PSIZE_16 | DMA_CCR_MINC |
+						 DMA_CCR_CIRC | DMA_CCR_DIR | DMA_CCR_HTIE | DMA_CCR_TCIE;
+	busy = 1;
+	DMA1_Channel3->CCR |= DMA_CCR_EN;
+
+	TIM3->DIER |= TIM_DIER_UDE;
+
+	return 1;
+}
+
+/*
+ * Funtion Name		: ws2812Busy
+ * Description 		: Frame (and its reset time) still being sent
+ * Input			: None
+ * Return Value		: 1 busy, 0 : ws2812Show can start the next frame
+*/
+uint32_t ws2812Busy(void)
+{
+	return busy;
+}
+
+/*
+ * Funtion Name		: ws2812DmaHandler
+ * Description 		: DMA1 channel 3 interrupt. Half transfer : first half
+ *					  sent, encode it again; transfer complete : second
+ *					  half. After the reset time of zeros the frame ends.
+ * Input			: None
+ * Return Value		: None
+*/
+void ws2812DmaHandler(void)
+{
+	uint32_t isr = DMA1->ISR;
+	uint32_t first;
+
+	if ((isr & DMA_ISR_HTIF3) && (isr & DMA_ISR_TCIF3))
+		ws2812Stats.late++;                         // Both halves sent, one chunk lost
+
+	if (isr & DMA_ISR_HTIF3) {
+		DMA1->IFCR = DMA_ISR_HTIF3;
+		first = 1;
+	} else if (isr & DMA_ISR_TCIF3) {
+		DMA1->IFCR = DMA_ISR_TCIF3;
+		first = 0;
+	} else {
+		return;
+	}
+	ws2812Stats.chunks++;
+
+	// The half in flight is zeros too : reset time done
+	if (zeroChunks > RESET_CHUNKS) {
+		ws2812Stop();
+		ws2812Stats.frames++;
+		return;
+	}
+
+	encodeChunk(first ? &dutyBuffer[0] : &dutyBuffer[CHUNK_WORDS]);
+
+	// The DMA must still be in the other half
+	if ((DMA1_Channel3->CNDTR > CHUNK_BYTES) == first)
+		ws2812Stats.late++;
+}
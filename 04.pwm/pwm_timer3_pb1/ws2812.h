@@ -0,0 +1,71 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+/*
+ * File Name  : ws2812.h Ver 1.0
+ *
+ * Description:
+ *   WS2812 / NeoPixel LED strip on PB1 (TIM3 CH4) : 800 kHz PWM, one
+ *   period per bit, the duty of each bit written into CCR4 by DMA
+ *
+ *   A bit is 1.25 us : high 0.4 us for 0, high 0.8 us for 1 (datasheet
+ *   +-150 ns), 24 bits per LED in the order G R B, MSB first. The line
+ *   held low for WS2812_RESET_US latches the frame.
+ *
+ *   Every bit takes one byte of duty (the compare value, 90 steps at
+ *   72 MHz), the DMA widens it to CCR4 (8 bit memory, 16 bit peripheral).
+ *   The duty buffer holds two chunks of WS2812_CHUNK_PIXELS LEDs only :
+ *   while the DMA sends one, the half transfer / transfer complete
+ *   interrupt encodes the next LEDs into the other. The buffer is
+ *   2 * 4 * 24 = 192 bytes for any strip length, the pixels stay 3 bytes
+ *   per LED (R, G, B) in the buffer of the application.
+ *
+ *   A chunk of 4 LEDs is sent in 120 us : the interrupt must encode it
+ *   within that time, a chunk encoded late is counted in ws2812Stats.late
+ *   (the strip shows a wrong color). A higher priority interrupt longer
+ *   than a chunk causes this, WS2812_CHUNK_PIXELS trades RAM for
+ *   latency.
+ *
+ *   300 LEDs : 7200 bits, 9.0 ms + 0.36 ms reset = 106 frames per second
+ *   at most, 79 interrupts per frame.
+ *
+ *      static uint8_t strip[300 * 3];      // R, G, B per LED
+ *
+ *      ws2812Init();
+ *      ...
+ *      if (!ws2812Busy())
+ *          ws2812Show(strip, 300);
+ *
+ *   ws2812DmaHandler must be the DMA1 channel 3 entry (0x074) of the
+ *   vector table (IVT_DMA1_CH3, stm32f1ivt.h). TIM3 and DMA1 channel 3
+ *   are used by the driver (not with tim3burst.c / tim3wave.c).
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define WS2812_HZ					(800000)  // Bit rate
+#define WS2812_T0H_NS				(400)     // High time of a 0
+#define WS2812_T1H_NS				(800)     // High time of a 1
+#define WS2812_RESET_US				(300)     // Low time that latches (WS2812B > 280 us)
+#define WS2812_CHUNK_PIXELS			(4)       // LEDs per half of the duty buffer
+
+typedef struct
+{
+	uint32_t frames;                /* Frames sent                                  */
+	uint32_t chunks;                /* Chunk interrupts                             */
+	uint32_t late;                  /* Chunks encoded after the DMA reached them    */
+} WS2812_STATS_type;
+
+extern volatile WS2812_STATS_type ws2812Stats;
+
+uint32_t ws2812Init(void);
+uint32_t ws2812Show(const uint8_t *rgb, uint32_t count);
+uint32_t ws2812Busy(void);
+void ws2812DmaHandler(void);
+
+#endif
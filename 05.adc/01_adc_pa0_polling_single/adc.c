@@ -20,6 +20,8 @@
  *
  *      Ext. Clock Freq     :   8 MHz   
  *      Int. Default Freq   :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
  *
  * Led Connection Details : PC13
  *
@@ -30,6 +32,7 @@
 
 /*************           ADC1           **********************
 
+0.	Switch system clock to 72 MHz, ADC clock 12 MHz (clockInit72MHz)
 1.	Enable Clock for GPIOA Port,Analog Block, and Alternate Function (RCC->APB2ENR)
 2.	Configure PC13 pin as Output Push Pull and PB5 as alternate function (GPIOC->CRH)
 
@@ -61,94 +64,12 @@
 
 *****************************************************/
 
-/*************************************************
-* Definitions
-*************************************************/
-#define int32_t         int
-#define int16_t         short
-#define int8_t          char
-#define uint32_t        unsigned int
-#define uint16_t        unsigned short
-#define uint8_t         unsigned char
-
-
-// Define the base addresses for peripherals
-#define PERIPH_BASE     ((uint32_t) 0x40000000)
-#define SRAM_BASE       ((uint32_t) 0x20000000)
-
-#define APB1PERIPH_BASE PERIPH_BASE
-#define APB2PERIPH_BASE (PERIPH_BASE + 0x10000)
-#define AHBPERIPH_BASE  (PERIPH_BASE + 0x20000)
-
-#define GPIOA_BASE      (PERIPH_BASE + 0x10800) // GPIOC base address is 0x40011000
-#define GPIOC_BASE      (PERIPH_BASE + 0x11000) // GPIOC base address is 0x40011000
-#define ADC1_BASE       (APB2PERIPH_BASE + 0x2400) //  ADC1 base address is 0x40012400
-#define RCC_BASE        ( AHBPERIPH_BASE + 0x1000) //   RCC base address is 0x40021000
-
-#define STACKINIT       0x20002000
-
-#define GPIOA   ((GPIO_type *)  GPIOA_BASE)
-#define GPIOC   ((GPIO_type *)  GPIOC_BASE)
-#define ADC1            ((ADC_type   *)  ADC1_BASE)
-#define RCC             ((RCC_type   *)   RCC_BASE)
-
-
-/*
- * Register Addresses
- */
-typedef struct
-{
-	uint32_t CRL;      /* GPIO port configuration register low,      Address offset: 0x00 */
-	uint32_t CRH;      /* GPIO port configuration register high,     Address offset: 0x04 */
-	uint32_t IDR;      /* GPIO port input data register,             Address offset: 0x08 */
-	uint32_t ODR;      /* GPIO port output data register,            Address offset: 0x0C */
-	uint32_t BSRR;     /* GPIO port bit set/reset register,          Address offset: 0x10 */
-	uint32_t BRR;      /* GPIO port bit reset register,              Address offset: 0x14 */
-	uint32_t LCKR;     /* GPIO port configuration lock register,     Address offset: 0x18 */
-} GPIO_type;
-
-
-typedef struct
-{
-	uint32_t CR;       /* RCC clock control register,                Address offset: 0x00 */
-	uint32_t CFGR;     /* RCC clock configuration register,          Address offset: 0x04 */
-	uint32_t CIR;      /* RCC clock interrupt register,              Address offset: 0x08 */
-	uint32_t APB2RSTR; /* RCC APB2 peripheral reset register,        Address offset: 0x0C */
-	uint32_t APB1RSTR; /* RCC APB1 peripheral reset register,        Address offset: 0x10 */
-	uint32_t AHBENR;   /* RCC AHB peripheral clock enable register,  Address offset: 0x14 */
-	uint32_t APB2ENR;  /* RCC APB2 peripheral clock enable register, Address offset: 0x18 */
-	uint32_t APB1ENR;  /* RCC APB1 peripheral clock enable register, Address offset: 0x1C */
-	uint32_t BDCR;     /* RCC backup domain control register,        Address offset: 0x20 */
-	uint32_t CSR;      /* RCC control/status register,               Address offset: 0x24 */
-	uint32_t AHBRSTR;  /* RCC AHB peripheral clock reset register,   Address offset: 0x28 */
-	uint32_t CFGR2;    /* RCC clock configuration register 2,        Address offset: 0x2C */
-} RCC_type;
-
-typedef struct
-{
-	uint32_t SR;        /* Address offset: 0x00 */
-	uint32_t CR1;       /* Address offset: 0x04 */
-	uint32_t CR2;       /* Address offset: 0x08 */
-	uint32_t SMPR1;     /* Address offset: 0x0C */
-	uint32_t SMPR2;     /* Address offset: 0x10 */
-	uint32_t JOFR1;     /* Address offset: 0x14 */
-	uint32_t JOFR2;     /* Address offset: 0x18 */
-	uint32_t JOFR3;     /* Address offset: 0x1C */
-	uint32_t JOFR4;     /* Address offset: 0x20 */
-	uint32_t HTR;       /* Address offset: 0x24 */
-	uint32_t LTR;       /* Address offset: 0x28 */
-	uint32_t SQR1;      /* Address offset: 0x2C */
-	uint32_t SQR2;      /* Address offset: 0x30 */
-	uint32_t SQR3;      /* Address offset: 0x34 */
-	uint32_t JSQR;      /* Address offset: 0x38 */
-	uint32_t JDR1;      /* Address offset: 0x3C */
-	uint32_t JDR2;      /* Address offset: 0x40 */
-	uint32_t JDR3;      /* Address offset: 0x44 */
-	uint32_t JDR4;      /* Address offset: 0x48 */
-	uint32_t DR;        /* Address offset: 0x4C */
-} ADC_type;
-
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
 
+#define PROF_ADC_CONVERSION		(0)   // Profile region (make profile)
 
 int32_t main(void);
 
@@ -162,7 +83,7 @@ int32_t main(void);
 uint32_t (* const vector_table[])
 __attribute__ ((section(".vectors"))) = {
 	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
-	(uint32_t *) main,              /* 0x004 Reset                           */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
 	0,                              /* 0x008 Non maskable interrupt          */
 };
 
@@ -175,6 +96,14 @@ int32_t main(void)
 
     unsigned int adc_data;
     int i;
+
+    // SYSCLK 72 MHz, APB2 72 MHz -> ADCCLK 72 / 6 = 12 MHz
+    clockInit72MHz();
+
+	// Cycle counter and region names, empty without -DPROFILE
+	PROFILE_INIT();
+	PROFILE_NAME(PROF_ADC_CONVERSION, "ADC conversion loop");
+
 	//  Register RCC->APB2ENR
     // Enabling Clock for GPIOC RCC Register
     //  15     14     13   12   11    10    09    08   07   06    05    04    03   02    01   00
@@ -250,6 +179,8 @@ int32_t main(void)
 	// While loop ADC reading with Software Start
     while(1)
 	{
+		// SWSTART to result in adc_data
+		PROFILE_BEGIN(PROF_ADC_CONVERSION);
 		ADC1->CR2 |=  (1<<22); // SWSTART/
 		
 		// ADC1->SR will become 0x12 after start of conversion
@@ -259,6 +190,7 @@ int32_t main(void)
 			while( (ADC1->SR & (1 <<1) ) );// Output will be  ADC1->SR = 0x02
 			adc_data=ADC1->DR & 0x0000FFFF;
 		}
+		PROFILE_END(PROF_ADC_CONVERSION);
 
 		if(adc_data < 0x800)
 			GPIOC->BRR = (1 << 13);  //Switch ON LED
@@ -0,0 +1,111 @@
+#ifndef STM32F1REG_H
+#define STM32F1REG_H
+
+/*************************************************
+* Definitions
+*************************************************/
+#define int32_t         int
+#define int16_t         short
+#define int8_t          char
+#define uint32_t        unsigned int
+#define uint16_t        unsigned short
+#define uint8_t         unsigned char
+
+#define HSE_Value       ((uint32_t)  8000000) /* Value of the External oscillator in Hz (Blue Pill crystal) */
+#define HSI_Value       ((uint32_t)  8000000) /* Value of the Internal oscillator in Hz*/
+
+// Define the base addresses for peripherals
+#define PERIPH_BASE     ((uint32_t) 0x40000000)
+#define SRAM_BASE       ((uint32_t) 0x20000000)
+
+#define APB1PERIPH_BASE PERIPH_BASE
+#define APB2PERIPH_BASE (PERIPH_BASE + 0x10000)
+#define AHBPERIPH_BASE  (PERIPH_BASE + 0x20000)
+
+#define GPIOA_BASE      (PERIPH_BASE + 0x10800) // GPIOC base address is 0x40011000
+#define GPIOC_BASE      (PERIPH_BASE + 0x11000) // GPIOC base address is 0x40011000
+#define ADC1_BASE       (APB2PERIPH_BASE + 0x2400) //  ADC1 base address is 0x40012400
+#define RCC_BASE        ( AHBPERIPH_BASE + 0x1000) //   RCC base address is 0x40021000
+#define FLASH_BASE      ( AHBPERIPH_BASE + 0x2000) // FLASH base address is 0x40022000
+
+// Stack top (_estack) is defined in the linker script, Reset_Handler in startup.s
+extern uint32_t _estack;
+void Reset_Handler(void);
+#define STACKINIT       (&_estack)
+
+#define GPIOA   ((GPIO_type *)  GPIOA_BASE)
+#define GPIOC   ((GPIO_type *)  GPIOC_BASE)
+#define ADC1            ((ADC_type   *)  ADC1_BASE)
+#define RCC             ((RCC_type   *)   RCC_BASE)
+#define FLASH           ((FLASH_type *) FLASH_BASE)
+
+
+/*
+ * Register Addresses
+ */
+typedef struct
+{
+	uint32_t CRL;      /* GPIO port configuration register low,      Address offset: 0x00 */
+	uint32_t CRH;      /* GPIO port configuration register high,     Address offset: 0x04 */
+	uint32_t IDR;      /* GPIO port input data register,             Address offset: 0x08 */
+	uint32_t ODR;      /* GPIO port output data register,            Address offset: 0x0C */
+	uint32_t BSRR;     /* GPIO port bit set/reset register,          Address offset: 0x10 */
+	uint32_t BRR;      /* GPIO port bit reset register,              Address offset: 0x14 */
+	uint32_t LCKR;     /* GPIO port configuration lock register,     Address offset: 0x18 */
+} GPIO_type;
+
+
+typedef struct
+{
+	uint32_t CR;       /* RCC clock control register,                Address offset: 0x00 */
+	uint32_t CFGR;     /* RCC clock configuration register,          Address offset: 0x04 */
+	uint32_t CIR;      /* RCC clock interrupt register,              Address offset: 0x08 */
+	uint32_t APB2RSTR; /* RCC APB2 peripheral reset register,        Address offset: 0x0C */
+	uint32_t APB1RSTR; /* RCC APB1 peripheral reset register,        Address offset: 0x10 */
+	uint32_t AHBENR;   /* RCC AHB peripheral clock enable register,  Address offset: 0x14 */
+	uint32_t APB2ENR;  /* RCC APB2 peripheral clock enable register, Address offset: 0x18 */
+	uint32_t APB1ENR;  /* RCC APB1 peripheral clock enable register, Address offset: 0x1C */
+	uint32_t BDCR;     /* RCC backup domain control register,        Address offset: 0x20 */
+	uint32_t CSR;      /* RCC control/status register,               Address offset: 0x24 */
+	uint32_t AHBRSTR;  /* RCC AHB peripheral clock reset register,   Address offset: 0x28 */
+	uint32_t CFGR2;    /* RCC clock configuration register 2,        Address offset: 0x2C */
+} RCC_type;
+
+typedef struct
+{
+	uint32_t ACR;      /* FLASH access control register,             Address offset: 0x00 */
+	uint32_t KEYR;     /* FLASH key register,                        Address offset: 0x04 */
+	uint32_t OPTKEYR;  /* FLASH option key register,                 Address offset: 0x08 */
+	uint32_t SR;       /* FLASH status register,                     Address offset: 0x0C */
+	uint32_t CR;       /* FLASH control register,                    Address offset: 0x10 */
+	uint32_t AR;       /* FLASH address register,                    Address offset: 0x14 */
+	uint32_t RESERVED; /* Reserved,                                  Address offset: 0x18 */
+	uint32_t OBR;      /* FLASH option byte register,                Address offset: 0x1C */
+	uint32_t WRPR;     /* FLASH write protection register,           Address offset: 0x20 */
+} FLASH_type;
+
+typedef struct
+{
+	uint32_t SR;        /* Address offset: 0x00 */
+	uint32_t CR1;       /* Address offset: 0x04 */
+	uint32_t CR2;       /* Address offset: 0x08 */
+	uint32_t SMPR1;     /* Address offset: 0x0C */
+	uint32_t SMPR2;     /* Address offset: 0x10 */
+	uint32_t JOFR1;     /* Address offset: 0x14 */
+	uint32_t JOFR2;     /* Address offset: 0x18 */
+	uint32_t JOFR3;     /* Address offset: 0x1C */
+	uint32_t JOFR4;     /* Address offset: 0x20 */
+	uint32_t HTR;       /* Address offset: 0x24 */
+	uint32_t LTR;       /* Address offset: 0x28 */
+	uint32_t SQR1;      /* Address offset: 0x2C */
+	uint32_t SQR2;      /* Address offset: 0x30 */
+	uint32_t SQR3;      /* Address offset: 0x34 */
+	uint32_t JSQR;      /* Address offset: 0x38 */
+	uint32_t JDR1;      /* Address offset: 0x3C */
+	uint32_t JDR2;      /* Address offset: 0x40 */
+	uint32_t JDR3;      /* Address offset: 0x44 */
+	uint32_t JDR4;      /* Address offset: 0x48 */
+	uint32_t DR;        /* Address offset: 0x4C */
+} ADC_type;
+
+#endif
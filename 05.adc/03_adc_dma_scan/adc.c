@@ -0,0 +1,146 @@
+/*
+ * File Name  : adc.c
+ *
+ * Description:
+ *              : Continuous scan of ADC channels 0-3 (PA0-PA3) with DMA
+ *                  Scan + continuous mode, DMA1 channel 1 circular
+ *                  Ping-pong buffer, half ready in the DMA interrupt (adcscan.c)
+ *                  Mean of every channel per half buffer in adcMean[]
+ *                  if mean of channel 0 is less than 0x800 it will switch on LED connected to PC13
+ *
+ *                Sustained sample rate : DMA1->CNDTR keeps running while the
+ *                CPU only handles one interrupt per half buffer. After
+ *                RATE_HALVES halves adcRate holds samples, DWT cycles and
+ *                samples per second (measured and from the sample times).
+ *                make rate (st-util must be running) prints it.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0, PA1, PA2, PA3
+ *
+ * Step for generating bin : make
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+
+#define SCAN_CHANNELS			(4)
+#define HALF_SCANS				(64)      // Scans per half buffer
+#define RATE_SKIP				(16)      // Halves before the measurement starts
+#define RATE_HALVES				(1000)    // Halves measured
+
+typedef struct
+{
+	uint32_t halves;            /* Halves measured                            */
+	uint32_t samples;           /* Samples in these halves                    */
+	uint32_t cycles;            /* DWT cycles for them                        */
+	uint32_t samplesPerSecond;  /* samples * SYSCLK / cycles                  */
+	uint32_t expected;          /* From ADCCLK and the sample times           */
+	uint32_t overruns;          /* Halves the callback was too late for       */
+} ADCRATE_type;
+
+ADCRATE_type adcRate;
+volatile uint32_t adcMean[SCAN_CHANNELS];
+
+static const uint8_t scanChannels[SCAN_CHANNELS] = {0, 1, 2, 3};
+static const uint8_t scanSampleTimes[SCAN_CHANNELS] = {ADC_SMP_1_5, ADC_SMP_1_5, ADC_SMP_1_5, ADC_SMP_1_5};
+static uint16_t scanBuffer[2 * HALF_SCANS * SCAN_CHANNELS];
+
+static void halfReady(const uint16_t *samples, uint32_t scans);
+
+static const ADC_SCAN_type scan = {
+	scanChannels, scanSampleTimes, SCAN_CHANNELS, scanBuffer, HALF_SCANS, halfReady,
+	ADC_TRIGGER_SWSTART
+};
+
+static volatile uint32_t rateStart;
+static volatile uint32_t rateEnd;
+
+void adcScanDmaHandler(void);
+void adcRateDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/*
+ * Funtion Name		: halfReady
+ * Description 		: Half buffer complete (DMA interrupt) : mean of every
+ *					  channel, LED from channel 0, time stamps for adcRate
+ * Input			: samples, scans
+ * Return Value		: None
+*/
+static void halfReady(const uint16_t *samples, uint32_t scans)
+{
+	uint32_t sum[SCAN_CHANNELS] = {0};
+	uint32_t s, ch;
+
+	if (adcScanHalves == RATE_SKIP)
+		rateStart = PROFILE_DWT->CYCCNT;
+	else if (adcScanHalves == RATE_SKIP + RATE_HALVES)
+		rateEnd = PROFILE_DWT->CYCCNT;
+
+	for (s = 0; s < scans; ++s)
+		for (ch = 0; ch < SCAN_CHANNELS; ++ch)
+			sum[ch] += *samples++;
+	for (ch = 0; ch < SCAN_CHANNELS; ++ch)
+		adcMean[ch] = sum[ch] / scans;
+
+	if(adcMean[0] < 0x800)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+}
+
+/*
+ * Funtion Name		: adcRateDone
+ * Description 		: adcRate is filled, gdb breakpoint for make rate
+ * Input			: None
+ * Return Value		: None
+*/
+void adcRateDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	// SYSCLK 72 MHz, APB2 72 MHz -> ADCCLK 72 / 6 = 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK for PC13
+	GPIOC->CRH |= 0x00200000; // Make GPIOC Pin13 output (PC13)
+
+	adcScanStart(&scan);
+
+	// Conversions and DMA run without the CPU, only the half buffer interrupts
+	while (adcScanHalves < RATE_SKIP + RATE_HALVES + 1)
+		__asm__("wfi");
+
+	adcRate.halves = RATE_HALVES;
+	adcRate.samples = RATE_HALVES * HALF_SCANS * SCAN_CHANNELS;
+	adcRate.cycles = rateEnd - rateStart;
+	adcRate.samplesPerSecond = (uint32_t) ((unsigned long long) adcRate.samples * clockFreq.sysclk / adcRate.cycles);
+	adcRate.expected = adcScanSampleRate(&scan);
+	adcRate.overruns = adcScanOverruns;
+	adcRateDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,273 @@
+/*
+ * File Name  : adc_dual.c Ver 1.0
+ *
+ * Description:
+ *   Throughput : single ADC1 scan against ADC1 + ADC2 dual modes
+ *
+ *      - step 0 : ADC1 alone, PA0, sample time 1.5, continuous, 16 bit DMA
+ *        (adcscan.c, the path of adc.c)
+ *      - step 1 : regular simultaneous, ADC1 PA0 and ADC2 PA1 at the same
+ *        instant, one 32 bit DMA word per pair (adcdual.c)
+ *      - step 2 : fast interleaved, PA0 on both ADCs 7 ADC clocks apart,
+ *        one 32 bit DMA word per two samples
+ *
+ *   Each step runs RATE_HALVES half buffers after RATE_SKIP and records
+ *   samples, DWT cycles and samples per second (measured and from ADCCLK)
+ *   in adcThroughput. The CPU only takes one interrupt per half buffer in
+ *   all steps, the words per half are the same, so step 1 and 2 also show
+ *   the DMA transfers saved by packing two results into one word.
+ *
+ *   make dual (st-util must be running) stops in adcDualDone and prints
+ *   adcThroughput.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0, PA1
+ *
+ * Build            : make dual
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+#include "adcdual.h"
+
+#define HALF_WORDS				(64)      // DMA transfers per half buffer
+#define RATE_SKIP				(16)      // Halves before the measurement starts
+#define RATE_HALVES				(200)     // Halves measured
+#define THROUGHPUT_STEPS		(3)
+
+typedef struct
+{
+	uint32_t mode;              /* 0 : ADC1 alone, ADC_DUAL_x                 */
+	uint32_t samples;           /* Samples in the measured halves             */
+	uint32_t cycles;            /* DWT cycles for them                        */
+	uint32_t samplesPerSecond;  /* samples * SYSCLK / cycles                  */
+	uint32_t expected;          /* From ADCCLK and the sample times           */
+	uint32_t overruns;          /* Halves the callback was too late for       */
+} ADCTHROUGHPUT_type;
+
+ADCTHROUGHPUT_type adcThroughput[THROUGHPUT_STEPS];
+
+static const uint8_t singleChannel[1] = {0};        // PA0
+static const uint8_t pairChannel[1] = {1};          // PA1
+static const uint8_t fastSampleTime[1] = {ADC_SMP_1_5};
+
+static uint16_t singleBuffer[2 * HALF_WORDS];
+static uint32_t dualBuffer[2 * HALF_WORDS];
+
+static void singleReady(const uint16_t *samples, uint32_t scans);
+static void dualReady(const uint32_t *words, uint32_t count);
+
+static const ADC_SCAN_type single = {
+	singleChannel, fastSampleTime, 1, singleBuffer, HALF_WORDS, singleReady,
+	ADC_TRIGGER_SWSTART
+};
+
+static const ADC_DUAL_type simultaneous = {
+	ADC_DUAL_REGULAR_SIMULTANEOUS, singleChannel, pairChannel, fastSampleTime, 1,
+	dualBuffer, HALF_WORDS, dualReady
+};
+
+static const ADC_DUAL_type interleaved = {
+	ADC_DUAL_FAST_INTERLEAVED, singleChannel, singleChannel, fastSampleTime, 1,
+	dualBuffer, HALF_WORDS, dualReady
+};
+
+static volatile uint32_t rateHalves;
+static volatile uint32_t rateStart;
+static volatile uint32_t rateEnd;
+static uint32_t dualRunning;
+
+/*********** Function declarations ****************/
+void adcDmaInterrupt(void);
+void adcDualDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
+	0,                              /* 0x008 Non maskable interrupt          */
+	0,                              /* 0x00C HardFault                       */
+	0,                              /* 0x010 Memory Management               */
+	0,                              /* 0x014 BusFault                        */
+	0,                              /* 0x018 UsageFault                      */
+	0,                              /* 0x01C Reserved                        */
+	0,                              /* 0x020 Reserved                        */
+	0,                              /* 0x024 Reserved                        */
+	0,                              /* 0x028 Reserved                        */
+	0,                              /* 0x02C System service call             */
+	0,                              /* 0x030 Debug Monitor                   */
+	0,                              /* 0x034 Reserved                        */
+	0,                              /* 0x038 PendSV                          */
+	0,                              /* 0x03C System tick timer               */
+	0,                              /* 0x040 Window watchdog                 */
+	0,                              /* 0x044 PVD through EXTI Line detection */
+	0,                              /* 0x048 Tamper                          */
+	0,                              /* 0x04C RTC global                      */
+	0,                              /* 0x050 FLASH global                    */
+	0,                              /* 0x054 RCC global                      */
+	0,                              /* 0x058 EXTI Line0                      */
+	0,                              /* 0x05C EXTI Line1                      */
+	0,                              /* 0x060 EXTI Line2                      */
+	0,                              /* 0x064 EXTI Line3                      */
+	0,                              /* 0x068 EXTI Line4                      */
+	(uint32_t *) adcDmaInterrupt,   /* 0x06C DMA1_Ch1                        */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: rateStamp
+ * Description 		: One more half buffer, time stamps at the start and
+ *					  the end of the measured halves
+ * Input			: None
+ * Return Value		: None
+*/
+static void rateStamp(void)
+{
+	if (rateHalves == RATE_SKIP)
+		rateStart = PROFILE_DWT->CYCCNT;
+	else if (rateHalves == RATE_SKIP + RATE_HALVES)
+		rateEnd = PROFILE_DWT->CYCCNT;
+	rateHalves++;
+}
+
+/*
+ * Funtion Name		: singleReady
+ * Description 		: Half buffer of step 0, LED from the first sample
+ * Input			: samples, scans
+ * Return Value		: None
+*/
+static void singleReady(const uint16_t *samples, uint32_t scans)
+{
+	rateStamp();
+	if(samples[0] < 0x800)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+}
+
+/*
+ * Funtion Name		: dualReady
+ * Description 		: Half buffer of step 1 and 2, LED from the ADC1
+ *					  result of the first word
+ * Input			: words, count
+ * Return Value		: None
+*/
+static void dualReady(const uint32_t *words, uint32_t count)
+{
+	rateStamp();
+	if(ADC_DUAL_RESULT1(words[0]) < 0x800)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+}
+
+/*
+ * Funtion Name		: adcDmaInterrupt
+ * Description 		: DMA1 channel 1 interrupt, to the driver of the step
+ * Input			: None
+ * Return Value		: None
+*/
+void adcDmaInterrupt(void)
+{
+	if (dualRunning)
+		adcDualDmaHandler();
+	else
+		adcScanDmaHandler();
+}
+
+/*
+ * Funtion Name		: adcDualDone
+ * Description 		: adcThroughput is filled, gdb breakpoint for make dual
+ * Input			: None
+ * Return Value		: None
+*/
+void adcDualDone(void)
+{
+}
+
+/*
+ * Funtion Name		: throughputStep
+ * Description 		: Waits for the measured halves and fills one entry
+ * Input			: t entry, samplesPerWord 1 (16 bit) or 2 (dual word)
+ * Return Value		: None
+*/
+static void throughputStep(ADCTHROUGHPUT_type *t, uint32_t samplesPerWord)
+{
+	while (rateHalves < RATE_SKIP + RATE_HALVES + 1)
+		__asm__("wfi");
+
+	t->samples = RATE_HALVES * HALF_WORDS * samplesPerWord;
+	t->cycles = rateEnd - rateStart;
+	t->samplesPerSecond = (uint32_t) ((unsigned long long) t->samples * clockFreq.sysclk / t->cycles);
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	ADCTHROUGHPUT_type *t;
+
+	// SYSCLK 72 MHz, APB2 72 MHz -> ADCCLK 72 / 6 = 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK for PC13
+	GPIOC->CRH |= 0x00200000; // Make GPIOC Pin13 output (PC13)
+
+	// Step 0 : ADC1 alone
+	t = &adcThroughput[0];
+	t->mode = ADC_DUAL_INDEPENDENT;
+	rateHalves = 0;
+	dualRunning = 0;
+	adcScanStart(&single);
+	throughputStep(t, 1);
+	adcScanStop();
+	t->expected = adcScanSampleRate(&single);
+	t->overruns = adcScanOverruns;
+
+	// Step 1 : regular simultaneous, PA0 and PA1
+	t = &adcThroughput[1];
+	t->mode = ADC_DUAL_REGULAR_SIMULTANEOUS;
+	rateHalves = 0;
+	dualRunning = 1;
+	adcDualStart(&simultaneous);
+	throughputStep(t, 2);
+	adcDualStop();
+	t->expected = adcDualSampleRate(&simultaneous);
+	t->overruns = adcDualOverruns;
+
+	// Step 2 : fast interleaved, PA0
+	t = &adcThroughput[2];
+	t->mode = ADC_DUAL_FAST_INTERLEAVED;
+	rateHalves = 0;
+	adcDualStart(&interleaved);
+	throughputStep(t, 2);
+	adcDualStop();
+	t->expected = adcDualSampleRate(&interleaved);
+	t->overruns = adcDualOverruns;
+
+	adcDualDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,256 @@
+/*
+ * File Name  : adc_filter.c Ver 1.0
+ *
+ * Description:
+ *   Fixed point filters on the DMA half buffers, cycles per sample
+ *
+ *   ADC1 converts PA0 at 8 kHz (TIM3 TRGO, adcTriggerStart) into a
+ *   ping-pong buffer of 256 samples per half (adcscan.c). The DMA callback
+ *   runs three filters of adcfilt.c over each half :
+ *
+ *      - moving average of 16 samples            -> maOut
+ *      - FIR 16 taps, low pass 500 Hz (Hamming)  -> firOut
+ *      - 2 biquads, Butterworth low pass 200 Hz
+ *        (4th order), coefficients Q31 >> 1      -> in place, the half
+ *                                                   buffer holds Q15 after it
+ *
+ *   adcFilterBench holds per filter the DWT cycles of the block calls,
+ *   the samples filtered, cycles per sample and the largest |output| of
+ *   the last half (Q15), to check the response with a known input.
+ *
+ *   make filter (st-util must be running) stops in adcFilterDone and
+ *   prints adcFilterBench.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0
+ *
+ * Build            : make filter
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+#include "adcfilt.h"
+
+#define SAMPLE_HZ				(8000)
+#define HALF_SCANS				(256)
+#define BENCH_HALVES			(16)      // 4096 samples, 0.5 s
+#define MA_BITS					(4)       // 16 samples
+#define FIR_TAPS				(16)
+#define BIQUAD_STAGES			(2)
+
+#define FILTER_MA				(0)
+#define FILTER_FIR				(1)
+#define FILTER_BIQUAD			(2)
+#define FILTERS					(3)
+
+typedef struct
+{
+	uint32_t samples;           /* Samples filtered                           */
+	unsigned long long cycles;  /* Block calls, all halves                    */
+	uint32_t cyclesPerSample;
+	uint32_t peak;              /* Largest |Q15 output| of the last half      */
+} ADCFILTBENCH_type;
+
+ADCFILTBENCH_type adcFilterBench[FILTERS];
+
+// Low pass 500 Hz at 8 kHz, Hamming window, sum 32768
+static const int16_t firCoeffs[FIR_TAPS] = {
+	27, 131, 450, 1111, 2111, 3280, 4327, 4947, 4947, 4327, 3280, 2111, 1111, 450, 131, 27
+};
+
+// Butterworth low pass 200 Hz at 8 kHz, {b0, b1, b2, a1, a2} * 2^30 (postShift 1)
+static const int32_t biquadCoeffs[5 * BIQUAD_STAGES] = {
+	5775114, 11550228, 5775114, 1853206872, -802565504,
+	6236429, 12472858, 6236429, 2001240540, -952444431
+};
+
+static const uint8_t scanChannels[1] = {0};         // PA0
+static const uint8_t scanSampleTimes[1] = {ADC_SMP_239_5};
+static uint16_t scanBuffer[2 * HALF_SCANS];
+
+static int16_t maDelay[1 << MA_BITS];
+static int16_t firDelay[2 * FIR_TAPS];
+static int32_t biquadState[4 * BIQUAD_STAGES];
+static int16_t maOut[HALF_SCANS];
+static int16_t firOut[HALF_SCANS];
+
+static FILT_MA_type ma;
+static FILT_FIR_type fir;
+static FILT_BIQUAD_type biquad;
+static volatile uint32_t benchHalves;
+
+static void halfReady(const uint16_t *samples, uint32_t scans);
+
+static const ADC_SCAN_type scan = {
+	scanChannels, scanSampleTimes, 1, scanBuffer, HALF_SCANS, halfReady,
+	ADC_TRIGGER_TIM3_TRGO
+};
+
+/*********** Function declarations ****************/
+void adcFilterDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
+	0,                              /* 0x008 Non maskable interrupt          */
+	0,                              /* 0x00C HardFault                       */
+	0,                              /* 0x010 Memory Management               */
+	0,                              /* 0x014 BusFault                        */
+	0,                              /* 0x018 UsageFault                      */
+	0,                              /* 0x01C Reserved                        */
+	0,                              /* 0x020 Reserved                        */
+	0,                              /* 0x024 Reserved                        */
+	0,                              /* 0x028 Reserved                        */
+	0,                              /* 0x02C System service call             */
+	0,                              /* 0x030 Debug Monitor                   */
+	0,                              /* 0x034 Reserved                        */
+	0,                              /* 0x038 PendSV                          */
+	0,                              /* 0x03C System tick timer               */
+	0,                              /* 0x040 Window watchdog                 */
+	0,                              /* 0x044 PVD through EXTI Line detection */
+	0,                              /* 0x048 Tamper                          */
+	0,                              /* 0x04C RTC global                      */
+	0,                              /* 0x050 FLASH global                    */
+	0,                              /* 0x054 RCC global                      */
+	0,                              /* 0x058 EXTI Line0                      */
+	0,                              /* 0x05C EXTI Line1                      */
+	0,                              /* 0x060 EXTI Line2                      */
+	0,                              /* 0x064 EXTI Line3                      */
+	0,                              /* 0x068 EXTI Line4                      */
+	(uint32_t *) adcScanDmaHandler, /* 0x06C DMA1_Ch1                        */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: filterPeak
+ * Description 		: Largest |value| of a Q15 block
+ * Input			: q15, count
+ * Return Value		: peak
+*/
+static uint32_t filterPeak(const int16_t *q15, uint32_t count)
+{
+	uint32_t peak = 0, i;
+	int32_t v;
+
+	for (i = 0; i < count; i++) {
+		v = q15[i] < 0 ? -q15[i] : q15[i];
+		if ((uint32_t) v > peak)
+			peak = v;
+	}
+	return peak;
+}
+
+/*
+ * Funtion Name		: filterRecord
+ * Description 		: Cycles and peak of one filter for one half
+ * Input			: filter, cycles, out, scans
+ * Return Value		: None
+*/
+static void filterRecord(uint32_t filter, uint32_t cycles, const int16_t *out, uint32_t scans)
+{
+	ADCFILTBENCH_type *b = &adcFilterBench[filter];
+
+	b->cycles += cycles;
+	b->samples += scans;
+	b->peak = filterPeak(out, scans);
+}
+
+/*
+ * Funtion Name		: halfReady
+ * Description 		: Half buffer of PA0 : moving average and FIR into
+ *					  their own buffers, biquad cascade in place
+ * Input			: samples, scans
+ * Return Value		: None
+*/
+static void halfReady(const uint16_t *samples, uint32_t scans)
+{
+	int16_t *q15 = (int16_t *) samples;
+	uint32_t start;
+
+	if (benchHalves >= BENCH_HALVES)
+		return;
+
+	start = PROFILE_DWT->CYCCNT;
+	filtMovingAverageBlock(&ma, samples, 1, scans, maOut);
+	filterRecord(FILTER_MA, PROFILE_DWT->CYCCNT - start, maOut, scans);
+
+	start = PROFILE_DWT->CYCCNT;
+	filtFirBlock(&fir, samples, 1, scans, firOut);
+	filterRecord(FILTER_FIR, PROFILE_DWT->CYCCNT - start, firOut, scans);
+
+	start = PROFILE_DWT->CYCCNT;
+	filtBiquadBlock(&biquad, samples, 1, scans, q15);
+	filterRecord(FILTER_BIQUAD, PROFILE_DWT->CYCCNT - start, q15, scans);
+
+	benchHalves++;
+}
+
+/*
+ * Funtion Name		: adcFilterDone
+ * Description 		: adcFilterBench is filled, gdb breakpoint for make filter
+ * Input			: None
+ * Return Value		: None
+*/
+void adcFilterDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	uint32_t n;
+
+	// SYSCLK 72 MHz, APB1 timers 72 MHz, ADCCLK 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK for PC13
+	GPIOC->CRH |= 0x00200000; // Make GPIOC Pin13 output (PC13)
+
+	filtMovingAverageInit(&ma, maDelay, MA_BITS);
+	filtFirInit(&fir, firCoeffs, firDelay, FIR_TAPS);
+	filtBiquadInit(&biquad, biquadCoeffs, biquadState, BIQUAD_STAGES, 1);
+
+	adcScanStart(&scan);
+	adcTriggerStart(ADC_TRIGGER_TIM3_TRGO, SAMPLE_HZ);
+	while (benchHalves < BENCH_HALVES)
+		__asm__("wfi");
+	adcTriggerStop(ADC_TRIGGER_TIM3_TRGO);
+	adcScanStop();
+
+	for (n = 0; n < FILTERS; n++)
+		adcFilterBench[n].cyclesPerSample = adcFilterBench[n].cycles / adcFilterBench[n].samples;
+
+	adcFilterDone();
+
+	// LED : low pass output of PA0 below mid scale
+	if (firOut[HALF_SCANS - 1] < 0)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,269 @@
+/*
+ * File Name  : adc_injected.c Ver 1.0
+ *
+ * Description:
+ *   Injected conversions at PWM center, with and without a DMA scan
+ *
+ *   TIM4 runs a 20 kHz center-aligned PWM on PB9 (CH4) and puts its update
+ *   event on TRGO (MMS 010). In center-aligned mode the update comes at
+ *   both ends of the count : CNT = 0 (center of the pulse) and CNT = ARR
+ *   (center of the gap), the two points where a motor phase current is
+ *   sampled. TRGO starts the injected group : PA4 and PA5, offset 0x800
+ *   (1.65 V zero of a current sensor) subtracted in JOFR1/JOFR2.
+ *
+ *      - step 0 : injected group only, ADC1 idle between triggers
+ *      - step 1 : injected group while a DMA scan of PA0-PA3 (sample time
+ *        71.5, 7 us per conversion) runs back to back (adcscan.c). The
+ *        trigger aborts the running regular conversion, the scan goes on
+ *        after the injected ranks.
+ *
+ *   Latency from the trigger to the JEOC interrupt : the callback reads
+ *   TIM4->CNT and DIR, the timer ticks since the last update are the
+ *   cycles since the trigger (PSC 0, timer clock = SYSCLK). adcInjLatency
+ *   holds min, max and total per step and the conversion part of it
+ *   (adcInjectedCycles), the rest is interrupt entry and handler. Without
+ *   the preemption the step 1 latency would grow by up to one regular
+ *   conversion (84 ADC clocks = 504 cycles).
+ *
+ *   make injected (st-util must be running) stops in adcInjectedDone and
+ *   prints adcInjLatency.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * PWM output             : PB9 (TIM4 CH4)
+ *
+ * ADC Channel used       : PA4, PA5 (injected), PA0-PA3 (regular scan)
+ *
+ * Build            : make injected
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+#include "adcinj.h"
+
+#define PWM_HZ					(20000)   // Center-aligned PWM, 2 triggers per period
+#define PWM_DUTY				(30)      // Percent
+#define INJ_TRIGGERS			(4000)    // Injected sequences per step
+#define INJ_STEPS				(2)
+#define SCAN_CHANNELS			(4)
+#define HALF_SCANS				(16)
+
+typedef struct
+{
+	uint32_t scanRunning;       /* 0 : ADC1 idle, 1 : DMA scan running        */
+	uint32_t triggers;          /* Injected sequences measured                */
+	uint32_t minCycles;         /* Trigger to JEOC interrupt                  */
+	uint32_t maxCycles;
+	unsigned long long total;   /* mean = total / triggers                    */
+	uint32_t conversionCycles;  /* Injected ranks (adcInjectedCycles)         */
+	uint32_t scanHalves;        /* Regular half buffers during the step       */
+} ADCINJLAT_type;
+
+ADCINJLAT_type adcInjLatency[INJ_STEPS];
+volatile int16_t phaseCurrent[2];
+
+static const uint8_t injChannels[2] = {4, 5};       // PA4, PA5
+static const uint8_t injSampleTimes[2] = {ADC_SMP_13_5, ADC_SMP_13_5};
+static const uint16_t injOffsets[2] = {0x800, 0x800};
+
+static const uint8_t scanChannels[SCAN_CHANNELS] = {0, 1, 2, 3};
+static const uint8_t scanSampleTimes[SCAN_CHANNELS] = {ADC_SMP_71_5, ADC_SMP_71_5, ADC_SMP_71_5, ADC_SMP_71_5};
+static uint16_t scanBuffer[2 * HALF_SCANS * SCAN_CHANNELS];
+
+static void currentsReady(const int16_t *results, uint32_t length);
+static void scanReady(const uint16_t *samples, uint32_t scans);
+
+static const ADC_INJ_type currents = {
+	injChannels, injSampleTimes, injOffsets, 2, ADC_JTRIGGER_TIM4_TRGO, currentsReady
+};
+
+static const ADC_SCAN_type scan = {
+	scanChannels, scanSampleTimes, SCAN_CHANNELS, scanBuffer, HALF_SCANS, scanReady,
+	ADC_TRIGGER_SWSTART
+};
+
+static ADCINJLAT_type *latencyStep;
+
+/*********** Function declarations ****************/
+void adcInjectedDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
+	0,                              /* 0x008 Non maskable interrupt          */
+	0,                              /* 0x00C HardFault                       */
+	0,                              /* 0x010 Memory Management               */
+	0,                              /* 0x014 BusFault                        */
+	0,                              /* 0x018 UsageFault                      */
+	0,                              /* 0x01C Reserved                        */
+	0,                              /* 0x020 Reserved                        */
+	0,                              /* 0x024 Reserved                        */
+	0,                              /* 0x028 Reserved                        */
+	0,                              /* 0x02C System service call             */
+	0,                              /* 0x030 Debug Monitor                   */
+	0,                              /* 0x034 Reserved                        */
+	0,                              /* 0x038 PendSV                          */
+	0,                              /* 0x03C System tick timer               */
+	0,                              /* 0x040 Window watchdog                 */
+	0,                              /* 0x044 PVD through EXTI Line detection */
+	0,                              /* 0x048 Tamper                          */
+	0,                              /* 0x04C RTC global                      */
+	0,                              /* 0x050 FLASH global                    */
+	0,                              /* 0x054 RCC global                      */
+	0,                              /* 0x058 EXTI Line0                      */
+	0,                              /* 0x05C EXTI Line1                      */
+	0,                              /* 0x060 EXTI Line2                      */
+	0,                              /* 0x064 EXTI Line3                      */
+	0,                              /* 0x068 EXTI Line4                      */
+	(uint32_t *) adcScanDmaHandler, /* 0x06C DMA1_Ch1                        */
+	0,                              /* 0x070 DMA1_Ch2                        */
+	0,                              /* 0x074 DMA1_Ch3                        */
+	0,                              /* 0x078 DMA1_Ch4                        */
+	0,                              /* 0x07C DMA1_Ch5                        */
+	0,                              /* 0x080 DMA1_Ch6                        */
+	0,                              /* 0x084 DMA1_Ch7                        */
+	(uint32_t *) adcInjectedHandler,/* 0x088 ADC1 and ADC2 global            */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: currentsReady
+ * Description 		: Injected sequence done (JEOC interrupt) : cycles since
+ *					  the TIM4 update that triggered it, signed currents,
+ *					  LED from the sign of the first one
+ * Input			: results, length
+ * Return Value		: None
+*/
+static void currentsReady(const int16_t *results, uint32_t length)
+{
+	uint32_t cnt = TIM4->CNT;
+	uint32_t down = TIM4->CR1 & (1 << 4);       // DIR
+	ADCINJLAT_type *l = latencyStep;
+	uint32_t cycles;
+
+	// Counting up : ticks since CNT = 0, counting down : since CNT = ARR
+	cycles = (down ? TIM4->ARR - cnt : cnt) * (clockFreq.sysclk / clockFreq.timApb1clk);
+
+	if (l->triggers < INJ_TRIGGERS) {
+		if (l->triggers == 0 || cycles < l->minCycles)
+			l->minCycles = cycles;
+		if (cycles > l->maxCycles)
+			l->maxCycles = cycles;
+		l->total += cycles;
+		l->triggers++;
+	}
+
+	phaseCurrent[0] = results[0];
+	phaseCurrent[1] = results[1];
+	if(results[0] < 0)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+}
+
+/*
+ * Funtion Name		: scanReady
+ * Description 		: Half buffer of the regular scan, only counted
+ *					  (adcScanHalves)
+ * Input			: samples, scans
+ * Return Value		: None
+*/
+static void scanReady(const uint16_t *samples, uint32_t scans)
+{
+}
+
+/*
+ * Funtion Name		: adcInjectedDone
+ * Description 		: adcInjLatency is filled, gdb breakpoint for make injected
+ * Input			: None
+ * Return Value		: None
+*/
+void adcInjectedDone(void)
+{
+}
+
+/*
+ * Funtion Name		: pwmCenterStart
+ * Description 		: TIM4 CH4 (PB9) center-aligned PWM, update event on TRGO
+ * Input			: hz PWM frequency, duty percent
+ * Return Value		: None
+*/
+static void pwmCenterStart(uint32_t hz, uint32_t duty)
+{
+	uint32_t arr = clockFreq.timApb1clk / (2 * hz);    // Up and down : 2 * ARR ticks
+
+	RCC->APB1ENR |= (1 << 2);   // TIM4 clock
+	RCC->APB2ENR |= (1 << 3);   // GPIOB clock
+	GPIOB->CRH = (GPIOB->CRH & ~(0xF << 4)) | (0xB << 4);  // PB9 AF push-pull 50 MHz
+
+	TIM4->CR1 = 0;
+	TIM4->PSC = 0;
+	TIM4->ARR = arr;
+	TIM4->CCR4 = arr * duty / 100;
+	TIM4->CCMR2 = (6 << 12) | (1 << 11);        // OC4M PWM mode 1, OC4PE
+	TIM4->CCER = (1 << 12);                     // CC4E
+	TIM4->CR2 = (2 << 4);                       // MMS 010 : update event on TRGO
+	TIM4->EGR = 1;                              // UG : load PSC, ARR, CCR4
+	TIM4->CR1 = (1 << 7) | (1 << 5) | (1 << 0); // ARPE, CMS 01 center-aligned, CEN
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	ADCINJLAT_type *l;
+
+	// SYSCLK 72 MHz, APB1 timers 72 MHz, ADCCLK 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK for PC13
+	GPIOC->CRH |= 0x00200000; // Make GPIOC Pin13 output (PC13)
+
+	pwmCenterStart(PWM_HZ, PWM_DUTY);
+
+	// Step 0 : injected group alone
+	latencyStep = l = &adcInjLatency[0];
+	l->conversionCycles = adcInjectedCycles(&currents);
+	adcInjectedStart(&currents);
+	while (l->triggers < INJ_TRIGGERS)
+		__asm__("wfi");
+	adcInjectedStop();
+
+	// Step 1 : injected group preempting a DMA scan
+	latencyStep = l = &adcInjLatency[1];
+	l->scanRunning = 1;
+	l->conversionCycles = adcInjectedCycles(&currents);
+	adcScanStart(&scan);
+	adcInjectedStart(&currents);
+	while (l->triggers < INJ_TRIGGERS)
+		__asm__("wfi");
+	adcInjectedStop();
+	l->scanHalves = adcScanHalves;
+	adcScanStop();
+
+	adcInjectedDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,264 @@
+/*
+ * File Name  : adc_jitter.c Ver 1.0
+ *
+ * Description:
+ *   Sample timing : software paced loop against TIM3 TRGO trigger
+ *
+ *      - step 0 : the polling loop of 01_adc_pa0_polling_single. SWSTART,
+ *        wait for EOC, read DR, process the sample, start the next one.
+ *        The time between samples is the time of one loop, it changes
+ *        with the processing (here a data dependent NOP loop, as any
+ *        filter or branch would).
+ *      - step 1 : TIM3 update event on TRGO starts each conversion
+ *        (EXTSEL 100, adcTriggerStart). The EOC interrupt reads DR and
+ *        does the same processing, main sleeps.
+ *
+ *   Each step takes JITTER_SAMPLES samples of PA0 and records the DWT
+ *   cycles between two samples in adcJitter : min, max, mean and
+ *   jitter = max - min. Step 0 stamps at SWSTART, step 1 at the entry of
+ *   the EOC interrupt : the conversion time is fixed, so a jitter of 0 in
+ *   step 1 means the samples are taken exactly every 'period' cycles
+ *   (any jitter left is interrupt entry, not sampling).
+ *
+ *   make jitter (st-util must be running) stops in adcJitterDone and
+ *   prints adcJitter.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0
+ *
+ * Build            : make jitter
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+
+#define SAMPLE_HZ				(10000)   // Trigger rate of step 1
+#define JITTER_SAMPLES			(10000)   // Samples per step
+#define JITTER_STEPS			(2)
+
+typedef struct
+{
+	uint32_t triggered;         /* 0 : software loop, 1 : TIM3 TRGO          */
+	uint32_t hz;                /* Trigger rate (step 1)                     */
+	uint32_t period;            /* Cycles between triggers (step 1)          */
+	uint32_t samples;
+	uint32_t minInterval;       /* Cycles between two samples                */
+	uint32_t maxInterval;
+	unsigned long long total;   /* mean = total / (samples - 1)              */
+	uint32_t jitter;            /* maxInterval - minInterval                 */
+} ADCJITTER_type;
+
+ADCJITTER_type adcJitter[JITTER_STEPS];
+
+static const uint8_t jitterChannel[1] = {0};
+static const uint8_t jitterSampleTime[1] = {ADC_SMP_1_5};
+
+static ADCJITTER_type *jitterStep;
+static uint32_t lastStamp;
+
+/*********** Function declarations ****************/
+void adcSampleHandler(void);
+void adcJitterDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
+	0,                              /* 0x008 Non maskable interrupt          */
+	0,                              /* 0x00C HardFault                       */
+	0,                              /* 0x010 Memory Management               */
+	0,                              /* 0x014 BusFault                        */
+	0,                              /* 0x018 UsageFault                      */
+	0,                              /* 0x01C Reserved                        */
+	0,                              /* 0x020 Reserved                        */
+	0,                              /* 0x024 Reserved                        */
+	0,                              /* 0x028 Reserved                        */
+	0,                              /* 0x02C System service call             */
+	0,                              /* 0x030 Debug Monitor                   */
+	0,                              /* 0x034 Reserved                        */
+	0,                              /* 0x038 PendSV                          */
+	0,                              /* 0x03C System tick timer               */
+	0,                              /* 0x040 Window watchdog                 */
+	0,                              /* 0x044 PVD through EXTI Line detection */
+	0,                              /* 0x048 Tamper                          */
+	0,                              /* 0x04C RTC global                      */
+	0,                              /* 0x050 FLASH global                    */
+	0,                              /* 0x054 RCC global                      */
+	0,                              /* 0x058 EXTI Line0                      */
+	0,                              /* 0x05C EXTI Line1                      */
+	0,                              /* 0x060 EXTI Line2                      */
+	0,                              /* 0x064 EXTI Line3                      */
+	0,                              /* 0x068 EXTI Line4                      */
+	0,                              /* 0x06C DMA1_Ch1                        */
+	0,                              /* 0x070 DMA1_Ch2                        */
+	0,                              /* 0x074 DMA1_Ch3                        */
+	0,                              /* 0x078 DMA1_Ch4                        */
+	0,                              /* 0x07C DMA1_Ch5                        */
+	0,                              /* 0x080 DMA1_Ch6                        */
+	0,                              /* 0x084 DMA1_Ch7                        */
+	(uint32_t *) adcSampleHandler,  /* 0x088 ADC1 and ADC2 global            */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: jitterStamp
+ * Description 		: Interval from the previous sample into the step
+ * Input			: stamp DWT->CYCCNT of this sample
+ * Return Value		: None
+*/
+static void jitterStamp(uint32_t stamp)
+{
+	ADCJITTER_type *j = jitterStep;
+	uint32_t interval = stamp - lastStamp;
+
+	lastStamp = stamp;
+	if (j->samples++ == 0)
+		return;
+
+	if (j->samples == 2 || interval < j->minInterval)
+		j->minInterval = interval;
+	if (interval > j->maxInterval)
+		j->maxInterval = interval;
+	j->total += interval;
+}
+
+/*
+ * Funtion Name		: processSample
+ * Description 		: Work done per sample : LED from the level and a data
+ *					  dependent loop standing in for filtering
+ * Input			: data ADC result
+ * Return Value		: None
+*/
+static void processSample(uint32_t data)
+{
+	uint32_t i;
+
+	if(data < 0x800)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+
+	for (i = 0; i < (data & 0x1F); ++i)
+		__asm__("nop");
+}
+
+/*
+ * Funtion Name		: adcSampleHandler
+ * Description 		: ADC1 EOC interrupt of step 1, conversion started by TRGO
+ * Input			: None
+ * Return Value		: None
+*/
+void adcSampleHandler(void)
+{
+	uint32_t stamp = PROFILE_DWT->CYCCNT;
+
+	if (jitterStep->samples < JITTER_SAMPLES)
+		jitterStamp(stamp);
+	processSample(ADC1->DR);        // Reading DR clears EOC
+}
+
+/*
+ * Funtion Name		: adcJitterDone
+ * Description 		: adcJitter is filled, gdb breakpoint for make jitter
+ * Input			: None
+ * Return Value		: None
+*/
+void adcJitterDone(void)
+{
+}
+
+/*
+ * Funtion Name		: adcSingleInit
+ * Description 		: ADC1 on for PA0, one conversion per trigger, calibrated
+ * Input			: trigger ADC_TRIGGER_x
+ * Return Value		: None
+*/
+static void adcSingleInit(uint32_t trigger)
+{
+	uint32_t i;
+
+	ADC1->CR2 = 0;
+	ADC1->CR1 = 0;
+	adcSetSampleTime(ADC1, jitterChannel[0], jitterSampleTime[0]);
+	adcSetSequence(ADC1, jitterChannel, 1);
+
+	//ADC1->CR2 : EXTSEL trigger, EXTTRIG (bit 20), ADON (bit 0)
+	ADC1->CR2 = ((trigger & 7) << 17) | (1 << 20);
+	ADC1->CR2 |= (1 << 0);
+
+	for (i = 0; i < 50; ++i) __asm__("nop");
+
+	ADC1->CR2 |= (1 << 3);      // Reset calibration
+	while((ADC1->CR2 & (1 << 3)));
+	ADC1->CR2 |= (1 << 2);      // Calibration
+	while((ADC1->CR2 & (1 << 2)));
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	ADCJITTER_type *j;
+	uint32_t stamp, step;
+
+	// SYSCLK 72 MHz, APB1 timers 72 MHz, ADCCLK 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4) | (1 << 2) | (1 << 9);    // GPIOC, GPIOA, ADC1 clocks
+	GPIOC->CRH |= 0x00200000;                           // PC13 output
+	GPIOA->CRL &= 0xFFFFFFF0;                           // PA0 analog input
+
+	// Step 0 : software paced
+	jitterStep = j = &adcJitter[0];
+	adcSingleInit(ADC_TRIGGER_SWSTART);
+	while (j->samples < JITTER_SAMPLES) {
+		stamp = PROFILE_DWT->CYCCNT;
+		ADC1->CR2 |= (1 << 22);                 // SWSTART
+		jitterStamp(stamp);
+		while(!(ADC1->SR & (1 << 1)));          // EOC
+		processSample(ADC1->DR);
+	}
+
+	// Step 1 : TIM3 TRGO every 1 / SAMPLE_HZ, EOC interrupt
+	jitterStep = j = &adcJitter[1];
+	j->triggered = 1;
+	adcSingleInit(ADC_TRIGGER_TIM3_TRGO);
+	ADC1->CR1 |= (1 << 5);                      // EOCIE
+	NVIC->ISER[ADC1_2_IRQn >> 5] = (1 << (ADC1_2_IRQn & 0x1F));
+	j->hz = adcTriggerStart(ADC_TRIGGER_TIM3_TRGO, SAMPLE_HZ);
+	j->period = (TIM3->PSC + 1) * (TIM3->ARR + 1) * (clockFreq.sysclk / clockFreq.timApb1clk);
+
+	while (j->samples < JITTER_SAMPLES)
+		__asm__("wfi");
+
+	adcTriggerStop(ADC_TRIGGER_TIM3_TRGO);
+	NVIC->ICER[ADC1_2_IRQn >> 5] = (1 << (ADC1_2_IRQn & 0x1F));
+
+	for (step = 0; step < JITTER_STEPS; ++step)
+		adcJitter[step].jitter = adcJitter[step].maxInterval - adcJitter[step].minInterval;
+	adcJitterDone();
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,231 @@
+/*
+ * File Name  : adc_monitor.c Ver 1.0
+ *
+ * Description:
+ *   VDDA and die temperature in the background of a DMA scan
+ *
+ *   ADC1 scans PA0-PA3 back to back (sample time 71.5, 7 us per
+ *   conversion) into a ping-pong buffer of 128 scans per half, the
+ *   primary loop (adcscan.c). adcmon.c converts VREFINT and the
+ *   temperature sensor as the injected group 10 times per second.
+ *
+ *      - step 0 : scan alone
+ *      - step 1 : scan with the monitor running
+ *
+ *   adcMonitorSteps holds per step the DWT cycles between two half buffer
+ *   callbacks (min, max, total over MONITOR_HALVES halves) : the max of
+ *   step 1 is longer than step 0 by the two injected conversions of a
+ *   monitor reading (42 us) plus the aborted regular conversion, the mean
+ *   barely moves. adcMonitorResult holds VDDA, the temperature and PA0
+ *   in millivolts with the measured VDDA and with 3.3 V assumed.
+ *
+ *   make monitor (st-util must be running) stops in adcMonitorDone and
+ *   prints adcMonitorSteps and adcMonitorResult.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0-PA3 (regular scan), temperature sensor and
+ *                          VREFINT (injected)
+ *
+ * Build            : make monitor
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+#include "adcinj.h"
+#include "adcmon.h"
+
+#define SCAN_CHANNELS			(4)
+#define HALF_SCANS				(128)     // 3.6 ms per half
+#define MONITOR_HALVES			(128)     // 0.46 s per step
+#define MONITOR_HZ				(10)
+#define MONITOR_STEPS			(2)
+
+typedef struct
+{
+	uint32_t monitor;           /* 0 : scan alone, 1 : monitor running        */
+	uint32_t halves;            /* Intervals measured                         */
+	uint32_t minCycles;         /* Between two half buffer callbacks          */
+	uint32_t maxCycles;
+	unsigned long long total;   /* mean = total / halves                      */
+	uint32_t readings;          /* Monitor readings during the step           */
+} ADCMONSTEP_type;
+
+typedef struct
+{
+	uint32_t vddaMv;            /* From VREFINT                               */
+	int32_t temperature;        /* 0.01 C                                     */
+	uint32_t pa0Code;           /* Mean of the last half                      */
+	uint32_t pa0Mv;             /* With the measured VDDA                     */
+	uint32_t pa0MvNominal;      /* With VDDA = 3.3 V assumed                  */
+} ADCMONRESULT_type;
+
+ADCMONSTEP_type adcMonitorSteps[MONITOR_STEPS];
+ADCMONRESULT_type adcMonitorResult;
+
+static const uint8_t scanChannels[SCAN_CHANNELS] = {0, 1, 2, 3};
+static const uint8_t scanSampleTimes[SCAN_CHANNELS] = {ADC_SMP_71_5, ADC_SMP_71_5, ADC_SMP_71_5, ADC_SMP_71_5};
+static uint16_t scanBuffer[2 * HALF_SCANS * SCAN_CHANNELS];
+
+static void halfReady(const uint16_t *samples, uint32_t scans);
+
+static const ADC_SCAN_type scan = {
+	scanChannels, scanSampleTimes, SCAN_CHANNELS, scanBuffer, HALF_SCANS, halfReady,
+	ADC_TRIGGER_SWSTART
+};
+
+static ADCMONSTEP_type *monitorStep;
+static uint32_t lastHalf;
+static volatile uint32_t pa0Mean;
+
+/*********** Function declarations ****************/
+void adcMonitorDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
+	0,                              /* 0x008 Non maskable interrupt          */
+	0,                              /* 0x00C HardFault                       */
+	0,                              /* 0x010 Memory Management               */
+	0,                              /* 0x014 BusFault                        */
+	0,                              /* 0x018 UsageFault                      */
+	0,                              /* 0x01C Reserved                        */
+	0,                              /* 0x020 Reserved                        */
+	0,                              /* 0x024 Reserved                        */
+	0,                              /* 0x028 Reserved                        */
+	0,                              /* 0x02C System service call             */
+	0,                              /* 0x030 Debug Monitor                   */
+	0,                              /* 0x034 Reserved                        */
+	0,                              /* 0x038 PendSV                          */
+	0,                              /* 0x03C System tick timer               */
+	0,                              /* 0x040 Window watchdog                 */
+	0,                              /* 0x044 PVD through EXTI Line detection */
+	0,                              /* 0x048 Tamper                          */
+	0,                              /* 0x04C RTC global                      */
+	0,                              /* 0x050 FLASH global                    */
+	0,                              /* 0x054 RCC global                      */
+	0,                              /* 0x058 EXTI Line0                      */
+	0,                              /* 0x05C EXTI Line1                      */
+	0,                              /* 0x060 EXTI Line2                      */
+	0,                              /* 0x064 EXTI Line3                      */
+	0,                              /* 0x068 EXTI Line4                      */
+	(uint32_t *) adcScanDmaHandler, /* 0x06C DMA1_Ch1                        */
+	0,                              /* 0x070 DMA1_Ch2                        */
+	0,                              /* 0x074 DMA1_Ch3                        */
+	0,                              /* 0x078 DMA1_Ch4                        */
+	0,                              /* 0x07C DMA1_Ch5                        */
+	0,                              /* 0x080 DMA1_Ch6                        */
+	0,                              /* 0x084 DMA1_Ch7                        */
+	(uint32_t *) adcInjectedHandler,/* 0x088 ADC1 and ADC2 global            */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: halfReady
+ * Description 		: Half buffer of the scan : cycles since the previous
+ *					  one into the step, mean of PA0
+ * Input			: samples, scans
+ * Return Value		: None
+*/
+static void halfReady(const uint16_t *samples, uint32_t scans)
+{
+	ADCMONSTEP_type *s = monitorStep;
+	uint32_t now = PROFILE_DWT->CYCCNT;
+	uint32_t cycles = now - lastHalf;
+	uint32_t sum = 0, i;
+
+	if (lastHalf != 0 && s->halves < MONITOR_HALVES) {
+		if (s->halves == 0 || cycles < s->minCycles)
+			s->minCycles = cycles;
+		if (cycles > s->maxCycles)
+			s->maxCycles = cycles;
+		s->total += cycles;
+		s->halves++;
+	}
+	lastHalf = now;
+
+	for (i = 0; i < scans; i++)
+		sum += samples[i * SCAN_CHANNELS];
+	pa0Mean = sum / scans;
+}
+
+/*
+ * Funtion Name		: adcMonitorDone
+ * Description 		: Steps and result filled, gdb breakpoint for make monitor
+ * Input			: None
+ * Return Value		: None
+*/
+void adcMonitorDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	ADCMONRESULT_type *r = &adcMonitorResult;
+	ADCMONSTEP_type *s;
+	uint32_t readings;
+
+	// SYSCLK 72 MHz, APB1 timers 72 MHz, ADCCLK 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK for PC13
+	GPIOC->CRH |= 0x00200000; // Make GPIOC Pin13 output (PC13)
+
+	// Step 0 : scan alone
+	monitorStep = s = &adcMonitorSteps[0];
+	adcScanStart(&scan);
+	while (s->halves < MONITOR_HALVES)
+		__asm__("wfi");
+
+	// Step 1 : same scan, monitor started next to it
+	lastHalf = 0;
+	monitorStep = s = &adcMonitorSteps[1];
+	s->monitor = 1;
+	adcMonitorStart(MONITOR_HZ);
+	while (s->halves < MONITOR_HALVES)
+		__asm__("wfi");
+	readings = adcMonitor.updates;
+	adcMonitorStop();
+	adcScanStop();
+	s->readings = readings;
+
+	r->vddaMv = adcMonitor.vddaMv;
+	r->temperature = adcMonitor.temperature;
+	r->pa0Code = pa0Mean;
+	r->pa0Mv = adcMonitorMillivolts(pa0Mean);
+	r->pa0MvNominal = (pa0Mean * 3300 + 2047) / 4095;
+
+	adcMonitorDone();
+
+	// LED : die above 40 C
+	if (r->temperature > 4000)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,208 @@
+/*
+ * File Name  : adc_oversample.c Ver 1.0
+ *
+ * Description:
+ *   Oversampling and decimation of a 4 channel DMA scan, cycles per output
+ *
+ *   ADC1 scans PA0-PA3 back to back (sample time 28.5, 41 ADC clocks per
+ *   conversion, 73 kS/s per channel) into a ping-pong buffer of 256 scans
+ *   per half (adcscan.c). Every half buffer is decimated at the five
+ *   ratios of adcovs.c, one after the other in the DMA callback :
+ *
+ *      ratio 1 (12 bit, copy), 4 (13 bit), 16 (14 bit), 64 (15 bit),
+ *      256 (16 bit)
+ *
+ *   adcOvsBench holds per ratio the DWT cycles spent in adcOvsProcess,
+ *   the outputs per channel and the last output of each channel, and
+ *   once all halves are done the cycles per input sample and per output
+ *   sample (one channel). The scan keeps running while the benchmark
+ *   runs, so the cycles include the DMA bus accesses of a live
+ *   acquisition.
+ *
+ *   make oversample (st-util must be running) stops in adcOversampleDone
+ *   and prints adcOvsBench.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0-PA3
+ *
+ * Build            : make oversample
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+#include "adcovs.h"
+
+#define SCAN_CHANNELS			(4)
+#define HALF_SCANS				(256)
+#define BENCH_HALVES			(32)      // 8192 scans, 32 outputs at ratio 256
+#define BENCH_RATIOS			(ADC_OVS_MAX_BITS + 1)
+
+typedef struct
+{
+	uint32_t ratio;             /* Scans per output                           */
+	uint32_t bits;              /* Output resolution                          */
+	uint32_t outputs;           /* Outputs per channel                        */
+	unsigned long long cycles;  /* adcOvsProcess, all halves                  */
+	uint32_t cyclesPerInput;    /* cycles / input samples                     */
+	uint32_t cyclesPerOutput;   /* cycles / output samples (one channel)      */
+	uint16_t last[SCAN_CHANNELS];
+} ADCOVSBENCH_type;
+
+ADCOVSBENCH_type adcOvsBench[BENCH_RATIOS];
+
+static const uint8_t scanChannels[SCAN_CHANNELS] = {0, 1, 2, 3};
+static const uint8_t scanSampleTimes[SCAN_CHANNELS] = {ADC_SMP_28_5, ADC_SMP_28_5, ADC_SMP_28_5, ADC_SMP_28_5};
+// Two samples per 32 bit load in adcovs.c : 4 byte aligned
+static uint16_t scanBuffer[2 * HALF_SCANS * SCAN_CHANNELS] __attribute__ ((aligned(4)));
+static uint16_t ovsOut[HALF_SCANS * SCAN_CHANNELS];
+static ADC_OVS_type ovs[BENCH_RATIOS];
+static volatile uint32_t benchHalves;
+
+static void halfReady(const uint16_t *samples, uint32_t scans);
+
+static const ADC_SCAN_type scan = {
+	scanChannels, scanSampleTimes, SCAN_CHANNELS, scanBuffer, HALF_SCANS, halfReady,
+	ADC_TRIGGER_SWSTART
+};
+
+/*********** Function declarations ****************/
+void adcOversampleDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
+	0,                              /* 0x008 Non maskable interrupt          */
+	0,                              /* 0x00C HardFault                       */
+	0,                              /* 0x010 Memory Management               */
+	0,                              /* 0x014 BusFault                        */
+	0,                              /* 0x018 UsageFault                      */
+	0,                              /* 0x01C Reserved                        */
+	0,                              /* 0x020 Reserved                        */
+	0,                              /* 0x024 Reserved                        */
+	0,                              /* 0x028 Reserved                        */
+	0,                              /* 0x02C System service call             */
+	0,                              /* 0x030 Debug Monitor                   */
+	0,                              /* 0x034 Reserved                        */
+	0,                              /* 0x038 PendSV                          */
+	0,                              /* 0x03C System tick timer               */
+	0,                              /* 0x040 Window watchdog                 */
+	0,                              /* 0x044 PVD through EXTI Line detection */
+	0,                              /* 0x048 Tamper                          */
+	0,                              /* 0x04C RTC global                      */
+	0,                              /* 0x050 FLASH global                    */
+	0,                              /* 0x054 RCC global                      */
+	0,                              /* 0x058 EXTI Line0                      */
+	0,                              /* 0x05C EXTI Line1                      */
+	0,                              /* 0x060 EXTI Line2                      */
+	0,                              /* 0x064 EXTI Line3                      */
+	0,                              /* 0x068 EXTI Line4                      */
+	(uint32_t *) adcScanDmaHandler, /* 0x06C DMA1_Ch1                        */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: halfReady
+ * Description 		: Half buffer of the scan : decimated at every ratio,
+ *					  cycles of each adcOvsProcess call added up
+ * Input			: samples, scans
+ * Return Value		: None
+*/
+static void halfReady(const uint16_t *samples, uint32_t scans)
+{
+	ADCOVSBENCH_type *b;
+	uint32_t n, c, outputs, start, cycles;
+
+	if (benchHalves >= BENCH_HALVES)
+		return;
+
+	for (n = 0; n < BENCH_RATIOS; n++) {
+		b = &adcOvsBench[n];
+		start = PROFILE_DWT->CYCCNT;
+		outputs = adcOvsProcess(&ovs[n], samples, scans, ovsOut);
+		cycles = PROFILE_DWT->CYCCNT - start;
+
+		b->cycles += cycles;
+		b->outputs += outputs;
+		if (outputs > 0) {
+			for (c = 0; c < SCAN_CHANNELS; c++)
+				b->last[c] = ovsOut[(outputs - 1) * SCAN_CHANNELS + c];
+		}
+	}
+
+	benchHalves++;
+}
+
+/*
+ * Funtion Name		: adcOversampleDone
+ * Description 		: adcOvsBench is filled, gdb breakpoint for make oversample
+ * Input			: None
+ * Return Value		: None
+*/
+void adcOversampleDone(void)
+{
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	ADCOVSBENCH_type *b;
+	uint32_t n;
+
+	// SYSCLK 72 MHz, APB2 72 MHz -> ADCCLK 72 / 6 = 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK for PC13
+	GPIOC->CRH |= 0x00200000; // Make GPIOC Pin13 output (PC13)
+
+	for (n = 0; n < BENCH_RATIOS; n++) {
+		adcOvsInit(&ovs[n], SCAN_CHANNELS, n);
+		adcOvsBench[n].ratio = ovs[n].ratio;
+		adcOvsBench[n].bits = 12 + n;
+	}
+
+	adcScanStart(&scan);
+	while (benchHalves < BENCH_HALVES)
+		__asm__("wfi");
+	adcScanStop();
+
+	for (n = 0; n < BENCH_RATIOS; n++) {
+		b = &adcOvsBench[n];
+		b->cyclesPerInput = b->cycles / (BENCH_HALVES * HALF_SCANS * SCAN_CHANNELS);
+		if (b->outputs > 0)
+			b->cyclesPerOutput = b->cycles / (b->outputs * SCAN_CHANNELS);
+	}
+
+	adcOversampleDone();
+
+	// LED : PA0 above mid scale at 16 bit
+	if (adcOvsBench[ADC_OVS_MAX_BITS].last[0] < 0x8000)
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+	else
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+
+	while(1)
+		__asm__("wfi");
+}
@@ -0,0 +1,211 @@
+/*
+ * File Name  : adc_warm.c Ver 1.0
+ *
+ * Description:
+ *   Time to the first valid sample : cold start against warm start
+ *
+ *      - boot   : record of the last run from the backup registers
+ *                 (adcCalLoad) into adcCalBoot
+ *      - step 0 : cold start as adc.c : ADON, t_STAB, RSTCAL, CAL, first
+ *                 conversion of PA0. Then VREFINT and sensor as reference,
+ *                 record saved in the backup registers.
+ *      - step 1 : adcPowerDown, IDLE_CYCLES (1 ms), warm start : ADON,
+ *                 t_STAB, VREFINT and sensor measured, first conversion
+ *      - step 2 : as step 1 after IDLE_LONG_CYCLES (10 ms). Calibrated
+ *                 again inside adcWarmStart if VREFINT or the sensor moved
+ *                 past the limits (ADC_CAL_VREFINT_LIMIT, ADC_CAL_TEMP_LIMIT)
+ *                 meanwhile, else warm as step 1
+ *
+ *   Each step records the DWT cycles from the start of power up to the
+ *   result of the first conversion in adcStart, with VREFINT and sensor
+ *   read at power up. PA0 is converted with sample time 1.5 (14 ADC
+ *   clocks = 84 cycles of the total).
+ *
+ *   Whether step 2 calibrates depends on the chip : warm it up or change
+ *   VDDA between the steps to see it (simulator : a sensor that moves,
+ *   ./adc_warm --adc 0=1 --adc-sine 16=1.43,0.05,25 --time 20ms).
+ *
+ *   make warm (st-util must be running) stops in adcWarmDone and prints
+ *   adcStart and adcCalBoot. Reset and run it again to see the record
+ *   of the previous run in adcCalBoot.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0
+ *
+ * Build            : make warm
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+#include "adccal.h"
+
+#define START_STEPS				(3)
+#define IDLE_CYCLES				(72000)   // Powered down before step 1, 1 ms
+#define IDLE_LONG_CYCLES		(720000)  // Powered down before step 2, 10 ms
+
+#define START_COLD				(0)
+#define START_WARM				(1)
+#define START_WARM_LONG			(2)
+
+typedef struct
+{
+	uint32_t path;              /* START_x                                    */
+	uint32_t calibrated;        /* 1 : RSTCAL/CAL done in this start          */
+	uint32_t cycles;            /* Power up to the first result               */
+	uint32_t sample;            /* First result of PA0                        */
+	uint32_t code;              /* Calibration code in use                    */
+	uint32_t vrefint;           /* VREFINT at power up (step 0 : reference)   */
+	uint32_t temperature;       /* Sensor at power up (step 0 : reference)    */
+} ADCSTART_type;
+
+typedef struct
+{
+	uint32_t recordFound;       /* Backup registers held a record             */
+	ADC_CAL_type record;        /* Record of the last run                     */
+	ADC_CAL_type current;       /* Record of this run (saved)                 */
+} ADCCALBOOT_type;
+
+ADCSTART_type adcStart[START_STEPS];
+ADCCALBOOT_type adcCalBoot;
+
+static ADC_CAL_type cal;
+
+/*********** Function declarations ****************/
+void adcWarmDone(void);
+int32_t main(void);
+
+/********** Interrupt Vector Table ***************/
+
+uint32_t (* const vector_table[])
+__attribute__ ((section(".vectors"))) = {
+	(uint32_t *) STACKINIT,         /* 0x000 Stack Pointer                   */
+	(uint32_t *) Reset_Handler,     /* 0x004 Reset                           */
+	0,                              /* 0x008 Non maskable interrupt          */
+};
+
+/********** Function Defintion ******************/
+
+/*
+ * Funtion Name		: adcWarmDone
+ * Description 		: adcStart is filled, gdb breakpoint for make warm
+ * Input			: None
+ * Return Value		: None
+*/
+void adcWarmDone(void)
+{
+}
+
+/*
+ * Funtion Name		: adcFirstSample
+ * Description 		: SWSTART, wait EOC, result (ADC1 powered on)
+ * Input			: None
+ * Return Value		: result of PA0
+*/
+static uint32_t adcFirstSample(void)
+{
+	ADC1->CR2 |= (1 << 22);                 // SWSTART
+	while(!(ADC1->SR & (1 << 1)));          // EOC
+	return ADC1->DR & 0xFFF;
+}
+
+/*
+ * Funtion Name		: adcIdle
+ * Description 		: ADC1 powered down for 'cycles'
+ * Input			: cycles
+ * Return Value		: None
+*/
+static void adcIdle(uint32_t cycles)
+{
+	uint32_t start = PROFILE_DWT->CYCCNT;
+
+	while (PROFILE_DWT->CYCCNT - start < cycles);
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	ADCSTART_type *s;
+	uint32_t start;
+
+	// SYSCLK 72 MHz, APB2 72 MHz -> ADCCLK 72 / 6 = 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4) | (1 << 2) | (1 << 9);    // GPIOC, GPIOA, ADC1 clocks
+	GPIOC->CRH |= 0x00200000;                           // PC13 output
+	GPIOA->CRL &= 0xFFFFFFF0;                           // PA0 analog input
+
+	adcCalBoot.recordFound = adcCalLoad(&adcCalBoot.record);
+
+	// PA0 single conversion on SWSTART, set while ADC1 is off
+	ADC1->CR1 = 0;
+	ADC1->SQR1 = 0;
+	ADC1->SQR3 = 0;
+	adcSetSampleTime(ADC1, 0, ADC_SMP_1_5);
+	ADC1->CR2 = (7 << 17) | (1 << 20);
+
+	// Step 0 : cold
+	s = &adcStart[0];
+	s->path = START_COLD;
+	start = PROFILE_DWT->CYCCNT;
+	adcPowerOn();
+	adcCalibrate(&cal);
+	s->sample = adcFirstSample();
+	s->cycles = PROFILE_DWT->CYCCNT - start;
+	s->calibrated = 1;
+	s->code = cal.code;
+
+	adcCalReference(&cal);
+	adcCalSave(&cal);
+	adcCalBoot.current = cal;
+	s->vrefint = cal.vrefint;
+	s->temperature = cal.temperature;
+
+	// Step 1 : warm after a short power down
+	s = &adcStart[1];
+	s->path = START_WARM;
+	adcPowerDown();
+	adcIdle(IDLE_CYCLES);
+	start = PROFILE_DWT->CYCCNT;
+	s->calibrated = !adcWarmStart(&cal, &s->vrefint, &s->temperature);
+	s->sample = adcFirstSample();
+	s->cycles = PROFILE_DWT->CYCCNT - start;
+	s->code = cal.code;
+
+	// Step 2 : warm after a longer power down, calibrated again on drift
+	s = &adcStart[2];
+	s->path = START_WARM_LONG;
+	adcPowerDown();
+	adcIdle(IDLE_LONG_CYCLES);
+	start = PROFILE_DWT->CYCCNT;
+	s->calibrated = !adcWarmStart(&cal, &s->vrefint, &s->temperature);
+	s->sample = adcFirstSample();
+	s->cycles = PROFILE_DWT->CYCCNT - start;
+	s->code = cal.code;
+
+	adcWarmDone();
+
+	while(1) {
+		if(adcFirstSample() < 0x800)
+			GPIOC->BRR = (1 << 13);  //Switch ON LED
+		else
+			GPIOC->BSRR = (1 << 13); //Switch OFF LED
+	}
+}
@@ -0,0 +1,225 @@
+/*
+ * File Name  : adccal.c Ver 1.0
+ *
+ * Description:
+ *   ADC1 calibration record, warm start and backup register copy
+ *   (see adccal.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for calibration and warm start **********************
+
+1.	Cold : ADON 0 -> 1, wait t_STAB, RSTCAL, CAL, code from ADC1->DR
+2.	Reference : TSVREFE, wait t_START, convert channel 17 (VREFINT) and
+	16 (sensor) with sample time 239.5 (>= 17.1 us), keep both with the code
+3.	Power down : ADON = 0, calibration kept in ADC1
+4.	Warm : ADON 0 -> 1, wait t_STAB, VREFINT and sensor as in step 2.
+	Within the limits of the reference -> calibration kept. Outside ->
+	RSTCAL, CAL, new reference
+5.	Backup registers : RCC->APB1ENR PWREN, BKPEN, PWR->CR DBP, then
+	BKP_DR1 magic, DR2 code, DR3 VREFINT, DR4 sensor
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcscan.h"
+#include "adccal.h"
+
+/*
+ * Funtion Name		: adcWait
+ * Description 		: Start-up time (t_STAB, t_START) with DWT->CYCCNT
+ * Input			: us microseconds
+ * Return Value		: None
+*/
+static void adcWait(uint32_t us)
+{
+	uint32_t start = PROFILE_DWT->CYCCNT;
+	uint32_t wait = clockFreq.sysclk / 1000000 * us;
+
+	while (PROFILE_DWT->CYCCNT - start < wait);
+}
+
+/*
+ * Funtion Name		: adcPowerOn
+ * Description 		: ADC1 clock, ADON 0 -> 1 and t_STAB. The rest of CR2
+ *					  is kept, ADC1 is not started.
+ * Input			: None
+ * Return Value		: None
+*/
+void adcPowerOn(void)
+{
+	RCC->APB2ENR |= (1 << 9);   // ADC1 clock
+	ADC1->CR2 |= (1 << 0);      // ADON : power on
+	adcWait(ADC_CAL_TSTAB_US);
+}
+
+/*
+ * Funtion Name		: adcPowerDown
+ * Description 		: ADON = 0, conversions stop, calibration is kept
+ * Input			: None
+ * Return Value		: None
+*/
+void adcPowerDown(void)
+{
+	ADC1->CR2 &= ~((1 << 1) | (1 << 0));    // CONT, ADON off
+}
+
+/*
+ * Funtion Name		: adcCalibrate
+ * Description 		: RSTCAL and CAL of ADC1 (powered on), calibration code
+ *					  into the record
+ * Input			: cal
+ * Return Value		: None
+*/
+void adcCalibrate(ADC_CAL_type *cal)
+{
+	ADC1->CR2 |= (1 << 3);      // Reset calibration
+	while((ADC1->CR2 & (1 << 3)));
+	ADC1->CR2 |= (1 << 2);      // Calibration
+	while((ADC1->CR2 & (1 << 2)));
+
+	cal->code = ADC1->DR & 0x7F;
+	cal->valid = 1;
+}
+
+/*
+ * Funtion Name		: adcConvert
+ * Description 		: One conversion of a channel on SWSTART, sample time 239.5
+ * Input			: channel
+ * Return Value		: result
+*/
+static uint32_t adcConvert(uint32_t channel)
+{
+	ADC1->SQR1 = 0;
+	ADC1->SQR3 = channel;
+	adcSetSampleTime(ADC1, channel, ADC_SMP_239_5);
+	ADC1->CR2 |= (1 << 22);                 // SWSTART
+	while(!(ADC1->SR & (1 << 1)));          // EOC
+	return ADC1->DR & 0xFFF;
+}
+
+/*
+ * Funtion Name		: adcCalMeasure
+ * Description 		: VREFINT and temperature sensor of ADC1 (powered on,
+ *					  idle). Sequence, sample times and trigger are
+ *					  restored afterwards.
+ * Input			: vrefint, temperature (results)
+ * Return Value		: None
+*/
+void adcCalMeasure(uint32_t *vrefint, uint32_t *temperature)
+{
+	uint32_t cr1 = ADC1->CR1, cr2 = ADC1->CR2;
+	uint32_t sqr1 = ADC1->SQR1, sqr3 = ADC1->SQR3, smpr1 = ADC1->SMPR1;
+	//ADC1->CR2 : TSVREFE, SWSTART trigger (EXTSEL 111, EXTTRIG), single, ADON
+	uint32_t measure = (1 << 23) | (7 << 17) | (1 << 20) | (1 << 0);
+
+	// CR2 is only written when it changes : the same value again with ADON
+	// set would start a conversion
+	ADC1->CR1 = 0;
+	if (cr2 != measure) {
+		ADC1->CR2 = measure;
+		adcWait((cr2 & (1 << 23)) ? ADC_CAL_TSTAB_US : ADC_CAL_TSTART_US);
+	}
+
+	*vrefint = adcConvert(17);
+	*temperature = adcConvert(16);
+
+	ADC1->SMPR1 = smpr1;
+	ADC1->SQR3 = sqr3;
+	ADC1->SQR1 = sqr1;
+	ADC1->CR1 = cr1;
+	if (cr2 != measure)
+		ADC1->CR2 = cr2;
+}
+
+/*
+ * Funtion Name		: adcCalReference
+ * Description 		: VREFINT and temperature now as the reference of the
+ *					  calibration (right after adcCalibrate)
+ * Input			: cal
+ * Return Value		: None
+*/
+void adcCalReference(ADC_CAL_type *cal)
+{
+	uint32_t vrefint, temperature;
+
+	adcCalMeasure(&vrefint, &temperature);
+	cal->vrefint = vrefint;
+	cal->temperature = temperature;
+}
+
+/*
+ * Funtion Name		: adcWarmStart
+ * Description 		: Powers ADC1 up from ADON = 0 and measures VREFINT and
+ *					  temperature. The calibration is kept when both are
+ *					  within the limits of the record, else ADC1 is
+ *					  calibrated again and the readings are the new record.
+ * Input			: cal, vrefint, temperature (readings at power up)
+ * Return Value		: 1 : warm (calibration kept), 0 : calibrated again
+*/
+uint32_t adcWarmStart(ADC_CAL_type *cal, uint32_t *vrefint, uint32_t *temperature)
+{
+	int32_t dv, dt;
+
+	adcPowerOn();
+	adcCalMeasure(vrefint, temperature);
+
+	dv = (int32_t) *vrefint - cal->vrefint;
+	dt = (int32_t) *temperature - cal->temperature;
+	if (cal->valid && dv <= ADC_CAL_VREFINT_LIMIT && dv >= -ADC_CAL_VREFINT_LIMIT &&
+	    dt <= ADC_CAL_TEMP_LIMIT && dt >= -ADC_CAL_TEMP_LIMIT)
+		return 1;
+
+	adcCalibrate(cal);
+	cal->vrefint = *vrefint;
+	cal->temperature = *temperature;
+	return 0;
+}
+
+/*
+ * Funtion Name		: adcCalSave
+ * Description 		: Record into BKP_DR1-DR4 (backup domain write access
+ *					  enabled with PWR->CR DBP)
+ * Input			: cal
+ * Return Value		: None
+*/
+void adcCalSave(const ADC_CAL_type *cal)
+{
+	RCC->APB1ENR |= (1 << 28) | (1 << 27);  // PWR, BKP clocks
+	PWR->CR |= (1 << 8);                    // DBP : backup domain writes
+
+	BKP->DR[0] = ADC_CAL_MAGIC;
+	BKP->DR[1] = cal->code;
+	BKP->DR[2] = cal->vrefint;
+	BKP->DR[3] = cal->temperature;
+
+	PWR->CR &= ~(1 << 8);
+}
+
+/*
+ * Funtion Name		: adcCalLoad
+ * Description 		: Record of the last run from BKP_DR1-DR4. It is a
+ *					  reference only : ADC1 is not calibrated with it
+ *					  (valid = 0).
+ * Input			: cal
+ * Return Value		: 1 : record found, 0 : none (first run, backup domain reset)
+*/
+uint32_t adcCalLoad(ADC_CAL_type *cal)
+{
+	RCC->APB1ENR |= (1 << 28) | (1 << 27);  // PWR, BKP clocks
+
+	cal->valid = 0;
+	if ((BKP->DR[0] & 0xFFFF) != ADC_CAL_MAGIC)
+		return 0;
+
+	cal->code = BKP->DR[1];
+	cal->vrefint = BKP->DR[2];
+	cal->temperature = BKP->DR[3];
+	return 1;
+}
@@ -0,0 +1,73 @@
+#ifndef ADCCAL_H
+#define ADCCAL_H
+
+/*
+ * File Name  : adccal.h Ver 1.0
+ *
+ * Description:
+ *   ADC1 calibration record, warm start and backup register copy
+ *
+ *   Cold start (adc.c) : ADON, t_STAB (a 50 NOP loop), RSTCAL, CAL, then the
+ *   first conversion. At the end of CAL the calibration code is in ADC1->DR;
+ *   adcCalibrate keeps it in an ADC_CAL_type together with VREFINT and the
+ *   temperature sensor at that time (adcCalReference). t_STAB is waited
+ *   with DWT->CYCCNT (1 us), not with a NOP count.
+ *
+ *   The F1 has no register to load a calibration code back (no CALFACT as
+ *   on later families) : the calibration stays in ADC1 while it is powered
+ *   down with ADON = 0 (adcPowerDown) and is lost on a reset of ADC1 or of
+ *   the chip. adcWarmStart powers ADC1 up again, waits t_STAB and converts
+ *   VREFINT and the temperature sensor : if VREFINT (VDDA) and the
+ *   temperature moved less than the limits since the calibration it is
+ *   kept, else ADC1 calibrates again.
+ *
+ *   The check is made at power up, not on readings from before the power
+ *   down : conditions change while ADC1 is off. Both inputs need a 17.1 us
+ *   sample time and t_START, about 52 us with ADCCLK 12 MHz, longer than a
+ *   calibration : the warm start keeps the calibration code (and so the
+ *   results) the same over power downs while the conditions hold, it does
+ *   not make the first sample earlier.
+ *
+ *   adcCalSave / adcCalLoad keep the record in the backup registers
+ *   (BKP_DR1-DR4, kept over resets with VBAT) : after a reset ADC1 has to
+ *   be calibrated again, the stored record is the reference to report the
+ *   drift of code, VDDA and temperature since the last run.
+ *
+ *      adcPowerOn();  adcCalibrate(&cal);  adcCalReference(&cal);  adcCalSave(&cal);
+ *      ...
+ *      adcPowerDown();
+ *      ...
+ *      adcWarmStart(&cal, &vrefint, &temperature);    // 1 : calibration kept
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define ADC_CAL_TSTAB_US			(1)       // Power-up time t_STAB, datasheet max 1 us
+#define ADC_CAL_TSTART_US			(10)      // Sensor / VREFINT start-up t_START, datasheet max 10 us
+#define ADC_CAL_VREFINT_LIMIT		(15)      // Counts of VREFINT (1.20 V = 1489), about 1 % of VDDA
+#define ADC_CAL_TEMP_LIMIT			(27)      // Counts of the sensor (4.3 mV/C), about 5 C
+#define ADC_CAL_MAGIC				(0xCA1B)  // BKP_DR1 of a saved record
+
+typedef struct
+{
+	uint16_t code;                  /* ADC1->DR at the end of CAL (7 bit)           */
+	uint16_t vrefint;               /* VREFINT counts at the calibration            */
+	uint16_t temperature;           /* Temperature sensor counts at the calibration */
+	uint16_t valid;                 /* 1 : ADC1 calibrated with this record         */
+} ADC_CAL_type;
+
+void adcPowerOn(void);
+void adcPowerDown(void);
+void adcCalibrate(ADC_CAL_type *cal);
+void adcCalMeasure(uint32_t *vrefint, uint32_t *temperature);
+void adcCalReference(ADC_CAL_type *cal);
+uint32_t adcWarmStart(ADC_CAL_type *cal, uint32_t *vrefint, uint32_t *temperature);
+void adcCalSave(const ADC_CAL_type *cal);
+uint32_t adcCalLoad(ADC_CAL_type *cal);
+
+#endif
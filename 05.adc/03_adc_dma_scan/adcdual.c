@@ -0,0 +1,183 @@
+/*
+ * File Name  : adcdual.c Ver 1.0
+ *
+ * Description:
+ *   ADC1 + ADC2 dual mode acquisition with DMA double buffering
+ *   (see adcdual.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for ADC1 + ADC2 dual mode **********************
+
+1.	Enable clocks : DMA1 (RCC->AHBENR), ADC1, ADC2 and GPIO ports (RCC->APB2ENR)
+2.	Analog input mode for the pins of both sequences
+3.	ADC2 (slave) : SCAN, sequence, sample times, SWSTART as trigger (the
+	master starts it), CONT, ADON, calibration
+4.	ADC1 (master) : DUALMOD in CR1, SCAN, sequence, sample times,
+	SWSTART trigger, DMA, CONT, ADON, calibration
+5.	DMA1 channel 1 : CPAR = &ADC1->DR, 32 bit to 32 bit, memory increment,
+	circular, HT and TC interrupts
+6.	SWSTART of ADC1 starts both
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "adcscan.h"
+#include "adcdual.h"
+
+// DMA channel configuration register (CCR) bits
+#define DMA_CCR_EN					(1 << 0)
+#define DMA_CCR_TCIE				(1 << 1)
+#define DMA_CCR_HTIE				(1 << 2)
+#define DMA_CCR_CIRC				(1 << 5)
+#define DMA_CCR_MINC				(1 << 7)
+#define DMA_CCR_PSIZE_32			(2 << 8)
+#define DMA_CCR_MSIZE_32			(2 << 10)
+#define DMA_CCR_PL_HIGH				(2 << 12)
+
+volatile uint32_t adcDualHalves;
+volatile uint32_t adcDualOverruns;
+
+static const ADC_DUAL_type *adcDual;		// Running acquisition
+
+/*
+ * Funtion Name		: adcDualSampleRate
+ * Description 		: Samples per second of both ADCs together from ADCCLK
+ *					  and the sample times. Simultaneous : two samples per
+ *					  conversion time, fast interleaved : one per 7 clocks.
+ * Input			: dual
+ * Return Value		: samples per second
+*/
+uint32_t adcDualSampleRate(const ADC_DUAL_type *dual)
+{
+	static const uint32_t sampleHalf[8] = {3, 15, 27, 57, 83, 111, 143, 479};
+	uint32_t rank, half = 0;
+
+	if (dual->mode == ADC_DUAL_FAST_INTERLEAVED)
+		return clockFreq.adcclk / 7;
+
+	for (rank = 0; rank < dual->length; ++rank)
+		half += sampleHalf[dual->sampleTimes[rank] & 7] + 25;
+
+	return (uint32_t) ((unsigned long long) clockFreq.adcclk * 2 * 2 * dual->length / half);
+}
+
+/*
+ * Funtion Name		: adcDualInit
+ * Description 		: Sequence, sample times, power on and calibration of
+ *					  one ADC of the pair
+ * Input			: adc, channels, dual, cr1, cr2 (without ADON)
+ * Return Value		: None
+*/
+static void adcDualInit(ADC_type *adc, const uint8_t *channels, const ADC_DUAL_type *dual,
+						uint32_t cr1, uint32_t cr2)
+{
+	uint32_t rank, i;
+
+	adc->CR2 = 0;
+	adc->CR1 = cr1;
+	for (rank = 0; rank < dual->length; ++rank) {
+		adcSetPin(channels[rank]);
+		adcSetSampleTime(adc, channels[rank], dual->sampleTimes[rank]);
+	}
+	adcSetSequence(adc, channels, dual->length);
+
+	adc->CR2 = cr2;
+	adc->CR2 |= (1 << 0);       // ADON : power on
+
+	for (i = 0; i < 50; ++i) __asm__("nop");
+
+	adc->CR2 |= (1 << 3);       // Reset calibration
+	while((adc->CR2 & (1 << 3)));
+	adc->CR2 |= (1 << 2);       // Calibration
+	while((adc->CR2 & (1 << 2)));
+}
+
+/*
+ * Funtion Name		: adcDualStart
+ * Description 		: Configures ADC2, ADC1 (master) and DMA1 channel 1 and
+ *					  starts both ADCs. The callback runs for every half
+ *					  buffer until adcDualStop.
+ * Input			: dual
+ * Return Value		: None
+*/
+void adcDualStart(const ADC_DUAL_type *dual)
+{
+	// SWSTART trigger (EXTSEL 111, EXTTRIG), CONT
+	uint32_t cr2 = (7 << 17) | (1 << 20) | (1 << 1);
+	uint32_t scan = (dual->length > 1) ? (1 << 8) : 0;
+
+	adcDual = dual;
+	adcDualHalves = 0;
+	adcDualOverruns = 0;
+
+	RCC->AHBENR |= (1 << 0);                // DMA1 clock
+	RCC->APB2ENR |= (1 << 9) | (1 << 10);   // ADC1, ADC2 clocks
+
+	// Slave first, it waits for the master's start
+	adcDualInit(ADC2, dual->channels2, dual, scan, cr2);
+	adcDualInit(ADC1, dual->channels1, dual, ((dual->mode & 0xF) << 16) | scan, cr2 | (1 << 8));
+
+	// DMA1 channel 1 : ADC1->DR (both results) -> buffer, 32 bit, circular
+	DMA1_Channel1->CCR = 0;
+	DMA1->IFCR = DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1;
+	DMA1_Channel1->CPAR = DMA_ADDRESS(&ADC1->DR);
+	DMA1_Channel1->CMAR = DMA_ADDRESS(dual->buffer);
+	DMA1_Channel1->CNDTR = 2 * dual->halfWords;
+	DMA1_Channel1->CCR = DMA_CCR_PL_HIGH | DMA_CCR_MSIZE_32 | DMA_CCR_PSIZE_32 | DMA_CCR_MINC |
+						 DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE;
+
+	NVIC->IPR[DMA1_Channel1_IRQn] = 0x10;
+	NVIC->ISER[DMA1_Channel1_IRQn >> 5] = (1 << (DMA1_Channel1_IRQn & 0x1F));
+	DMA1_Channel1->CCR |= DMA_CCR_EN;
+
+	ADC1->CR2 |= (1 << 22);     // SWSTART of the master starts both
+}
+
+/*
+ * Funtion Name		: adcDualStop
+ * Description 		: Stops both ADCs and DMA, back to independent mode
+ * Input			: None
+ * Return Value		: None
+*/
+void adcDualStop(void)
+{
+	ADC1->CR2 &= ~(1 << 1);
+	ADC2->CR2 &= ~(1 << 1);
+	ADC1->CR2 &= ~(1 << 0);
+	ADC2->CR2 &= ~(1 << 0);
+	ADC1->CR1 &= ~(0xF << 16);
+	DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+	NVIC->ICER[DMA1_Channel1_IRQn >> 5] = (1 << (DMA1_Channel1_IRQn & 0x1F));
+}
+
+/*
+ * Funtion Name		: adcDualDmaHandler
+ * Description 		: DMA1 channel 1 interrupt, half of the words ready
+ *					  (as adcScanDmaHandler)
+ * Input			: None
+ * Return Value		: None
+*/
+void adcDualDmaHandler(void)
+{
+	uint32_t isr = DMA1->ISR;
+
+	if ((isr & DMA_ISR_HTIF1) && (isr & DMA_ISR_TCIF1))
+		adcDualOverruns++;
+
+	if (isr & DMA_ISR_HTIF1) {
+		DMA1->IFCR = DMA_ISR_HTIF1;
+		adcDualHalves++;
+		adcDual->callback(adcDual->buffer, adcDual->halfWords);
+	}
+	if (isr & DMA_ISR_TCIF1) {
+		DMA1->IFCR = DMA_ISR_TCIF1;
+		adcDualHalves++;
+		adcDual->callback(adcDual->buffer + adcDual->halfWords, adcDual->halfWords);
+	}
+}
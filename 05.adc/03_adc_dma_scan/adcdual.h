@@ -0,0 +1,76 @@
+#ifndef ADCDUAL_H
+#define ADCDUAL_H
+
+/*
+ * File Name  : adcdual.h Ver 1.0
+ *
+ * Description:
+ *   ADC1 + ADC2 dual mode acquisition with DMA double buffering
+ *
+ *   ADC1 is the master, ADC2 the slave (CR1 DUALMOD of ADC1). ADC2 has no
+ *   DMA request : in dual mode ADC1->DR holds the ADC2 result in [31:16]
+ *   and the ADC1 result in [15:0], DMA1 channel 1 moves it as one 32 bit
+ *   word. Buffer and interrupts work as in adcscan.h (two halves, half
+ *   transfer / transfer complete).
+ *
+ *      word   : | ADC2 result [31:16] | ADC1 result [15:0] |
+ *
+ *   ADC_DUAL_REGULAR_SIMULTANEOUS : both convert their sequence at the same
+ *      time, rank n of ADC1 together with rank n of ADC2 (phase coherent
+ *      capture of two channels). One word per rank, sample times of a
+ *      rank must be equal on both ADCs (they are set from ADC1's list).
+ *
+ *   ADC_DUAL_FAST_INTERLEAVED : both convert the same channel, ADC2 starts
+ *      at once and ADC1 7 ADC clocks later, both continuous. One word per
+ *      ADC1 conversion = two samples, a sample every 7 ADC clocks :
+ *      ADCCLK 12 MHz -> 1.714 MS/s, ADCCLK 14 MHz -> 2 MS/s. Sample time
+ *      1.5 cycles only, the sequence is one channel.
+ *
+ *      static const uint8_t ch1[2] = {0, 1}, ch2[2] = {2, 3};   // PA0/PA2, PA1/PA3
+ *      static const uint8_t smp[2] = {ADC_SMP_1_5, ADC_SMP_1_5};
+ *      static uint32_t words[2 * 128];
+ *      static const ADC_DUAL_type dual = {ADC_DUAL_REGULAR_SIMULTANEOUS,
+ *                                         ch1, ch2, smp, 2, words, 128, halfReady};
+ *
+ *      adcDualStart(&dual);       // runs until adcDualStop()
+ *
+ *   adcDualDmaHandler must be the DMA1 channel 1 entry (0x06C) of the
+ *   vector table.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+// ADC1->CR1 DUALMOD[3:0]
+#define ADC_DUAL_INDEPENDENT			(0)
+#define ADC_DUAL_REGULAR_SIMULTANEOUS	(6)
+#define ADC_DUAL_FAST_INTERLEAVED		(7)
+
+#define ADC_DUAL_RESULT1(word)			((word) & 0xFFFF)   // ADC1 result of a word
+#define ADC_DUAL_RESULT2(word)			((word) >> 16)      // ADC2 result of a word
+
+typedef struct
+{
+	uint32_t mode;                  /* ADC_DUAL_x                                   */
+	const uint8_t *channels1;       /* ADC1 channel of rank 1 .. 'length'           */
+	const uint8_t *channels2;       /* ADC2 channel of rank 1 .. 'length'           */
+	const uint8_t *sampleTimes;     /* ADC_SMP_x of each rank, both ADCs            */
+	uint32_t length;                /* Ranks, 1 .. 16 (fast interleaved : 1)        */
+	uint32_t *buffer;               /* 2 * halfWords words                          */
+	uint32_t halfWords;             /* Words in one half of the buffer              */
+	void (*callback)(const uint32_t *words, uint32_t count);   /* Half ready       */
+} ADC_DUAL_type;
+
+extern volatile uint32_t adcDualHalves;     // Halves handed to the callback
+extern volatile uint32_t adcDualOverruns;   // Halves overwritten before the callback ran
+
+uint32_t adcDualSampleRate(const ADC_DUAL_type *dual);
+void adcDualStart(const ADC_DUAL_type *dual);
+void adcDualStop(void);
+void adcDualDmaHandler(void);
+
+#endif
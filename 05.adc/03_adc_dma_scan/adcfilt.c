@@ -0,0 +1,218 @@
+/*
+ * File Name  : adcfilt.c Ver 1.0
+ *
+ * Description:
+ *   Fixed point filters for ADC sample blocks (see adcfilt.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for the filters **********************
+
+1.	Init : delay line / state cleared, position 0
+2.	Block : every 'stride'-th sample of the half buffer to Q15 (or half
+	scale Q31 for the biquad)
+3.	Moving average : sum + new - oldest, sum >> bits
+	FIR : new sample at pos and pos + taps, 64 bit sum of coeffs[k] times
+	delay[pos + taps - k] (4 taps per loop pass), >> 15
+	Biquad : each stage 5 products into a 64 bit sum, >> (31 - postShift),
+	state shifted
+4.	Result saturated to Q15 and written at the place of the sample in out
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "adcfilt.h"
+
+/*
+ * Funtion Name		: filtSaturate
+ * Description 		: Clamp to the Q15 range
+ * Input			: y
+ * Return Value		: -32768 .. 32767
+*/
+static int16_t filtSaturate(int32_t y)
+{
+	if (y > 32767)
+		return 32767;
+	if (y < -32768)
+		return -32768;
+	return y;
+}
+
+/*
+ * Funtion Name		: filtMovingAverageInit
+ * Description 		: Moving average of 2^bits samples, delay line cleared
+ * Input			: f, delay (2^bits samples), bits (0 .. 15)
+ * Return Value		: None
+*/
+void filtMovingAverageInit(FILT_MA_type *f, int16_t *delay, uint32_t bits)
+{
+	uint32_t i;
+
+	f->delay = delay;
+	f->bits = bits;
+	f->pos = 0;
+	f->sum = 0;
+	for (i = 0; i < (1u << bits); i++)
+		delay[i] = 0;
+}
+
+/*
+ * Funtion Name		: filtMovingAverageBlock
+ * Description 		: Moving average of one channel of a scan buffer
+ * Input			: f, samples (12 bit), stride, count (samples of the
+ *					  channel), out (Q15, same places as samples)
+ * Return Value		: None
+*/
+void filtMovingAverageBlock(FILT_MA_type *f, const uint16_t *samples, uint32_t stride, uint32_t count, int16_t *out)
+{
+	int16_t *delay = f->delay;
+	uint32_t mask = (1u << f->bits) - 1;
+	uint32_t pos = f->pos;
+	int32_t sum = f->sum;
+	int32_t x;
+
+	for (; count > 0; count--) {
+		x = FILT_ADC_TO_Q15(*samples);
+		sum += x - delay[pos];
+		delay[pos] = x;
+		pos = (pos + 1) & mask;
+		*out = sum >> f->bits;
+		samples += stride;
+		out += stride;
+	}
+
+	f->pos = pos;
+	f->sum = sum;
+}
+
+/*
+ * Funtion Name		: filtFirInit
+ * Description 		: FIR with Q15 coefficients, delay line cleared
+ * Input			: f, coeffs (taps), delay (2 * taps samples), taps
+ * Return Value		: None
+*/
+void filtFirInit(FILT_FIR_type *f, const int16_t *coeffs, int16_t *delay, uint32_t taps)
+{
+	uint32_t i;
+
+	f->coeffs = coeffs;
+	f->delay = delay;
+	f->taps = taps;
+	f->pos = 0;
+	for (i = 0; i < 2 * taps; i++)
+		delay[i] = 0;
+}
+
+/*
+ * Funtion Name		: filtFirBlock
+ * Description 		: FIR of one channel of a scan buffer
+ * Input			: f, samples (12 bit), stride, count (samples of the
+ *					  channel), out (Q15, same places as samples)
+ * Return Value		: None
+*/
+void filtFirBlock(FILT_FIR_type *f, const uint16_t *samples, uint32_t stride, uint32_t count, int16_t *out)
+{
+	uint32_t taps = f->taps;
+	uint32_t pos = f->pos;
+	const int16_t *c;
+	const int16_t *d;
+	long long acc;
+	int32_t x;
+	uint32_t k;
+
+	for (; count > 0; count--) {
+		x = FILT_ADC_TO_Q15(*samples);
+		f->delay[pos] = x;
+		f->delay[pos + taps] = x;
+
+		// Newest at delay[pos + taps], oldest at delay[pos + 1]
+		c = f->coeffs;
+		d = &f->delay[pos + taps];
+		acc = 0;
+		for (k = taps; k >= 4; k -= 4) {
+			FILT_MAC(acc, c[0], d[0]);
+			FILT_MAC(acc, c[1], d[-1]);
+			FILT_MAC(acc, c[2], d[-2]);
+			FILT_MAC(acc, c[3], d[-3]);
+			c += 4;
+			d -= 4;
+		}
+		for (; k > 0; k--)
+			FILT_MAC(acc, *c++, *d--);
+
+		*out = filtSaturate(acc >> 15);
+		if (++pos == taps)
+			pos = 0;
+		samples += stride;
+		out += stride;
+	}
+
+	f->pos = pos;
+}
+
+/*
+ * Funtion Name		: filtBiquadInit
+ * Description 		: Cascade of 'stages' biquads, state cleared
+ * Input			: f, coeffs (5 per stage), state (4 per stage), stages,
+ *					  postShift (coefficients scaled by 2^-postShift)
+ * Return Value		: None
+*/
+void filtBiquadInit(FILT_BIQUAD_type *f, const int32_t *coeffs, int32_t *state, uint32_t stages, uint32_t postShift)
+{
+	uint32_t i;
+
+	f->coeffs = coeffs;
+	f->state = state;
+	f->stages = stages;
+	f->postShift = postShift;
+	for (i = 0; i < 4 * stages; i++)
+		state[i] = 0;
+}
+
+/*
+ * Funtion Name		: filtBiquadBlock
+ * Description 		: Biquad cascade of one channel of a scan buffer
+ * Input			: f, samples (12 bit), stride, count (samples of the
+ *					  channel), out (Q15, same places as samples)
+ * Return Value		: None
+*/
+void filtBiquadBlock(FILT_BIQUAD_type *f, const uint16_t *samples, uint32_t stride, uint32_t count, int16_t *out)
+{
+	uint32_t shift = 31 - f->postShift;
+	const int32_t *c;
+	int32_t *s;
+	long long acc;
+	int32_t x, y;
+	uint32_t stage;
+
+	for (; count > 0; count--) {
+		x = FILT_ADC_TO_Q31H(*samples);
+		c = f->coeffs;
+		s = f->state;
+
+		for (stage = f->stages; stage > 0; stage--) {
+			FILT_MUL(acc, c[0], x);
+			FILT_MAC(acc, c[1], s[0]);
+			FILT_MAC(acc, c[2], s[1]);
+			FILT_MAC(acc, c[3], s[2]);
+			FILT_MAC(acc, c[4], s[3]);
+			y = acc >> shift;
+
+			s[1] = s[0];
+			s[0] = x;
+			s[3] = s[2];
+			s[2] = y;
+			x = y;
+			c += 5;
+			s += 4;
+		}
+
+		*out = filtSaturate(x >> 15);
+		samples += stride;
+		out += stride;
+	}
+}
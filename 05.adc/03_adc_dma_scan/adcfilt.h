@@ -0,0 +1,100 @@
+#ifndef ADCFILT_H
+#define ADCFILT_H
+
+/*
+ * File Name  : adcfilt.h Ver 1.0
+ *
+ * Description:
+ *   Fixed point filters for ADC sample blocks : moving average, FIR and
+ *   biquad cascade, no floating point (Cortex-M3 has no FPU)
+ *
+ *   Samples are the 12 bit right aligned results of a DMA scan buffer
+ *   (adcscan.c). Each filter takes one channel of a half buffer : every
+ *   'stride'-th sample (stride = channels of the scan), and writes its Q15
+ *   result at the same place of 'out'. out may be the half buffer itself
+ *   (in place, the callback owns the half until it returns) :
+ *
+ *      static void halfReady(const uint16_t *samples, uint32_t scans)
+ *      {
+ *          int16_t *q15 = (int16_t *) samples;
+ *
+ *          filtFirBlock(&fir, samples, 4, scans, q15);         // channel 0 of 4
+ *          filtFirBlock(&fir1, samples + 1, 4, scans, q15 + 1);// channel 1 of 4
+ *      }
+ *
+ *   Input to Q15 : (sample - 2048) << 4, mid scale (VDDA / 2) is 0 and
+ *   full scale is -32768 .. 32752. Q15 to millivolts : q * VDDA_mV / 65536
+ *   + VDDA_mV / 2.
+ *
+ *      Moving average : 2^n samples, running sum, circular delay line of
+ *                       2^n Q15 values, no multiply
+ *      FIR            : Q15 coefficients, circular delay line of 2 * taps
+ *                       (every sample written twice, taps apart, so
+ *                       the newest 'taps' samples are always contiguous),
+ *                       64 bit accumulator (SMLAL)
+ *      Biquad         : cascade of direct form 1 sections, Q31 state and
+ *                       coefficients scaled by 2^-postShift, 64 bit
+ *                       accumulator (SMULL/SMLAL). Coefficients per stage
+ *                       {b0, b1, b2, a1, a2} with
+ *                       y = b0 x + b1 x1 + b2 x2 + a1 y1 + a2 y2
+ *                       (a1, a2 with the sign of a difference equation,
+ *                       i.e. negated against the transfer function).
+ *                       The input is taken at half scale (Q31 >> 1) to
+ *                       leave room for overshoot, the output is Q15 again.
+ *
+ *   Multiply-accumulate uses SMLAL (32 x 32 + 64 bit, 3-5 cycles) through
+ *   FILT_MAC : gcc at -O0 (as in the makefile) would call a 64 bit
+ *   multiply routine for (long long) a * b.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#if defined(__arm__)
+#define FILT_MUL(acc, a, b)		__asm__ ("smull %Q0, %R0, %1, %2" : "=&r" (acc) : "r" ((int32_t) (a)), "r" ((int32_t) (b)))
+#define FILT_MAC(acc, a, b)		__asm__ ("smlal %Q0, %R0, %1, %2" : "+r" (acc) : "r" ((int32_t) (a)), "r" ((int32_t) (b)))
+#else
+#define FILT_MUL(acc, a, b)		((acc) = (long long) (a) * (b))
+#define FILT_MAC(acc, a, b)		((acc) += (long long) (a) * (b))
+#endif
+
+// 12 bit ADC sample to Q15 / Q31 (half scale, see Biquad)
+#define FILT_ADC_TO_Q15(x)		((int32_t) (((int32_t) (x) - 2048) << 4))
+#define FILT_ADC_TO_Q31H(x)		((int32_t) (((int32_t) (x) - 2048) << 19))
+
+typedef struct
+{
+	int16_t *delay;                 /* 2^bits samples                               */
+	uint32_t bits;                  /* Length 2^bits, 0 .. 15                       */
+	uint32_t pos;                   /* Oldest sample                                */
+	int32_t sum;                    /* Sum of the delay line                        */
+} FILT_MA_type;
+
+typedef struct
+{
+	const int16_t *coeffs;          /* Q15, coeffs[0] for the newest sample         */
+	int16_t *delay;                 /* 2 * taps samples                             */
+	uint32_t taps;
+	uint32_t pos;                   /* Next write, 0 .. taps - 1                    */
+} FILT_FIR_type;
+
+typedef struct
+{
+	const int32_t *coeffs;          /* 5 per stage : b0, b1, b2, a1, a2             */
+	int32_t *state;                 /* 4 per stage : x1, x2, y1, y2                 */
+	uint32_t stages;
+	uint32_t postShift;             /* Coefficients scaled by 2^-postShift          */
+} FILT_BIQUAD_type;
+
+void filtMovingAverageInit(FILT_MA_type *f, int16_t *delay, uint32_t bits);
+void filtMovingAverageBlock(FILT_MA_type *f, const uint16_t *samples, uint32_t stride, uint32_t count, int16_t *out);
+void filtFirInit(FILT_FIR_type *f, const int16_t *coeffs, int16_t *delay, uint32_t taps);
+void filtFirBlock(FILT_FIR_type *f, const uint16_t *samples, uint32_t stride, uint32_t count, int16_t *out);
+void filtBiquadInit(FILT_BIQUAD_type *f, const int32_t *coeffs, int32_t *state, uint32_t stages, uint32_t postShift);
+void filtBiquadBlock(FILT_BIQUAD_type *f, const uint16_t *samples, uint32_t stride, uint32_t count, int16_t *out);
+
+#endif
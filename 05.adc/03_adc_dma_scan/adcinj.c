@@ -0,0 +1,154 @@
+/*
+ * File Name  : adcinj.c Ver 1.0
+ *
+ * Description:
+ *   ADC1 injected group : triggered high priority conversions
+ *   (see adcinj.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for the injected group **********************
+
+1.	Enable clocks : ADC1 and the GPIO ports (RCC->APB2ENR),
+	analog input mode for the pins
+2.	Sample times (SMPR1/2), JSQR : JL = length - 1, rank 1 .. length in
+	JSQ(4 - JL) .. JSQ4
+3.	JOFR1 .. JOFRn : offset subtracted from rank n, result in JDRn
+4.	ADC1->CR1 : JEOCIE, SCAN for more than one rank
+5.	ADC1->CR2 : JEXTSEL trigger, JEXTTRIG. ADON, t_STAB and calibration
+	if ADC1 is not on yet (regular scan running : already done)
+6.	Enable ADC1_2 interrupt in the NVIC
+7.	Interrupt : JEOC, read JDR1 .. JDRn (signed), clear JEOC and JSTRT
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "adcscan.h"
+#include "adcinj.h"
+
+// ADC1 bits of the injected group
+#define ADC_SR_JEOC					(1 << 2)
+#define ADC_SR_JSTRT				(1 << 3)
+#define ADC_CR1_JEOCIE				(1 << 7)
+#define ADC_CR1_SCAN				(1 << 8)
+#define ADC_CR2_JEXTTRIG			(1 << 15)
+#define ADC_CR2_JSWSTART			(1 << 21)
+
+volatile uint32_t adcInjectedEvents;
+
+static const ADC_INJ_type *adcInj;		// Armed injected group
+
+/*
+ * Funtion Name		: adcInjectedCycles
+ * Description 		: SYSCLK cycles to convert the injected ranks
+ *					  (sample time + 12.5 ADC clocks each)
+ * Input			: inj
+ * Return Value		: cycles
+*/
+uint32_t adcInjectedCycles(const ADC_INJ_type *inj)
+{
+	static const uint32_t sampleHalf[8] = {3, 15, 27, 57, 83, 111, 143, 479};
+	uint32_t rank, half = 0;
+
+	for (rank = 0; rank < inj->length; ++rank)
+		half += sampleHalf[inj->sampleTimes[rank] & 7] + 25;
+
+	return half * (clockFreq.sysclk / clockFreq.adcclk) / 2;
+}
+
+/*
+ * Funtion Name		: adcInjectedStart
+ * Description 		: Injected sequence, offsets and trigger of ADC1. ADC1
+ *					  is powered on and calibrated when it is off, a
+ *					  running regular scan is left as it is.
+ * Input			: inj
+ * Return Value		: None
+*/
+void adcInjectedStart(const ADC_INJ_type *inj)
+{
+	uint32_t jsqr, rank, i;
+
+	adcInj = inj;
+	adcInjectedEvents = 0;
+
+	RCC->APB2ENR |= (1 << 9);   // ADC1 clock
+
+	// Rank 1 .. length into JSQ(4 - JL) .. JSQ4, offset of rank n in JOFRn
+	jsqr = (inj->length - 1) << 20;
+	for (rank = 0; rank < inj->length; ++rank) {
+		adcSetPin(inj->channels[rank]);
+		adcSetSampleTime(ADC1, inj->channels[rank], inj->sampleTimes[rank]);
+		jsqr |= (inj->channels[rank] & 0x1F) << ((4 - inj->length + rank) * 5);
+		(&ADC1->JOFR1)[rank] = inj->offsets[rank] & 0xFFF;
+	}
+	ADC1->JSQR = jsqr;
+
+	ADC1->CR1 |= ADC_CR1_JEOCIE;
+	if (inj->length > 1)
+		ADC1->CR1 |= ADC_CR1_SCAN;
+
+	if (!(ADC1->CR2 & (1 << 0))) {
+		//ADC1->CR2 : regular group SWSTART (EXTSEL 111, EXTTRIG), not started
+		ADC1->CR2 = (7 << 17) | (1 << 20);
+		ADC1->CR2 |= (1 << 0);  // ADON : power on
+
+		for (i = 0; i < 50; ++i) __asm__("nop");
+
+		ADC1->CR2 |= (1 << 3);  // Reset calibration
+		while((ADC1->CR2 & (1 << 3)));
+		ADC1->CR2 |= (1 << 2);  // Calibration
+		while((ADC1->CR2 & (1 << 2)));
+	}
+
+	//ADC1->CR2 : JEXTSEL[14:12] trigger, JEXTTRIG. JEXTTRIG is off until here, so
+	//the write changes CR2 and is not taken as an ADON start of the regular group
+	ADC1->CR2 = (ADC1->CR2 & ~(7 << 12)) | ((inj->trigger & 7) << 12) | ADC_CR2_JEXTTRIG;
+
+	ADC1->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);
+	NVIC->ISER[ADC1_2_IRQn >> 5] = (1 << (ADC1_2_IRQn & 0x1F));
+
+	if (inj->trigger == ADC_JTRIGGER_JSWSTART)
+		ADC1->CR2 |= ADC_CR2_JSWSTART;
+}
+
+/*
+ * Funtion Name		: adcInjectedStop
+ * Description 		: Injected trigger and interrupt off, ADC1 stays on
+ *					  for the regular group
+ * Input			: None
+ * Return Value		: None
+*/
+void adcInjectedStop(void)
+{
+	ADC1->CR2 &= ~ADC_CR2_JEXTTRIG;
+	ADC1->CR1 &= ~ADC_CR1_JEOCIE;
+	NVIC->ICER[ADC1_2_IRQn >> 5] = (1 << (ADC1_2_IRQn & 0x1F));
+}
+
+/*
+ * Funtion Name		: adcInjectedHandler
+ * Description 		: ADC1_2 interrupt, end of the injected sequence :
+ *					  signed results (offset subtracted) to the callback
+ * Input			: None
+ * Return Value		: None
+*/
+void adcInjectedHandler(void)
+{
+	int16_t results[ADC_INJ_MAX_RANKS];
+	uint32_t rank;
+
+	if (!(ADC1->SR & ADC_SR_JEOC))
+		return;
+
+	for (rank = 0; rank < adcInj->length; ++rank)
+		results[rank] = (int16_t) (&ADC1->JDR1)[rank];
+	ADC1->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);  // rc_w0 : clear JEOC, JSTRT only
+
+	adcInjectedEvents++;
+	adcInj->callback(results, adcInj->length);
+}
@@ -0,0 +1,75 @@
+#ifndef ADCINJ_H
+#define ADCINJ_H
+
+/*
+ * File Name  : adcinj.h Ver 1.0
+ *
+ * Description:
+ *   ADC1 injected group : triggered high priority conversions
+ *
+ *   The injected group (JSQR, up to 4 ranks) is converted on its own
+ *   trigger (JEXTSEL) next to the regular group. A trigger during a
+ *   regular conversion (a DMA scan of adcscan.c) aborts it, converts the
+ *   injected ranks and restarts the aborted regular conversion, so the
+ *   injected sample instant does not wait for the scan. The aborted
+ *   conversion starts again from its sampling phase : a regular conversion
+ *   longer than the time between two injected sequences never completes
+ *   (the scan stops), keep regular sample times short enough.
+ *
+ *   JOFRx is subtracted in hardware, JDRx holds the signed result
+ *   (sign extended, right aligned) : with the offset at the zero of a
+ *   current sensor (e.g. 0x800 for 1.65 V) JDRx is the signed current.
+ *
+ *      static const uint8_t  ch[2]  = {4, 5};                      // PA4, PA5
+ *      static const uint8_t  smp[2] = {ADC_SMP_13_5, ADC_SMP_13_5};
+ *      static const uint16_t ofs[2] = {0x800, 0x800};
+ *      static const ADC_INJ_type inj = {ch, smp, ofs, 2, ADC_JTRIGGER_TIM4_TRGO, currents};
+ *
+ *      adcScanStart(&scan);        // optional, regular DMA scan
+ *      adcInjectedStart(&inj);     // armed, one sequence per TIM4 TRGO
+ *
+ *   Start the regular scan first : adcScanStart rewrites CR1/CR2,
+ *   adcInjectedStart only adds its bits (and powers ADC1 on if it is off).
+ *   More than one injected rank needs SCAN, it is set here and then also
+ *   applies to the regular group. The trigger source (timer) is set up by
+ *   the caller; adcInjectedHandler must be the ADC1_2 entry (0x088) of the
+ *   vector table.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define ADC_INJ_MAX_RANKS			(4)
+
+// External trigger of the injected group, JEXTSEL[2:0] of ADC1->CR2
+#define ADC_JTRIGGER_TIM1_TRGO		(0)
+#define ADC_JTRIGGER_TIM1_CC4		(1)
+#define ADC_JTRIGGER_TIM2_TRGO		(2)
+#define ADC_JTRIGGER_TIM2_CC1		(3)
+#define ADC_JTRIGGER_TIM3_CC4		(4)
+#define ADC_JTRIGGER_TIM4_TRGO		(5)
+#define ADC_JTRIGGER_EXTI15			(6)
+#define ADC_JTRIGGER_JSWSTART		(7)
+
+typedef struct
+{
+	const uint8_t *channels;        /* Channel of rank 1 .. 'length'                */
+	const uint8_t *sampleTimes;     /* ADC_SMP_x of each rank                       */
+	const uint16_t *offsets;        /* JOFRx of each rank, 0 .. 0xFFF               */
+	uint32_t length;                /* Ranks, 1 .. 4                                */
+	uint32_t trigger;               /* ADC_JTRIGGER_x                               */
+	void (*callback)(const int16_t *results, uint32_t length);  /* JEOC           */
+} ADC_INJ_type;
+
+extern volatile uint32_t adcInjectedEvents;     // Injected sequences converted
+
+uint32_t adcInjectedCycles(const ADC_INJ_type *inj);
+void adcInjectedStart(const ADC_INJ_type *inj);
+void adcInjectedStop(void);
+void adcInjectedHandler(void);
+
+#endif
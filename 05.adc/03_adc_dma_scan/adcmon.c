@@ -0,0 +1,147 @@
+/*
+ * File Name  : adcmon.c Ver 1.0
+ *
+ * Description:
+ *   VDDA and die temperature monitor on the ADC1 injected group
+ *   (see adcmon.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for the VDDA and temperature monitor **********************
+
+1.	Injected group : channel 17 (VREFINT) and 16 (sensor), sample time
+	239.5, no offset, trigger TIM2 TRGO (adcInjectedStart sets TSVREFE)
+2.	TIM2 : PSC/ARR for the rate (adcTriggerPlan), update event on TRGO
+	(MMS 010), counter on
+3.	JEOC interrupt : both codes averaged, VDDA = 1.20 V * 4095 / VREFINT,
+	sensor voltage = 1.20 V * sensor / VREFINT,
+	temperature = 25 C + (V25 - sensor voltage) / slope
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "adcscan.h"
+#include "adcinj.h"
+#include "adcmon.h"
+
+#define TIM_CR1_CEN					(1 << 0)
+#define TIM_CR2_MMS_UPDATE			(2 << 4)
+#define TIM_EGR_UG					(1 << 0)
+
+volatile ADC_MON_type adcMonitor;
+
+static void adcMonitorReady(const int16_t *results, uint32_t length);
+
+static const uint8_t monChannels[2] = {17, 16};     // VREFINT, sensor
+static const uint8_t monSampleTimes[2] = {ADC_SMP_239_5, ADC_SMP_239_5};
+static const uint16_t monOffsets[2] = {0, 0};
+
+static const ADC_INJ_type monitor = {
+	monChannels, monSampleTimes, monOffsets, 2, ADC_JTRIGGER_TIM2_TRGO, adcMonitorReady
+};
+
+/*
+ * Funtion Name		: adcMonitorReady
+ * Description 		: Injected sequence done : VREFINT and sensor code
+ * Input			: results, length
+ * Return Value		: None
+*/
+static void adcMonitorReady(const int16_t *results, uint32_t length)
+{
+	adcMonitorUpdate(results[0], results[1]);
+}
+
+/*
+ * Funtion Name		: adcMonitorUpdate
+ * Description 		: New VREFINT and sensor codes into the averages, VDDA
+ *					  and temperature from the averages
+ * Input			: vrefint, sensor (12 bit codes)
+ * Return Value		: None
+*/
+void adcMonitorUpdate(uint32_t vrefint, uint32_t sensor)
+{
+	uint32_t v, s, sense;
+
+	if (vrefint == 0)
+		return;
+
+	v = adcMonitor.vrefint;
+	s = adcMonitor.sensor;
+	if (adcMonitor.updates == 0) {
+		v = vrefint << ADC_MON_AVERAGE_BITS;
+		s = sensor << ADC_MON_AVERAGE_BITS;
+	} else {
+		v += vrefint - (v >> ADC_MON_AVERAGE_BITS);
+		s += sensor - (s >> ADC_MON_AVERAGE_BITS);
+	}
+
+	// Sensor voltage in 10 uV : 120000 * s / v, both codes scaled alike
+	sense = (ADC_MON_VREFINT_MV * 100) * s / v;
+
+	adcMonitor.vrefint = v;
+	adcMonitor.sensor = s;
+	adcMonitor.vddaMv = (ADC_MON_VREFINT_MV * 4095 << ADC_MON_AVERAGE_BITS) / v;
+	adcMonitor.temperature = 2500 + ((int32_t) ADC_MON_V25 - (int32_t) sense) * 100 / ADC_MON_SLOPE;
+	adcMonitor.updates++;
+}
+
+/*
+ * Funtion Name		: adcMonitorMillivolts
+ * Description 		: Regular channel code to millivolts with the measured
+ *					  VDDA (3300 mV until the first reading)
+ * Input			: code (12 bit)
+ * Return Value		: millivolts
+*/
+uint32_t adcMonitorMillivolts(uint32_t code)
+{
+	uint32_t vdda = adcMonitor.updates ? adcMonitor.vddaMv : 3300;
+
+	return (code * vdda + 2047) / 4095;
+}
+
+/*
+ * Funtion Name		: adcMonitorStart
+ * Description 		: Channels 16 and 17 as the injected group of ADC1 on
+ *					  TIM2 TRGO, 'hz' sequences per second
+ * Input			: hz
+ * Return Value		: Rate obtained, 0 : not possible
+*/
+uint32_t adcMonitorStart(uint32_t hz)
+{
+	ADC_TRIGGER_RATE_type rate;
+
+	adcTriggerPlan(clockFreq.timApb1clk, hz, &rate);
+	if (rate.hz == 0)
+		return 0;
+
+	adcMonitor.updates = 0;
+	adcInjectedStart(&monitor);
+
+	RCC->APB1ENR |= (1 << 0);   // TIM2 clock
+	TIM2->CR1 = 0;
+	TIM2->PSC = rate.psc;
+	TIM2->ARR = rate.arr;
+	TIM2->EGR = TIM_EGR_UG;     // Load PSC before the first period
+	TIM2->SR = 0;
+	TIM2->CR2 = TIM_CR2_MMS_UPDATE;
+	TIM2->CR1 = TIM_CR1_CEN;
+
+	return rate.hz;
+}
+
+/*
+ * Funtion Name		: adcMonitorStop
+ * Description 		: TIM2 and the injected group off, last readings kept
+ * Input			: None
+ * Return Value		: None
+*/
+void adcMonitorStop(void)
+{
+	TIM2->CR1 &= ~TIM_CR1_CEN;
+	adcInjectedStop();
+}
@@ -0,0 +1,72 @@
+#ifndef ADCMON_H
+#define ADCMON_H
+
+/*
+ * File Name  : adcmon.h Ver 1.0
+ *
+ * Description:
+ *   VDDA and die temperature from VREFINT (channel 17) and the temperature
+ *   sensor (channel 16) of ADC1, sampled in the background
+ *
+ *   adcMonitorStart converts both channels as the injected group of ADC1
+ *   (adcinj.c) on TIM2 TRGO at a low rate (a few Hz). A running regular
+ *   scan (adcscan.c) is not changed : its sequence, DMA buffer and rate
+ *   stay as they are, each injected sequence only delays it by the two
+ *   conversions (sample time 239.5 >= 17.1 us of the datasheet, 42 us
+ *   together) plus the restart of the regular conversion it aborted.
+ *   The regular sample time must be shorter than the time between two
+ *   monitor triggers (see adcinj.h), at a few Hz any is.
+ *
+ *   Channels 16/17 can also be part of a regular scan; the scan callback
+ *   then hands them to adcMonitorUpdate and adcMonitorStart is not used.
+ *
+ *   VDDA = VREFINT * 4095 / code of VREFINT, and a regular code in
+ *   millivolts is code * VDDA / 4095 (adcMonitorMillivolts), so results
+ *   stay right when VDDA is not 3.3 V or moves with load. The F1 has no
+ *   factory calibration of VREFINT or of the sensor : typical datasheet
+ *   values are used (VREFINT 1.20 V, 1.16 - 1.24 V; V25 1.43 V,
+ *   1.34 - 1.52 V; 4.3 mV/C). The sensor is linear to +-1 C typical, its
+ *   offset between parts needs a one point trim of ADC_MON_V25 for an
+ *   absolute temperature.
+ *
+ *      static const ADC_SCAN_type scan = {...};
+ *
+ *      adcScanStart(&scan);            // primary loop, DMA
+ *      adcMonitorStart(10);            // VREFINT and sensor 10 times per second
+ *      ...
+ *      mv = adcMonitorMillivolts(code);
+ *      t = adcMonitor.temperature;     // 0.01 C
+ *
+ *   The injected group and TIM2 are used by the monitor while it runs;
+ *   adcInjectedHandler must be the ADC1_2 entry (0x088) of the vector table.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define ADC_MON_VREFINT_MV			(1200)    // VREFINT typical, datasheet 1.16 - 1.24 V
+#define ADC_MON_V25					(143000)  // Sensor at 25 C in 10 uV, typical 1.43 V
+#define ADC_MON_SLOPE				(430)     // Sensor slope in 10 uV per C, typical 4.3 mV/C
+#define ADC_MON_AVERAGE_BITS		(3)       // Readings averaged over about 2^3 updates
+
+typedef struct
+{
+	uint32_t vrefint;               /* VREFINT code << AVERAGE_BITS, averaged       */
+	uint32_t sensor;                /* Sensor code << AVERAGE_BITS, averaged        */
+	uint32_t vddaMv;                /* VDDA in mV                                   */
+	int32_t temperature;            /* Die temperature in 0.01 C                    */
+	uint32_t updates;               /* Readings taken, 0 : no result yet            */
+} ADC_MON_type;
+
+extern volatile ADC_MON_type adcMonitor;
+
+uint32_t adcMonitorStart(uint32_t hz);
+void adcMonitorStop(void);
+void adcMonitorUpdate(uint32_t vrefint, uint32_t sensor);
+uint32_t adcMonitorMillivolts(uint32_t code);
+
+#endif
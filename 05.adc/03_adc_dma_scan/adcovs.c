@@ -0,0 +1,185 @@
+/*
+ * File Name  : adcovs.c Ver 1.0
+ *
+ * Description:
+ *   Oversampling and decimation of DMA scan buffers (see adcovs.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for oversampling and decimation **********************
+
+1.	adcOvsInit : channels of the scan, extra bits n, ratio 4^n, sums cleared
+2.	adcOvsProcess with each half buffer : the scans are summed in chunks of
+	up to ADC_OVS_PACKED_SCANS (and not past the end of a window)
+3.	Chunk : two samples per 32 bit load and add, 4 scans per loop pass,
+	the two 16 bit halves of the sum are added to the channel sums
+4.	Window of 'ratio' scans complete : sum >> n of every channel to the
+	output, sums cleared
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "adcovs.h"
+
+/*
+ * Funtion Name		: adcOvsInit
+ * Description 		: Decimation of 'channels' samples per scan to 12 + bits
+ * Input			: ovs, channels (1 .. 16), bits (0 .. 4)
+ * Return Value		: None
+*/
+void adcOvsInit(ADC_OVS_type *ovs, uint32_t channels, uint32_t bits)
+{
+	uint32_t c;
+
+	if (channels > ADC_OVS_MAX_CHANNELS)
+		channels = ADC_OVS_MAX_CHANNELS;
+	if (bits > ADC_OVS_MAX_BITS)
+		bits = ADC_OVS_MAX_BITS;
+
+	ovs->channels = channels;
+	ovs->bits = bits;
+	ovs->ratio = 1 << (2 * bits);
+	ovs->count = 0;
+	for (c = 0; c < ADC_OVS_MAX_CHANNELS; c++)
+		ovs->sum[c] = 0;
+}
+
+/*
+ * Funtion Name		: adcOvsSumSingle
+ * Description 		: One channel : consecutive samples, two per word
+ * Input			: ovs, p (4 byte aligned), scans (<= ADC_OVS_PACKED_SCANS)
+ * Return Value		: None
+*/
+static void adcOvsSumSingle(ADC_OVS_type *ovs, const uint32_t *p, uint32_t scans)
+{
+	uint32_t acc = 0;
+	uint32_t i = scans / 2;
+
+	for (; i >= 4; i -= 4) {
+		acc += p[0] + p[1] + p[2] + p[3];
+		p += 4;
+	}
+	for (; i > 0; i--)
+		acc += *p++;
+
+	ovs->sum[0] += (acc & 0xFFFF) + (acc >> 16);
+	if (scans & 1)
+		ovs->sum[0] += *((const uint16_t *) p);
+}
+
+/*
+ * Funtion Name		: adcOvsSumPairs
+ * Description 		: Even number of channels : word k of a scan holds
+ *					  channel 2k (low half) and 2k + 1 (high half)
+ * Input			: ovs, p (4 byte aligned), scans (<= ADC_OVS_PACKED_SCANS)
+ * Return Value		: None
+*/
+static void adcOvsSumPairs(ADC_OVS_type *ovs, const uint32_t *p, uint32_t scans)
+{
+	uint32_t w = ovs->channels / 2;
+	uint32_t k, i, acc;
+	const uint32_t *q;
+
+	for (k = 0; k < w; k++) {
+		q = p + k;
+		acc = 0;
+		for (i = scans; i >= 4; i -= 4) {
+			acc += q[0] + q[w] + q[2 * w] + q[3 * w];
+			q += 4 * w;
+		}
+		for (; i > 0; i--) {
+			acc += *q;
+			q += w;
+		}
+		ovs->sum[2 * k] += acc & 0xFFFF;
+		ovs->sum[2 * k + 1] += acc >> 16;
+	}
+}
+
+/*
+ * Funtion Name		: adcOvsSumOdd
+ * Description 		: Odd number of channels above 1 : one sample per load
+ * Input			: ovs, p, scans
+ * Return Value		: None
+*/
+static void adcOvsSumOdd(ADC_OVS_type *ovs, const uint16_t *p, uint32_t scans)
+{
+	uint32_t n = ovs->channels;
+	uint32_t c, i, acc;
+	const uint16_t *q;
+
+	for (c = 0; c < n; c++) {
+		q = p + c;
+		acc = 0;
+		for (i = scans; i >= 4; i -= 4) {
+			acc += q[0] + q[n] + q[2 * n] + q[3 * n];
+			q += 4 * n;
+		}
+		for (; i > 0; i--) {
+			acc += *q;
+			q += n;
+		}
+		ovs->sum[c] += acc;
+	}
+}
+
+/*
+ * Funtion Name		: adcOvsProcess
+ * Description 		: Sums the scans of a half buffer into the window, an
+ *					  output scan (12 + bits per sample) for every 'ratio'
+ *					  scans. With bits = 0 the samples are copied.
+ * Input			: ovs, samples (scan buffer half), scans, out (outputs)
+ * Return Value		: output scans written to out
+*/
+uint32_t adcOvsProcess(ADC_OVS_type *ovs, const uint16_t *samples, uint32_t scans, uint16_t *out)
+{
+	uint32_t n = ovs->channels;
+	uint32_t outputs = 0;
+	uint32_t chunk, c, i;
+
+	if (ovs->ratio == 1) {
+		for (i = scans * n; i >= 4; i -= 4) {
+			out[0] = samples[0];
+			out[1] = samples[1];
+			out[2] = samples[2];
+			out[3] = samples[3];
+			out += 4;
+			samples += 4;
+		}
+		for (; i > 0; i--)
+			*out++ = *samples++;
+		return scans;
+	}
+
+	for (; scans > 0; scans -= chunk) {
+		chunk = ovs->ratio - ovs->count;
+		if (chunk > ADC_OVS_PACKED_SCANS)
+			chunk = ADC_OVS_PACKED_SCANS;
+		if (chunk > scans)
+			chunk = scans;
+
+		if (n == 1)
+			adcOvsSumSingle(ovs, (const uint32_t *) samples, chunk);
+		else if (n & 1)
+			adcOvsSumOdd(ovs, samples, chunk);
+		else
+			adcOvsSumPairs(ovs, (const uint32_t *) samples, chunk);
+		samples += chunk * n;
+
+		ovs->count += chunk;
+		if (ovs->count == ovs->ratio) {
+			for (c = 0; c < n; c++) {
+				*out++ = ovs->sum[c] >> ovs->bits;
+				ovs->sum[c] = 0;
+			}
+			ovs->count = 0;
+			outputs++;
+		}
+	}
+
+	return outputs;
+}
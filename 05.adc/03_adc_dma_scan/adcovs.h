@@ -0,0 +1,71 @@
+#ifndef ADCOVS_H
+#define ADCOVS_H
+
+/*
+ * File Name  : adcovs.h Ver 1.0
+ *
+ * Description:
+ *   Oversampling and decimation of DMA scan buffers (adcscan.c)
+ *
+ *   Every 4^n scans of a channel are summed and the sum is shifted right
+ *   by n : one output of 12 + n bits per 4^n inputs, per channel.
+ *
+ *      n (bits)  ratio   output        output rate
+ *         0         1    12 bit        scan rate       (plain copy)
+ *         1         4    13 bit        scan rate / 4
+ *         2        16    14 bit        scan rate / 16
+ *         3        64    15 bit        scan rate / 64
+ *         4       256    16 bit        scan rate / 256
+ *
+ *   The extra bits are only real when the input has at least about 1 LSB
+ *   of noise (or dither) that is not correlated with the signal; a quiet
+ *   constant input decimates to the same 12 bit code shifted up.
+ *
+ *   adcOvsProcess takes the half buffers of the scan callback as they come,
+ *   a decimation window may span several halves (ratio 256 with 64 scans
+ *   per half needs 4 of them). Outputs are written per scan, channel by
+ *   channel as in the input :
+ *
+ *      static ADC_OVS_type ovs;
+ *      static uint16_t out[64 * 4];
+ *
+ *      adcOvsInit(&ovs, 4, 2);                             // 4 channels, 14 bit
+ *      ...
+ *      static void halfReady(const uint16_t *samples, uint32_t scans)
+ *      {
+ *          uint32_t outputs = adcOvsProcess(&ovs, samples, scans, out);
+ *          ...                                             // out[0 .. outputs * 4 - 1]
+ *      }
+ *
+ *   Samples are read as 32 bit words, two 12 bit samples per load and add
+ *   (two sums in the halves of one register, up to ADC_OVS_PACKED_SCANS
+ *   adds before the low half could carry into the high half). This needs
+ *   a 4 byte aligned DMA buffer and an even number of samples per half
+ *   (halfScans * length); a sequence with an odd number of channels above
+ *   1 is summed one sample per load.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define ADC_OVS_MAX_CHANNELS		(16)
+#define ADC_OVS_MAX_BITS			(4)       // Ratio 256, 16 bit output
+#define ADC_OVS_PACKED_SCANS		(16)      // 16 * 0xFFF = 0xFFF0 fits in 16 bits
+
+typedef struct
+{
+	uint32_t channels;              /* Samples per scan, 1 .. 16                    */
+	uint32_t bits;                  /* Extra bits n, 0 .. 4                         */
+	uint32_t ratio;                 /* Scans per output, 4^n                        */
+	uint32_t count;                 /* Scans summed in the current window           */
+	uint32_t sum[ADC_OVS_MAX_CHANNELS];
+} ADC_OVS_type;
+
+void adcOvsInit(ADC_OVS_type *ovs, uint32_t channels, uint32_t bits);
+uint32_t adcOvsProcess(ADC_OVS_type *ovs, const uint16_t *samples, uint32_t scans, uint16_t *out);
+
+#endif
@@ -0,0 +1,356 @@
+/*
+ * File Name  : adcscan.c Ver 1.0
+ *
+ * Description:
+ *   Continuous multi-channel ADC1 acquisition with DMA double buffering
+ *   (see adcscan.h)
+ *
+ *   adcScanDmaHandler must be the DMA1 channel 1 entry (0x06C) of the
+ *   vector table.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for ADC1 SCAN + DMA **********************
+
+1.	Enable clocks : DMA1 (RCC->AHBENR), ADC1 and GPIO ports (RCC->APB2ENR)
+2.	Analog input mode (CNF/MODE 0000) for the pins of the sequence
+3.	ADC1->CR1 SCAN, sequence in SQR1-3 (length in SQR1 L[3:0]),
+	sample times in SMPR1/SMPR2
+4.	ADC1->CR2 DMA, ADON, trigger : SWSTART with CONT, or EXTSEL of a timer
+	event without CONT (one scan per event)
+5.	Wait t_STAB, calibrate
+6.	DMA1 channel 1 : CPAR = &ADC1->DR, CMAR = buffer, CNDTR = samples,
+	16 bit to 16 bit, memory increment, circular, HT and TC interrupts
+7.	Enable DMA1_Channel1 interrupt in the NVIC, enable the channel
+8.	SWSTART : the sequence runs until adcScanStop
+	Timer trigger : adcTriggerStart starts the timer, one scan per period
+
+*************STEPS for the trigger timer ***************
+
+1.	PSC/ARR for the rate : (PSC + 1) * (ARR + 1) = timer clock / rate,
+	smallest PSC so the period is as exact as possible
+2.	TIM3 : CR2 MMS = 010, update event on TRGO
+	TIM2 CH2 / TIM4 CH4 : PWM mode 1, CCR half the period, CCxE
+	(the CCx event triggers, the pin stays a GPIO unless set to AF)
+3.	UG loads PSC, then CEN
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "adcscan.h"
+
+// DMA channel configuration register (CCR) bits
+#define DMA_CCR_EN					(1 << 0)
+#define DMA_CCR_TCIE				(1 << 1)
+#define DMA_CCR_HTIE				(1 << 2)
+#define DMA_CCR_CIRC				(1 << 5)
+#define DMA_CCR_MINC				(1 << 7)
+#define DMA_CCR_PSIZE_16			(1 << 8)
+#define DMA_CCR_MSIZE_16			(1 << 10)
+#define DMA_CCR_PL_HIGH				(2 << 12)
+
+// Timer bits for the trigger
+#define TIM_CR1_CEN					(1 << 0)
+#define TIM_CR2_MMS_UPDATE			(2 << 4)
+#define TIM_EGR_UG					(1 << 0)
+#define TIM_OCM_PWM1				(6)
+
+volatile uint32_t adcScanHalves;
+volatile uint32_t adcScanOverruns;
+
+static const ADC_SCAN_type *adcScan;		// Running acquisition
+
+/*
+ * Funtion Name		: adcSetSequence
+ * Description 		: Regular sequence : rank 1-6 in SQR3, 7-12 in SQR2,
+ *					  13-16 in SQR1, length - 1 in SQR1 L[3:0]
+ * Input			: adc ADC1 or ADC2, channels (rank 1 first), length 1 .. 16
+ * Return Value		: None
+*/
+void adcSetSequence(ADC_type *adc, const uint8_t *channels, uint32_t length)
+{
+	uint32_t sqr[3] = {0, 0, 0};
+	uint32_t rank;
+
+	for (rank = 0; rank < length; ++rank)
+		sqr[rank / 6] |= (channels[rank] & 0x1F) << ((rank % 6) * 5);
+
+	adc->SQR3 = sqr[0];
+	adc->SQR2 = sqr[1];
+	adc->SQR1 = sqr[2] | ((length - 1) << 20);
+}
+
+/*
+ * Funtion Name		: adcSetSampleTime
+ * Description 		: Sample time of one channel : channel 0-9 in SMPR2,
+ *					  10-17 in SMPR1, 3 bits each
+ * Input			: adc ADC1 or ADC2, channel 0 .. 17, smp ADC_SMP_x
+ * Return Value		: None
+*/
+void adcSetSampleTime(ADC_type *adc, uint32_t channel, uint32_t smp)
+{
+	if (channel < 10) {
+		adc->SMPR2 &= ~(7 << (channel * 3));
+		adc->SMPR2 |= (smp & 7) << (channel * 3);
+	} else {
+		adc->SMPR1 &= ~(7 << ((channel - 10) * 3));
+		adc->SMPR1 |= (smp & 7) << ((channel - 10) * 3);
+	}
+}
+
+/*
+ * Funtion Name		: adcScanSampleRate
+ * Description 		: Samples per second of the sequence from ADCCLK and
+ *					  the sample times (each conversion : sample + 12.5 clocks)
+ * Input			: scan
+ * Return Value		: samples per second, all channels together
+*/
+uint32_t adcScanSampleRate(const ADC_SCAN_type *scan)
+{
+	// Sample time in half ADC clocks for SMP 0-7
+	static const uint32_t sampleHalf[8] = {3, 15, 27, 57, 83, 111, 143, 479};
+	uint32_t rank, half = 0;
+
+	for (rank = 0; rank < scan->length; ++rank)
+		half += sampleHalf[scan->sampleTimes[rank] & 7] + 25;
+
+	return (uint32_t) ((unsigned long long) clockFreq.adcclk * 2 * scan->length / half);
+}
+
+/*
+ * Funtion Name		: adcSetPin
+ * Description 		: Analog input mode for the pin of a channel
+ *					  (0-7 PA0-PA7, 8-9 PB0-PB1), TSVREFE for 16 and 17
+ *					  (ADC1 only)
+ * Input			: channel
+ * Return Value		: None
+*/
+void adcSetPin(uint32_t channel)
+{
+	if (channel < 8) {
+		RCC->APB2ENR |= (1 << 2);                   // GPIOA clock
+		GPIOA->CRL &= ~(0xF << (channel * 4));      // CNF 00 Analog, MODE 00 Input
+	} else if (channel < 10) {
+		RCC->APB2ENR |= (1 << 3);                   // GPIOB clock
+		GPIOB->CRL &= ~(0xF << ((channel - 8) * 4));
+	} else if ((channel == 16 || channel == 17) && !(ADC1->CR2 & (1 << 23))) {
+		// Only when it changes : CR2 written again unchanged with ADON set
+		// would start a regular conversion
+		ADC1->CR2 |= (1 << 23);                     // TSVREFE
+	}
+}
+
+/*
+ * Funtion Name		: adcScanStart
+ * Description 		: Configures ADC1 and DMA1 channel 1 for the scan and
+ *					  starts the conversions. The callback runs for every
+ *					  half buffer until adcScanStop.
+ * Input			: scan
+ * Return Value		: None
+*/
+void adcScanStart(const ADC_SCAN_type *scan)
+{
+	uint32_t rank, i;
+
+	adcScan = scan;
+	adcScanHalves = 0;
+	adcScanOverruns = 0;
+
+	RCC->AHBENR |= (1 << 0);    // DMA1 clock
+	RCC->APB2ENR |= (1 << 9);   // ADC1 clock
+
+	//ADC1->CR1 : SCAN (bit 8), no interrupts, independent mode
+	ADC1->CR1 = (1 << 8);
+	ADC1->CR2 = 0;
+	for (rank = 0; rank < scan->length; ++rank) {
+		adcSetPin(scan->channels[rank]);
+		adcSetSampleTime(ADC1, scan->channels[rank], scan->sampleTimes[rank]);
+	}
+	adcSetSequence(ADC1, scan->channels, scan->length);
+
+	//ADC1->CR2 : EXTSEL trigger, EXTTRIG (bit 20), DMA (bit 8), CONT (bit 1) for SWSTART only
+	ADC1->CR2 |= ((scan->trigger & 7) << 17) | (1 << 20) | (1 << 8);
+	if (scan->trigger == ADC_TRIGGER_SWSTART)
+		ADC1->CR2 |= (1 << 1);
+	ADC1->CR2 |= (1 << 0);      // ADON : power on
+
+	// t_STAB 1 us before calibration
+	for (i = 0; i < 50; ++i) __asm__("nop");
+
+	ADC1->CR2 |= (1 << 3);      // Reset calibration
+	while((ADC1->CR2 & (1 << 3)));
+	ADC1->CR2 |= (1 << 2);      // Calibration
+	while((ADC1->CR2 & (1 << 2)));
+
+	// DMA1 channel 1 : ADC1->DR -> buffer, 16 bit, circular, half and full interrupts
+	DMA1_Channel1->CCR = 0;
+	DMA1->IFCR = DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1;
+	DMA1_Channel1->CPAR = DMA_ADDRESS(&ADC1->DR);
+	DMA1_Channel1->CMAR = DMA_ADDRESS(scan->buffer);
+	DMA1_Channel1->CNDTR = 2 * scan->halfScans * scan->length;
+	DMA1_Channel1->CCR = DMA_CCR_PL_HIGH | DMA_CCR_MSIZE_16 | DMA_CCR_PSIZE_16 | DMA_CCR_MINC |
+						 DMA_CCR_CIRC | DMA_CCR_HTIE | DMA_CCR_TCIE;
+
+	NVIC->IPR[DMA1_Channel1_IRQn] = 0x10;
+	NVIC->ISER[DMA1_Channel1_IRQn >> 5] = (1 << (DMA1_Channel1_IRQn & 0x1F));
+	DMA1_Channel1->CCR |= DMA_CCR_EN;
+
+	// SWSTART : first scan, CONT repeats it. Timer trigger : armed, adcTriggerStart
+	if (scan->trigger == ADC_TRIGGER_SWSTART)
+		ADC1->CR2 |= (1 << 22);
+}
+
+/*
+ * Funtion Name		: adcScanStop
+ * Description 		: Stops conversions and DMA, ADC1 is powered down
+ * Input			: None
+ * Return Value		: None
+*/
+void adcScanStop(void)
+{
+	ADC1->CR2 &= ~(1 << 1);     // CONT off : the running scan is the last one
+	ADC1->CR2 &= ~(1 << 0);     // ADON off
+	DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+	NVIC->ICER[DMA1_Channel1_IRQn >> 5] = (1 << (DMA1_Channel1_IRQn & 0x1F));
+}
+
+/*
+ * Funtion Name		: adcScanDmaHandler
+ * Description 		: DMA1 channel 1 interrupt. Half transfer : first half
+ *					  ready, transfer complete : second half ready.
+ *					  Both flags at once : one half was overwritten before
+ *					  its callback could run.
+ * Input			: None
+ * Return Value		: None
+*/
+void adcScanDmaHandler(void)
+{
+	uint32_t isr = DMA1->ISR;
+	uint32_t half = adcScan->halfScans * adcScan->length;
+
+	if ((isr & DMA_ISR_HTIF1) && (isr & DMA_ISR_TCIF1))
+		adcScanOverruns++;
+
+	if (isr & DMA_ISR_HTIF1) {
+		DMA1->IFCR = DMA_ISR_HTIF1;
+		adcScanHalves++;
+		adcScan->callback(adcScan->buffer, adcScan->halfScans);
+	}
+	if (isr & DMA_ISR_TCIF1) {
+		DMA1->IFCR = DMA_ISR_TCIF1;
+		adcScanHalves++;
+		adcScan->callback(adcScan->buffer + half, adcScan->halfScans);
+	}
+}
+
+/*
+ * Funtion Name		: adcTriggerPlan
+ * Description 		: PSC/ARR of a timer for a rate. The smallest prescaler
+ *					  that fits ARR in 16 bits, so the period is the
+ *					  nearest timer clock count to timclk / hz.
+ * Input			: timclk timer clock, hz rate, rate (result)
+ * Return Value		: None, rate->hz is 0 if hz is 0 or above timclk / 2
+*/
+void adcTriggerPlan(uint32_t timclk, uint32_t hz, ADC_TRIGGER_RATE_type *rate)
+{
+	uint32_t ticks, div;
+
+	rate->psc = 0;
+	rate->arr = 0;
+	rate->hz = 0;
+	if (hz == 0)
+		return;
+
+	ticks = (timclk + hz / 2) / hz;         // Timer clocks per period, rounded
+	if (ticks < 2)
+		return;
+
+	rate->psc = (ticks - 1) / 65536;
+	if (rate->psc > 0xFFFF)
+		rate->psc = 0xFFFF;
+	div = rate->psc + 1;
+	rate->arr = (ticks + div / 2) / div - 1;
+	if (rate->arr > 0xFFFF)
+		rate->arr = 0xFFFF;
+	rate->hz = (uint32_t) (((unsigned long long) timclk + (unsigned long long) div * (rate->arr + 1) / 2) /
+						   ((unsigned long long) div * (rate->arr + 1)));
+}
+
+/*
+ * Funtion Name		: adcTriggerStart
+ * Description 		: Sets up and starts the timer of a trigger source
+ *					  (TIM3 TRGO, TIM2 CC2, TIM4 CC4) for hz events per
+ *					  second. Start it after adcScanStart armed the ADC.
+ * Input			: trigger ADC_TRIGGER_x, hz
+ * Return Value		: Rate obtained, 0 : source not handled here or hz not possible
+*/
+uint32_t adcTriggerStart(uint32_t trigger, uint32_t hz)
+{
+	ADC_TRIGGER_RATE_type rate;
+	TIM_type *tim;
+
+	adcTriggerPlan(clockFreq.timApb1clk, hz, &rate);
+	if (rate.hz == 0)
+		return 0;
+
+	switch (trigger) {
+	case ADC_TRIGGER_TIM2_CC2:
+		RCC->APB1ENR |= (1 << 0);
+		tim = TIM2;
+		break;
+	case ADC_TRIGGER_TIM3_TRGO:
+		RCC->APB1ENR |= (1 << 1);
+		tim = TIM3;
+		break;
+	case ADC_TRIGGER_TIM4_CC4:
+		RCC->APB1ENR |= (1 << 2);
+		tim = TIM4;
+		break;
+	default:
+		return 0;
+	}
+
+	tim->CR1 = 0;
+	tim->CR2 = 0;
+	tim->PSC = rate.psc;
+	tim->ARR = rate.arr;
+	tim->EGR = TIM_EGR_UG;      // Load PSC before the first period
+	tim->SR = 0;
+
+	if (trigger == ADC_TRIGGER_TIM3_TRGO) {
+		tim->CR2 = TIM_CR2_MMS_UPDATE;
+	} else if (trigger == ADC_TRIGGER_TIM2_CC2) {
+		tim->CCR2 = (rate.arr + 1) / 2;
+		tim->CCMR1 = (tim->CCMR1 & ~(0x7 << 12)) | (TIM_OCM_PWM1 << 12);
+		tim->CCER |= (1 << 4);                  // CC2E
+	} else {
+		tim->CCR4 = (rate.arr + 1) / 2;
+		tim->CCMR2 = (tim->CCMR2 & ~(0x7 << 12)) | (TIM_OCM_PWM1 << 12);
+		tim->CCER |= (1 << 12);                 // CC4E
+	}
+
+	tim->CR1 = TIM_CR1_CEN;
+	return rate.hz;
+}
+
+/*
+ * Funtion Name		: adcTriggerStop
+ * Description 		: Stops the timer of a trigger source, the ADC waits
+ *					  for the next event
+ * Input			: trigger ADC_TRIGGER_x
+ * Return Value		: None
+*/
+void adcTriggerStop(uint32_t trigger)
+{
+	if (trigger == ADC_TRIGGER_TIM2_CC2)
+		TIM2->CR1 &= ~TIM_CR1_CEN;
+	else if (trigger == ADC_TRIGGER_TIM3_TRGO)
+		TIM3->CR1 &= ~TIM_CR1_CEN;
+	else if (trigger == ADC_TRIGGER_TIM4_CC4)
+		TIM4->CR1 &= ~TIM_CR1_CEN;
+}
@@ -0,0 +1,127 @@
+#ifndef ADCSCAN_H
+#define ADCSCAN_H
+
+/*
+ * File Name  : adcscan.h Ver 1.0
+ *
+ * Description:
+ *   Continuous multi-channel ADC1 acquisition with DMA double buffering
+ *
+ *   ADC1 converts the regular sequence (SQR1-3, up to 16 ranks) in SCAN and
+ *   continuous mode without software start per conversion. DMA1 channel 1
+ *   moves every result from ADC1->DR to a buffer in circular mode, the
+ *   buffer is two halves (ping-pong) :
+ *
+ *      buffer : | half 0 : halfScans scans | half 1 : halfScans scans |
+ *      scan   : | rank 1 | rank 2 | ... | rank 'length' |
+ *
+ *   DMA half transfer interrupt : half 0 is complete, DMA fills half 1
+ *   DMA transfer complete      : half 1 is complete, DMA fills half 0
+ *
+ *   The callback gets the complete half in the DMA interrupt and has the
+ *   time of one half buffer to use it before DMA writes it again.
+ *   adcScanOverruns counts halves the callback was too late for.
+ *
+ *   Conversion time = sample time + 12.5 ADC clocks. ADCCLK is 12 MHz
+ *   (72 MHz / 6), fastest conversion 1.5 + 12.5 = 14 clocks :
+ *   857 kS/s in total, shared by the channels of the sequence.
+ *   1 MS/s needs ADCCLK 14 MHz (SYSCLK 56 MHz, ADC prescaler /4).
+ *
+ *      static const uint8_t channels[4]    = {0, 1, 2, 3};      // PA0-PA3
+ *      static const uint8_t sampleTimes[4] = {ADC_SMP_1_5, ADC_SMP_1_5, ADC_SMP_1_5, ADC_SMP_1_5};
+ *      static uint16_t buffer[2 * 64 * 4];
+ *      static const ADC_SCAN_type scan = {channels, sampleTimes, 4, buffer, 64, halfReady,
+ *                                         ADC_TRIGGER_SWSTART};
+ *
+ *      adcScanStart(&scan);     // runs until adcScanStop()
+ *
+ *   Channels 0-7 are PA0-PA7, 8-9 PB0-PB1 (set to analog input here),
+ *   16 temperature sensor and 17 VREFINT (TSVREFE set when used).
+ *
+ *   Fixed rate sampling : with trigger ADC_TRIGGER_SWSTART the sequence runs
+ *   back to back (continuous mode). Any other trigger selects EXTSEL, CONT
+ *   is off and each rising edge of the trigger converts the sequence once,
+ *   so the sample instants are timer ticks and do not depend on the CPU :
+ *
+ *      static const ADC_SCAN_type scan = {channels, sampleTimes, 4, buffer, 64, halfReady,
+ *                                         ADC_TRIGGER_TIM3_TRGO};
+ *
+ *      adcScanStart(&scan);                                // armed, waits for TRGO
+ *      hz = adcTriggerStart(ADC_TRIGGER_TIM3_TRGO, 48000); // 48000 scans per second
+ *
+ *   adcTriggerStart sets PSC/ARR of the timer from clockFreq (adcTriggerPlan)
+ *   and returns the scan rate obtained. The trigger period must be longer
+ *   than the conversion time of the sequence, see adcScanSampleRate.
+ *   TIM2/TIM3/TIM4 sources are set up here; TIM1 CCx and EXTI11 are
+ *   selected in EXTSEL, the timer or pin has to be set up by the caller.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+#define ADC_SCAN_MAX_RANKS			(16)
+
+// Sample time SMPx[2:0] (SMPR1/SMPR2) in ADC clocks
+#define ADC_SMP_1_5					(0)
+#define ADC_SMP_7_5					(1)
+#define ADC_SMP_13_5				(2)
+#define ADC_SMP_28_5				(3)
+#define ADC_SMP_41_5				(4)
+#define ADC_SMP_55_5				(5)
+#define ADC_SMP_71_5				(6)
+#define ADC_SMP_239_5				(7)
+
+// External trigger of the regular group, EXTSEL[2:0] of ADC1->CR2
+#define ADC_TRIGGER_TIM1_CC1		(0)
+#define ADC_TRIGGER_TIM1_CC2		(1)
+#define ADC_TRIGGER_TIM1_CC3		(2)
+#define ADC_TRIGGER_TIM2_CC2		(3)
+#define ADC_TRIGGER_TIM3_TRGO		(4)
+#define ADC_TRIGGER_TIM4_CC4		(5)
+#define ADC_TRIGGER_EXTI11			(6)
+#define ADC_TRIGGER_SWSTART			(7)
+
+// DMA1->ISR / IFCR bits of channel 1
+#define DMA_ISR_GIF1				(1 << 0)
+#define DMA_ISR_TCIF1				(1 << 1)
+#define DMA_ISR_HTIF1				(1 << 2)
+#define DMA_ISR_TEIF1				(1 << 3)
+
+typedef struct
+{
+	const uint8_t *channels;        /* Channel of rank 1 .. 'length'                */
+	const uint8_t *sampleTimes;     /* ADC_SMP_x of each rank                       */
+	uint32_t length;                /* Ranks in the sequence, 1 .. 16               */
+	uint16_t *buffer;               /* 2 * halfScans * length samples               */
+	uint32_t halfScans;             /* Scans in one half of the buffer              */
+	void (*callback)(const uint16_t *samples, uint32_t scans);  /* Half ready      */
+	uint32_t trigger;               /* ADC_TRIGGER_x, SWSTART : continuous          */
+} ADC_SCAN_type;
+
+// Timer of a trigger : rate = timer clock / ((PSC + 1) * (ARR + 1))
+typedef struct
+{
+	uint32_t psc;
+	uint32_t arr;
+	uint32_t hz;                    /* Rate obtained (rounded), 0 : not possible    */
+} ADC_TRIGGER_RATE_type;
+
+extern volatile uint32_t adcScanHalves;     // Halves handed to the callback
+extern volatile uint32_t adcScanOverruns;   // Halves overwritten before the callback ran
+
+void adcSetSequence(ADC_type *adc, const uint8_t *channels, uint32_t length);
+void adcSetSampleTime(ADC_type *adc, uint32_t channel, uint32_t smp);
+void adcSetPin(uint32_t channel);
+uint32_t adcScanSampleRate(const ADC_SCAN_type *scan);
+void adcScanStart(const ADC_SCAN_type *scan);
+void adcScanStop(void);
+void adcScanDmaHandler(void);
+void adcTriggerPlan(uint32_t timclk, uint32_t hz, ADC_TRIGGER_RATE_type *rate);
+uint32_t adcTriggerStart(uint32_t trigger, uint32_t hz);
+void adcTriggerStop(uint32_t trigger);
+
+#endif
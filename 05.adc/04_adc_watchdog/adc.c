@@ -0,0 +1,227 @@
+/*
+ * File Name  : adc.c
+ *
+ * Description:
+ *              : PA0 level to LED (PC13) : polling loop against analog watchdog
+ *                  step 0 : SWSTART, wait EOC, compare with 0x800 in the
+ *                           loop as in 01_adc_pa0_polling_single
+ *                  step 1 : continuous conversion, the analog watchdog
+ *                           interrupts only when PA0 crosses 0x800
+ *                           (hysteresis 0x40, adcwdg.c), main sleeps
+ *                  LED on below 0x800 in both steps
+ *
+ *                CPU load : each step runs LOAD_SECONDS. adcLoad holds the
+ *                cycles the CPU was busy (polling : all of them, watchdog :
+ *                interrupt handlers + entry/exit), samples compared and
+ *                LED changes. SysTick wakes main every 10 ms to end the
+ *                step, its handler is counted as busy as well.
+ *                make load (st-util must be running) prints adcLoad.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *      ADC Clock           :  12 MHz (PCLK2 72 MHz / 6, max 14 MHz)
+ *
+ * Led Connection Details : PC13
+ *
+ * ADC Channel used       : PA0
+ *
+ * Step for generating bin : make
+ */
+
+/********** stm32f1 Register Address and Structures  ***************/
+#include "stm32f1reg.h"
+#include "clock.h"
+#include "profile.h"
+#include "adcwdg.h"
+
+#define LEVEL_THRESHOLD			(0x800)
+#define LEVEL_HYSTERESIS		(0x40)
+#define LOAD_SECONDS			(1)
+#define LOAD_STEPS				(2)
+#define LOAD_TICK_HZ			(100)     // SysTick, wakes main to end a step
+#define IRQ_ENTRY_EXIT_CYCLES	(24)      // Cortex-M3 exception entry 12 + return 12
+
+typedef struct
+{
+	uint32_t watchdog;          /* 0 : polling loop, 1 : analog watchdog      */
+	uint32_t cycles;            /* Cycles measured                            */
+	uint32_t busyCycles;        /* Cycles the CPU was not sleeping            */
+	uint32_t checks;            /* Polling : samples compared, AWD interrupts */
+	uint32_t crossings;         /* LED changes                                */
+	uint32_t loadPpm;           /* busyCycles * 1000000 / cycles, parts per million */
+} ADCLOAD_type;
+
+ADCLOAD_type adcLoad[LOAD_STEPS];
+
+static void levelChanged(uint32_t above);
+
+static const ADC_WDG_type levelWatchdog = {
+	0, ADC_WDG_SMP_239_5, LEVEL_THRESHOLD, LEVEL_HYSTERESIS, levelChanged
+};
+
+static ADCLOAD_type *loadStep;
+static volatile uint32_t loadTicks;
+
+void loadTickHandler(void);
+void adcInterrupt(void);
+void adcLoadDone(void);
+int32_t main(void);
+
+#include "stm32f1ivt.h"
+
+/*
+ * Funtion Name		: levelChanged
+ * Description 		: PA0 crossed the threshold (watchdog callback)
+ * Input			: above : 1 at or above LEVEL_THRESHOLD
+ * Return Value		: None
+*/
+static void levelChanged(uint32_t above)
+{
+	if (above)
+		GPIOC->BSRR = (1 << 13); //Switch OFF LED
+	else
+		GPIOC->BRR = (1 << 13);  //Switch ON LED
+}
+
+/*
+ * Funtion Name		: loadTickHandler
+ * Description 		: SysTick interrupt, counts the step time
+ * Input			: None
+ * Return Value		: None
+*/
+void loadTickHandler(void)
+{
+	uint32_t start = PROFILE_DWT->CYCCNT;
+
+	loadTicks++;
+	loadStep->busyCycles += PROFILE_DWT->CYCCNT - start + IRQ_ENTRY_EXIT_CYCLES;
+}
+
+/*
+ * Funtion Name		: adcInterrupt
+ * Description 		: ADC1_2 interrupt : analog watchdog, handler cycles
+ *					  counted into the running step
+ * Input			: None
+ * Return Value		: None
+*/
+void adcInterrupt(void)
+{
+	uint32_t start = PROFILE_DWT->CYCCNT;
+
+	adcWatchdogHandler();
+	loadStep->busyCycles += PROFILE_DWT->CYCCNT - start + IRQ_ENTRY_EXIT_CYCLES;
+}
+
+/*
+ * Funtion Name		: adcLoadDone
+ * Description 		: adcLoad is filled, gdb breakpoint for make load
+ * Input			: None
+ * Return Value		: None
+*/
+void adcLoadDone(void)
+{
+}
+
+/*
+ * Funtion Name		: adcPollingInit
+ * Description 		: ADC1 single conversion of PA0 on SWSTART, calibrated
+ * Input			: None
+ * Return Value		: None
+*/
+static void adcPollingInit(void)
+{
+	uint32_t i;
+
+	RCC->APB2ENR |= (1 << 2) | (1 << 9);   // GPIOA, ADC1 clocks
+	GPIOA->CRL &= 0xFFFFFFF0;               // PA0 analog input
+
+	ADC1->CR1 = 0;
+	ADC1->SQR1 = 0;
+	ADC1->SQR3 = 0;                         // Channel 0 PA0
+	ADC1->SMPR2 = ADC_WDG_SMP_239_5;
+	ADC1->CR2 = (7 << 17) | (1 << 20);      // SWSTART trigger, single conversion
+	ADC1->CR2 |= (1 << 0);
+
+	for (i = 0; i < 50; ++i) __asm__("nop");
+
+	ADC1->CR2 |= (1 << 3);
+	while((ADC1->CR2 & (1 << 3)));
+	ADC1->CR2 |= (1 << 2);
+	while((ADC1->CR2 & (1 << 2)));
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int32_t main(void)
+{
+	ADCLOAD_type *l;
+	uint32_t window, start, step, adc_data;
+	uint32_t led = 2;
+
+	// SYSCLK 72 MHz, APB2 72 MHz -> ADCCLK 72 / 6 = 12 MHz
+	clockInit72MHz();
+
+	RCC->APB2ENR |= (1 << 4); // Enable GPIOC CLK for PC13
+	GPIOC->CRH |= 0x00200000; // Make GPIOC Pin13 output (PC13)
+
+	window = LOAD_SECONDS * clockFreq.sysclk;
+
+	// Step 0 : polling loop, the CPU never sleeps
+	loadStep = l = &adcLoad[0];
+	adcPollingInit();
+	start = PROFILE_DWT->CYCCNT;
+	while (PROFILE_DWT->CYCCNT - start < window) {
+		ADC1->CR2 |= (1 << 22);                 // SWSTART
+		while(!(ADC1->SR & (1 << 1)));          // EOC
+		adc_data = ADC1->DR & 0xFFF;
+		l->checks++;
+
+		if (adc_data < LEVEL_THRESHOLD) {
+			GPIOC->BRR = (1 << 13);  //Switch ON LED
+			if (led != 1)
+				l->crossings++;
+			led = 1;
+		} else {
+			GPIOC->BSRR = (1 << 13); //Switch OFF LED
+			if (led != 0)
+				l->crossings++;
+			led = 0;
+		}
+	}
+	l->cycles = PROFILE_DWT->CYCCNT - start;
+	l->busyCycles = l->cycles;
+	ADC1->CR2 = 0;
+
+	// Step 1 : analog watchdog, the CPU sleeps until a crossing or a tick
+	loadStep = l = &adcLoad[1];
+	l->watchdog = 1;
+	adcWatchdogStart(&levelWatchdog);
+	SYSTICK->RVR = SYSTICK_RELOAD(1, LOAD_TICK_HZ);
+	SYSTICK->CVR = 0;
+	SYSTICK->CSR = 0x7;                         // Processor clock, TICKINT, ENABLE
+	start = PROFILE_DWT->CYCCNT;
+	loadTicks = 0;
+	while (loadTicks < LOAD_SECONDS * LOAD_TICK_HZ)
+		__asm__("wfi");
+	l->cycles = PROFILE_DWT->CYCCNT - start;
+	SYSTICK->CSR = 0;
+	l->checks = adcWatchdogEvents;
+	l->crossings = adcWatchdogCrossings;
+
+	for (step = 0; step < LOAD_STEPS; ++step)
+		adcLoad[step].loadPpm = (uint32_t) ((unsigned long long) adcLoad[step].busyCycles * 1000000 / adcLoad[step].cycles);
+	adcLoadDone();
+
+	// Watchdog keeps driving the LED
+	while(1)
+		__asm__("wfi");
+}
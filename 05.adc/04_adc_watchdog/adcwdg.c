@@ -0,0 +1,162 @@
+/*
+ * File Name  : adcwdg.c Ver 1.0
+ *
+ * Description:
+ *   Threshold crossing detection with the ADC1 analog watchdog
+ *   (see adcwdg.h)
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+/*************STEPS for the analog watchdog **********************
+
+1.	Enable clocks : ADC1 and the GPIO port (RCC->APB2ENR),
+	analog input mode for the pin
+2.	ADC1->CR1 : AWDEN (regular group), AWDSGL with AWDCH = channel
+	(one channel only), AWDIE
+3.	Sample time (SMPR1/2), one conversion in SQR1/SQR3
+4.	ADC1->LTR/HTR : window every result is outside of (LTR = HTR + 1)
+5.	ADC1->CR2 : SWSTART trigger, CONT, ADON, t_STAB, calibration
+6.	Enable ADC1_2 interrupt in the NVIC, SWSTART
+7.	Interrupt : DR outside the armed window is a crossing, window on the
+	new side, clear AWD
+
+*****************************************************/
+
+#include "stm32f1reg.h"
+#include "adcwdg.h"
+
+volatile uint32_t adcWatchdogEvents;
+volatile uint32_t adcWatchdogCrossings;
+
+static const ADC_WDG_type *adcWdg;      // Running watchdog
+static uint32_t adcWdgAbove;            // Side reported last
+static uint32_t adcWdgStarted;          // Side reported at least once
+static uint32_t adcWdgLow, adcWdgHigh;  // Window armed (LTR, HTR)
+
+/*
+ * Funtion Name		: adcWatchdogArm
+ * Description 		: Window around the side the level is on now
+ * Input			: above
+ * Return Value		: None
+*/
+static void adcWatchdogArm(uint32_t above)
+{
+	uint32_t threshold = adcWdg->threshold;
+	uint32_t hysteresis = adcWdg->hysteresis;
+
+	if (above) {
+		adcWdgLow = (threshold > hysteresis) ? threshold - hysteresis : 0;
+		adcWdgHigh = 0xFFF;
+	} else {
+		adcWdgLow = 0;
+		adcWdgHigh = (threshold + hysteresis - 1 < 0xFFF) ? threshold + hysteresis - 1 : 0xFFF;
+	}
+	ADC1->HTR = adcWdgHigh;
+	ADC1->LTR = adcWdgLow;
+}
+
+/*
+ * Funtion Name		: adcWatchdogStart
+ * Description 		: Continuous conversion of one channel with the analog
+ *					  watchdog interrupt, the first interrupt reports the side
+ * Input			: wdg
+ * Return Value		: None
+*/
+void adcWatchdogStart(const ADC_WDG_type *wdg)
+{
+	uint32_t ch = wdg->channel;
+	uint32_t i;
+
+	adcWdg = wdg;
+	adcWdgStarted = 0;
+	adcWatchdogEvents = 0;
+	adcWatchdogCrossings = 0;
+
+	RCC->APB2ENR |= (1 << 9);   // ADC1 clock
+	if (ch < 8) {
+		RCC->APB2ENR |= (1 << 2);
+		GPIOA->CRL &= ~(0xF << (ch * 4));           // CNF 00 Analog, MODE 00 Input
+	} else {
+		RCC->APB2ENR |= (1 << 3);
+		GPIOB->CRL &= ~(0xF << ((ch - 8) * 4));
+	}
+
+	//ADC1->CR1 : AWDEN, AWDSGL, AWDIE, AWDCH[4:0]
+	ADC1->CR2 = 0;
+	ADC1->CR1 = ADC_CR1_AWDEN | ADC_CR1_AWDSGL | ADC_CR1_AWDIE | (ch & 0x1F);
+	ADC1->SMPR2 = (wdg->sampleTime & 7) << (ch * 3);
+	ADC1->SQR1 = 0;             // One conversion
+	ADC1->SQR3 = ch;
+
+	// Every result outside the window : first conversion gives the side
+	ADC1->HTR = 0;
+	ADC1->LTR = 1;
+
+	//ADC1->CR2 : SWSTART trigger (EXTSEL 111, EXTTRIG), CONT, ADON
+	ADC1->CR2 = (7 << 17) | (1 << 20) | (1 << 1);
+	ADC1->CR2 |= (1 << 0);
+
+	for (i = 0; i < 50; ++i) __asm__("nop");
+
+	ADC1->CR2 |= (1 << 3);      // Reset calibration
+	while((ADC1->CR2 & (1 << 3)));
+	ADC1->CR2 |= (1 << 2);      // Calibration
+	while((ADC1->CR2 & (1 << 2)));
+
+	ADC1->SR = 0;
+	NVIC->ISER[ADC1_2_IRQn >> 5] = (1 << (ADC1_2_IRQn & 0x1F));
+	ADC1->CR2 |= (1 << 22);     // SWSTART, CONT repeats
+}
+
+/*
+ * Funtion Name		: adcWatchdogStop
+ * Description 		: ADC1 off, interrupt disabled
+ * Input			: None
+ * Return Value		: None
+*/
+void adcWatchdogStop(void)
+{
+	ADC1->CR2 &= ~((1 << 1) | (1 << 0));
+	ADC1->CR1 &= ~(ADC_CR1_AWDEN | ADC_CR1_AWDIE);
+	NVIC->ICER[ADC1_2_IRQn >> 5] = (1 << (ADC1_2_IRQn & 0x1F));
+}
+
+/*
+ * Funtion Name		: adcWatchdogHandler
+ * Description 		: ADC1 analog watchdog interrupt. The latest result
+ *					  outside the armed window is a crossing, the window
+ *					  is moved to the new side. A result converted while
+ *					  the window was moved may raise AWD once more, it is
+ *					  inside the new window and gives no callback.
+ * Input			: None
+ * Return Value		: None
+*/
+void adcWatchdogHandler(void)
+{
+	uint32_t value, above;
+
+	if (!(ADC1->SR & ADC_SR_AWD))
+		return;
+
+	adcWatchdogEvents++;
+	value = ADC1->DR & 0xFFF;
+	if (!adcWdgStarted)
+		above = value >= adcWdg->threshold;
+	else if (adcWdgAbove)
+		above = value >= adcWdgLow;
+	else
+		above = value > adcWdgHigh;
+	adcWatchdogArm(above);
+	ADC1->SR = ~ADC_SR_AWD;     // rc_w0 : clear AWD only
+
+	if (!adcWdgStarted || above != adcWdgAbove) {
+		adcWdgStarted = 1;
+		adcWdgAbove = above;
+		adcWatchdogCrossings++;
+		adcWdg->callback(above);
+	}
+}
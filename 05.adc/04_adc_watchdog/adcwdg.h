@@ -0,0 +1,70 @@
+#ifndef ADCWDG_H
+#define ADCWDG_H
+
+/*
+ * File Name  : adcwdg.h Ver 1.0
+ *
+ * Description:
+ *   Threshold crossing detection with the ADC1 analog watchdog
+ *
+ *   ADC1 converts one channel continuously, the analog watchdog compares
+ *   every result with LTR/HTR in hardware and sets AWD only when the
+ *   result is outside the window. The CPU does not read the samples, it
+ *   gets an interrupt when the level crosses the threshold :
+ *
+ *      below : window 0 .. threshold + hysteresis - 1
+ *              AWD when result >= threshold + hysteresis
+ *      above : window threshold - hysteresis .. 0xFFF
+ *              AWD when result <  threshold - hysteresis
+ *
+ *   adcWatchdogHandler moves the window to the other side (re-arm) and
+ *   calls the callback once per crossing, so with a hysteresis noise
+ *   around the threshold does not cause interrupts. Hysteresis 0 gives
+ *   the compare of the polling loop : above when result >= threshold.
+ *
+ *      static const ADC_WDG_type wdg = {0, ADC_WDG_SMP_239_5, 0x800, 0x40, levelChanged};
+ *
+ *      adcWatchdogStart(&wdg);
+ *      while (1)
+ *          __asm__("wfi");          // levelChanged(above) in the interrupt
+ *
+ *   adcWatchdogHandler must be called from the ADC1_2 interrupt (0x088).
+ *   The first conversion is outside every window, its interrupt reports
+ *   the starting side.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "stm32f1reg.h"
+
+// Sample time SMPx[2:0] in ADC clocks : longer sampling, fewer conversions
+#define ADC_WDG_SMP_1_5				(0)
+#define ADC_WDG_SMP_28_5			(3)
+#define ADC_WDG_SMP_239_5			(7)
+
+// ADC1->CR1 / SR bits of the analog watchdog
+#define ADC_CR1_AWDEN				(1 << 23)
+#define ADC_CR1_AWDSGL				(1 << 9)
+#define ADC_CR1_AWDIE				(1 << 6)
+#define ADC_SR_AWD					(1 << 0)
+
+typedef struct
+{
+	uint32_t channel;               /* Channel watched, 0-7 PA0-PA7, 8-9 PB0-PB1    */
+	uint32_t sampleTime;            /* ADC_WDG_SMP_x                                */
+	uint32_t threshold;             /* 12 bit level, 1 .. 0xFFF                     */
+	uint32_t hysteresis;            /* Codes on each side of the threshold          */
+	void (*callback)(uint32_t above);   /* Crossing, above : result >= threshold    */
+} ADC_WDG_type;
+
+extern volatile uint32_t adcWatchdogEvents;     // AWD interrupts
+extern volatile uint32_t adcWatchdogCrossings;  // Callbacks (side changed)
+
+void adcWatchdogStart(const ADC_WDG_type *wdg);
+void adcWatchdogStop(void);
+void adcWatchdogHandler(void);
+
+#endif
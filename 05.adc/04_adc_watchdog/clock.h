@@ -0,0 +1,57 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+/*
+ * File Name  : clock.h
+ *
+ * Description:
+ *   Clock tree bring-up for STM32F103 (Blue Pill)
+ *
+ *      HSE 8 MHz --> PLL x9 --> SYSCLK 72 MHz
+ *                                  |
+ *                                  +-- AHB  /1 --> HCLK   72 MHz (Core, SysTick, DMA)
+ *                                  +-- APB1 /2 --> PCLK1  36 MHz (TIM2/3/4 clock = 72 MHz)
+ *                                  +-- APB2 /1 --> PCLK2  72 MHz (TIM1 clock    = 72 MHz)
+ *                                                     +-- ADC /6 --> ADCCLK 12 MHz
+ *
+ *   After clockInit72MHz() the resulting bus frequencies are available
+ *   in clockFreq. Use them to derive PSC/ARR and SysTick reload values.
+ */
+
+#include "stm32f1reg.h"
+
+#define HSE_STARTUP_TIMEOUT     ((uint32_t) 0x5000)
+
+/*
+ * Bus frequencies in Hz. Filled by clockUpdateFreq() from RCC->CFGR
+ */
+typedef struct
+{
+	uint32_t sysclk;     /* SYSCLK, core clock                         */
+	uint32_t hclk;       /* AHB clock, SysTick processor clock         */
+	uint32_t pclk1;      /* APB1 peripheral clock (max 36 MHz)         */
+	uint32_t pclk2;      /* APB2 peripheral clock (max 72 MHz)         */
+	uint32_t timApb1clk; /* APB1 timer clock TIM2, TIM3, TIM4          */
+	uint32_t timApb2clk; /* APB2 timer clock TIM1                      */
+	uint32_t adcclk;     /* ADC clock (max 14 MHz)                     */
+} CLOCKFREQ_type;
+
+extern CLOCKFREQ_type clockFreq;
+
+/*
+ * Timer prescaler value for a timer clock of tickHz
+ *      fCK_CNT = fCK_PSC / (PSC[15:0] + 1)
+ */
+#define TIMER_PSC(timclk, tickHz)       (((timclk) / (tickHz)) - 1)
+
+/*
+ * SysTick reload value for an interrupt/COUNTFLAG every 1/rateHz second
+ *      clkSource 1 -> Processor clock (HCLK)   0 -> AHB/8
+ */
+#define SYSTICK_RELOAD(clkSource, rateHz) \
+	((((clkSource) ? clockFreq.hclk : (clockFreq.hclk / 8)) / (rateHz)) - 1)
+
+int32_t clockInit72MHz(void);
+void clockUpdateFreq(void);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/*
+ * File Name  : profile.h Ver 1.0
+ *
+ * Description:
+ *   Cycle count profiling with DWT->CYCCNT (Cortex-M3 data watchpoint and trace unit)
+ *
+ *   Each region has a number (0 .. PROFILE_MAX_REGIONS-1) and a name.
+ *   PROFILE_BEGIN/PROFILE_END around the code to be measured accumulate
+ *   count, min, max and total cycles of the region in profileTable (RAM).
+ *   Cost of the markers themselves is measured in profileInit and removed.
+ *
+ *      PROFILE_INIT();
+ *      PROFILE_NAME(0, "delayMilliSec");
+ *      ...
+ *      PROFILE_BEGIN(0);
+ *      delayMilliSec(2000);
+ *      PROFILE_END(0);
+ *
+ *   Markers are empty unless the code is built with -DPROFILE, so the
+ *   normal build is not changed. make profile builds with -DPROFILE -g,
+ *   runs the program and prints the table with profile.gdb once a region
+ *   has been measured PROFILE_REPORT_COUNT times (st-util must be running).
+ *
+ *   A region must not be nested in itself. Regions used in interrupt
+ *   handlers should not also be used in main.
+ *   At 72 MHz CYCCNT wraps after 59.6 seconds, longer regions are not valid.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#define PROFILE_MAX_REGIONS		8
+#ifndef PROFILE_REPORT_COUNT
+#define PROFILE_REPORT_COUNT	5
+#endif
+
+/********** Core debug and DWT registers ***************/
+#define COREDEBUG_DEMCR		(*((volatile uint32_t *) 0xE000EDFC))
+#define DEMCR_TRCENA		(1 << 24)
+
+typedef struct
+{
+	volatile uint32_t CTRL;     /* DWT control register,       Address offset: 0x00 */
+	volatile uint32_t CYCCNT;   /* DWT cycle count register,   Address offset: 0x04 */
+} PROFILE_DWT_type;
+
+#define PROFILE_DWT			((PROFILE_DWT_type *) 0xE0001000)
+#define DWT_CTRL_CYCCNTENA	(1 << 0)
+
+/********** Region statistics ***************/
+typedef struct
+{
+	const char *name;
+	uint32_t count;             /* Number of BEGIN/END pairs                 */
+	uint32_t min;               /* Cycles, marker overhead removed           */
+	uint32_t max;
+	unsigned long long total;   /* Sum of all cycles, mean = total / count   */
+	uint32_t start;             /* CYCCNT at PROFILE_BEGIN                   */
+} PROFILE_type;
+
+extern PROFILE_type profileTable[PROFILE_MAX_REGIONS];
+extern uint32_t profileOverhead;
+
+void profileInit(void);
+void profileName(uint32_t region, const char *name);
+void profileBegin(uint32_t region);
+void profileEnd(uint32_t region);
+void profileReport(void);
+
+#ifdef PROFILE
+#define PROFILE_INIT()					profileInit()
+#define PROFILE_NAME(region, name)		profileName((region), (name))
+#define PROFILE_BEGIN(region)			profileBegin(region)
+#define PROFILE_END(region)				profileEnd(region)
+#else
+#define PROFILE_INIT()
+#define PROFILE_NAME(region, name)
+#define PROFILE_BEGIN(region)
+#define PROFILE_END(region)
+#endif
+
+#endif
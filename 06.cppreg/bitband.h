@@ -0,0 +1,47 @@
+#ifndef BITBAND_H
+#define BITBAND_H
+
+/*
+ * File Name  : bitband.h
+ *
+ * Description:
+ *   Cortex-M3 bit-band alias access
+ *
+ *   Every bit of the first 1 MB of SRAM and peripheral space has its own
+ *   32 bit word in an alias region. Writing 0/1 to the alias word clears/sets
+ *   only that bit (the bus does the read-modify-write, ISRs can not break it).
+ *
+ *      Region       Bit-band area              Alias area
+ *      SRAM         0x20000000 - 0x200FFFFF    0x22000000 - 0x23FFFFFF
+ *      Peripheral   0x40000000 - 0x400FFFFF    0x42000000 - 0x43FFFFFF
+ *
+ *      alias address = alias base + (byte offset * 32) + (bit number * 4)
+ *
+ *   All address macros are constant expressions when addr is constant,
+ *   so BITBAND_PERIPH(&GPIOC->ODR, 13) = 1 compiles to a single STR.
+ *
+ *   Set/clear of one bit : single STR
+ *   Read of one bit      : single LDR (value 0 or 1)
+ *   Toggle of one bit    : LDR, EOR, STR on the alias (other bits are never written)
+ *
+ *   Status flags that are cleared by writing 0 (rc_w0, e.g. TIM SR) do not
+ *   need bit-band : REG = ~FLAG is already a single store and can not clear
+ *   a flag that is set while the store is in progress.
+ */
+
+#define BITBAND_SRAM_BASE       ((uint32_t) 0x20000000)
+#define BITBAND_SRAM_ALIAS      ((uint32_t) 0x22000000)
+#define BITBAND_PERIPH_BASE     ((uint32_t) 0x40000000)
+#define BITBAND_PERIPH_ALIAS    ((uint32_t) 0x42000000)
+
+// Alias word address of bit 'bit' at address 'addr'
+#define BITBAND_SRAM_ADDR(addr, bit) \
+	(BITBAND_SRAM_ALIAS + (((uint32_t)(addr) - BITBAND_SRAM_BASE) << 5) + ((uint32_t)(bit) << 2))
+#define BITBAND_PERIPH_ADDR(addr, bit) \
+	(BITBAND_PERIPH_ALIAS + (((uint32_t)(addr) - BITBAND_PERIPH_BASE) << 5) + ((uint32_t)(bit) << 2))
+
+// Alias word as lvalue : BITBAND_PERIPH(&GPIOC->ODR, 13) = 1;  flag = BITBAND_SRAM(&flags, 3);
+#define BITBAND_SRAM(addr, bit)     (*((volatile uint32_t *) BITBAND_SRAM_ADDR(addr, bit)))
+#define BITBAND_PERIPH(addr, bit)   (*((volatile uint32_t *) BITBAND_PERIPH_ADDR(addr, bit)))
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * File Name  : compare_c.c
+ *
+ * Description:
+ *   Hand written register accesses taken from the C examples
+ *   (04.pwm/pwm_timer3_pb1/pwm.c, 03.timer/timer3/timer.c, 01.ledblink/ledblink.c)
+ *   Each function has a twin with the same name and _cpp suffix in compare_cpp.cpp.
+ *
+ *   make compare : builds both files with -O2 and lists instruction count per function
+ *
+ *   Note : stm32f1reg.h structures are not volatile, so at -O2 GCC is free to
+ *          merge (gpio_clock_c, pwm_ch4_mode_c) or drop accesses. reg.hpp always
+ *          accesses through a volatile reference and merges only what is written
+ *          in one call.
+ */
+
+#include "stm32f1reg.h"
+#include "bitband.h"
+
+void gpio_clock_c(void)
+{
+	RCC->APB2ENR |= (1 << 0);
+	RCC->APB2ENR |= (1 << 4);
+	RCC->APB2ENR |= (1 << 3);
+}
+
+void pc13_output_c(void)
+{
+	GPIOC->CRH |= 0x00200000;
+}
+
+void pb1_altfunc_c(void)
+{
+	GPIOB->CRL |= 0x000000A0;
+}
+
+void led_on_c(void)
+{
+	GPIOC->BRR = (1 << 13);
+}
+
+void led_off_c(void)
+{
+	GPIOC->BSRR = (1 << 13);
+}
+
+void led_toggle_c(void)
+{
+	GPIOC->ODR ^= (1 << 13);
+}
+
+void led_toggle_bitband_c(void)
+{
+	BITBAND_PERIPH(&GPIOC->ODR, 13) ^= 1;
+}
+
+void led_on_bitband_c(void)
+{
+	BITBAND_PERIPH(&GPIOC->ODR, 13) = 0;
+}
+
+void pwm_ch4_mode_c(void)
+{
+	TIM3->CCMR2 |= 0x6800;
+	TIM3->CCER |= 0x3000;
+}
+
+void timer_uif_clear_c(void)
+{
+	TIM3->SR = ~(1 << 0);
+}
+
+void timer_start_c(void)
+{
+	TIM3->CR1 |= (1 << 0);
+}
+
+uint32_t timer_count_c(void)
+{
+	return TIM3->CNT;
+}
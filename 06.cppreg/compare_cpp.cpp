@@ -0,0 +1,78 @@
+/*
+ * File Name  : compare_cpp.cpp
+ *
+ * Description:
+ *   Same register accesses as compare_c.c written with reg.hpp / stm32f1.hpp
+ *
+ *   make compare : builds both files with -O2 and lists instruction count per function
+ */
+
+#include "stm32f1.hpp"
+
+using namespace stm32f1;
+
+extern "C" {
+
+void gpio_clock_cpp(void)
+{
+	Rcc::APB2ENR::set(Rcc::AFIOEN::value(true), Rcc::IOPCEN::value(true), Rcc::IOPBEN::value(true));
+}
+
+void pc13_output_cpp(void)
+{
+	GpioC::CR<13>::set(GpioC::MODE<13>::value(PinMode::Output2MHz));
+}
+
+void pb1_altfunc_cpp(void)
+{
+	GpioB::CR<1>::set(GpioB::MODE<1>::value(PinMode::Output2MHz),
+	                  GpioB::CNF<1>::value(PinCnf::AltPushPull));
+}
+
+void led_on_cpp(void)
+{
+	GpioC::resetPin<13>();
+}
+
+void led_off_cpp(void)
+{
+	GpioC::setPin<13>();
+}
+
+void led_toggle_cpp(void)
+{
+	GpioC::ODx<13>::toggle();
+}
+
+void led_toggle_bitband_cpp(void)
+{
+	GpioC::ODx<13>::bit::toggle();
+}
+
+void led_on_bitband_cpp(void)
+{
+	GpioC::ODx<13>::bit::reset();
+}
+
+void pwm_ch4_mode_cpp(void)
+{
+	Tim3::CCMR2::set(Tim3::OC4M::value(OcMode::Pwm1), Tim3::OC4PE::value(true));
+	Tim3::CCER::set(Tim3::CC4E::value(true), Tim3::CC4P::value(true));
+}
+
+void timer_uif_clear_cpp(void)
+{
+	Tim3::UIF::clear();
+}
+
+void timer_start_cpp(void)
+{
+	Tim3::CEN::set();
+}
+
+std::uint32_t timer_count_cpp(void)
+{
+	return Tim3::CNT::read();
+}
+
+}
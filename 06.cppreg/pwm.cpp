@@ -0,0 +1,121 @@
+/*
+ * File Name  : pwm.cpp Ver 1.0
+ *
+ * Description:
+ *   04.pwm/pwm_timer3_pb1/pwm.c written with the C++ register layer (reg.hpp)
+ *   PWM on PB1 (TIM3 CH4) 1 second period, 100 ms duty
+ *   PC13 LED toggles every 1 second in timer 3 interrupt handler
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ *
+ * Hardware :
+ *      STM32F103C8T6 Blue Pill Board
+ *
+ *      Ext. Clock Freq     :   8 MHz
+ *      System Clock        :  72 MHz (HSE + PLL, see clock.c)
+ *
+ * Led Connection Details : PC13
+ *							Connect External LED +v Terminal -> 3.3 V
+ *												 -v Terminal -> PB1
+ *
+ * Step for generating bin : make
+ * Code size comparison    : make compare
+ */
+
+#include "stm32f1.hpp"
+
+extern "C" {
+#include "clock.h"
+}
+
+using namespace stm32f1;
+
+#define GPIO_PIN					(13)  // LED connected on PC13
+
+/*********** Function declarations ****************/
+extern "C" {
+void timer3Handler(void);
+int main(void);
+
+/********** Interrupt Vector Table ***************/
+__attribute__ ((section(".isr_vector"), used))
+void (* const vector_table[])(void) = {
+	reinterpret_cast<void (*)(void)>(&_estack), /* 0x000 Stack Pointer */
+	Reset_Handler,                  /* 0x004 Reset                           */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 0x008 - 0x02C                         */
+	0, 0, 0, 0,                     /* 0x030 - 0x03C                         */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 0x040 - 0x064 IRQ 0 - 9               */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   /* 0x068 - 0x08C IRQ 10 - 19             */
+	0, 0, 0, 0, 0, 0, 0, 0, 0,      /* 0x090 - 0x0B0 IRQ 20 - 28             */
+	timer3Handler,                  /* 0x0B4 TIM3                            */
+};
+}
+
+/*
+ * Funtion Name		: timer3Handler
+ * Description 		: Toggles output on PC13 (bit-band alias) and clears CC4IF
+ *					  Flag clear is a single store (rc_w0), no read-modify-write
+ * Input			: None
+ * Return Value		: None
+*/
+void timer3Handler(void)
+{
+	Tim3::CCR4::write(1000);
+	GpioC::ODx<GPIO_PIN>::bit::toggle();
+	Tim3::CC4IF::clear();
+}
+
+/*************************************************
+* Main code starts from here
+*************************************************/
+int main(void)
+{
+	// SYSCLK 72 MHz, APB1 36 MHz -> TIM3 clock 72 MHz
+	clockInit72MHz();
+
+	// AFIO, GPIOB, GPIOC clock : one read-modify-write of RCC->APB2ENR
+	Rcc::APB2ENR::set(Rcc::AFIOEN::value(true),
+	                  Rcc::IOPBEN::value(true),
+	                  Rcc::IOPCEN::value(true));
+	Rcc::TIM3EN::set();
+
+	// PC13 Output Push Pull 2 MHz, PB1 alternate function push pull 2 MHz
+	GpioC::CR<GPIO_PIN>::modify(GpioC::MODE<GPIO_PIN>::value(PinMode::Output2MHz),
+	                            GpioC::CNF<GPIO_PIN>::value(PinCnf::PushPull));
+	GpioB::CR<1>::modify(GpioB::MODE<1>::value(PinMode::Output2MHz),
+	                     GpioB::CNF<1>::value(PinCnf::AltPushPull));
+
+	// No remap required for PB1 (TIM3 CH4)
+	Afio::TIM3_REMAP::write(0);
+
+	// Up counter, edge aligned, timer disabled
+	Tim3::CR1::write(0);
+
+	// 72 Mhz / 7199 + 1 = 10 KHz timer clock, 1 second period, 100 ms duty
+	Tim3::PSC::write(TIMER_PSC(clockFreq.timApb1clk, 10000));
+	Tim3::ARR::write(10000 - 1);
+	Tim3::CCR4::write(1000);
+
+	Tim3::CC4IE::set();
+
+	// Preload enable and PWM mode 1 for CH4 (was TIM3->CCMR2 |= 0x6800)
+	Tim3::CCMR2::modify(Tim3::OC4M::value(OcMode::Pwm1), Tim3::OC4PE::value(true));
+
+	// Enable CH4 output and polarity (was TIM3->CCER |= 0x3000)
+	Tim3::CCER::set(Tim3::CC4E::value(true), Tim3::CC4P::value(true));
+
+	// Priority level 1 and enable TIM3 in NVIC (C structures from stm32f1reg.h)
+	NVIC->IPR[TIM3_IRQn] = 0x10;
+	NVIC->ISER[((uint32_t)(TIM3_IRQn) >> 5)] = (1 << ((uint32_t)(TIM3_IRQn) & 0x1F));
+
+	// Finally enable TIM3 module
+	Tim3::CEN::set();
+
+	while(1);
+
+	// Should never reach here
+	return 0;
+}
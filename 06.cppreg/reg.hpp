@@ -0,0 +1,240 @@
+#ifndef REG_HPP
+#define REG_HPP
+
+/*
+ * File Name  : reg.hpp Ver 1.0
+ *
+ * Description:
+ *   Header only C++17 register access layer
+ *
+ *      Register<Address, Access>          : one 32 bit memory mapped register
+ *      Field<Register, Offset, Width, T>  : bit field inside a register, typed by T
+ *                                           (bool, enum class or integer)
+ *
+ *   Everything is resolved at compile time. Field values are combined
+ *   into one mask/value pair, so several field writes to the same register
+ *   cost a single access :
+ *
+ *      Reg::write(F1::value(a), F2::value(b))  -> STR                  (other bits 0)
+ *      Reg::set(F1::value(a), F2::value(b))    -> LDR, ORR, STR        (same as REG |= x)
+ *      Reg::modify(F1::value(a), ...)          -> LDR, BIC, ORR, STR   (fields replaced)
+ *      F1::read()                              -> LDR, UBFX
+ *      F1::toggle()                            -> LDR, EOR, STR        (same as REG ^= x)
+ *      F1::bit::set() / reset()                -> STR to bit-band alias (single bit fields)
+ *
+ *   Every access goes through a volatile reference. Fields of different
+ *   registers can not be mixed in one call (compile error).
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include <cstdint>
+#include <type_traits>
+
+namespace reg {
+
+/*
+ * Access policies
+ *      ReadWrite   : normal register
+ *      ReadOnly    : IDR, DR ...             (write/set/modify do not compile)
+ *      WriteOnly   : BSRR, BRR, EGR ...      (read/set/modify do not compile)
+ *      ClearWithZero : status flags rc_w0 (TIM SR, ADC SR)
+ *                    flag is cleared by writing 0, writing 1 has no effect,
+ *                    so clear() is a single store without read-modify-write
+ */
+struct ReadWrite     { static constexpr bool readable = true;  static constexpr bool writable = true;  };
+struct ReadOnly      { static constexpr bool readable = true;  static constexpr bool writable = false; };
+struct WriteOnly     { static constexpr bool readable = false; static constexpr bool writable = true;  };
+struct ClearWithZero { static constexpr bool readable = true;  static constexpr bool writable = true;  };
+
+/*
+ * Mask/value pair of one or more fields of register Reg
+ */
+template <typename Reg>
+struct FieldValue
+{
+	std::uint32_t mask;
+	std::uint32_t value;
+
+	constexpr FieldValue operator|(FieldValue other) const
+	{
+		return FieldValue{mask | other.mask, value | other.value};
+	}
+};
+
+template <typename Reg>
+constexpr FieldValue<Reg> combine()
+{
+	return FieldValue<Reg>{0, 0};
+}
+
+template <typename Reg, typename... Values>
+constexpr FieldValue<Reg> combine(FieldValue<Reg> first, Values... rest)
+{
+	return first | combine<Reg>(rest...);
+}
+
+/*
+ * Cortex-M3 bit-band alias
+ *      SRAM       0x20000000 - 0x200FFFFF  ->  0x22000000
+ *      Peripheral 0x40000000 - 0x400FFFFF  ->  0x42000000
+ *      alias = alias base + (byte offset * 32) + (bit * 4)
+ */
+constexpr bool inBitBandRegion(std::uint32_t address)
+{
+	return (address - 0x20000000u) < 0x100000u || (address - 0x40000000u) < 0x100000u;
+}
+
+constexpr std::uint32_t bitBandAlias(std::uint32_t address, unsigned bit)
+{
+	return (address & 0xF0000000u) + 0x02000000u + ((address & 0x000FFFFFu) << 5) + (bit << 2);
+}
+
+/*
+ * One bit through its alias word : set/reset/write are a single STR, read a single LDR,
+ * toggle is LDR, EOR, STR on the alias (no other bit of the register is written)
+ */
+template <std::uint32_t Address, unsigned Bit>
+struct BitBand
+{
+	static_assert(inBitBandRegion(Address), "address outside bit-band region");
+	static_assert(Bit < 32, "bit outside register");
+
+	static constexpr std::uint32_t alias = bitBandAlias(Address, Bit);
+
+	static volatile std::uint32_t &ref()
+	{
+		return *reinterpret_cast<volatile std::uint32_t *>(alias);
+	}
+
+	static void set()          { ref() = 1; }
+	static void reset()        { ref() = 0; }
+	static void write(bool v)  { ref() = v; }
+	static bool read()         { return ref() != 0; }
+	static void toggle()       { ref() = ref() ^ 1u; }
+};
+
+static_assert(bitBandAlias(0x4001100C, 13) == 0x422201B4, "GPIOC ODR bit 13");
+static_assert(bitBandAlias(0x20000300, 2) == 0x22006008, "SRAM bit");
+
+template <std::uint32_t Address, typename Access = ReadWrite>
+struct Register
+{
+	static constexpr std::uint32_t address = Address;
+	using access = Access;
+
+	static volatile std::uint32_t &ref()
+	{
+		return *reinterpret_cast<volatile std::uint32_t *>(Address);
+	}
+
+	static std::uint32_t read()
+	{
+		static_assert(Access::readable, "register is write only");
+		return ref();
+	}
+
+	// Raw 32 bit write
+	static void write(std::uint32_t value)
+	{
+		static_assert(Access::writable, "register is read only");
+		ref() = value;
+	}
+
+	// Write fields, all other bits 0 : single STR
+	template <typename... Values>
+	static void write(FieldValue<Register> first, Values... rest)
+	{
+		static_assert(Access::writable, "register is read only");
+		ref() = combine<Register>(first, rest...).value;
+	}
+
+	// OR fields into register (REG |= x)
+	template <typename... Values>
+	static void set(FieldValue<Register> first, Values... rest)
+	{
+		static_assert(Access::readable && Access::writable, "set needs a read/write register");
+		static_assert(!std::is_same<Access, ClearWithZero>::value, "use Field::clear on rc_w0 registers");
+		ref() = ref() | combine<Register>(first, rest...).value;
+	}
+
+	// Replace fields, keep other bits : single read-modify-write
+	template <typename... Values>
+	static void modify(FieldValue<Register> first, Values... rest)
+	{
+		static_assert(Access::readable && Access::writable, "modify needs a read/write register");
+		static_assert(!std::is_same<Access, ClearWithZero>::value, "use Field::clear on rc_w0 registers");
+		const FieldValue<Register> fv = combine<Register>(first, rest...);
+		ref() = (ref() & ~fv.mask) | fv.value;
+	}
+};
+
+template <typename Reg, unsigned Offset, unsigned Width, typename T = std::uint32_t>
+struct Field
+{
+	static_assert(Offset < 32 && Width >= 1 && (Offset + Width) <= 32, "field outside register");
+
+	using reg = Reg;
+	using type = T;
+	static constexpr unsigned offset = Offset;
+	static constexpr unsigned width = Width;
+	static constexpr std::uint32_t mask =
+		((Width == 32) ? 0xFFFFFFFFu : ((1u << Width) - 1u)) << Offset;
+
+	// Bit-band alias of a single bit field (rc_w0 flags use clear() instead)
+	using bit = BitBand<Reg::address, Offset>;
+
+	static constexpr FieldValue<Reg> value(T v)
+	{
+		return FieldValue<Reg>{mask, (static_cast<std::uint32_t>(v) << Offset) & mask};
+	}
+
+	static T read()
+	{
+		return static_cast<T>((Reg::read() & mask) >> Offset);
+	}
+
+	static void write(T v)
+	{
+		Reg::modify(value(v));
+	}
+
+	// Single bit helpers
+	static void set()
+	{
+		static_assert(Width == 1, "set() is for single bit fields");
+		Reg::set(FieldValue<Reg>{mask, mask});
+	}
+
+	static void reset()
+	{
+		static_assert(Width == 1, "reset() is for single bit fields");
+		Reg::modify(FieldValue<Reg>{mask, 0});
+	}
+
+	static void toggle()
+	{
+		static_assert(Width == 1, "toggle() is for single bit fields");
+		static_assert(Reg::access::readable && Reg::access::writable, "toggle needs a read/write register");
+		Reg::ref() = Reg::ref() ^ mask;
+	}
+
+	static bool isSet()
+	{
+		return (Reg::read() & mask) != 0;
+	}
+
+	// rc_w0 flag clear : write 0 to this flag and 1 to all others (no effect) : single STR
+	static void clear()
+	{
+		static_assert(std::is_same<typename Reg::access, ClearWithZero>::value, "clear() is for rc_w0 flags");
+		Reg::ref() = ~mask;
+	}
+};
+
+} // namespace reg
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef STM32F1_HPP
+#define STM32F1_HPP
+
+/*
+ * File Name  : stm32f1.hpp Ver 1.0
+ *
+ * Description:
+ *   STM32F103 registers and bit fields described with reg.hpp
+ *   (RCC, AFIO, GPIOA-C, TIM3, ADC1). Same addresses as stm32f1reg.h,
+ *   names are Rcc, Afio, GpioC, Tim3, Adc1 so they do not clash with
+ *   the C macros (RCC, GPIOC, TIM3 ...) when both headers are used.
+ *
+ *   Bit positions are taken from RM0008, see the register diagrams in
+ *   the C examples (02.systick ... 05.adc).
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "reg.hpp"
+
+namespace stm32f1 {
+
+using reg::Register;
+using reg::Field;
+using reg::ReadWrite;
+using reg::ReadOnly;
+using reg::WriteOnly;
+using reg::ClearWithZero;
+
+/*************************************************
+* RCC  (0x40021000)
+*************************************************/
+struct Rcc
+{
+	static constexpr std::uint32_t base = 0x40021000;
+
+	using APB2ENR  = Register<base + 0x18>;
+	using AFIOEN   = Field<APB2ENR,  0, 1, bool>;
+	using IOPAEN   = Field<APB2ENR,  2, 1, bool>;
+	using IOPBEN   = Field<APB2ENR,  3, 1, bool>;
+	using IOPCEN   = Field<APB2ENR,  4, 1, bool>;
+	using ADC1EN   = Field<APB2ENR,  9, 1, bool>;
+	using TIM1EN   = Field<APB2ENR, 11, 1, bool>;
+
+	using APB1ENR  = Register<base + 0x1C>;
+	using TIM2EN   = Field<APB1ENR,  0, 1, bool>;
+	using TIM3EN   = Field<APB1ENR,  1, 1, bool>;
+	using TIM4EN   = Field<APB1ENR,  2, 1, bool>;
+};
+
+/*************************************************
+* AFIO (0x40010000)
+*************************************************/
+struct Afio
+{
+	static constexpr std::uint32_t base = 0x40010000;
+
+	using MAPR       = Register<base + 0x04>;
+	using TIM3_REMAP = Field<MAPR, 10, 2>;
+};
+
+/*************************************************
+* GPIO
+*************************************************/
+enum class PinMode : std::uint32_t
+{
+	Input        = 0,
+	Output10MHz  = 1,
+	Output2MHz   = 2,
+	Output50MHz  = 3,
+};
+
+enum class PinCnf : std::uint32_t
+{
+	Analog          = 0,   // Input
+	Floating        = 1,   // Input
+	PullUpDown      = 2,   // Input
+	PushPull        = 0,   // Output
+	OpenDrain       = 1,   // Output
+	AltPushPull     = 2,   // Output
+	AltOpenDrain    = 3,   // Output
+};
+
+template <std::uint32_t Base>
+struct Gpio
+{
+	static constexpr std::uint32_t base = Base;
+
+	using CRL  = Register<Base + 0x00>;
+	using CRH  = Register<Base + 0x04>;
+	using IDR  = Register<Base + 0x08, ReadOnly>;
+	using ODR  = Register<Base + 0x0C>;
+	using BSRR = Register<Base + 0x10, WriteOnly>;
+	using BRR  = Register<Base + 0x14, WriteOnly>;
+	using LCKR = Register<Base + 0x18>;
+
+	// Pin 0-7 in CRL, Pin 8-15 in CRH, 4 bits per pin : CNF[1:0] MODE[1:0]
+	template <unsigned Pin>
+	using CR   = typename std::conditional<(Pin < 8), CRL, CRH>::type;
+	template <unsigned Pin>
+	using MODE = Field<CR<Pin>, (Pin % 8) * 4,     2, PinMode>;
+	template <unsigned Pin>
+	using CNF  = Field<CR<Pin>, (Pin % 8) * 4 + 2, 2, PinCnf>;
+	template <unsigned Pin>
+	using ODx  = Field<ODR, Pin, 1, bool>;
+	template <unsigned Pin>
+	using IDx  = Field<IDR, Pin, 1, bool>;
+
+	// Atomic pin set/reset : single STR
+	template <unsigned Pin>
+	static void setPin()   { BSRR::write(1u << Pin); }
+	template <unsigned Pin>
+	static void resetPin() { BRR::write(1u << Pin); }
+};
+
+using GpioA = Gpio<0x40010800>;
+using GpioB = Gpio<0x40010C00>;
+using GpioC = Gpio<0x40011000>;
+
+/*************************************************
+* General purpose timer (TIM2 - TIM4)
+*************************************************/
+enum class OcMode : std::uint32_t
+{
+	Frozen        = 0,
+	ActiveOnMatch = 1,
+	InactiveOnMatch = 2,
+	Toggle        = 3,
+	ForceInactive = 4,
+	ForceActive   = 5,
+	Pwm1          = 6,
+	Pwm2          = 7,
+};
+
+template <std::uint32_t Base>
+struct Tim
+{
+	static constexpr std::uint32_t base = Base;
+
+	using CR1   = Register<Base + 0x00>;
+	using CEN   = Field<CR1, 0, 1, bool>;
+	using UDIS  = Field<CR1, 1, 1, bool>;
+	using URS   = Field<CR1, 2, 1, bool>;
+	using OPM   = Field<CR1, 3, 1, bool>;
+	using DIR   = Field<CR1, 4, 1, bool>;
+	using CMS   = Field<CR1, 5, 2>;
+	using ARPE  = Field<CR1, 7, 1, bool>;
+	using CKD   = Field<CR1, 8, 2>;
+
+	using CR2   = Register<Base + 0x04>;
+	using MMS   = Field<CR2, 4, 3>;
+
+	using SMCR  = Register<Base + 0x08>;
+
+	using DIER  = Register<Base + 0x0C>;
+	using UIE   = Field<DIER,  0, 1, bool>;
+	using CC1IE = Field<DIER,  1, 1, bool>;
+	using CC2IE = Field<DIER,  2, 1, bool>;
+	using CC3IE = Field<DIER,  3, 1, bool>;
+	using CC4IE = Field<DIER,  4, 1, bool>;
+	using UDE   = Field<DIER,  8, 1, bool>;
+	using CC1DE = Field<DIER,  9, 1, bool>;
+	using CC2DE = Field<DIER, 10, 1, bool>;
+	using CC3DE = Field<DIER, 11, 1, bool>;
+	using CC4DE = Field<DIER, 12, 1, bool>;
+
+	using SR    = Register<Base + 0x10, ClearWithZero>;
+	using UIF   = Field<SR, 0, 1, bool>;
+	using CC1IF = Field<SR, 1, 1, bool>;
+	using CC2IF = Field<SR, 2, 1, bool>;
+	using CC3IF = Field<SR, 3, 1, bool>;
+	using CC4IF = Field<SR, 4, 1, bool>;
+
+	using EGR   = Register<Base + 0x14, WriteOnly>;
+	using UG    = Field<EGR, 0, 1, bool>;
+
+	using CCMR1 = Register<Base + 0x18>;
+	using OC1PE = Field<CCMR1,  3, 1, bool>;
+	using OC1M  = Field<CCMR1,  4, 3, OcMode>;
+	using OC2PE = Field<CCMR1, 11, 1, bool>;
+	using OC2M  = Field<CCMR1, 12, 3, OcMode>;
+
+	using CCMR2 = Register<Base + 0x1C>;
+	using OC3PE = Field<CCMR2,  3, 1, bool>;
+	using OC3M  = Field<CCMR2,  4, 3, OcMode>;
+	using OC4PE = Field<CCMR2, 11, 1, bool>;
+	using OC4M  = Field<CCMR2, 12, 3, OcMode>;
+
+	using CCER  = Register<Base + 0x20>;
+	using CC1E  = Field<CCER,  0, 1, bool>;
+	using CC1P  = Field<CCER,  1, 1, bool>;
+	using CC2E  = Field<CCER,  4, 1, bool>;
+	using CC2P  = Field<CCER,  5, 1, bool>;
+	using CC3E  = Field<CCER,  8, 1, bool>;
+	using CC3P  = Field<CCER,  9, 1, bool>;
+	using CC4E  = Field<CCER, 12, 1, bool>;
+	using CC4P  = Field<CCER, 13, 1, bool>;
+
+	using CNT   = Register<Base + 0x24>;
+	using PSC   = Register<Base + 0x28>;
+	using ARR   = Register<Base + 0x2C>;
+	using CCR1  = Register<Base + 0x34>;
+	using CCR2  = Register<Base + 0x38>;
+	using CCR3  = Register<Base + 0x3C>;
+	using CCR4  = Register<Base + 0x40>;
+	using DCR   = Register<Base + 0x48>;
+	using DMAR  = Register<Base + 0x4C>;
+};
+
+using Tim3 = Tim<0x40000400>;
+
+/*************************************************
+* ADC
+*************************************************/
+template <std::uint32_t Base>
+struct Adc
+{
+	static constexpr std::uint32_t base = Base;
+
+	using SR      = Register<Base + 0x00, ClearWithZero>;
+	using AWD     = Field<SR, 0, 1, bool>;
+	using EOC     = Field<SR, 1, 1, bool>;
+	using JEOC    = Field<SR, 2, 1, bool>;
+	using JSTRT   = Field<SR, 3, 1, bool>;
+	using STRT    = Field<SR, 4, 1, bool>;
+
+	using CR1     = Register<Base + 0x04>;
+	using EOCIE   = Field<CR1,  5, 1, bool>;
+	using SCAN    = Field<CR1,  8, 1, bool>;
+	using DUALMOD = Field<CR1, 16, 4>;
+
+	using CR2     = Register<Base + 0x08>;
+	using ADON    = Field<CR2,  0, 1, bool>;
+	using CONT    = Field<CR2,  1, 1, bool>;
+	using CAL     = Field<CR2,  2, 1, bool>;
+	using RSTCAL  = Field<CR2,  3, 1, bool>;
+	using DMA     = Field<CR2,  8, 1, bool>;
+	using ALIGN   = Field<CR2, 11, 1, bool>;
+	using EXTSEL  = Field<CR2, 17, 3>;
+	using EXTTRIG = Field<CR2, 20, 1, bool>;
+	using SWSTART = Field<CR2, 22, 1, bool>;
+	using TSVREFE = Field<CR2, 23, 1, bool>;
+
+	using SMPR1   = Register<Base + 0x0C>;
+	using SMPR2   = Register<Base + 0x10>;
+	using SQR1    = Register<Base + 0x2C>;
+	using L       = Field<SQR1, 20, 4>;
+	using SQR3    = Register<Base + 0x34>;
+	using SQ1     = Field<SQR3, 0, 5>;
+	using DR      = Register<Base + 0x4C, ReadOnly>;
+};
+
+using Adc1 = Adc<0x40012400>;
+
+} // namespace stm32f1
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef SIM_H
+#define SIM_H
+
+/*
+ * File Name  : sim.h Ver 1.0
+ *
+ * Description:
+ *   Force included (g++ -include sim.h) in front of every firmware source
+ *   built for the host simulator. It takes the place of stm32f1reg.h and
+ *   bitband.h :
+ *
+ *      - include guards of stm32f1reg.h / bitband.h / profile.h are defined
+ *        here, so the copies next to the example sources are skipped
+ *      - same type macros, *_BASE macros, peripheral macros, IRQn_type
+ *      - *_BASE macros point to the simulator register blocks instead of
+ *        0x4000xxxx, so GPIOC->ODR ^= (1 << 13) runs the GPIO model
+ *      - __asm__("nop") and every while () condition cost CPU cycles,
+ *        so NOP delays, polling loops and while(1); advance simulated time
+ *      - main is renamed to firmware_main (Makefile -Dmain=firmware_main),
+ *        Reset_Handler, _estack and the time base come from simcore.cpp
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "simcore.h"
+
+#define STM32F1REG_H
+#define BITBAND_H
+#define PROFILE_H
+
+/*************************************************
+* Definitions (as stm32f1reg.h)
+*************************************************/
+#define int32_t         int
+#define int16_t         short
+#define int8_t          char
+#define uint32_t        unsigned int
+#define uint16_t        unsigned short
+#define uint8_t         unsigned char
+#define uint64_t        unsigned long long
+
+#define HSE_Value       ((uint32_t)  8000000) /* Value of the External oscillator in Hz (Blue Pill crystal) */
+#define HSI_Value       ((uint32_t)  8000000) /* Value of the Internal oscillator in Hz*/
+
+// Base addresses : simulator register blocks
+#define TIM1_BASE       (&simTIM1)
+#define TIM2_BASE       (&simTIM2)
+#define TIM3_BASE       (&simTIM3)
+#define TIM4_BASE       (&simTIM4)
+#define AFIO_BASE       (&simAFIO)
+#define GPIOA_BASE      (&simGPIOA)
+#define GPIOB_BASE      (&simGPIOB)
+#define GPIOC_BASE      (&simGPIOC)
+#define GPIOD_BASE      (&simGPIOD)
+#define GPIOE_BASE      (&simGPIOE)
+#define ADC1_BASE       (&simADC1)
+#define ADC2_BASE       (&simADC2)
+#define DMA1_BASE       (&simDMA1.dma)
+#define RCC_BASE        (&simRCC)
+#define FLASH_BASE      (&simFLASH)
+#define PWR_BASE        (&simPWR)
+#define BKP_BASE        (&simBKP)
+#define SYSTICK_BASE    (&simSYSTICK)
+#define NVIC_BASE       (&simNVIC)
+#define SCB_BASE        (&simSCB)
+
+// Stack top and reset handler are provided by simcore.cpp
+extern uint32_t _estack;
+void Reset_Handler(void);
+#define STACKINIT       (&_estack)
+#define DELAY           7200000
+
+#define TIM1            ((TIM_type   *)  TIM1_BASE)
+#define TIM2            ((TIM_type   *)  TIM2_BASE)
+#define TIM3            ((TIM_type   *)  TIM3_BASE)
+#define TIM4            ((TIM_type   *)  TIM4_BASE)
+#define AFIO            ((AFIO_type  *)  AFIO_BASE)
+#define GPIOA           ((GPIO_type  *)  GPIOA_BASE)
+#define GPIOB           ((GPIO_type  *)  GPIOB_BASE)
+#define GPIOC           ((GPIO_type  *)  GPIOC_BASE)
+#define GPIOD           ((GPIO_type  *)  GPIOD_BASE)
+#define GPIOE           ((GPIO_type  *)  GPIOE_BASE)
+#define ADC1            ((ADC_type   *)  ADC1_BASE)
+#define ADC2            ((ADC_type   *)  ADC2_BASE)
+#define DMA1            ((DMA_type   *)  DMA1_BASE)
+#define DMA1_Channel1   (&simDMA1.channel[0])
+#define DMA1_Channel2   (&simDMA1.channel[1])
+#define DMA1_Channel3   (&simDMA1.channel[2])
+#define DMA1_Channel4   (&simDMA1.channel[3])
+#define DMA1_Channel5   (&simDMA1.channel[4])
+#define DMA1_Channel6   (&simDMA1.channel[5])
+#define DMA1_Channel7   (&simDMA1.channel[6])
+#define RCC             ((RCC_type   *)  RCC_BASE)
+#define FLASH           ((FLASH_type *)  FLASH_BASE)
+#define PWR             ((PWR_type   *)  PWR_BASE)
+#define BKP             ((BKP_type   *)  BKP_BASE)
+#define SYSTICK         ((STK_type   *)  SYSTICK_BASE)
+#define NVIC            ((NVIC_type  *)  NVIC_BASE)
+#define SCB             ((SCB_type   *)  SCB_BASE)
+
+// CPAR/CMAR : simulator handle of a register or buffer (32 bit address on the board)
+#define DMA_ADDRESS(p)  simDmaAddress(p)
+
+#define SET_BIT(REG, BIT)     ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)   ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)    ((REG) & (BIT))
+
+/*
+ * STM32F103 Interrupt Number Definition
+ */
+typedef enum IRQn
+{
+	NonMaskableInt_IRQn         = -14,
+	MemoryManagement_IRQn       = -12,
+	BusFault_IRQn               = -11,
+	UsageFault_IRQn             = -10,
+	SVCall_IRQn                 = -5,
+	DebugMonitor_IRQn           = -4,
+	PendSV_IRQn                 = -2,
+	SysTick_IRQn                = -1,
+	WWDG_IRQn                   = 0,
+	PVD_IRQn                    = 1,
+	TAMPER_IRQn                 = 2,
+	RTC_IRQn                    = 3,
+	FLASH_IRQn                  = 4,
+	RCC_IRQn                    = 5,
+	EXTI0_IRQn                  = 6,
+	EXTI1_IRQn                  = 7,
+	EXTI2_IRQn                  = 8,
+	EXTI3_IRQn                  = 9,
+	EXTI4_IRQn                  = 10,
+	DMA1_Channel1_IRQn          = 11,
+	DMA1_Channel2_IRQn          = 12,
+	DMA1_Channel3_IRQn          = 13,
+	DMA1_Channel4_IRQn          = 14,
+	DMA1_Channel5_IRQn          = 15,
+	DMA1_Channel6_IRQn          = 16,
+	DMA1_Channel7_IRQn          = 17,
+	ADC1_2_IRQn                 = 18,
+	CAN1_TX_IRQn                = 19,
+	CAN1_RX0_IRQn               = 20,
+	CAN1_RX1_IRQn               = 21,
+	CAN1_SCE_IRQn               = 22,
+	EXTI9_5_IRQn                = 23,
+	TIM1_BRK_IRQn               = 24,
+	TIM1_UP_IRQn                = 25,
+	TIM1_TRG_COM_IRQn           = 26,
+	TIM1_CC_IRQn                = 27,
+	TIM2_IRQn                   = 28,
+	TIM3_IRQn                   = 29,
+	TIM4_IRQn                   = 30,
+	I2C1_EV_IRQn                = 31,
+	I2C1_ER_IRQn                = 32,
+	I2C2_EV_IRQn                = 33,
+	I2C2_ER_IRQn                = 34,
+	SPI1_IRQn                   = 35,
+	SPI2_IRQn                   = 36,
+	USART1_IRQn                 = 37,
+	USART2_IRQn                 = 38,
+	USART3_IRQn                 = 39,
+	EXTI15_10_IRQn              = 40,
+	RTCAlarm_IRQn               = 41,
+	OTG_FS_WKUP_IRQn            = 42
+} IRQn_type;
+
+/*************************************************
+* Cycle counter (as profile.h) : DWT model, profiling regions are not built
+*************************************************/
+#define COREDEBUG_DEMCR     (simDEMCR)
+#define DEMCR_TRCENA        (1 << 24)
+#define PROFILE_DWT         (&simDWT)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+
+#define PROFILE_INIT()
+#define PROFILE_NAME(region, name)
+#define PROFILE_BEGIN(region)
+#define PROFILE_END(region)
+
+/*************************************************
+* Bit-band (as bitband.h) : one bit of a simulator register
+*************************************************/
+class SimBit
+{
+public:
+	SimBit(SimReg &r, unsigned int b) : reg(r), bit(b) {}
+
+	operator unsigned int() const       { return (static_cast<unsigned int>(reg) >> bit) & 1; }
+	// Alias write : the bus reads and writes the word, the CPU pays one store
+	SimBit &operator=(unsigned int v)
+	{
+		unsigned int word = simPeek(reg);
+		reg = (v & 1) ? (word | (1u << bit)) : (word & ~(1u << bit));
+		return *this;
+	}
+	SimBit &operator^=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) ^ v; }
+	SimBit &operator|=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) | v; }
+	SimBit &operator&=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) & v; }
+
+private:
+	SimReg &reg;
+	unsigned int bit;
+};
+
+#define BITBAND_PERIPH(addr, bit)   (SimBit(*(addr), (bit)))
+
+/*************************************************
+* CPU cycle hooks
+*************************************************/
+void simAsm(const char *instruction);
+bool simLoop(bool condition);
+
+// Vector table of the firmware (external linkage, read by the NVIC model)
+extern uint32_t * const vector_table[];
+
+#define __asm__(instruction)    simAsm(instruction)
+#define while(condition)        while (simLoop(condition))
+
+#endif
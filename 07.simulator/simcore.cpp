@@ -0,0 +1,691 @@
+/*
+ * File Name  : simcore.cpp Ver 1.0
+ *
+ * Description:
+ *   CPU side of the host simulator
+ *
+ *      - register access hooks of SimReg (cost simCost.access cycles each)
+ *      - __asm__("nop"/"cpsid i"/"cpsie i"/"wfi") and while () hooks
+ *      - time base : SYSCLK cycles and nanoseconds since reset
+ *      - NVIC model : enable, pending, active, priority (upper 4 bits of IPR),
+ *        preemption of lower priority handlers, level sensitive requests
+ *      - Reset_Handler : runs firmware_main (the renamed main of the example)
+ *      - command line and analog inputs
+ *
+ *   The simulator is single threaded. Firmware runs on the host CPU, time
+ *   only moves when the firmware touches a register, executes a NOP or
+ *   checks a while () condition. Code in between (computation on local
+ *   variables) takes no simulated time.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "simcore.h"
+
+#include <cmath>
+#include <cstdarg>
+
+// Symbols the firmware vector table refers to
+unsigned int _estack;
+extern unsigned int * const vector_table[];
+int firmware_main(void);
+
+/*
+ * Cycle cost of the firmware constructs (arm-none-eabi-gcc -O0, Cortex-M3, 2 flash wait states)
+ *      access   : LDR/STR to the peripheral bus plus address load
+ *      nop      : for (i = 0; i < N; ++i) __asm__("nop");  one iteration
+ *      loop     : while () condition check and branch
+ *      irqEntry : exception entry 12 cycles, irqExit : exception return 12 cycles
+ * Calibrate against hardware with make profile in the example directories.
+ */
+SIMCOST_type simCost = {3, 12, 3, 12, 12};
+
+#define SIM_EXCEPTIONS      (1 + 68)    // SysTick + 68 external interrupts
+#define SIM_PRIO_THREAD     256         // Execution priority of main (no handler active)
+
+typedef struct
+{
+	bool enabled;
+	bool pending;
+	bool active;
+	bool line;              // Peripheral request level
+	unsigned int priority;  // IPR value (upper 4 bits used)
+	int signal;             // Trace signal, -1 until first entry
+} IRQSTATE_type;
+
+static IRQSTATE_type irqState[SIM_EXCEPTIONS];
+static std::vector<int> activeStack;        // Handlers in progress, innermost last
+static bool primask;
+
+static bool irqCheck = true;                // NVIC state changed, look for an interrupt to take
+static std::uint64_t irqTaken;             // Handlers entered since reset
+static std::uint64_t cycleCount;
+static std::uint64_t nextEvent;             // Earliest horizon of all models
+static double timeNow;                      // ns
+static double nsPerCycle = 125.0;           // HSI 8 MHz after reset
+static double timeEnd = 5e9;                // --time, ns
+
+typedef struct
+{
+	bool used;
+	double offset;          // V
+	double amplitude;       // V (sine)
+	double frequency;       // Hz (sine), 0 : constant
+} ANALOG_type;
+
+static ANALOG_type analogIn[18];
+
+static int wireSource[5 * 16];              // --wire : output pin + 1 driving each input pin, 0 : none
+
+static IRQSTATE_type &irqEntry(int irq)
+{
+	if (irq < -1 || irq >= SIM_EXCEPTIONS - 1)
+		simFatal("interrupt number %d out of range", irq);
+	return irqState[irq + 1];
+}
+
+static const char *irqName(int irq)
+{
+	static const char *names[] = {
+		"WWDG", "PVD", "TAMPER", "RTC", "FLASH", "RCC", "EXTI0", "EXTI1", "EXTI2", "EXTI3",
+		"EXTI4", "DMA1_CH1", "DMA1_CH2", "DMA1_CH3", "DMA1_CH4", "DMA1_CH5", "DMA1_CH6", "DMA1_CH7",
+		"ADC1_2", "CAN1_TX", "CAN1_RX0", "CAN1_RX1", "CAN1_SCE", "EXTI9_5", "TIM1_BRK", "TIM1_UP",
+		"TIM1_TRG_COM", "TIM1_CC", "TIM2", "TIM3", "TIM4",
+	};
+
+	if (irq == -1)
+		return "SysTick";
+	if (irq >= 0 && irq < (int) (sizeof(names) / sizeof(names[0])))
+		return names[irq];
+	return nullptr;
+}
+
+/*************************************************
+* Time base
+*************************************************/
+std::uint64_t simCycles(void)
+{
+	return cycleCount;
+}
+
+double simTimeNs(void)
+{
+	return timeNow;
+}
+
+/*
+ * Funtion Name		: simSync
+ * Description 		: Advances one model to the current cycle and asks it
+ *					  for its next horizon
+ * Input			: model
+ * Return Value		: None
+*/
+static void schedule(SimDevice *dev)
+{
+	std::uint64_t horizon = dev->horizon();
+	std::uint64_t previous = dev->nextEvent;
+
+	dev->nextEvent = (horizon == SIM_NEVER) ? SIM_NEVER : cycleCount + horizon;
+	if (dev->nextEvent < nextEvent) {
+		nextEvent = dev->nextEvent;
+	} else if (previous == nextEvent && dev->nextEvent != previous) {
+		// This model had the earliest horizon, find the new one
+		nextEvent = SIM_NEVER;
+		for (SimDevice *d : simDevices())
+			if (d->nextEvent < nextEvent)
+				nextEvent = d->nextEvent;
+	}
+}
+
+void simSync(SimDevice *dev)
+{
+	if (cycleCount > dev->syncedAt) {
+		dev->advance(cycleCount - dev->syncedAt);
+		dev->syncedAt = cycleCount;
+	}
+	schedule(dev);
+}
+
+void simSyncAll(void)
+{
+	for (SimDevice *d : simDevices())
+		simSync(d);
+}
+
+// Models whose horizon was reached
+static void syncDue(void)
+{
+	for (SimDevice *d : simDevices())
+		if (d->nextEvent <= cycleCount)
+			simSync(d);
+}
+
+// After a register access : horizon of the model may have moved, SYSCLK may have changed
+static void accessDone(SimDevice *dev)
+{
+	schedule(dev);
+	nsPerCycle = 1e9 / simSysclk();
+}
+
+static void simFinish(void)
+{
+	std::fflush(stdout);
+	std::exit(simTraceFinish());
+}
+
+// Interrupt enabled and pending (wakes WFI even with PRIMASK set)
+static bool wakeupPending(void)
+{
+	int irq;
+
+	for (irq = -1; irq < SIM_EXCEPTIONS - 1; ++irq) {
+		IRQSTATE_type &s = irqEntry(irq);
+		if (s.pending && (s.enabled || irq < 0))
+			return true;
+	}
+	return false;
+}
+
+static int currentPriority(void)
+{
+	return activeStack.empty() ? SIM_PRIO_THREAD : (int) irqEntry(activeStack.back()).priority;
+}
+
+/*
+ * Funtion Name		: takeInterrupts
+ * Description 		: Enters the highest priority pending interrupt that can
+ *					  preempt the running code, runs its handler from the
+ *					  firmware vector table and repeats until nothing is left.
+ *					  Same priority : lower exception number first.
+ * Input			: None
+ * Return Value		: None
+*/
+static void takeInterrupts(void)
+{
+	int irq;
+
+	irqCheck = false;
+	while (!primask) {
+		int best = -2;
+		unsigned int bestPriority = SIM_PRIO_THREAD;
+
+		for (irq = -1; irq < SIM_EXCEPTIONS - 1; ++irq) {
+			IRQSTATE_type &s = irqEntry(irq);
+			if (!s.pending || s.active || !(s.enabled || irq < 0))
+				continue;
+			if (s.priority < bestPriority) {
+				best = irq;
+				bestPriority = s.priority;
+			}
+		}
+		if (best == -2 || (int) bestPriority >= currentPriority())
+			return;
+
+		IRQSTATE_type &s = irqEntry(best);
+		void (*handler)(void) = reinterpret_cast<void (*)(void)>(vector_table[16 + best]);
+		if (handler == nullptr)
+			simFatal("interrupt %d enabled without handler in vector_table", best);
+
+		if (s.signal < 0) {
+			const char *name = irqName(best);
+			s.signal = simTraceSignal(name ? std::string(name) : "IRQ" + std::to_string(best));
+		}
+
+		// Entry : pending -> active, stacking and vector fetch
+		s.pending = false;
+		s.active = true;
+		irqTaken++;
+		activeStack.push_back(best);
+		simTraceLevel(s.signal, 1);
+		simRun(simCost.irqEntry);
+
+		handler();
+
+		// Exit : a request still asserted makes the interrupt pending again
+		activeStack.pop_back();
+		s.active = false;
+		simTraceLevel(s.signal, 0);
+		if (s.line)
+			s.pending = true;
+		irqCheck = true;
+		simRun(simCost.irqExit);
+	}
+}
+
+/*
+ * Funtion Name		: simRun
+ * Description 		: CPU spent 'cycles' SYSCLK cycles : advance time and
+ *					  peripherals, then take pending interrupts.
+ *					  Stops the simulation at --time.
+ * Input			: cycles
+ * Return Value		: None
+*/
+void simRun(unsigned int cycles)
+{
+	std::uint64_t end = cycleCount + cycles;
+
+	// Models due inside the lump run at their cycle : pin edges one model
+	// sees from another (input capture) keep their time
+	while (nextEvent > cycleCount && nextEvent < end && timeNow < timeEnd) {
+		timeNow += (nextEvent - cycleCount) * nsPerCycle;
+		cycleCount = nextEvent;
+		syncDue();
+		nsPerCycle = 1e9 / simSysclk();
+	}
+	timeNow += (end - cycleCount) * nsPerCycle;
+	cycleCount = end;
+
+	if (cycleCount >= nextEvent) {
+		syncDue();
+		nsPerCycle = 1e9 / simSysclk();
+	}
+
+	if (timeNow >= timeEnd) {
+		simSyncAll();
+		simFinish();
+	}
+
+	if (irqCheck)
+		takeInterrupts();
+}
+
+// Cycles the CPU can sleep before a model needs to run (WFI)
+static unsigned int idleCycles(void)
+{
+	std::uint64_t idle = (nextEvent > cycleCount) ? nextEvent - cycleCount : 1;
+	double toEnd = (timeEnd - timeNow) / nsPerCycle + 1;
+
+	if (idle > toEnd)
+		idle = (std::uint64_t) toEnd;
+	if (idle > 0x10000000)
+		idle = 0x10000000;
+	return idle ? idle : 1;
+}
+
+/*************************************************
+* NVIC
+*************************************************/
+void simIrqLine(int irq, bool level)
+{
+	IRQSTATE_type &s = irqEntry(irq);
+
+	// Rising request sets pending, an active handler is re-pended at exit
+	if (level && !s.line && !s.active) {
+		s.pending = true;
+		irqCheck = true;
+	}
+	s.line = level;
+}
+
+void simSetPending(int irq)
+{
+	irqEntry(irq).pending = true;
+	irqCheck = true;
+}
+
+void simClearPending(int irq)
+{
+	irqEntry(irq).pending = false;
+}
+
+bool simIsPending(int irq)
+{
+	return irqEntry(irq).pending;
+}
+
+bool simIsActive(int irq)
+{
+	return irqEntry(irq).active;
+}
+
+void simSetEnable(int irq, bool enable)
+{
+	IRQSTATE_type &s = irqEntry(irq);
+
+	s.enabled = enable;
+	// A request that is still asserted is seen when the interrupt gets enabled
+	if (enable && s.line && !s.active)
+		s.pending = true;
+	irqCheck = true;
+}
+
+bool simIsEnabled(int irq)
+{
+	return irqEntry(irq).enabled;
+}
+
+void simSetPriority(int irq, unsigned int priority)
+{
+	irqEntry(irq).priority = priority & 0xF0;
+	irqCheck = true;
+}
+
+unsigned int simGetPriority(int irq)
+{
+	return irqEntry(irq).priority;
+}
+
+/*************************************************
+* Register access hooks
+*************************************************/
+// Peripheral without RCC clock : reads 0, writes are lost (as on hardware)
+static bool gated(SimDevice *dev)
+{
+	if (dev == nullptr || dev->clocked())
+		return false;
+	if (!dev->gateWarned) {
+		std::fprintf(stderr, "sim: %.3f ms: %s accessed while its RCC clock is disabled\n",
+		             timeNow * 1e-6, dev->name);
+		dev->gateWarned = true;
+	}
+	return true;
+}
+
+SimReg::operator unsigned int() const
+{
+	SimReg &r = const_cast<SimReg &>(*this);
+	unsigned int v;
+
+	if (dev == nullptr) {
+		v = value;
+	} else if (gated(dev)) {
+		v = 0;
+	} else {
+		simSync(dev);
+		v = dev->read(r);
+		accessDone(dev);
+	}
+
+	simRun(simCost.access);
+	return v;
+}
+
+SimReg &SimReg::operator=(unsigned int v)
+{
+	if (dev == nullptr) {
+		value = v;
+	} else if (!gated(dev)) {
+		simSync(dev);
+		dev->write(*this, v);
+		accessDone(dev);
+	}
+
+	simRun(simCost.access);
+	return *this;
+}
+
+unsigned int simPeek(SimReg &r)
+{
+	unsigned int v;
+
+	if (r.dev == nullptr)
+		return r.value;
+	if (gated(r.dev))
+		return 0;
+	simSync(r.dev);
+	v = r.dev->read(r);
+	accessDone(r.dev);
+	return v;
+}
+
+std::vector<SimDevice *> &simDevices(void)
+{
+	static std::vector<SimDevice *> list;
+	return list;
+}
+
+SimDevice::SimDevice(const char *deviceName, std::uint32_t baseAddress)
+	: name(deviceName), base(baseAddress), enableReg(nullptr), enableBit(0),
+	  gateWarned(false), syncedAt(0), nextEvent(0)
+{
+	simDevices().push_back(this);
+}
+
+void SimDevice::attach(SimReg *first, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; ++i) {
+		first[i].dev = this;
+		first[i].offset = i * 4;
+		first[i].value = 0;
+	}
+}
+
+/*
+ * Funtion Name		: simAsm
+ * Description 		: __asm__("...") of the firmware
+ *					  nop, cpsid i, cpsie i, wfi, dsb, dmb, isb
+ * Input			: instruction text
+ * Return Value		: None
+*/
+void simAsm(const char *instruction)
+{
+	if (std::strcmp(instruction, "nop") == 0) {
+		simRun(simCost.nop);
+	} else if (std::strcmp(instruction, "cpsid i") == 0) {
+		primask = true;
+		irqCheck = true;
+		simRun(1);
+	} else if (std::strcmp(instruction, "cpsie i") == 0) {
+		primask = false;
+		irqCheck = true;
+		simRun(1);
+	} else if (std::strcmp(instruction, "wfi") == 0) {
+		// Sleep until an interrupt is taken, or is pending while PRIMASK masks it
+		std::uint64_t taken = irqTaken;
+		while (irqTaken == taken && !(primask && wakeupPending()))
+			simRun(idleCycles());
+	} else if (std::strcmp(instruction, "dsb") == 0 || std::strcmp(instruction, "dmb") == 0 ||
+	           std::strcmp(instruction, "isb") == 0) {
+		simRun(1);
+	} else {
+		simFatal("__asm__(\"%s\") is not supported by the simulator", instruction);
+	}
+}
+
+bool simLoop(bool condition)
+{
+	simRun(simCost.loop);
+	return condition;
+}
+
+/*************************************************
+* Analog inputs
+*************************************************/
+double simAnalogInput(unsigned int channel)
+{
+	const ANALOG_type *a;
+
+	if (channel >= 18)
+		return 0.0;
+	a = &analogIn[channel];
+	if (!a->used) {
+		if (channel == 16)
+			return 1.43;            // Temperature sensor V25 at 25 C
+		if (channel == 17)
+			return 1.20;            // VREFINT
+		return 0.0;
+	}
+	if (a->frequency == 0.0)
+		return a->offset;
+	return a->offset + a->amplitude * std::sin(2.0 * M_PI * a->frequency * timeNow * 1e-9);
+}
+
+/*************************************************
+* Helpers
+*************************************************/
+void simFatal(const char *fmt, ...)
+{
+	va_list args;
+
+	std::fflush(stdout);
+	std::fprintf(stderr, "sim: %.3f ms: ", timeNow * 1e-6);
+	va_start(args, fmt);
+	std::vfprintf(stderr, fmt, args);
+	va_end(args);
+	std::fprintf(stderr, "\n");
+	std::exit(2);
+}
+
+double simParseTimeNs(const char *text)
+{
+	char *end;
+	double v = std::strtod(text, &end);
+
+	if (end == text || v < 0)
+		return -1;
+	if (std::strcmp(end, "ns") == 0)
+		return v;
+	if (std::strcmp(end, "us") == 0)
+		return v * 1e3;
+	if (std::strcmp(end, "ms") == 0 || *end == '\0')
+		return v * 1e6;
+	if (std::strcmp(end, "s") == 0)
+		return v * 1e9;
+	return -1;
+}
+
+/*************************************************
+* Wires between pins
+*************************************************/
+int simWireSource(unsigned int port, unsigned int pin)
+{
+	if (port >= 5 || pin >= 16)
+		return -1;
+	return wireSource[port * 16 + pin] - 1;
+}
+
+/*************************************************
+* Reset and command line
+*************************************************/
+void Reset_Handler(void)
+{
+	firmware_main();
+
+	// main returned : hang as startup.s does
+	while (true)
+		simRun(simCost.loop);
+}
+
+static void usage(const char *program)
+{
+	std::printf("Usage: %s [options]\n"
+	            "  --time T             simulated run time (default 5s), T : 10ms, 2s, 500us\n"
+	            "  --adc CH=V           constant voltage on ADC channel CH (PA0 = 0 ... PA7 = 7)\n"
+	            "  --adc-sine CH=V,A,F  sine on ADC channel CH : offset V, amplitude A volts, F Hz\n"
+	            "  --wire OUT=IN        input pin IN follows output pin OUT (a jumper), e.g. PA6=PA0\n"
+	            "  --no-hse             external crystal does not start (stays on HSI)\n"
+	            "  --nop-cycles N       cycles of one NOP loop iteration (default %u)\n"
+	            "  --access-cycles N    cycles of one register access (default %u)\n"
+	            "  --loop-cycles N      cycles of one while () check (default %u)\n",
+	            program, simCost.nop, simCost.access, simCost.loop);
+	simTraceUsage();
+}
+
+static bool parseChannel(const char *arg, unsigned int *channel, const char **rest)
+{
+	char *end;
+	unsigned long ch = std::strtoul(arg, &end, 10);
+
+	if (end == arg || *end != '=' || ch >= 18)
+		return false;
+	*channel = ch;
+	*rest = end + 1;
+	return true;
+}
+
+// "PA6" -> port << 4 | pin, -1 on error
+static int parsePin(const char *text, const char **rest)
+{
+	char *end;
+	unsigned long pin;
+
+	if (text[0] != 'P' || text[1] < 'A' || text[1] > 'E')
+		return -1;
+	pin = std::strtoul(text + 2, &end, 10);
+	if (end == text + 2 || pin >= 16)
+		return -1;
+	*rest = end;
+	return ((text[1] - 'A') << 4) | pin;
+}
+
+static bool parseWire(const char *arg)
+{
+	const char *rest;
+	int out, in;
+
+	out = parsePin(arg, &rest);
+	if (out < 0 || *rest != '=')
+		return false;
+	in = parsePin(rest + 1, &rest);
+	if (in < 0 || *rest != '\0' || in == out)
+		return false;
+	wireSource[(in >> 4) * 16 + (in & 0xF)] = out + 1;
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		unsigned int ch;
+		const char *rest;
+
+		if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+			usage(argv[0]);
+			return 0;
+		} else if (std::strcmp(arg, "--time") == 0 && next) {
+			timeEnd = simParseTimeNs(next);
+			if (timeEnd <= 0)
+				simFatal("bad --time %s", next);
+			++i;
+		} else if (std::strcmp(arg, "--adc") == 0 && next && parseChannel(next, &ch, &rest)) {
+			analogIn[ch].used = true;
+			analogIn[ch].offset = std::atof(rest);
+			analogIn[ch].frequency = 0.0;
+			++i;
+		} else if (std::strcmp(arg, "--adc-sine") == 0 && next && parseChannel(next, &ch, &rest)) {
+			ANALOG_type *a = &analogIn[ch];
+			if (std::sscanf(rest, "%lf,%lf,%lf", &a->offset, &a->amplitude, &a->frequency) != 3)
+				simFatal("bad --adc-sine %s", next);
+			a->used = true;
+			++i;
+		} else if (std::strcmp(arg, "--wire") == 0 && next) {
+			if (!parseWire(next))
+				simFatal("bad --wire %s", next);
+			++i;
+		} else if (std::strcmp(arg, "--no-hse") == 0) {
+			simSetHseEnabled(false);
+		} else if (std::strcmp(arg, "--nop-cycles") == 0 && next) {
+			simCost.nop = std::atoi(next);
+			++i;
+		} else if (std::strcmp(arg, "--access-cycles") == 0 && next) {
+			simCost.access = std::atoi(next);
+			++i;
+		} else if (std::strcmp(arg, "--loop-cycles") == 0 && next) {
+			simCost.loop = std::atoi(next);
+			++i;
+		} else if (!simTraceOption(argc, argv, i)) {
+			std::fprintf(stderr, "unknown option %s\n", arg);
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	for (i = 0; i < SIM_EXCEPTIONS; ++i)
+		irqState[i].signal = -1;
+
+	for (SimDevice *d : simDevices())
+		d->reset();
+	simGpioUpdate();
+	Reset_Handler();
+
+	return 0;
+}
@@ -0,0 +1,396 @@
+#ifndef SIMCORE_H
+#define SIMCORE_H
+
+/*
+ * File Name  : simcore.h Ver 1.0
+ *
+ * Description:
+ *   Host simulator core : register proxy, peripheral register layouts and
+ *   the time base shared by the peripheral models (simperiph.cpp), the
+ *   CPU/NVIC model (simcore.cpp) and the trace recorder (simtrace.cpp).
+ *
+ *   Every field of a peripheral structure is a SimReg. Reading or writing
+ *   it calls the peripheral model (SimDevice::read/write) and then lets
+ *   simulated time advance by the cost of one register access, so
+ *   polling loops, NOP delays and interrupts follow the simulated clock.
+ *
+ *   Firmware sources do not include this file directly, see sim.h.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class SimDevice;
+
+/*************************************************
+* One 32 bit memory mapped register
+*************************************************/
+class SimReg
+{
+public:
+	SimReg() : dev(nullptr), offset(0), value(0) {}
+	SimReg(const SimReg &) = delete;
+
+	// CPU side : every access goes through the device model and costs cycles
+	operator unsigned int() const;
+	SimReg &operator=(unsigned int v);
+	SimReg &operator=(const SimReg &r)  { return *this = static_cast<unsigned int>(r); }
+	SimReg &operator|=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) | v; }
+	SimReg &operator&=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) & v; }
+	SimReg &operator^=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) ^ v; }
+	SimReg &operator+=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) + v; }
+	SimReg &operator-=(unsigned int v)  { return *this = static_cast<unsigned int>(*this) - v; }
+
+	SimDevice *dev;         // Peripheral model, nullptr : plain memory
+	unsigned int offset;    // Byte offset inside the peripheral
+	unsigned int value;     // Register contents (hardware side, no access cost)
+};
+
+/*************************************************
+* Peripheral model
+*************************************************/
+#define SIM_NEVER       (~(std::uint64_t) 0)
+
+class SimDevice
+{
+public:
+	SimDevice(const char *deviceName, std::uint32_t baseAddress);
+	virtual ~SimDevice() {}
+
+	// Register access from the CPU, the model is brought up to the current cycle first
+	virtual unsigned int read(SimReg &r)            { return r.value; }
+	virtual void write(SimReg &r, unsigned int v)   { r.value = v; }
+
+	// Reset values, called before the firmware starts
+	virtual void reset() {}
+
+	// Simulated time moved on by 'cycles' SYSCLK cycles
+	virtual void advance(std::uint64_t cycles)      { (void) cycles; }
+
+	// SYSCLK cycles until the model changes a flag, pin or interrupt request on
+	// its own (timer update, end of conversion ...), SIM_NEVER if it is idle.
+	// Models are only advanced when this time is reached or a register is accessed.
+	virtual std::uint64_t horizon()                 { return SIM_NEVER; }
+
+	// RCC clock enable bit : registers of an unclocked peripheral read 0, writes are lost
+	bool clocked() const
+	{
+		return enableReg == nullptr || ((enableReg->value >> enableBit) & 1);
+	}
+
+	const char *name;
+	std::uint32_t base;
+	SimReg *enableReg;
+	unsigned int enableBit;
+	bool gateWarned;            // Access without clock reported once
+	std::uint64_t syncedAt;     // Cycle the model was advanced to
+	std::uint64_t nextEvent;    // Cycle of the next horizon
+
+protected:
+	// Registers laid out back to back, offset 0, 4, 8 ...
+	void attach(SimReg *first, unsigned int count);
+};
+
+/*************************************************
+* Register layouts : same names and offsets as stm32f1reg.h
+*************************************************/
+struct GPIO_type
+{
+	SimReg CRL;      /* GPIO port configuration register low,      Address offset: 0x00 */
+	SimReg CRH;      /* GPIO port configuration register high,     Address offset: 0x04 */
+	SimReg IDR;      /* GPIO port input data register,             Address offset: 0x08 */
+	SimReg ODR;      /* GPIO port output data register,            Address offset: 0x0C */
+	SimReg BSRR;     /* GPIO port bit set/reset register,          Address offset: 0x10 */
+	SimReg BRR;      /* GPIO port bit reset register,              Address offset: 0x14 */
+	SimReg LCKR;     /* GPIO port configuration lock register,     Address offset: 0x18 */
+};
+
+struct AFIO_type
+{
+	SimReg EVCR;     /* Address offset: 0x00 */
+	SimReg MAPR;     /* Address offset: 0x04 */
+	SimReg EXTICR1;  /* Address offset: 0x08 */
+	SimReg EXTICR2;  /* Address offset: 0x0C */
+	SimReg EXTICR3;  /* Address offset: 0x10 */
+	SimReg EXTICR4;  /* Address offset: 0x14 */
+	SimReg MAPR2;    /* Address offset: 0x18 */
+};
+
+struct RCC_type
+{
+	SimReg CR;       /* RCC clock control register,                Address offset: 0x00 */
+	SimReg CFGR;     /* RCC clock configuration register,          Address offset: 0x04 */
+	SimReg CIR;      /* RCC clock interrupt register,              Address offset: 0x08 */
+	SimReg APB2RSTR; /* RCC APB2 peripheral reset register,        Address offset: 0x0C */
+	SimReg APB1RSTR; /* RCC APB1 peripheral reset register,        Address offset: 0x10 */
+	SimReg AHBENR;   /* RCC AHB peripheral clock enable register,  Address offset: 0x14 */
+	SimReg APB2ENR;  /* RCC APB2 peripheral clock enable register, Address offset: 0x18 */
+	SimReg APB1ENR;  /* RCC APB1 peripheral clock enable register, Address offset: 0x1C */
+	SimReg BDCR;     /* RCC backup domain control register,        Address offset: 0x20 */
+	SimReg CSR;      /* RCC control/status register,               Address offset: 0x24 */
+	SimReg AHBRSTR;  /* RCC AHB peripheral clock reset register,   Address offset: 0x28 */
+	SimReg CFGR2;    /* RCC clock configuration register 2,        Address offset: 0x2C */
+};
+
+struct FLASH_type
+{
+	SimReg ACR;      /* FLASH access control register,             Address offset: 0x00 */
+	SimReg KEYR;     /* FLASH key register,                        Address offset: 0x04 */
+	SimReg OPTKEYR;  /* FLASH option key register,                 Address offset: 0x08 */
+	SimReg SR;       /* FLASH status register,                     Address offset: 0x0C */
+	SimReg CR;       /* FLASH control register,                    Address offset: 0x10 */
+	SimReg AR;       /* FLASH address register,                    Address offset: 0x14 */
+	SimReg RESERVED; /* Reserved,                                  Address offset: 0x18 */
+	SimReg OBR;      /* FLASH option byte register,                Address offset: 0x1C */
+	SimReg WRPR;     /* FLASH write protection register,           Address offset: 0x20 */
+};
+
+struct PWR_type
+{
+	SimReg CR;       /* PWR power control register,                Address offset: 0x00 */
+	SimReg CSR;      /* PWR power control/status register,         Address offset: 0x04 */
+};
+
+struct BKP_type
+{
+	SimReg RESERVED0; /* Reserved,                                 Address offset: 0x00 */
+	SimReg DR[10];   /* BKP data registers DR1-DR10,               Address offset: 0x04 - 0x28 */
+	SimReg RTCCR;    /* BKP RTC clock calibration register,        Address offset: 0x2C */
+	SimReg CR;       /* BKP control register,                      Address offset: 0x30 */
+	SimReg CSR;      /* BKP control/status register,               Address offset: 0x34 */
+};
+
+struct STK_type
+{
+	SimReg CSR;      /* SYSTICK control and status register,       Address offset: 0x00 */
+	SimReg RVR;      /* SYSTICK reload value register,             Address offset: 0x04 */
+	SimReg CVR;      /* SYSTICK current value register,            Address offset: 0x08 */
+	SimReg CALIB;    /* SYSTICK calibration value register,        Address offset: 0x0C */
+};
+
+struct TIM_type
+{
+	SimReg CR1;      /* Address offset: 0x00 */
+	SimReg CR2;      /* Address offset: 0x04 */
+	SimReg SMCR;     /* Address offset: 0x08 */
+	SimReg DIER;     /* Address offset: 0x0C */
+	SimReg SR;       /* Address offset: 0x10 */
+	SimReg EGR;      /* Address offset: 0x14 */
+	SimReg CCMR1;    /* Address offset: 0x18 */
+	SimReg CCMR2;    /* Address offset: 0x1C */
+	SimReg CCER;     /* Address offset: 0x20 */
+	SimReg CNT;      /* Address offset: 0x24 */
+	SimReg PSC;      /* Address offset: 0x28 */
+	SimReg ARR;      /* Address offset: 0x2C */
+	SimReg RCR;      /* Address offset: 0x30, TIM1 only */
+	SimReg CCR1;     /* Address offset: 0x34 */
+	SimReg CCR2;     /* Address offset: 0x38 */
+	SimReg CCR3;     /* Address offset: 0x3C */
+	SimReg CCR4;     /* Address offset: 0x40 */
+	SimReg BDTR;     /* Address offset: 0x44, TIM1 only */
+	SimReg DCR;      /* Address offset: 0x48 */
+	SimReg DMAR;     /* Address offset: 0x4C */
+};
+
+struct ADC_type
+{
+	SimReg SR;       /* Address offset: 0x00 */
+	SimReg CR1;      /* Address offset: 0x04 */
+	SimReg CR2;      /* Address offset: 0x08 */
+	SimReg SMPR1;    /* Address offset: 0x0C */
+	SimReg SMPR2;    /* Address offset: 0x10 */
+	SimReg JOFR1;    /* Address offset: 0x14 */
+	SimReg JOFR2;    /* Address offset: 0x18 */
+	SimReg JOFR3;    /* Address offset: 0x1C */
+	SimReg JOFR4;    /* Address offset: 0x20 */
+	SimReg HTR;      /* Address offset: 0x24 */
+	SimReg LTR;      /* Address offset: 0x28 */
+	SimReg SQR1;     /* Address offset: 0x2C */
+	SimReg SQR2;     /* Address offset: 0x30 */
+	SimReg SQR3;     /* Address offset: 0x34 */
+	SimReg JSQR;     /* Address offset: 0x38 */
+	SimReg JDR1;     /* Address offset: 0x3C */
+	SimReg JDR2;     /* Address offset: 0x40 */
+	SimReg JDR3;     /* Address offset: 0x44 */
+	SimReg JDR4;     /* Address offset: 0x48 */
+	SimReg DR;       /* Address offset: 0x4C */
+};
+
+struct DMA_type
+{
+	SimReg ISR;      /* DMA interrupt status register,             Address offset: 0x00 */
+	SimReg IFCR;     /* DMA interrupt flag clear register,         Address offset: 0x04 */
+};
+
+struct DMA_Channel_type
+{
+	SimReg CCR;      /* DMA channel configuration register,        Address offset: 0x00 */
+	SimReg CNDTR;    /* DMA channel number of data register,       Address offset: 0x04 */
+	SimReg CPAR;     /* DMA channel peripheral address register,   Address offset: 0x08 */
+	SimReg CMAR;     /* DMA channel memory address register,       Address offset: 0x0C */
+	SimReg RESERVED; /* Reserved,                                  Address offset: 0x10 */
+};
+
+// DMA1 : status registers and channel 1-7 back to back as on the bus
+struct SIMDMA_type
+{
+	DMA_type dma;
+	DMA_Channel_type channel[7];
+};
+
+struct DWT_type
+{
+	SimReg CTRL;     /* DWT control register,                      Address offset: 0x00 */
+	SimReg CYCCNT;   /* DWT cycle count register,                  Address offset: 0x04 */
+};
+
+struct NVIC_type
+{
+	SimReg   ISER[8];     /* Address offset: 0x000 - 0x01C */
+	SimReg  RES0[24];     /* Address offset: 0x020 - 0x07C */
+	SimReg   ICER[8];     /* Address offset: 0x080 - 0x09C */
+	SimReg  RES1[24];     /* Address offset: 0x0A0 - 0x0FC */
+	SimReg   ISPR[8];     /* Address offset: 0x100 - 0x11C */
+	SimReg  RES2[24];     /* Address offset: 0x120 - 0x17C */
+	SimReg   ICPR[8];     /* Address offset: 0x180 - 0x19C */
+	SimReg  RES3[24];     /* Address offset: 0x1A0 - 0x1FC */
+	SimReg   IABR[8];     /* Address offset: 0x200 - 0x21C */
+	SimReg  RES4[56];     /* Address offset: 0x220 - 0x2FC */
+	SimReg   IPR[240];    /* Address offset: 0x300 - 0x3EC (bytes on hardware) */
+	SimReg       STIR;    /* Address offset:         0xF00 */
+};
+
+struct SCB_type
+{
+	SimReg CPUID;    /* Address offset: 0x00 */
+	SimReg ICSR;     /* Address offset: 0x04 */
+	SimReg VTOR;     /* Address offset: 0x08 */
+	SimReg AIRCR;    /* Address offset: 0x0C */
+	SimReg SCR;      /* Address offset: 0x10 */
+	SimReg CCR;      /* Address offset: 0x14 */
+	SimReg SHPR1;    /* Address offset: 0x18 */
+	SimReg SHPR2;    /* Address offset: 0x1C */
+	SimReg SHPR3;    /* Address offset: 0x20 */
+	SimReg SHCSR;    /* Address offset: 0x24 */
+};
+
+// Register blocks used by the firmware (sim.h maps the *_BASE macros to them)
+extern GPIO_type  simGPIOA, simGPIOB, simGPIOC, simGPIOD, simGPIOE;
+extern AFIO_type  simAFIO;
+extern RCC_type   simRCC;
+extern FLASH_type simFLASH;
+extern PWR_type   simPWR;
+extern BKP_type   simBKP;
+extern STK_type   simSYSTICK;
+extern TIM_type   simTIM1, simTIM2, simTIM3, simTIM4;
+extern ADC_type   simADC1, simADC2;
+extern SIMDMA_type simDMA1;
+extern DWT_type   simDWT;
+extern SimReg     simDEMCR;
+extern NVIC_type  simNVIC;
+extern SCB_type   simSCB;
+
+/*************************************************
+* Time base and CPU model (simcore.cpp)
+*************************************************/
+
+// Cycle cost of the firmware constructs the simulator can see (-O0 code)
+struct SIMCOST_type
+{
+	unsigned int access;    /* One peripheral register read or write               */
+	unsigned int nop;       /* One iteration of for (...) __asm__("nop")           */
+	unsigned int loop;      /* One while () condition check                        */
+	unsigned int irqEntry;  /* Exception entry (stacking + vector fetch)           */
+	unsigned int irqExit;   /* Exception return (unstacking)                       */
+};
+
+extern SIMCOST_type simCost;
+
+// Simulated time
+std::uint64_t simCycles(void);          // SYSCLK cycles since reset
+double simTimeNs(void);                 // Nanoseconds since reset
+std::uint32_t simSysclk(void);          // Current SYSCLK in Hz (from the RCC model)
+
+// CPU executed 'cycles' : peripherals advance, pending interrupts are taken
+void simRun(unsigned int cycles);
+
+// Peripheral models (all registered by the SimDevice constructor)
+std::vector<SimDevice *> &simDevices(void);
+void simSync(SimDevice *dev);           // Advance one model to the current cycle
+void simSyncAll(void);                  // All models, before a change of clocks
+unsigned int simPeek(SimReg &r);        // Register read without CPU cycles (bit-band bus access)
+
+// Interrupts : irq >= 0 external (NVIC), -1 SysTick
+void simIrqLine(int irq, bool level);   // Level of a peripheral interrupt request
+void simSetPending(int irq);
+void simClearPending(int irq);
+bool simIsPending(int irq);
+bool simIsActive(int irq);
+void simSetEnable(int irq, bool enable);
+bool simIsEnabled(int irq);
+void simSetPriority(int irq, unsigned int priority);
+unsigned int simGetPriority(int irq);
+
+// Analog input of ADC channel 0-17 in volts at the current time
+double simAnalogInput(unsigned int channel);
+
+// Logic level of a pin driven by a peripheral (alternate function), -1 if none
+int simAltFunctionOutput(unsigned int port, unsigned int pin);
+
+// Output pin wired to an input pin (--wire), port << 4 | pin, -1 if none
+int simWireSource(unsigned int port, unsigned int pin);
+
+// Stop the simulation with a message (firmware error the model detected)
+void simFatal(const char *fmt, ...);
+
+// "2s", "500ms", "20us", "100ns" -> nanoseconds, negative on error
+double simParseTimeNs(const char *text);
+
+/*************************************************
+* Peripheral models (simperiph.cpp)
+*************************************************/
+bool simHseEnabled(void);                   // --no-hse clears it
+void simSetHseEnabled(bool enable);
+
+// Clock of a bus as SYSCLK divider, from RCC->CFGR
+unsigned int simHclkDiv(void);
+unsigned int simApb1TimerDiv(void);
+unsigned int simApb2TimerDiv(void);
+unsigned int simAdcDiv(void);
+
+// Pin levels of a GPIO port changed (output data or alternate function)
+void simGpioUpdate(void);
+
+// Timer 2-4 event for the trigger inputs of other peripherals (ADC EXTSEL),
+// event 0 : TRGO, 1-4 : CCx compare match
+void simTimerEvent(unsigned int timer, unsigned int event);
+
+// DMA CPAR/CMAR value for a register or a buffer of the firmware (DMA_ADDRESS in sim.h),
+// host pointers do not fit in 32 bits
+std::uint32_t simDmaAddress(SimReg *reg);
+std::uint32_t simDmaAddress(const volatile void *memory);
+
+// Peripheral DMA request on DMA1 channel 1-7 (ADC1 EOC, timer events ...).
+// 'from' is the requesting model, it is in the middle of its advance().
+void simDmaRequest(unsigned int channel, SimDevice *from);
+
+/*************************************************
+* Trace recorder (simtrace.cpp)
+*************************************************/
+int simTraceSignal(const std::string &name);        // Id of a pin or interrupt signal
+void simTraceLevel(int signal, int level);          // Signal level at current time
+int simTraceFinish(void);                           // Reports, checks; exit status
+bool simTraceOption(int argc, char **argv, int &i); // Command line options of the recorder
+void simTraceUsage(void);
+
+#endif
@@ -0,0 +1,2148 @@
+/*
+ * File Name  : simperiph.cpp Ver 1.0
+ *
+ * Description:
+ *   Peripheral models of the host simulator
+ *
+ *      RCC     : HSI/HSE/PLL start-up, SYSCLK switch (SWS follows SW when the
+ *                source is ready), AHB/APB/ADC prescalers, clock enables
+ *      FLASH   : ACR (no effect on timing, see simCost)
+ *      PWR/BKP : DBP write protection of the backup data registers DR1-DR10
+ *      GPIO    : CRL/CRH, IDR, ODR, BSRR, BRR, pin level from ODR or from the
+ *                timer output when the pin is an alternate function output,
+ *                input pins wired to an output pin (--wire)
+ *      AFIO    : MAPR remap of TIM2/TIM3/TIM4 pins (TIM1 not remapped)
+ *      SysTick : HCLK or HCLK/8, reload, COUNTFLAG, TICKINT
+ *      TIM2-4  : PSC/ARR/CCRx with preload, up/down/center-aligned counting,
+ *                one pulse, UG, output compare modes 0-7, SR/DIER interrupts,
+ *                TRGO (MMS reset/update/compare pulse) and CCx events,
+ *                update/CCx DMA requests (UDE/CCxDE) and DMA burst through
+ *                DCR/DMAR, input capture of the channel pins (CCxS TI1-TI4,
+ *                CCxP edge, ICxPSC, CCxIF/CCxOF, reading CCRx clears CCxIF)
+ *      TIM1    : as TIM2-4 on APB2, repetition counter (RCR), complementary
+ *                outputs CH1N-CH3N with dead-time (BDTR DTG, CKD), MOE with
+ *                OSSR/OSSI idle levels (CR2 OISx), break from BKIN (PB12,
+ *                BKE/BKP) or EGR BG, AOE, BRK/UP/TRG_COM/CC interrupt lines
+ *      ADC1    : power on, calibration (code in DR at the end), SWSTART/ADON start, single/continuous,
+ *                scan of the regular sequence, sample times, EOC interrupt,
+ *                external trigger TIM2 CC2 / TIM3 TRGO / TIM4 CC4 (EXTSEL),
+ *                analog watchdog (LTR/HTR, AWDSGL, AWD interrupt),
+ *                injected group (JSQR, JOFRx, JDRx, JEOC interrupt, JSWSTART
+ *                or TIM2 TRGO/CC1, TIM3 CC4, TIM4 TRGO, preempts the regular
+ *                conversion),
+ *                DMA request on DMA1 channel 1
+ *      ADC2    : as ADC1 (no DMA request), dual modes with ADC1 as master :
+ *                regular simultaneous and fast interleaved, ADC2 result in
+ *                ADC1->DR[31:16], shared ADC1_2 interrupt
+ *      DMA1    : channels 1-7, CNDTR/CPAR/CMAR, 8/16/32 bit items, increment,
+ *                circular, HT/TC flags and interrupts (peripheral requests only :
+ *                ADC1, TIM1-4)
+ *      DWT     : CYCCNT in SYSCLK cycles, DEMCR TRCENA
+ *      NVIC    : ISER/ICER/ISPR/ICPR/IABR/IPR/STIR on top of simcore.cpp
+ *
+ *   Models see time in SYSCLK cycles (advance) and convert it with the bus
+ *   prescalers of RCC->CFGR, so a wrong clock setup shows up as wrong timing.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "simcore.h"
+
+#include <cmath>
+
+#define HSE_HZ          8000000     // Blue Pill crystal
+#define HSI_HZ          8000000
+#define HSE_STARTUP_NS  1000000.0   // Crystal start-up, typical 1 ms (datasheet max 2 ms)
+#define PLL_LOCK_NS     200000.0    // PLL lock time, datasheet max 200 us
+
+GPIO_type  simGPIOA, simGPIOB, simGPIOC, simGPIOD, simGPIOE;
+AFIO_type  simAFIO;
+RCC_type   simRCC;
+FLASH_type simFLASH;
+PWR_type   simPWR;
+BKP_type   simBKP;
+STK_type   simSYSTICK;
+TIM_type   simTIM1, simTIM2, simTIM3, simTIM4;
+ADC_type   simADC1, simADC2;
+SIMDMA_type simDMA1;
+DWT_type   simDWT;
+SimReg     simDEMCR;
+NVIC_type  simNVIC;
+SCB_type   simSCB;
+
+static bool hseEnabled = true;
+
+// SYSCLK cycles of 'clocks' ticks of a clock SYSCLK/div, 'acc' cycles already counted
+static std::uint64_t cyclesFor(std::uint64_t clocks, std::uint64_t div, std::uint64_t acc)
+{
+	std::uint64_t cycles = clocks * div;
+	return (cycles > acc) ? cycles - acc : 1;
+}
+
+/*************************************************
+* RCC
+*************************************************/
+class RccModel : public SimDevice
+{
+public:
+	RccModel() : SimDevice("RCC", 0x40021000)
+	{
+		attach(&simRCC.CR, sizeof(RCC_type) / sizeof(SimReg));
+	}
+
+	void reset() override
+	{
+		simRCC.CR.value = 0x00000083;       // HSION, HSIRDY
+		simRCC.CFGR.value = 0;
+		simRCC.CIR.value = 0;
+		simRCC.AHBENR.value = 0x00000014;   // SRAM, FLITF
+		simRCC.APB2ENR.value = 0;
+		simRCC.APB1ENR.value = 0;
+		simRCC.CSR.value = 0x0C000000;
+		hseOnAt = pllOnAt = -1;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &simRCC.CR) {
+			unsigned int old = r.value;
+			// Ready flags are read only
+			r.value = (v & ~((1u << 1) | (1u << 17) | (1u << 25))) | (old & ((1u << 1) | (1u << 17) | (1u << 25)));
+			if ((v & (1u << 16)) && !(old & (1u << 16)))
+				hseOnAt = simTimeNs();
+			if (!(v & (1u << 16))) {
+				hseOnAt = -1;
+				r.value &= ~(1u << 17);
+			}
+			if ((v & (1u << 24)) && !(old & (1u << 24)))
+				pllOnAt = simTimeNs();
+			if (!(v & (1u << 24))) {
+				pllOnAt = -1;
+				r.value &= ~(1u << 25);
+			}
+		} else if (&r == &simRCC.CFGR) {
+			// Bus clocks change : every model counts the old clocks up to now
+			simSyncAll();
+
+			// PLL configuration is locked while the PLL runs, SWS is read only
+			unsigned int pllBits = (1u << 16) | (1u << 17) | (0xFu << 18);
+			unsigned int keep = 0xCu;
+			if (simRCC.CR.value & (1u << 24)) {
+				if ((v ^ r.value) & pllBits)
+					std::fprintf(stderr, "sim: %.3f ms: RCC->CFGR PLL bits written while PLL is on (ignored)\n",
+					             simTimeNs() * 1e-6);
+				keep |= pllBits;
+			}
+			r.value = (v & ~keep) | (r.value & keep);
+			updateSwitch();
+		} else {
+			r.value = v;
+		}
+	}
+
+	void advance(std::uint64_t cycles) override
+	{
+		(void) cycles;
+		unsigned int cr = simRCC.CR.value;
+
+		if (hseOnAt >= 0 && hseEnabled && !(cr & (1u << 17)) && simTimeNs() - hseOnAt >= HSE_STARTUP_NS)
+			cr |= (1u << 17);
+		if (pllOnAt >= 0 && !(cr & (1u << 25)) && simTimeNs() - pllOnAt >= PLL_LOCK_NS && pllSourceReady(cr))
+			cr |= (1u << 25);
+		simRCC.CR.value = cr;
+		updateSwitch();
+	}
+
+	// Until HSE ready / PLL lock
+	std::uint64_t horizon() override
+	{
+		unsigned int cr = simRCC.CR.value;
+		double wait = -1;
+
+		if (hseOnAt >= 0 && hseEnabled && !(cr & (1u << 17)))
+			wait = hseOnAt + HSE_STARTUP_NS - simTimeNs();
+		else if (pllOnAt >= 0 && !(cr & (1u << 25)) && pllSourceReady(cr))
+			wait = pllOnAt + PLL_LOCK_NS - simTimeNs();
+		if (wait < 0)
+			return SIM_NEVER;
+		return (std::uint64_t) (wait * simSysclk() * 1e-9) + 1;
+	}
+
+	// SWS follows SW as soon as the selected source is ready
+	void updateSwitch(void)
+	{
+		unsigned int cfgr = simRCC.CFGR.value;
+		unsigned int cr = simRCC.CR.value;
+		unsigned int sw = cfgr & 0x3;
+		bool ready = (sw == 0 && (cr & (1u << 1))) ||
+		             (sw == 1 && (cr & (1u << 17))) ||
+		             (sw == 2 && (cr & (1u << 25)));
+
+		if (ready && ((cfgr >> 2) & 0x3) != sw)
+			simRCC.CFGR.value = (cfgr & ~0xCu) | (sw << 2);
+	}
+
+	bool pllSourceReady(unsigned int cr) const
+	{
+		return (simRCC.CFGR.value & (1u << 16)) ? (cr & (1u << 17)) : (cr & (1u << 1));
+	}
+
+private:
+	double hseOnAt;
+	double pllOnAt;
+};
+
+static RccModel rccModel;
+
+std::uint32_t simSysclk(void)
+{
+	unsigned int cfgr = simRCC.CFGR.value;
+	unsigned int input;
+	unsigned int mul;
+
+	switch ((cfgr >> 2) & 0x3) {
+	case 1:
+		return HSE_HZ;
+	case 2:
+		if (cfgr & (1u << 16))
+			input = (cfgr & (1u << 17)) ? HSE_HZ / 2 : HSE_HZ;
+		else
+			input = HSI_HZ / 2;
+		mul = ((cfgr >> 18) & 0xF) + 2;
+		if (mul > 16)
+			mul = 16;
+		return input * mul;
+	default:
+		return HSI_HZ;
+	}
+}
+
+bool simHseEnabled(void)
+{
+	return hseEnabled;
+}
+
+void simSetHseEnabled(bool enable)
+{
+	hseEnabled = enable;
+}
+
+unsigned int simHclkDiv(void)
+{
+	static const unsigned int ahb[16] = {1, 1, 1, 1, 1, 1, 1, 1, 2, 4, 8, 16, 64, 128, 256, 512};
+	return ahb[(simRCC.CFGR.value >> 4) & 0xF];
+}
+
+static unsigned int apbDiv(unsigned int ppre)
+{
+	static const unsigned int apb[8] = {1, 1, 1, 1, 2, 4, 8, 16};
+	return apb[ppre & 0x7];
+}
+
+// Timer clock is doubled when the APB prescaler is not 1
+unsigned int simApb1TimerDiv(void)
+{
+	unsigned int div = apbDiv(simRCC.CFGR.value >> 8);
+	return simHclkDiv() * (div == 1 ? 1 : div / 2);
+}
+
+unsigned int simApb2TimerDiv(void)
+{
+	unsigned int div = apbDiv(simRCC.CFGR.value >> 11);
+	return simHclkDiv() * (div == 1 ? 1 : div / 2);
+}
+
+unsigned int simAdcDiv(void)
+{
+	return simHclkDiv() * apbDiv(simRCC.CFGR.value >> 11) * ((((simRCC.CFGR.value >> 14) & 0x3) + 1) * 2);
+}
+
+/*************************************************
+* FLASH
+*************************************************/
+class FlashModel : public SimDevice
+{
+public:
+	FlashModel() : SimDevice("FLASH", 0x40022000)
+	{
+		attach(&simFLASH.ACR, sizeof(FLASH_type) / sizeof(SimReg));
+	}
+
+	void reset() override
+	{
+		simFLASH.ACR.value = 0x00000030;    // Prefetch enabled, zero wait states
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &simFLASH.ACR)
+			r.value = (v & 0x1F) | ((v & (1u << 4)) << 1);  // PRFTBS follows PRFTBE
+		else
+			r.value = v;
+	}
+};
+
+static FlashModel flashModel;
+
+/*************************************************
+* PWR and BKP
+*************************************************/
+class PwrModel : public SimDevice
+{
+public:
+	PwrModel() : SimDevice("PWR", 0x40007000)
+	{
+		attach(&simPWR.CR, sizeof(PWR_type) / sizeof(SimReg));
+		enableReg = &simRCC.APB1ENR;
+		enableBit = 28;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &simPWR.CR)
+			r.value = v & 0x1FF;
+	}
+};
+
+static PwrModel pwrModel;
+
+// Backup domain : starts empty (VBAT not held), DR1-DR10 only written with PWR->CR DBP
+class BkpModel : public SimDevice
+{
+public:
+	BkpModel() : SimDevice("BKP", 0x40006C00)
+	{
+		attach(&simBKP.RESERVED0, sizeof(BKP_type) / sizeof(SimReg));
+		enableReg = &simRCC.APB1ENR;
+		enableBit = 27;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (!(simPWR.CR.value & (1u << 8)))
+			return;
+		if (&r >= &simBKP.DR[0] && &r <= &simBKP.DR[9])
+			r.value = v & 0xFFFF;
+		else if (&r != &simBKP.RESERVED0)
+			r.value = v;
+	}
+};
+
+static BkpModel bkpModel;
+
+/*************************************************
+* AFIO
+*************************************************/
+class AfioModel : public SimDevice
+{
+public:
+	AfioModel() : SimDevice("AFIO", 0x40010000)
+	{
+		attach(&simAFIO.EVCR, sizeof(AFIO_type) / sizeof(SimReg));
+		enableReg = &simRCC.APB2ENR;
+		enableBit = 0;
+	}
+
+	void reset() override
+	{
+		simAFIO.MAPR.value = 0;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		r.value = v;
+		simGpioUpdate();
+	}
+};
+
+static AfioModel afioModel;
+
+static int wiredLevel(unsigned int key);
+static void timInputs(void);
+
+/*************************************************
+* GPIO
+*************************************************/
+class GpioModel : public SimDevice
+{
+public:
+	GpioModel(const char *deviceName, std::uint32_t baseAddress, GPIO_type &block, unsigned int portNumber)
+		: SimDevice(deviceName, baseAddress), regs(block), port(portNumber)
+	{
+		attach(&regs.CRL, sizeof(GPIO_type) / sizeof(SimReg));
+		enableReg = &simRCC.APB2ENR;
+		enableBit = 2 + port;
+	}
+
+	void reset() override
+	{
+		unsigned int pin;
+
+		regs.CRL.value = 0x44444444;            // Floating inputs
+		regs.CRH.value = 0x44444444;
+		regs.IDR.value = 0;
+		regs.ODR.value = 0;
+		for (pin = 0; pin < 16; ++pin) {
+			level[pin] = -1;
+			signal[pin] = -1;
+		}
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		if (&r == &regs.IDR) {
+			simSyncAll();                       // Alternate function outputs up to date
+			return inputData();
+		}
+		if (&r == &regs.BSRR || &r == &regs.BRR)
+			return 0;
+		return r.value;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &regs.BSRR)
+			regs.ODR.value = (regs.ODR.value | (v & 0xFFFF)) & ~((v >> 16) & ~v & 0xFFFF);
+		else if (&r == &regs.BRR)
+			regs.ODR.value &= ~(v & 0xFFFF);
+		else if (&r == &regs.ODR)
+			r.value = v & 0xFFFF;
+		else if (&r != &regs.IDR)
+			r.value = v;
+		update();
+		timInputs();
+	}
+
+	// Mode/CNF nibble of a pin
+	unsigned int config(unsigned int pin) const
+	{
+		return ((pin < 8 ? regs.CRL.value : regs.CRH.value) >> ((pin & 7) * 4)) & 0xF;
+	}
+
+	// Pin level : output data, alternate function output, or pull-up/down input
+	int pinLevel(unsigned int pin) const
+	{
+		unsigned int cfg = config(pin);
+
+		if (!clocked())
+			return -1;
+		if (cfg & 0x3) {
+			if (cfg & 0x8) {
+				int af = simAltFunctionOutput(port, pin);
+				return af < 0 ? 0 : af;
+			}
+			return (regs.ODR.value >> pin) & 1;
+		}
+		if (simWireSource(port, pin) >= 0)      // Input driven by a wire
+			return wiredLevel(simWireSource(port, pin));
+		if ((cfg >> 2) == 2)                    // Input pull-up/pull-down : ODR selects
+			return (regs.ODR.value >> pin) & 1;
+		return -1;
+	}
+
+	// Level of an output pin, -1 for an input
+	int outputLevel(unsigned int pin) const
+	{
+		return (config(pin) & 0x3) ? pinLevel(pin) : -1;
+	}
+
+	unsigned int inputData(void) const
+	{
+		unsigned int pin;
+		unsigned int idr = 0;
+
+		for (pin = 0; pin < 16; ++pin)
+			if (pinLevel(pin) > 0)
+				idr |= (1u << pin);
+		return idr;
+	}
+
+	// Outputs only are traced, signal name PC13, PB1 ...
+	void update(void)
+	{
+		unsigned int pin;
+
+		for (pin = 0; pin < 16; ++pin) {
+			int l = (config(pin) & 0x3) ? pinLevel(pin) : -1;
+			if (l == level[pin])
+				continue;
+			level[pin] = l;
+			if (l < 0)
+				continue;
+			if (signal[pin] < 0)
+				signal[pin] = simTraceSignal(std::string("P") + char('A' + port) + std::to_string(pin));
+			simTraceLevel(signal[pin], l);
+		}
+	}
+
+private:
+	GPIO_type &regs;
+	unsigned int port;
+	int level[16];
+	int signal[16];
+};
+
+static GpioModel gpioA("GPIOA", 0x40010800, simGPIOA, 0);
+static GpioModel gpioB("GPIOB", 0x40010C00, simGPIOB, 1);
+static GpioModel gpioC("GPIOC", 0x40011000, simGPIOC, 2);
+static GpioModel gpioD("GPIOD", 0x40011400, simGPIOD, 3);
+static GpioModel gpioE("GPIOE", 0x40011800, simGPIOE, 4);
+
+static GpioModel *const gpioPorts[5] = {&gpioA, &gpioB, &gpioC, &gpioD, &gpioE};
+
+// Level of pin port << 4 | pin
+static int portPinLevel(unsigned int key)
+{
+	return gpioPorts[(key >> 4) % 5]->pinLevel(key & 0xF);
+}
+
+// Input end of a wire : level of the output pin at the other end
+static int wiredLevel(unsigned int key)
+{
+	return gpioPorts[(key >> 4) % 5]->outputLevel(key & 0xF);
+}
+
+void simGpioUpdate(void)
+{
+	gpioA.update();
+	gpioB.update();
+	gpioC.update();
+	gpioD.update();
+	gpioE.update();
+	timInputs();
+}
+
+/*************************************************
+* SysTick
+*************************************************/
+class SysTickModel : public SimDevice
+{
+public:
+	SysTickModel() : SimDevice("SysTick", 0xE000E010)
+	{
+		attach(&simSYSTICK.CSR, sizeof(STK_type) / sizeof(SimReg));
+	}
+
+	void reset() override
+	{
+		simSYSTICK.CSR.value = 0;
+		simSYSTICK.RVR.value = 0;
+		simSYSTICK.CVR.value = 0;
+		simSYSTICK.CALIB.value = 9000;      // 1 ms at HCLK/8 = 9 MHz
+		acc = 0;
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		unsigned int v = r.value;
+
+		if (&r == &simSYSTICK.CSR)
+			r.value &= ~(1u << 16);         // COUNTFLAG clears on read
+		return v;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &simSYSTICK.CSR) {
+			r.value = (r.value & (1u << 16)) | (v & 0x7);
+		} else if (&r == &simSYSTICK.RVR) {
+			r.value = v & 0x00FFFFFF;
+		} else if (&r == &simSYSTICK.CVR) {
+			r.value = 0;                    // Any write clears counter and COUNTFLAG
+			simSYSTICK.CSR.value &= ~(1u << 16);
+		}
+	}
+
+	void advance(std::uint64_t cycles) override
+	{
+		unsigned int csr = simSYSTICK.CSR.value;
+		unsigned int div;
+		std::uint64_t ticks;
+
+		if (!(csr & 1))
+			return;
+
+		// CLKSOURCE 1 : HCLK, 0 : HCLK/8
+		div = simHclkDiv() * ((csr & (1u << 2)) ? 1 : 8);
+		acc += cycles;
+		ticks = acc / div;
+		acc %= div;
+
+		while (ticks > 0) {
+			unsigned int cvr = simSYSTICK.CVR.value;
+			std::uint64_t step;
+
+			if (cvr == 0) {
+				// Reload on the tick after reaching 0, RVR 0 stops the counter
+				if (simSYSTICK.RVR.value == 0)
+					return;
+				simSYSTICK.CVR.value = simSYSTICK.RVR.value;
+				ticks--;
+				continue;
+			}
+			step = (ticks < cvr) ? ticks : cvr;
+			simSYSTICK.CVR.value = cvr - step;
+			ticks -= step;
+			if (simSYSTICK.CVR.value == 0) {
+				simSYSTICK.CSR.value |= (1u << 16);
+				if (simSYSTICK.CSR.value & (1u << 1))
+					simSetPending(-1);
+			}
+		}
+	}
+
+	// Until the counter reaches 0 (SysTick exception)
+	std::uint64_t horizon() override
+	{
+		unsigned int csr = simSYSTICK.CSR.value;
+		unsigned int cvr = simSYSTICK.CVR.value;
+		std::uint64_t ticks;
+
+		if (!(csr & 1) || !(csr & (1u << 1)))
+			return SIM_NEVER;
+		if (cvr)
+			ticks = cvr;
+		else if (simSYSTICK.RVR.value)
+			ticks = simSYSTICK.RVR.value + 1;
+		else
+			return SIM_NEVER;
+		return cyclesFor(ticks, simHclkDiv() * ((csr & (1u << 2)) ? 1 : 8), acc);
+	}
+
+private:
+	std::uint64_t acc;
+};
+
+static SysTickModel sysTickModel;
+
+/*************************************************
+* General purpose timers TIM2, TIM3, TIM4 and advanced timer TIM1
+*************************************************/
+// Pins of the channels (port << 4 | pin) by AFIO->MAPR remap
+static const unsigned char tim1Pins[4] = {0x08, 0x09, 0x0A, 0x0B};
+static const unsigned char tim1NPins[3] = {0x1D, 0x1E, 0x1F};
+static const unsigned char tim2Pins[4][4] = {
+	{0x00, 0x01, 0x02, 0x03}, {0x0F, 0x13, 0x02, 0x03},
+	{0x00, 0x01, 0x1A, 0x1B}, {0x0F, 0x13, 0x1A, 0x1B},
+};
+static const unsigned char tim3Pins[4][4] = {
+	{0x06, 0x07, 0x10, 0x11}, {0x06, 0x07, 0x10, 0x11},
+	{0x14, 0x15, 0x10, 0x11}, {0x26, 0x27, 0x28, 0x29},
+};
+static const unsigned char tim4Pins[2][4] = {
+	{0x16, 0x17, 0x18, 0x19}, {0x3C, 0x3D, 0x3E, 0x3F},
+};
+
+/*
+ * Funtion Name		: timChannelPin
+ * Description 		: Pin of a timer channel, AFIO->MAPR remap included
+ *					  TIM1 CH1-4 PA8 PA9 PA10 PA11, CH1N-3N PB13 PB14 PB15
+ *					                               (no remap only)
+ *					  TIM2 CH1-4 PA0 PA1 PA2 PA3   (remap PA15 PB3 PB10 PB11)
+ *					  TIM3 CH1-4 PA6 PA7 PB0 PB1   (partial PB4 PB5, full PC6-PC9)
+ *					  TIM4 CH1-4 PB6 PB7 PB8 PB9   (remap PD12-PD15)
+ * Input			: timer 1-4, ch 0-3
+ * Return Value		: port << 4 | pin, 0xFF : TIM1 remapped (not modelled)
+*/
+static unsigned int timChannelPin(unsigned int timer, unsigned int ch)
+{
+	unsigned int mapr = simAFIO.MAPR.value;
+
+	switch (timer) {
+	case 1:
+		return (((mapr >> 6) & 0x3) == 0) ? tim1Pins[ch] : 0xFF;
+	case 2:
+		return tim2Pins[(mapr >> 8) & 0x3][ch];
+	case 3:
+		return tim3Pins[(mapr >> 10) & 0x3][ch];
+	default:
+		return tim4Pins[(mapr >> 12) & 0x1][ch];
+	}
+}
+
+class TimModel : public SimDevice
+{
+public:
+	// dmaChannels : DMA1 channel of the update and CC1-CC4 requests, 0 : none
+	TimModel(const char *deviceName, std::uint32_t baseAddress, TIM_type &block, unsigned int apb1Bit, int irqNumber,
+	         const unsigned char *dmaChannels)
+		: SimDevice(deviceName, baseAddress), regs(block), irq(irqNumber), number(apb1Bit + 2), dma(dmaChannels),
+		  advanced(false)
+	{
+		attach(&regs.CR1, sizeof(TIM_type) / sizeof(SimReg));
+		enableReg = &simRCC.APB1ENR;
+		enableBit = apb1Bit;
+	}
+
+	// TIM1 on APB2 : interrupt lines BRK, UP, TRG_COM, CC from breakIrq on
+	TimModel(const char *deviceName, std::uint32_t baseAddress, TIM_type &block, int breakIrq,
+	         const unsigned char *dmaChannels)
+		: SimDevice(deviceName, baseAddress), regs(block), irq(breakIrq + 1), number(1), dma(dmaChannels),
+		  advanced(true)
+	{
+		attach(&regs.CR1, sizeof(TIM_type) / sizeof(SimReg));
+		enableReg = &simRCC.APB2ENR;
+		enableBit = 11;
+	}
+
+	void reset() override
+	{
+		unsigned int ch;
+		SimReg *r;
+
+		for (r = &regs.CR1; r <= &regs.DMAR; ++r)
+			r->value = 0;
+		regs.ARR.value = 0xFFFF;
+		arr = 0xFFFF;
+		psc = 0;
+		pscCount = 0;
+		acc = 0;
+		down = false;
+		burst = 0;
+		burstAccesses = 0;
+		rep = 0;
+		clock = 0;
+		breakLevel = false;
+		for (ch = 0; ch < 4; ++ch) {
+			ccr[ch] = 0;
+			ref[ch] = 0;
+			refChange[ch] = 0;
+			tiLevel[ch] = -1;
+			icCount[ch] = 0;
+		}
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		if (&r == &regs.EGR)
+			return 0;
+		if (&r == &regs.DMAR) {
+			SimReg *target = burstTarget();
+			return (target != nullptr) ? read(*target) : 0;
+		}
+		if (&r >= &regs.CCR1 && &r <= &regs.CCR4 && !outputChannel(&r - &regs.CCR1)) {
+			regs.SR.value &= ~(1u << (&r - &regs.CCR1 + 1));   // Reading a capture clears CCxIF
+			irqLines();
+		}
+		return r.value;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &regs.DMAR) {
+			SimReg *target = burstTarget();
+			if (target != nullptr)
+				write(*target, v);
+			return;
+		}
+		if (&r == &regs.SR) {
+			r.value &= v;                       // rc_w0
+		} else if (&r == &regs.EGR) {
+			if (v & 1)
+				updateEvent(true);
+			regs.SR.value |= v & 0x1E;          // CCxG
+			if (advanced && (v & (1u << 7)))    // BG
+				breakEvent();
+		} else if (&r == &regs.BDTR) {
+			// MOE stays cleared while the break input is active
+			r.value = v & (breakActive() ? 0x7FFF : 0xFFFF);
+		} else if (&r == &regs.RCR) {
+			r.value = v & 0xFF;                 // Loaded at the next update event
+		} else if (&r == &regs.CR1) {
+			// DIR is read only in center-aligned mode
+			if (r.value & (0x3u << 5))
+				v = (v & ~(1u << 4)) | (r.value & (1u << 4));
+			r.value = v & 0x3FF;
+			if (((v >> 5) & 0x3) == 0)
+				down = (v >> 4) & 1;
+		} else if (&r == &regs.CNT) {
+			r.value = v & 0xFFFF;
+		} else if (&r == &regs.DCR) {
+			r.value = v & 0x1F1F;
+			burst = 0;
+		} else if (&r == &regs.PSC) {
+			r.value = v & 0xFFFF;               // Loaded at the next update event
+		} else if (&r == &regs.ARR) {
+			r.value = v & 0xFFFF;
+			if (!(regs.CR1.value & (1u << 7)))  // ARPE
+				arr = r.value;
+		} else if (&r >= &regs.CCR1 && &r <= &regs.CCR4) {
+			unsigned int ch = &r - &regs.CCR1;
+			if (!outputChannel(ch))
+				return;                         // Read only in input capture
+			r.value = v & 0xFFFF;
+			if (!preload(ch))
+				ccr[ch] = r.value;
+		} else if (&r == &regs.CCER) {
+			for (unsigned int ch = 0; ch < 4; ++ch)
+				if (!((v >> (ch * 4)) & 1))
+					icCount[ch] = 0;            // Capture prescaler reset while disabled
+			r.value = v;
+		} else {
+			r.value = v;
+		}
+		compare(false);
+		outputs();
+		irqLines();
+		inputs();                               // Input channel set up : pin levels latched
+	}
+
+	void advance(std::uint64_t cycles) override
+	{
+		std::uint64_t ticks;
+		unsigned int div;
+
+		if (!clocked() || !(regs.CR1.value & 1))
+			return;
+
+		advancing = true;
+		div = timerDiv();
+		acc += cycles;
+		ticks = acc / div;
+		acc %= div;
+
+		// Prescaler counts timer clocks, counter counts prescaler overflows
+		while (ticks > 0 && (regs.CR1.value & 1)) {
+			std::uint64_t needed = psc + 1 - pscCount;
+			std::uint64_t steps;
+
+			if (ticks < needed) {
+				pscCount += ticks;
+				clock += ticks;
+				break;
+			}
+			ticks -= needed;
+			clock += needed;
+			pscCount = 0;
+			steps = 1 + counterSteps(ticks / (psc + 1));
+			ticks -= (steps - 1) * (psc + 1);
+		}
+		if (advanced)
+			outputs();                          // Dead-time over
+		irqLines();
+		advancing = false;
+	}
+
+	// Until the next compare match, update event or end of a dead-time
+	std::uint64_t horizon() override
+	{
+		std::uint64_t clocks, dead;
+
+		if (!clocked() || !(regs.CR1.value & 1))
+			return SIM_NEVER;
+		clocks = stepsToEvent() * (psc + 1) - pscCount;
+		dead = deadTimeLeft();
+		if (dead > 0 && dead < clocks)
+			clocks = dead;
+		return cyclesFor(clocks, timerDiv(), acc);
+	}
+
+	// Output of channel 0-3 at the pin : OCxREF ^ CCxP when CCxE is set, -1 when disabled
+	int output(unsigned int ch) const
+	{
+		unsigned int ccer = regs.CCER.value >> (ch * 4);
+
+		if (!outputChannel(ch))
+			return -1;                          // Input capture channel
+		if (advanced)
+			return advancedOutput(ch, false);
+		if (!clocked() || !(ccer & 1))
+			return -1;
+		return ref[ch] ^ ((ccer >> 1) & 1);
+	}
+
+	// Complementary output OCxN of channel 0-2 (TIM1), -1 when disabled
+	int outputN(unsigned int ch) const
+	{
+		return (advanced && ch < 3 && outputChannel(ch)) ? advancedOutput(ch, true) : -1;
+	}
+
+	/*
+	 * Funtion Name		: inputs
+	 * Description 		: Pin levels may have changed : capture on the edges
+	 *					  of TI1-TI4 the input channels select (CCxS, CCxP,
+	 *					  ICxPSC), break when BKIN (TIM1, PB12) became active
+	 * Input			: None
+	 * Return Value		: None
+	*/
+	void inputs(void)
+	{
+		unsigned int used = 0;
+		unsigned int ch, ti;
+		bool active;
+
+		if (!clocked()) {
+			for (ti = 0; ti < 4; ++ti)
+				tiLevel[ti] = -1;
+			return;
+		}
+		if (advanced) {
+			active = breakActive();
+			if (active && !breakLevel) {
+				breakLevel = true;
+				sync();
+				breakEvent();
+			}
+			breakLevel = active;
+		}
+
+		for (ch = 0; ch < 4; ++ch)
+			if (inputSource(ch) >= 0)
+				used |= 1u << inputSource(ch);
+		for (ti = 0; ti < 4; ++ti) {
+			unsigned int key = timChannelPin(number, ti);
+			int level = ((used >> ti) & 1) && key != 0xFF ? portPinLevel(key) : -1;
+			int previous = tiLevel[ti];
+
+			if (level == previous)
+				continue;
+			tiLevel[ti] = level;
+			if (previous < 0 || level < 0)
+				continue;
+			sync();
+			for (ch = 0; ch < 4; ++ch)
+				if (inputSource(ch) == (int) ti && ((regs.CCER.value >> (ch * 4 + 1)) & 1) == (unsigned int) !level)
+					capture(ch);
+		}
+	}
+
+private:
+	// Up to the current cycle, unless called from the own advance (outputs -> pins -> inputs)
+	void sync(void)
+	{
+		if (!advancing)
+			simSync(this);
+	}
+
+	// TI1-TI4 of an input channel (CCxS 01 : own, 10 : the other of the pair), -1 : output or TRC
+	int inputSource(unsigned int ch) const
+	{
+		unsigned int ccmr = (ch < 2) ? regs.CCMR1.value : regs.CCMR2.value;
+		unsigned int ccs = (ccmr >> ((ch & 1) * 8)) & 0x3;
+
+		if (ccs == 1)
+			return ch;
+		if (ccs == 2)
+			return ch ^ 1;
+		return -1;
+	}
+
+	/*
+	 * Funtion Name		: capture
+	 * Description 		: Edge on the input of a channel : every 2^ICxPSC
+	 *					  edges CNT into CCRx, CCxIF (CCxOF when CCxIF was
+	 *					  still set), DMA request with CCxDE
+	 * Input			: ch 0-3
+	 * Return Value		: None
+	*/
+	void capture(unsigned int ch)
+	{
+		unsigned int ccmr = (ch < 2) ? regs.CCMR1.value : regs.CCMR2.value;
+		unsigned int prescaler = (ccmr >> ((ch & 1) * 8 + 2)) & 0x3;
+
+		if (!((regs.CCER.value >> (ch * 4)) & 1))   // CCxE
+			return;
+		if (++icCount[ch] < (1u << prescaler))
+			return;
+		icCount[ch] = 0;
+		if (regs.SR.value & (1u << (ch + 1)))
+			regs.SR.value |= (1u << (ch + 9));     // CCxOF
+		(&regs.CCR1)[ch].value = regs.CNT.value;
+		regs.SR.value |= (1u << (ch + 1));
+		if (regs.DIER.value & (1u << (ch + 9)))    // CCxDE
+			dmaRequest(ch + 1);
+		irqLines();
+	}
+
+	unsigned int timerDiv(void) const
+	{
+		return advanced ? simApb2TimerDiv() : simApb1TimerDiv();
+	}
+
+	// TIM1 has one interrupt line per event group, TIM2-4 one for all
+	void irqLines(void)
+	{
+		unsigned int pending = regs.SR.value & regs.DIER.value;
+
+		if (!advanced) {
+			simIrqLine(irq, pending & 0x5F);
+			return;
+		}
+		simIrqLine(irq - 1, pending & 0x80);    // BRK : BIF
+		simIrqLine(irq, pending & 0x01);        // UP
+		simIrqLine(irq + 1, pending & 0x60);    // TRG_COM : TIF, COMIF
+		simIrqLine(irq + 2, pending & 0x1E);    // CC : CC1IF-CC4IF
+	}
+
+	bool breakActive(void) const
+	{
+		unsigned int bdtr = regs.BDTR.value;
+		int level = portPinLevel(0x1C);     // PB12
+
+		return advanced && (bdtr & (1u << 12)) && level >= 0 && (unsigned int) level == ((bdtr >> 13) & 1);
+	}
+
+	// Break : MOE cleared at once, outputs to the off state, BIF
+	void breakEvent(void)
+	{
+		regs.BDTR.value &= ~(1u << 15);
+		regs.SR.value |= (1u << 7);
+		outputs();
+		irqLines();
+	}
+
+	// Timer clocks of the dead-time (BDTR DTG, tDTS from CR1 CKD)
+	unsigned int deadTime(void) const
+	{
+		unsigned int dtg = regs.BDTR.value & 0xFF;
+		unsigned int dts = 1u << ((regs.CR1.value >> 8) & 0x3);
+
+		if (!(dtg & 0x80))
+			return dtg * dts;
+		if (!(dtg & 0x40))
+			return (64 + (dtg & 0x3F)) * 2 * dts;
+		if (!(dtg & 0x20))
+			return (32 + (dtg & 0x1F)) * 8 * dts;
+		return (32 + (dtg & 0x1F)) * 16 * dts;
+	}
+
+	// Timer clocks until the first running dead-time ends, 0 : none
+	std::uint64_t deadTimeLeft(void) const
+	{
+		std::uint64_t left = 0;
+		unsigned int ch;
+
+		if (!advanced)
+			return 0;
+		for (ch = 0; ch < 3; ++ch) {
+			std::uint64_t end = refChange[ch] + deadTime();
+			if (((regs.CCER.value >> (ch * 4)) & 0x5) == 0x5 && end > clock && (left == 0 || end - clock < left))
+				left = end - clock;
+		}
+		return left;
+	}
+
+	/*
+	 * Funtion Name		: advancedOutput
+	 * Description 		: TIM1 OCx / OCxN pin level. MOE set : OCxREF and its
+	 *					  complement, the rising edge of each delayed by the
+	 *					  dead-time when both are enabled, a disabled one at
+	 *					  its inactive level with OSSR. MOE cleared : idle
+	 *					  levels OISx / OISxN with OSSI, else disabled.
+	 * Input			: ch 0-3, complementary : OCxN
+	 * Return Value		: level, -1 when disabled
+	*/
+	int advancedOutput(unsigned int ch, bool complementary) const
+	{
+		unsigned int ccer = (regs.CCER.value >> (ch * 4)) & 0xF;
+		unsigned int bdtr = regs.BDTR.value;
+		unsigned int enabled = complementary ? (ccer >> 2) & 1 : ccer & 1;
+		unsigned int polarity = complementary ? (ccer >> 3) & 1 : (ccer >> 1) & 1;
+		int level;
+
+		if (ch == 3)
+			ccer &= 0x3;                        // No CC4N
+		if (!clocked() || !(ccer & 0x5))
+			return -1;
+		if (!(bdtr & (1u << 15))) {             // MOE
+			if (!(bdtr & (1u << 10)))           // OSSI
+				return -1;
+			return (regs.CR2.value >> (8 + ch * 2 + complementary)) & 1;
+		}
+		if (!enabled)
+			return (bdtr & (1u << 11)) ? (int) polarity : -1;  // OSSR
+
+		level = complementary ? !ref[ch] : ref[ch];
+		if ((ccer & 0x5) == 0x5 && level && clock - refChange[ch] < deadTime())
+			level = 0;
+		return level ^ polarity;
+	}
+
+	// Counter overflow / underflow : update event, on TIM1 at every RCR + 1 of them
+	void overflow(void)
+	{
+		if (advanced && rep > 0) {
+			rep--;
+			return;
+		}
+		updateEvent(false);
+	}
+
+	unsigned int mode(unsigned int ch) const
+	{
+		unsigned int ccmr = (ch < 2) ? regs.CCMR1.value : regs.CCMR2.value;
+		return (ccmr >> ((ch & 1) * 8 + 4)) & 0x7;
+	}
+
+	bool preload(unsigned int ch) const
+	{
+		unsigned int ccmr = (ch < 2) ? regs.CCMR1.value : regs.CCMR2.value;
+		return (ccmr >> ((ch & 1) * 8 + 3)) & 1;
+	}
+
+	bool outputChannel(unsigned int ch) const
+	{
+		unsigned int ccmr = (ch < 2) ? regs.CCMR1.value : regs.CCMR2.value;
+		return ((ccmr >> ((ch & 1) * 8)) & 0x3) == 0;
+	}
+
+	bool countingDown(void) const
+	{
+		return ((regs.CR1.value >> 5) & 0x3) ? down : ((regs.CR1.value >> 4) & 1);
+	}
+
+	// Counter steps until CNT reaches a compare value, ARR (up) or 0 (down)
+	std::uint64_t stepsToEvent(void) const
+	{
+		unsigned int cnt = regs.CNT.value;
+		unsigned int next;
+		unsigned int ch;
+
+		if (!countingDown()) {
+			if (cnt >= arr)
+				return 1;
+			next = arr;
+			for (ch = 0; ch < 4; ++ch)
+				if (ccr[ch] > cnt && ccr[ch] < next)
+					next = ccr[ch];
+			return next - cnt;
+		}
+		if (cnt == 0)
+			return 1;
+		next = 0;
+		for (ch = 0; ch < 4; ++ch)
+			if (ccr[ch] < cnt && ccr[ch] > next)
+				next = ccr[ch];
+		return cnt - next;
+	}
+
+	/*
+	 * Funtion Name		: counterSteps
+	 * Description 		: One counter step, preceded by up to 'extra' steps in
+	 *					  which nothing happens (no compare value, ARR or 0
+	 *					  is reached), these are done at once
+	 * Input			: extra : further steps available
+	 * Return Value		: extra steps done
+	*/
+	std::uint64_t counterSteps(std::uint64_t extra)
+	{
+		unsigned int cr1 = regs.CR1.value;
+		unsigned int cnt = regs.CNT.value;
+		unsigned int cms = (cr1 >> 5) & 0x3;
+		std::uint64_t skip = stepsToEvent() - 1;
+
+		if (skip > extra)
+			skip = extra;
+		clock += skip * (psc + 1);
+		cnt = countingDown() ? cnt - skip : cnt + skip;
+
+		if (cms == 0) {
+			if (!down) {
+				if (cnt >= arr) {
+					cnt = 0;
+					regs.CNT.value = cnt;
+					overflow();
+				} else {
+					regs.CNT.value = cnt + 1;
+				}
+			} else {
+				if (cnt == 0) {
+					regs.CNT.value = arr;
+					overflow();
+				} else {
+					regs.CNT.value = cnt - 1;
+				}
+			}
+		} else {
+			// Center aligned : 0 .. ARR up, ARR .. 0 down, update at both ends
+			if (!down) {
+				cnt++;
+				regs.CNT.value = cnt;
+				if (cnt >= arr) {
+					regs.CNT.value = arr;
+					down = true;
+					regs.CR1.value |= (1u << 4);
+					overflow();
+				}
+			} else {
+				cnt = cnt ? cnt - 1 : 0;
+				regs.CNT.value = cnt;
+				if (cnt == 0) {
+					down = false;
+					regs.CR1.value &= ~(1u << 4);
+					overflow();
+				}
+			}
+		}
+
+		compare(true);
+		outputs();
+		return skip;
+	}
+
+	/*
+	 * Funtion Name		: updateEvent
+	 * Description 		: UEV : preload registers to shadow, UIF, one pulse stop
+	 * Input			: generated : true for EGR UG (counter restarts, URS hides UIF)
+	 * Return Value		: None
+	*/
+	void updateEvent(bool generated)
+	{
+		unsigned int cr1 = regs.CR1.value;
+		unsigned int ch;
+
+		if (generated) {
+			pscCount = 0;
+			regs.CNT.value = (((cr1 >> 5) & 0x3) == 0 && (cr1 & (1u << 4))) ? regs.ARR.value : 0;
+		} else if (cr1 & (1u << 1)) {
+			return;                             // UDIS
+		}
+
+		psc = regs.PSC.value;
+		arr = regs.ARR.value;
+		rep = regs.RCR.value;
+		for (ch = 0; ch < 4; ++ch)
+			ccr[ch] = (&regs.CCR1)[ch].value;
+		if (advanced && (regs.BDTR.value & (1u << 14)) && !breakActive())
+			regs.BDTR.value |= (1u << 15);      // AOE : MOE set again
+
+		if (!(generated && (cr1 & (1u << 2))))  // URS : only overflow sets UIF
+			regs.SR.value |= 1;
+		if (((regs.CR2.value >> 4) & 0x7) == 2 || (generated && ((regs.CR2.value >> 4) & 0x7) == 0))
+			simTimerEvent(number, 0);           // TRGO : MMS update, or reset (UG)
+		if (!generated && (cr1 & (1u << 3)))    // OPM
+			regs.CR1.value &= ~1u;
+		if (regs.DIER.value & (1u << 8))        // UDE
+			dmaRequest(0);
+	}
+
+	// Compare match flags and OCxREF of all output channels, time of each OCxREF change
+	void compare(bool counted)
+	{
+		unsigned int cnt = regs.CNT.value;
+		bool downward = countingDown();
+		unsigned int ch;
+
+		for (ch = 0; ch < 4; ++ch) {
+			bool match = counted && cnt == ccr[ch];
+			int before = ref[ch];
+
+			if (!outputChannel(ch))
+				continue;
+			if (match) {
+				regs.SR.value |= (1u << (ch + 1));
+				simTimerEvent(number, ch + 1);
+				if (regs.DIER.value & (1u << (ch + 9)))   // CCxDE
+					dmaRequest(ch + 1);
+				if (ch == 0 && ((regs.CR2.value >> 4) & 0x7) == 3)
+					simTimerEvent(number, 0);   // TRGO : MMS compare pulse
+			}
+
+			switch (mode(ch)) {
+			case 1:     // Active on match
+				if (match)
+					ref[ch] = 1;
+				break;
+			case 2:     // Inactive on match
+				if (match)
+					ref[ch] = 0;
+				break;
+			case 3:     // Toggle on match
+				if (match)
+					ref[ch] ^= 1;
+				break;
+			case 4:     // Force inactive
+				ref[ch] = 0;
+				break;
+			case 5:     // Force active
+				ref[ch] = 1;
+				break;
+			case 6:     // PWM1 : active while CNT < CCR (up), inactive while CNT > CCR (down)
+				ref[ch] = downward ? (cnt <= ccr[ch]) : (cnt < ccr[ch]);
+				break;
+			case 7:     // PWM2
+				ref[ch] = downward ? (cnt > ccr[ch]) : (cnt >= ccr[ch]);
+				break;
+			default:    // Frozen
+				break;
+			}
+			if (ref[ch] != before)
+				refChange[ch] = clock;
+		}
+	}
+
+	void outputs(void)
+	{
+		unsigned int ch;
+		bool changed = false;
+
+		for (ch = 0; ch < 4; ++ch) {
+			int o = output(ch);
+			int n = outputN(ch);
+			if (o != pin[ch] || n != pinN[ch]) {
+				pin[ch] = o;
+				pinN[ch] = n;
+				changed = true;
+			}
+		}
+		if (changed)
+			simGpioUpdate();
+	}
+
+	/*
+	 * Funtion Name		: burstTarget
+	 * Description 		: Register of a DMAR access : DCR DBA + accesses so far
+	 *					  in the burst, the burst ends after DBL + 1 accesses
+	 * Input			: None
+	 * Return Value		: register, nullptr past the end of the timer
+	*/
+	SimReg *burstTarget(void)
+	{
+		unsigned int dba = regs.DCR.value & 0x1F;
+		unsigned int dbl = (regs.DCR.value >> 8) & 0x1F;
+		unsigned int index = dba + burst;
+
+		burst = (burst >= dbl) ? 0 : burst + 1;
+		burstAccesses++;
+		if (index >= (unsigned int) (&regs.DMAR - &regs.CR1))
+			return nullptr;
+		return &regs.CR1 + index;
+	}
+
+	/*
+	 * Funtion Name		: dmaRequest
+	 * Description 		: DMA request of an event (0 update, 1-4 CCx). When
+	 *					  the DMA accesses DMAR the request stays until the
+	 *					  whole burst (DBL + 1 transfers) is done.
+	 * Input			: event
+	 * Return Value		: None
+	*/
+	void dmaRequest(unsigned int event)
+	{
+		unsigned int n, before;
+
+		if (dma[event] == 0)
+			return;
+		for (n = 0; n <= 0x1F; ++n) {
+			before = burstAccesses;
+			simDmaRequest(dma[event], this);
+			if (burstAccesses == before || burst == 0)
+				break;
+		}
+	}
+
+	TIM_type &regs;
+	int irq;
+	unsigned int number;        // 1, 2, 3, 4
+	const unsigned char *dma;   // DMA1 channel of update, CC1-CC4
+	unsigned int burst;         // DMAR accesses done in the running burst
+	unsigned int burstAccesses;
+	unsigned int arr;           // Shadow registers
+	unsigned int psc;
+	unsigned int ccr[4];
+	std::uint64_t pscCount;
+	std::uint64_t acc;          // SYSCLK cycles not yet a timer clock
+	bool down;
+	int ref[4];                 // OCxREF
+	int pin[4] = {-1, -1, -1, -1};
+	int pinN[4] = {-1, -1, -1, -1};
+	bool advanced;              // TIM1 : RCR, complementary outputs, dead-time, break
+	unsigned int rep;           // Repetition down counter
+	std::uint64_t clock;        // Timer clocks counted, time base of the dead-time
+	std::uint64_t refChange[4]; // Clock of the last OCxREF change
+	bool breakLevel;            // Break input active at the last look
+	int tiLevel[4];             // TI1-TI4 pin levels, -1 : not used by a channel
+	unsigned int icCount[4];    // Edges counted by the input capture prescalers
+	bool advancing = false;     // Inside advance : already at the current cycle
+};
+
+// DMA1 channels of the timer requests (reference manual DMA1 request map) : UP, CH1-CH4
+static const unsigned char tim1Dma[5] = {5, 2, 3, 6, 4};
+static const unsigned char tim2Dma[5] = {2, 5, 7, 1, 7};
+static const unsigned char tim3Dma[5] = {3, 6, 0, 2, 3};
+static const unsigned char tim4Dma[5] = {7, 1, 4, 5, 0};
+
+static TimModel tim1Model("TIM1", 0x40012C00, simTIM1, 24, tim1Dma);
+static TimModel tim2Model("TIM2", 0x40000000, simTIM2, 0, 28, tim2Dma);
+static TimModel tim3Model("TIM3", 0x40000400, simTIM3, 1, 29, tim3Dma);
+static TimModel tim4Model("TIM4", 0x40000800, simTIM4, 2, 30, tim4Dma);
+
+/*
+ * Funtion Name		: simAltFunctionOutput
+ * Description 		: Timer channel driving a pin (pins see timChannelPin)
+ * Input			: port (0 = A), pin
+ * Return Value		: level, -1 if no enabled channel on the pin
+*/
+int simAltFunctionOutput(unsigned int port, unsigned int pin)
+{
+	static TimModel *const timers[4] = {&tim1Model, &tim2Model, &tim3Model, &tim4Model};
+	unsigned int key = (port << 4) | pin;   // Port in the upper nibble
+	unsigned int ch, n;
+
+	for (ch = 0; ch < 4; ++ch) {
+		for (n = 0; n < 4; ++n)
+			if (timChannelPin(n + 1, ch) == key && timers[n]->output(ch) >= 0)
+				return timers[n]->output(ch);
+		if (ch < 3 && timChannelPin(1, ch) != 0xFF && tim1NPins[ch] == key && tim1Model.outputN(ch) >= 0)
+			return tim1Model.outputN(ch);
+	}
+	return -1;
+}
+
+// Pin levels or GPIO configuration changed : timer inputs (capture, TIM1 BKIN)
+static void timInputs(void)
+{
+	tim1Model.inputs();
+	tim2Model.inputs();
+	tim3Model.inputs();
+	tim4Model.inputs();
+}
+
+/*************************************************
+* ADC1, ADC2 : independent or dual (ADC1 master, CR1 DUALMOD)
+*************************************************/
+#define ADC_DUAL_REGULAR_SIMULTANEOUS   6
+#define ADC_DUAL_FAST_INTERLEAVED       7
+#define ADC_CAL_CODE                    0x3C    // DR after CAL, 7 bit code (any value on a board)
+
+class AdcModel : public SimDevice
+{
+public:
+	AdcModel(const char *deviceName, std::uint32_t baseAddress, ADC_type &regs, unsigned int bit,
+	         AdcModel *slaveModel) :
+		SimDevice(deviceName, baseAddress), adc(regs), master(nullptr), slave(slaveModel)
+	{
+		attach(&adc.SR, sizeof(ADC_type) / sizeof(SimReg));
+		enableReg = &simRCC.APB2ENR;
+		enableBit = bit;
+		if (slave)
+			slave->master = this;
+	}
+
+	void reset() override
+	{
+		SimReg *r;
+
+		for (r = &adc.SR; r <= &adc.DR; ++r)
+			r->value = 0;
+		adc.HTR.value = 0xFFF;
+		busy = 0;
+		calibrating = 0;
+		rank = 0;
+		acc = 0;
+		injBusy = 0;
+		injRank = 0;
+		paused = false;
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		if (&r == &adc.DR) {
+			adc.SR.value &= ~(1u << 1);     // Reading DR clears EOC
+			irqLine();
+		}
+		return r.value;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &adc.SR) {
+			r.value &= v;                       // rc_w0
+		} else if (&r == &adc.CR2) {
+			unsigned int old = r.value;
+			r.value = v & ~((1u << 22) | (1u << 21));   // SWSTART/JSWSTART read back 0
+
+			if (!(v & 1)) {
+				busy = 0;                       // Power down stops conversions
+				injBusy = 0;
+				paused = false;
+			} else if (old & 1) {
+				// ADON written again with no other change : start conversion
+				if (v == old && !busy)
+					start();
+				if ((v & (1u << 22)) && (v & (1u << 20)) && ((v >> 17) & 0x7) == 7 && !busy)
+					start();
+				if ((v & (1u << 21)) && (v & (1u << 15)) && ((v >> 12) & 0x7) == 7 && !injBusy)
+					startInjected();
+				if ((v & (1u << 2)) && !(old & (1u << 2)))
+					calibrating = 83;
+				if (v & (1u << 3))
+					r.value &= ~(1u << 3);      // Calibration registers reset at once
+			}
+		} else if (&r == &adc.DR || (&r >= &adc.JDR1 && &r <= &adc.JDR4)) {
+			// Read only
+		} else {
+			r.value = v;
+		}
+		irqLine();
+	}
+
+	void advance(std::uint64_t cycles) override
+	{
+		std::uint64_t clocks;
+
+		if (!clocked() || !(adc.CR2.value & 1))
+			return;
+
+		acc += cycles;
+		clocks = acc / simAdcDiv();
+		acc %= simAdcDiv();
+
+		// Half ADC clocks (sample times are x.5 cycles)
+		while (clocks > 0) {
+			if (calibrating) {
+				std::uint64_t step = (clocks < calibrating) ? clocks : calibrating;
+				calibrating -= step;
+				clocks -= step;
+				if (!calibrating) {
+					adc.CR2.value &= ~(1u << 2);
+					adc.DR.value = ADC_CAL_CODE;       // Calibration code in DR
+				}
+			} else if (injBusy) {
+				std::uint64_t half = clocks * 2;
+				std::uint64_t step = (half < injBusy) ? half : injBusy;
+				injBusy -= step;
+				clocks -= (step + 1) / 2;
+				if (!injBusy)
+					finishInjected();
+			} else if (busy) {
+				std::uint64_t half = clocks * 2;
+				std::uint64_t step = (half < busy) ? half : busy;
+				busy -= step;
+				clocks -= (step + 1) / 2;
+				if (!busy)
+					finish();
+			} else {
+				break;
+			}
+		}
+	}
+
+	// Timer event on an external trigger input
+	void trigger(unsigned int timer, unsigned int event)
+	{
+		// EXTSEL of the regular group : TIM2 CC2, TIM3 TRGO, TIM4 CC4
+		static const unsigned int extsel[3][5] = {
+			{8, 8, 3, 8, 8},    // TIM2 : TRGO, CC1 .. CC4
+			{4, 8, 8, 8, 8},    // TIM3
+			{8, 8, 8, 8, 5},    // TIM4
+		};
+		// JEXTSEL of the injected group : TIM2 TRGO/CC1, TIM3 CC4, TIM4 TRGO
+		static const unsigned int jextsel[3][5] = {
+			{2, 3, 8, 8, 8},    // TIM2 : TRGO, CC1 .. CC4
+			{8, 8, 8, 8, 4},    // TIM3
+			{5, 8, 8, 8, 8},    // TIM4
+		};
+		unsigned int cr2 = adc.CR2.value;
+
+		if (timer < 2 || timer > 4 || event > 4 || !clocked() || !(cr2 & 1) || calibrating)
+			return;
+		// A trigger during a conversion of the same group is ignored
+		if ((cr2 & (1u << 20)) && ((cr2 >> 17) & 0x7) == extsel[timer - 2][event] && !busy && !injBusy && !paused)
+			start();
+		if ((cr2 & (1u << 15)) && ((cr2 >> 12) & 0x7) == jextsel[timer - 2][event] && !injBusy)
+			startInjected();
+	}
+
+	// Until calibration or conversion ends
+	std::uint64_t horizon() override
+	{
+		if (!clocked() || !(adc.CR2.value & 1))
+			return SIM_NEVER;
+		if (calibrating)
+			return cyclesFor(calibrating, simAdcDiv(), acc);
+		if (injBusy)
+			return cyclesFor((injBusy + 1) / 2, simAdcDiv(), acc);
+		if (busy)
+			return cyclesFor((busy + 1) / 2, simAdcDiv(), acc);
+		return SIM_NEVER;
+	}
+
+private:
+	// DUALMOD of the master, 0 : independent
+	unsigned int dualMode(void) const
+	{
+		const AdcModel *m = master ? master : this;
+
+		return m->slave ? (m->adc.CR1.value >> 16) & 0xF : 0;
+	}
+
+	unsigned int sequenceLength(void) const
+	{
+		return (adc.CR1.value & (1u << 8)) ? ((adc.SQR1.value >> 20) & 0xF) + 1 : 1;
+	}
+
+	unsigned int channel(unsigned int n) const
+	{
+		if (n < 6)
+			return (adc.SQR3.value >> (n * 5)) & 0x1F;
+		if (n < 12)
+			return (adc.SQR2.value >> ((n - 6) * 5)) & 0x1F;
+		return (adc.SQR1.value >> ((n - 12) * 5)) & 0x1F;
+	}
+
+	// Sampling + 12.5 conversion clocks, in half ADC clocks
+	unsigned int conversionHalfClocks(unsigned int ch) const
+	{
+		static const unsigned int sampleHalf[8] = {3, 15, 27, 57, 83, 111, 143, 479};
+		unsigned int smp = (ch < 10) ? (adc.SMPR2.value >> (ch * 3)) : (adc.SMPR1.value >> ((ch - 10) * 3));
+		return sampleHalf[smp & 0x7] + 25;
+	}
+
+	void start(void)
+	{
+		rank = 0;
+		adc.SR.value |= (1u << 4);          // STRT
+		busy = conversionHalfClocks(channel(rank));
+
+		if (master || !slave || !(slave->adc.CR2.value & 1))
+			return;
+		// Master start starts the slave : simultaneous in step with the master
+		// (converted in finish), interleaved 7 ADC clocks ahead of the master
+		if (dualMode() == ADC_DUAL_REGULAR_SIMULTANEOUS) {
+			slave->rank = 0;
+			slave->adc.SR.value |= (1u << 4);
+		} else if (dualMode() == ADC_DUAL_FAST_INTERLEAVED) {
+			simSync(slave);
+			slave->acc = acc;
+			slave->rank = 0;
+			slave->adc.SR.value |= (1u << 4);
+			slave->busy = slave->conversionHalfClocks(slave->channel(0));
+			busy += 14;
+		}
+	}
+
+	// 12 bit code of a channel now
+	int sample(unsigned int ch) const
+	{
+		double volts = 0.0;
+		int code;
+
+		if (ch < 16 || (!master && (adc.CR2.value & (1u << 23))))   // Sensor and VREFINT : ADC1 only
+			volts = simAnalogInput(ch);
+		code = (int) std::lround(volts / 3.3 * 4095.0);
+		if (code < 0)
+			code = 0;
+		if (code > 4095)
+			code = 4095;
+		return code;
+	}
+
+	// Result of a channel now, right aligned or left aligned (ALIGN)
+	int convert(unsigned int ch)
+	{
+		int code = sample(ch);
+
+		adc.DR.value = (adc.CR2.value & (1u << 11)) ? (code << 4) : code;
+		adc.SR.value |= (1u << 1);          // EOC
+		watchdog(ch, code);
+		irqLine();
+		return code;
+	}
+
+	void finish(void)
+	{
+		unsigned int mode = dualMode();
+
+		convert(channel(rank));
+
+		// Dual mode : ADC2 result in DR[31:16] of ADC1
+		if (slave && mode == ADC_DUAL_REGULAR_SIMULTANEOUS) {
+			slave->convert(slave->channel(rank < slave->sequenceLength() ? rank : 0));
+			adc.DR.value |= (slave->adc.DR.value & 0xFFFF) << 16;
+		} else if (slave && mode == ADC_DUAL_FAST_INTERLEAVED) {
+			simSync(slave);
+			adc.DR.value |= (slave->adc.DR.value & 0xFFFF) << 16;
+		}
+		if (adc.CR2.value & (1u << 8))
+			simDmaRequest(1, this);             // DMA reads DR, EOC cleared
+
+		// Next rank of the scan, or restart in continuous mode
+		if (master && mode == ADC_DUAL_REGULAR_SIMULTANEOUS)
+			return;                             // Slave runs in step with the master
+		if (++rank < sequenceLength()) {
+			busy = conversionHalfClocks(channel(rank));
+		} else if (adc.CR2.value & (1u << 1)) {
+			rank = 0;
+			busy = conversionHalfClocks(channel(rank));
+		}
+	}
+
+	// Injected rank n (0 = first converted) : JSQ(4 - JL + n), 1 rank without SCAN
+	unsigned int injectedLength(void) const
+	{
+		return (adc.CR1.value & (1u << 8)) ? ((adc.JSQR.value >> 20) & 0x3) + 1 : 1;
+	}
+
+	unsigned int injectedChannel(unsigned int n) const
+	{
+		unsigned int jl = (adc.JSQR.value >> 20) & 0x3;
+
+		return (adc.JSQR.value >> ((3 - jl + n) * 5)) & 0x1F;
+	}
+
+	// Injected trigger : a running regular conversion is aborted and
+	// converted again once the injected ranks are done
+	void startInjected(void)
+	{
+		if (busy) {
+			busy = 0;
+			paused = true;
+		}
+		injRank = 0;
+		adc.SR.value |= (1u << 3);          // JSTRT
+		injBusy = conversionHalfClocks(injectedChannel(0));
+	}
+
+	void finishInjected(void)
+	{
+		int data;
+
+		// JOFRx subtracted, signed result : right aligned sign extended, left aligned << 3
+		data = sample(injectedChannel(injRank)) - (int) ((&adc.JOFR1)[injRank].value & 0xFFF);
+		if (adc.CR2.value & (1u << 11))
+			data *= 8;
+		(&adc.JDR1)[injRank].value = (unsigned int) data & 0xFFFF;
+
+		if (++injRank < injectedLength()) {
+			injBusy = conversionHalfClocks(injectedChannel(injRank));
+			return;
+		}
+		adc.SR.value |= (1u << 2);          // JEOC
+		irqLine();
+		if (paused) {
+			paused = false;
+			busy = conversionHalfClocks(channel(rank));
+		}
+	}
+
+	// Analog watchdog : AWD when the 12 bit result is outside LTR .. HTR
+	void watchdog(unsigned int ch, int code)
+	{
+		unsigned int cr1 = adc.CR1.value;
+
+		if (!(cr1 & (1u << 23)))                // AWDEN, regular group
+			return;
+		if ((cr1 & (1u << 9)) && (cr1 & 0x1F) != ch)
+			return;                             // AWDSGL : other channel
+		if ((unsigned int) code > (adc.HTR.value & 0xFFF) || (unsigned int) code < (adc.LTR.value & 0xFFF))
+			adc.SR.value |= (1u << 0);
+	}
+
+	bool pending(void) const
+	{
+		unsigned int sr = adc.SR.value;
+		unsigned int cr1 = adc.CR1.value;
+
+		return ((sr & (1u << 1)) && (cr1 & (1u << 5))) ||
+		       ((sr & (1u << 0)) && (cr1 & (1u << 6))) ||
+		       ((sr & (1u << 2)) && (cr1 & (1u << 7)));
+	}
+
+	// ADC1 and ADC2 share the ADC1_2 interrupt
+	void irqLine(void)
+	{
+		const AdcModel *m = master ? master : this;
+
+		simIrqLine(18, m->pending() || (m->slave && m->slave->pending()));
+	}
+
+	ADC_type &adc;
+	AdcModel *master;           // ADC1 model of the slave, nullptr for ADC1
+	AdcModel *slave;            // ADC2 model of the master
+	std::uint64_t busy;         // Half ADC clocks left of the running conversion
+	std::uint64_t calibrating;  // ADC clocks left of the calibration
+	std::uint64_t acc;
+	unsigned int rank;
+	std::uint64_t injBusy;      // Half ADC clocks left of the running injected conversion
+	unsigned int injRank;
+	bool paused;                // Regular conversion aborted by the injected group
+};
+
+static AdcModel adc2Model("ADC2", 0x40012800, simADC2, 10, nullptr);
+static AdcModel adcModel("ADC1", 0x40012400, simADC1, 9, &adc2Model);
+
+void simTimerEvent(unsigned int timer, unsigned int event)
+{
+	simSync(&adcModel);
+	simSync(&adc2Model);
+	adcModel.trigger(timer, event);
+	adc2Model.trigger(timer, event);
+	simSync(&adcModel);
+	simSync(&adc2Model);
+}
+
+/*************************************************
+* DMA1 : channels 1-7, peripheral requests from the models
+*************************************************/
+
+// CPAR/CMAR handles : host addresses of registers and buffers
+struct SIMDMA_TARGET_type
+{
+	SimReg *reg;                // Register of a model, nullptr : memory
+	volatile unsigned char *memory;
+};
+
+static std::vector<SIMDMA_TARGET_type> dmaTargets;
+
+#define SIM_DMA_HANDLE  0x20000000u     // First handle, SRAM as on the board
+
+static std::uint32_t dmaHandle(SimReg *reg, volatile unsigned char *memory)
+{
+	std::size_t i;
+
+	for (i = 0; i < dmaTargets.size(); ++i)
+		if (dmaTargets[i].reg == reg && dmaTargets[i].memory == memory)
+			return SIM_DMA_HANDLE + (std::uint32_t) i * 0x10000;
+	dmaTargets.push_back({reg, memory});
+	return SIM_DMA_HANDLE + (std::uint32_t) i * 0x10000;
+}
+
+std::uint32_t simDmaAddress(SimReg *reg)
+{
+	return dmaHandle(reg, nullptr);
+}
+
+std::uint32_t simDmaAddress(const volatile void *memory)
+{
+	return dmaHandle(nullptr, (volatile unsigned char *) memory);
+}
+
+class DmaModel : public SimDevice
+{
+public:
+	DmaModel() : SimDevice("DMA1", 0x40020000)
+	{
+		attach(&simDMA1.dma.ISR, sizeof(SIMDMA_type) / sizeof(SimReg));
+		enableReg = &simRCC.AHBENR;
+		enableBit = 0;
+	}
+
+	void reset() override
+	{
+		unsigned int n;
+
+		simDMA1.dma.ISR.value = 0;
+		for (n = 0; n < 7; ++n) {
+			simDMA1.channel[n].CCR.value = 0;
+			simDMA1.channel[n].CNDTR.value = 0;
+			simDMA1.channel[n].CPAR.value = 0;
+			simDMA1.channel[n].CMAR.value = 0;
+			loaded[n] = 0;
+			peripheralOffset[n] = memoryOffset[n] = 0;
+		}
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		if (&r == &simDMA1.dma.IFCR)
+			return 0;
+		return r.value;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		unsigned int n;
+
+		if (&r == &simDMA1.dma.ISR)
+			return;                             // Read only
+		if (&r == &simDMA1.dma.IFCR) {
+			// Write 1 to clear, CGIFx clears all flags of channel x
+			for (n = 0; n < 7; ++n)
+				if (v & (1u << (n * 4)))
+					v |= 0xFu << (n * 4);
+			simDMA1.dma.ISR.value &= ~v;
+			for (n = 0; n < 7; ++n)
+				irqLine(n);
+			return;
+		}
+
+		n = (r.offset - 8) / 20;
+		DMA_Channel_type &ch = simDMA1.channel[n];
+		if (&r == &ch.CCR) {
+			if ((v & 1) && !(ch.CCR.value & 1)) {
+				// Enable : transfers start at CPAR/CMAR with CNDTR items
+				loaded[n] = ch.CNDTR.value & 0xFFFF;
+				peripheralOffset[n] = memoryOffset[n] = 0;
+			}
+			ch.CCR.value = v & 0x7FFF;
+			irqLine(n);
+		} else if (&r == &ch.CNDTR || &r == &ch.CPAR || &r == &ch.CMAR) {
+			if (!(ch.CCR.value & 1))
+				r.value = (&r == &ch.CNDTR) ? (v & 0xFFFF) : v;   // Only while the channel is off
+		}
+	}
+
+	// One peripheral request : one item from source to destination
+	void request(unsigned int n, SimDevice *from)
+	{
+		DMA_Channel_type &ch = simDMA1.channel[n];
+		unsigned int ccr = ch.CCR.value;
+		unsigned int psize = 1u << ((ccr >> 8) & 3);    // Bytes
+		unsigned int msize = 1u << ((ccr >> 10) & 3);
+		unsigned int item;
+
+		if (!clocked() || !(ccr & 1) || ch.CNDTR.value == 0)
+			return;
+		simSync(this);
+
+		if (ccr & (1u << 4)) {
+			// Memory to peripheral
+			item = access(ch.CMAR.value, memoryOffset[n], msize, false, 0, from);
+			access(ch.CPAR.value, peripheralOffset[n], psize, true, item, from);
+		} else {
+			item = access(ch.CPAR.value, peripheralOffset[n], psize, false, 0, from);
+			access(ch.CMAR.value, memoryOffset[n], msize, true, item, from);
+		}
+		if (ccr & (1u << 6))
+			peripheralOffset[n] += psize;
+		if (ccr & (1u << 7))
+			memoryOffset[n] += msize;
+
+		ch.CNDTR.value--;
+		if (loaded[n] >= 2 && ch.CNDTR.value == loaded[n] - loaded[n] / 2)
+			simDMA1.dma.ISR.value |= 0x5u << (n * 4);  // HTIF, GIF
+		if (ch.CNDTR.value == 0) {
+			simDMA1.dma.ISR.value |= 0x3u << (n * 4);  // TCIF, GIF
+			if (ccr & (1u << 5)) {
+				// Circular : reload the count and the start addresses
+				ch.CNDTR.value = loaded[n];
+				peripheralOffset[n] = memoryOffset[n] = 0;
+			}
+		}
+		irqLine(n);
+	}
+
+private:
+	// Read or write one item at handle + offset, a register or a buffer
+	unsigned int access(std::uint32_t address, unsigned int offset, unsigned int size,
+	                    bool write, unsigned int item, SimDevice *from)
+	{
+		std::uint32_t index = (address - SIM_DMA_HANDLE) / 0x10000;
+		unsigned int v = 0;
+
+		if (address < SIM_DMA_HANDLE || index >= dmaTargets.size() || (address & 0xFFFF) != 0)
+			simFatal("DMA1 address 0x%08X was not made with DMA_ADDRESS()", address);
+
+		SIMDMA_TARGET_type &t = dmaTargets[index];
+		if (t.reg != nullptr) {
+			// Registers of a model are one SimReg per word
+			SimReg &r = t.reg[offset / 4];
+			SimDevice *dev = r.dev;
+
+			if (dev == nullptr) {
+				if (write)
+					r.value = item;
+				return r.value;
+			}
+			if (dev != from)
+				simSync(dev);
+			if (write)
+				dev->write(r, (size < 4) ? (item & ((1u << (size * 8)) - 1)) : item);
+			else
+				v = dev->read(r);
+			if (dev != from)
+				simSync(dev);
+			return v;
+		}
+
+		if (write)
+			std::memcpy((void *) (t.memory + offset), &item, size);
+		else
+			std::memcpy(&v, (const void *) (t.memory + offset), size);
+		return v;
+	}
+
+	void irqLine(unsigned int n)
+	{
+		unsigned int flags = (simDMA1.dma.ISR.value >> (n * 4)) & 0xE;     // TEIF, HTIF, TCIF
+
+		simIrqLine(11 + n, (flags & simDMA1.channel[n].CCR.value & 0xE) != 0);
+	}
+
+	unsigned int loaded[7];             // CNDTR at enable, reloaded in circular mode
+	unsigned int peripheralOffset[7];   // Bytes from CPAR of the next item
+	unsigned int memoryOffset[7];       // Bytes from CMAR of the next item
+};
+
+static DmaModel dmaModel;
+
+void simDmaRequest(unsigned int channel, SimDevice *from)
+{
+	if (channel >= 1 && channel <= 7)
+		dmaModel.request(channel - 1, from);
+}
+
+/*************************************************
+* DWT : CYCCNT counts SYSCLK cycles (enabled at reset like startup.s does)
+*************************************************/
+class DwtModel : public SimDevice
+{
+public:
+	DwtModel() : SimDevice("DWT", 0xE0001000)
+	{
+		attach(&simDWT.CTRL, sizeof(DWT_type) / sizeof(SimReg));
+	}
+
+	void reset() override
+	{
+		simDEMCR.value = (1u << 24);        // TRCENA
+		simDWT.CTRL.value = 1;              // CYCCNTENA
+		simDWT.CYCCNT.value = 0;
+		since = 0;
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		if (&r == &simDWT.CYCCNT)
+			return count();
+		return r.value;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		simDWT.CYCCNT.value = count();
+		since = simCycles();
+		if (&r == &simDWT.CYCCNT)
+			r.value = v;
+		else
+			r.value = v & 1;
+	}
+
+private:
+	unsigned int count(void) const
+	{
+		if (!(simDWT.CTRL.value & 1) || !(simDEMCR.value & (1u << 24)))
+			return simDWT.CYCCNT.value;
+		return simDWT.CYCCNT.value + (unsigned int) (simCycles() - since);
+	}
+
+	std::uint64_t since;        // Cycle of the last CYCCNT/CTRL write
+};
+
+static DwtModel dwtModel;
+
+/*************************************************
+* NVIC
+*************************************************/
+class NvicModel : public SimDevice
+{
+public:
+	NvicModel() : SimDevice("NVIC", 0xE000E100)
+	{
+		attach(&simNVIC.ISER[0], sizeof(NVIC_type) / sizeof(SimReg));
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		unsigned int index = r.offset / 4;
+		unsigned int word = index & 7;
+		unsigned int v = 0;
+		unsigned int bit;
+
+		if (index >= 192 && index < 192 + 68)
+			return simGetPriority(index - 192);
+		if (index >= 160 || (index & 31) >= 8)
+			return 0;
+
+		for (bit = 0; bit < 32; ++bit) {
+			int irq = word * 32 + bit;
+			bool set = false;
+			if (irq >= 68)
+				break;
+			switch (index >> 5) {
+			case 0: case 1: set = simIsEnabled(irq); break;     // ISER, ICER
+			case 2: case 3: set = simIsPending(irq); break;     // ISPR, ICPR
+			case 4:         set = simIsActive(irq);  break;     // IABR
+			}
+			if (set)
+				v |= (1u << bit);
+		}
+		return v;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		unsigned int index = r.offset / 4;
+		unsigned int word = index & 7;
+		unsigned int bit;
+
+		if (&r == &simNVIC.STIR) {
+			if ((v & 0x1FF) < 68)
+				simSetPending(v & 0x1FF);
+			return;
+		}
+		if (index >= 192 && index < 192 + 68) {
+			simSetPriority(index - 192, v);
+			return;
+		}
+		if (index >= 128 || (index & 31) >= 8)
+			return;
+
+		for (bit = 0; bit < 32; ++bit) {
+			int irq = word * 32 + bit;
+			if (irq >= 68)
+				break;
+			if (!(v & (1u << bit)))
+				continue;
+			switch (index >> 5) {
+			case 0: simSetEnable(irq, true);  break;
+			case 1: simSetEnable(irq, false); break;
+			case 2: simSetPending(irq);       break;
+			case 3: simClearPending(irq);     break;
+			}
+		}
+	}
+};
+
+static NvicModel nvicModel;
+
+/*************************************************
+* System control block : SysTick pending (ICSR), priority (SHPR3) and
+* active (SHCSR SYSTICKACT)
+*************************************************/
+class ScbModel : public SimDevice
+{
+public:
+	ScbModel() : SimDevice("SCB", 0xE000ED00)
+	{
+		attach(&simSCB.CPUID, sizeof(SCB_type) / sizeof(SimReg));
+	}
+
+	void reset() override
+	{
+		simSCB.CPUID.value = 0x411FC231;    // Cortex-M3 r1p1
+		simSCB.CCR.value = 0x200;           // STKALIGN
+	}
+
+	unsigned int read(SimReg &r) override
+	{
+		if (&r == &simSCB.ICSR)
+			return simIsPending(-1) ? (1u << 26) : 0;   // PENDSTSET
+		if (&r == &simSCB.SHPR3)
+			return (r.value & 0x00FFFFFF) | (simGetPriority(-1) << 24);
+		if (&r == &simSCB.SHCSR)
+			return (r.value & ~(1u << 11)) | (simIsActive(-1) ? (1u << 11) : 0);   // SYSTICKACT
+		return r.value;
+	}
+
+	void write(SimReg &r, unsigned int v) override
+	{
+		if (&r == &simSCB.ICSR) {
+			if (v & (1u << 26))
+				simSetPending(-1);
+			else if (v & (1u << 25))
+				simClearPending(-1);
+		} else if (&r == &simSCB.SHPR3) {
+			r.value = v & 0x00FF0000;
+			simSetPriority(-1, v >> 24);
+		} else if (&r != &simSCB.CPUID) {
+			r.value = v;
+		}
+	}
+};
+
+static ScbModel scbModel;
@@ -0,0 +1,333 @@
+/*
+ * File Name  : simtrace.cpp Ver 1.0
+ *
+ * Description:
+ *   Signal recorder of the host simulator
+ *
+ *   Signals are GPIO output pins (PC13, PB1 ...) and interrupt handlers
+ *   (SysTick, TIM3 ... : 1 while the handler runs). For every signal the
+ *   recorder keeps edge count, period (rising to rising edge) and duty cycle.
+ *
+ *      --vcd FILE                 waveform for GTKWave (timescale 1 ns)
+ *      --csv FILE                 time_ns,signal,level per edge
+ *      --period NAME=TIME[,TOL%]  mean period check, default tolerance 1 %
+ *      --duty NAME=PCT[,TOL]      duty cycle check in %, default +- 1
+ *      --count NAME=N             number of rising edges (handler entries)
+ *      --from TIME                statistics and checks start at TIME
+ *
+ *   Summary table is printed at the end, exit status 1 when a check fails
+ *   so the simulator can be used in CI.
+ *
+ * Author:
+ *       ICEEL.NET (iceelinstitute@gmail.com)
+ *
+ * License : GNU General Public License v3.0
+ */
+
+#include "simcore.h"
+
+#include <cmath>
+
+typedef struct
+{
+	std::string name;
+	int level;                  // -1 : not driven yet
+	double lastChange;
+	double lastRise;            // -1 : no rising edge yet
+	double lastHigh;            // High time of the running period
+	unsigned long rises;
+	unsigned long falls;
+	unsigned long periods;
+	double periodSum;
+	double periodMin;
+	double periodMax;
+	double highSum;             // High time of complete periods
+} SIGNAL_type;
+
+typedef struct
+{
+	double time;
+	int signal;
+	int level;
+} EVENT_type;
+
+typedef struct
+{
+	enum { PERIOD, DUTY, COUNT } kind;
+	std::string name;
+	double expected;
+	double tolerance;
+} CHECK_type;
+
+static std::vector<SIGNAL_type> signals;
+static std::vector<EVENT_type> events;     // Kept only for --vcd / --csv
+static std::vector<CHECK_type> checks;
+static const char *vcdFile;
+static const char *csvFile;
+static double statsFrom;                    // --from, ns
+
+int simTraceSignal(const std::string &name)
+{
+	SIGNAL_type s;
+	unsigned int i;
+
+	for (i = 0; i < signals.size(); ++i)
+		if (signals[i].name == name)
+			return i;
+
+	s.name = name;
+	s.level = -1;
+	s.lastChange = 0;
+	s.lastRise = -1;
+	s.lastHigh = 0;
+	s.rises = s.falls = s.periods = 0;
+	s.periodSum = s.periodMin = s.periodMax = s.highSum = 0;
+	signals.push_back(s);
+	return signals.size() - 1;
+}
+
+void simTraceLevel(int signal, int level)
+{
+	SIGNAL_type &s = signals[signal];
+	double now = simTimeNs();
+
+	if (level == s.level)
+		return;
+
+	if (now < statsFrom) {
+		// Start-up, only the level is followed
+	} else if (s.level == 0 && level == 1) {
+		if (s.lastRise >= 0) {
+			double period = now - s.lastRise;
+			if (s.periods == 0 || period < s.periodMin)
+				s.periodMin = period;
+			if (period > s.periodMax)
+				s.periodMax = period;
+			s.periodSum += period;
+			s.highSum += s.lastHigh;
+			s.periods++;
+		}
+		s.lastRise = now;
+		s.lastHigh = 0;
+		s.rises++;
+	} else if (s.level == 1 && level == 0) {
+		if (s.lastRise >= 0)
+			s.lastHigh = now - s.lastRise;
+		s.falls++;
+	}
+	s.level = level;
+	s.lastChange = now;
+
+	if (vcdFile || csvFile)
+		events.push_back({now, signal, level});
+}
+
+static std::string formatTime(double ns)
+{
+	char text[32];
+
+	// Unit switches where the printed value would round up to 1000
+	if (ns >= 1e9 - 5e4)
+		std::snprintf(text, sizeof(text), "%.4f s", ns * 1e-9);
+	else if (ns >= 1e6 - 50)
+		std::snprintf(text, sizeof(text), "%.4f ms", ns * 1e-6);
+	else if (ns >= 1e3 - 0.5)
+		std::snprintf(text, sizeof(text), "%.3f us", ns * 1e-3);
+	else
+		std::snprintf(text, sizeof(text), "%.1f ns", ns);
+	return text;
+}
+
+static void writeVcd(void)
+{
+	FILE *f = std::fopen(vcdFile, "w");
+	unsigned int i;
+	double last = -1;
+
+	if (f == nullptr) {
+		std::fprintf(stderr, "sim: can not write %s\n", vcdFile);
+		return;
+	}
+
+	// Identifiers : printable characters from '!'
+	std::fprintf(f, "$timescale 1ns $end\n$scope module stm32f103 $end\n");
+	for (i = 0; i < signals.size(); ++i)
+		std::fprintf(f, "$var wire 1 %c%c %s $end\n", '!' + i % 90, '!' + i / 90, signals[i].name.c_str());
+	std::fprintf(f, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+	for (i = 0; i < signals.size(); ++i)
+		std::fprintf(f, "x%c%c\n", '!' + i % 90, '!' + i / 90);
+	std::fprintf(f, "$end\n");
+
+	for (const EVENT_type &e : events) {
+		if (e.time != last) {
+			std::fprintf(f, "#%llu\n", (unsigned long long) std::llround(e.time));
+			last = e.time;
+		}
+		std::fprintf(f, "%d%c%c\n", e.level, '!' + e.signal % 90, '!' + e.signal / 90);
+	}
+	std::fprintf(f, "#%llu\n", (unsigned long long) std::llround(simTimeNs()));
+	std::fclose(f);
+}
+
+static void writeCsv(void)
+{
+	FILE *f = std::fopen(csvFile, "w");
+
+	if (f == nullptr) {
+		std::fprintf(stderr, "sim: can not write %s\n", csvFile);
+		return;
+	}
+	std::fprintf(f, "time_ns,signal,level\n");
+	for (const EVENT_type &e : events)
+		std::fprintf(f, "%.1f,%s,%d\n", e.time, signals[e.signal].name.c_str(), e.level);
+	std::fclose(f);
+}
+
+static const SIGNAL_type *findSignal(const std::string &name)
+{
+	for (const SIGNAL_type &s : signals)
+		if (s.name == name)
+			return &s;
+	return nullptr;
+}
+
+/*
+ * Funtion Name		: simTraceFinish
+ * Description 		: Writes VCD/CSV, prints the signal summary and runs the
+ *					  --period/--duty/--count checks
+ * Input			: None
+ * Return Value		: 0 all checks passed, 1 a check failed
+*/
+int simTraceFinish(void)
+{
+	int failed = 0;
+
+	if (vcdFile)
+		writeVcd();
+	if (csvFile)
+		writeCsv();
+
+	std::printf("Simulated %s, %llu cycles, SYSCLK %u Hz\n\n", formatTime(simTimeNs()).c_str(),
+	            (unsigned long long) simCycles(), simSysclk());
+	std::printf("%-10s %8s %14s %14s %14s %8s\n", "Signal", "Rising", "Period", "Min", "Max", "Duty");
+	for (const SIGNAL_type &s : signals) {
+		if (s.periods) {
+			std::printf("%-10s %8lu %14s %14s %14s %7.2f%%\n", s.name.c_str(), s.rises,
+			            formatTime(s.periodSum / s.periods).c_str(), formatTime(s.periodMin).c_str(),
+			            formatTime(s.periodMax).c_str(), 100.0 * s.highSum / s.periodSum);
+		} else {
+			std::printf("%-10s %8lu %14s %14s %14s %8s\n", s.name.c_str(), s.rises, "-", "-", "-",
+			            s.level < 0 ? "-" : (s.level ? "high" : "low"));
+		}
+	}
+
+	if (!checks.empty())
+		std::printf("\n");
+	for (const CHECK_type &c : checks) {
+		const SIGNAL_type *s = findSignal(c.name);
+		bool pass = false;
+		std::string measured = "no edges";
+
+		if (c.kind == CHECK_type::COUNT) {
+			unsigned long rises = s ? s->rises : 0;
+			measured = std::to_string(rises);
+			pass = rises == (unsigned long) c.expected;
+			std::printf("%s count %s : %s (expected %.0f)\n", pass ? "PASS" : "FAIL", c.name.c_str(),
+			            measured.c_str(), c.expected);
+		} else if (c.kind == CHECK_type::PERIOD) {
+			if (s && s->periods) {
+				double mean = s->periodSum / s->periods;
+				measured = formatTime(mean);
+				pass = std::fabs(mean - c.expected) <= c.expected * c.tolerance / 100.0;
+			}
+			std::printf("%s period %s : %s (expected %s +- %.2f%%)\n", pass ? "PASS" : "FAIL", c.name.c_str(),
+			            measured.c_str(), formatTime(c.expected).c_str(), c.tolerance);
+		} else {
+			if (s && s->periods) {
+				double duty = 100.0 * s->highSum / s->periodSum;
+				char text[16];
+				std::snprintf(text, sizeof(text), "%.2f%%", duty);
+				measured = text;
+				pass = std::fabs(duty - c.expected) <= c.tolerance;
+			}
+			std::printf("%s duty %s : %s (expected %.2f%% +- %.2f)\n", pass ? "PASS" : "FAIL", c.name.c_str(),
+			            measured.c_str(), c.expected, c.tolerance);
+		}
+		if (!pass)
+			failed = 1;
+	}
+
+	return failed;
+}
+
+// NAME=VALUE[,TOL] -> check
+static bool parseCheck(const char *arg, CHECK_type &c, double defaultTolerance)
+{
+	const char *eq = std::strchr(arg, '=');
+	const char *comma;
+	std::string value;
+
+	if (eq == nullptr || eq == arg)
+		return false;
+	c.name.assign(arg, eq - arg);
+	comma = std::strchr(eq + 1, ',');
+	value.assign(eq + 1, comma ? (size_t) (comma - eq - 1) : std::strlen(eq + 1));
+	c.tolerance = comma ? std::atof(comma + 1) : defaultTolerance;
+
+	if (c.kind == CHECK_type::PERIOD)
+		c.expected = simParseTimeNs(value.c_str());
+	else
+		c.expected = std::atof(value.c_str());
+	return c.expected >= 0 && !value.empty();
+}
+
+bool simTraceOption(int argc, char **argv, int &i)
+{
+	const char *arg = argv[i];
+	CHECK_type c;
+
+	if (i + 1 >= argc)
+		return false;
+
+	if (std::strcmp(arg, "--from") == 0) {
+		statsFrom = simParseTimeNs(argv[i + 1]);
+		if (statsFrom < 0)
+			simFatal("bad --from %s", argv[i + 1]);
+		++i;
+	} else if (std::strcmp(arg, "--vcd") == 0) {
+		vcdFile = argv[++i];
+	} else if (std::strcmp(arg, "--csv") == 0) {
+		csvFile = argv[++i];
+	} else if (std::strcmp(arg, "--period") == 0) {
+		c.kind = CHECK_type::PERIOD;
+		if (!parseCheck(argv[i + 1], c, 1.0))
+			simFatal("bad --period %s", argv[i + 1]);
+		checks.push_back(c);
+		++i;
+	} else if (std::strcmp(arg, "--duty") == 0) {
+		c.kind = CHECK_type::DUTY;
+		if (!parseCheck(argv[i + 1], c, 1.0))
+			simFatal("bad --duty %s", argv[i + 1]);
+		checks.push_back(c);
+		++i;
+	} else if (std::strcmp(arg, "--count") == 0) {
+		c.kind = CHECK_type::COUNT;
+		if (!parseCheck(argv[i + 1], c, 0.0))
+			simFatal("bad --count %s", argv[i + 1]);
+		checks.push_back(c);
+		++i;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void simTraceUsage(void)
+{
+	std::printf("  --from T             edges before T are not counted (start-up), VCD/CSV keep them\n"
+	            "  --vcd FILE           write waveform (GTKWave), signals : pins PC13 ... and handlers SysTick, TIM3 ...\n"
+	            "  --csv FILE           write edges as time_ns,signal,level\n"
+	            "  --period SIG=T[,P]   check mean period of SIG is T within P %% (default 1)\n"
+	            "  --duty SIG=D[,P]     check duty cycle of SIG is D %% within +- P (default 1)\n"
+	            "  --count SIG=N        check SIG has N rising edges\n");
+}